@@ -0,0 +1,33 @@
+// bench/bench.h
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+/**
+ * Minimal benchmark harness
+ *
+ * measure() repeats `work` until at least `min_seconds` have passed and
+ * returns the seconds per call, so fast and slow cases get comparable
+ * sample sizes without hand-tuned iteration counts.
+ */
+
+template <typename Work>
+double measure(Work&& work, double min_seconds = 0.5) {
+    using Clock = std::chrono::steady_clock;
+    work();                                 // warm up caches and lazy init
+    size_t calls = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        work();
+        calls++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return elapsed / calls;
+}
+
+// Keep the optimizer from dropping a result nobody reads
+template <typename T>
+void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
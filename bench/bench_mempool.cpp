@@ -0,0 +1,173 @@
+// bench/bench_mempool.cpp
+//
+// The mempool under synthetic load: accept() on signed P2WPKH spends, then
+// a pool grown to N MB (argument, default 300) of chained transactions,
+// timing block templates, block arrival and trimming at that size.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "coins/utxo_set.h"
+#include "crypto/hash.h"
+#include "crypto/keys.h"
+#include "crypto/sha256.h"
+#include "mempool/mempool.h"
+#include "script/sighash.h"
+
+using namespace bitcoin;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+crypto::Hash256 random_hash(std::mt19937_64& rng) {
+    crypto::Hash256 hash;
+    for (unsigned char& b : hash) b = (unsigned char)rng();
+    return hash;
+}
+
+// Spend `coin` (a P2WPKH output of `key`) into two outputs, leaving `fee`
+TransactionRef signed_spend(const crypto::PrivateKey& key, const crypto::PublicKey& pub, const OutPoint& outpoint,
+                            const TransactionOutput& coin, uint64_t fee) {
+    crypto::Hash160 key_hash = crypto::Hash::hash160(pub.get_bytes());
+    TransactionBuilder builder;
+    builder.add_input(TransactionInput(outpoint.txid, outpoint.vout, ""));
+    uint64_t half = (coin.value - fee) / 2;
+    builder.add_output(TransactionOutput(half, make_p2wpkh(key_hash)));
+    builder.add_output(TransactionOutput(coin.value - fee - half, make_p2wpkh(key_hash)));
+
+    TransactionRef unsigned_tx = builder.build();
+    PrecomputedSighash precomputed(*unsigned_tx);
+    crypto::Hash256 sighash = segwit_signature_hash(*unsigned_tx, 0, make_p2pkh(key_hash).span(), coin.value,
+                                                    SIGHASH_ALL, precomputed);
+    std::vector<unsigned char> signature = key.sign(sighash);
+    signature.push_back(SIGHASH_ALL);
+    builder.mutable_input(0).witness = {std::string(signature.begin(), signature.end()),
+                                        std::string(pub.get_bytes().begin(), pub.get_bytes().end())};
+    return std::move(builder).build();
+}
+
+// Signed spends of confirmed coins, and chains of children spending those,
+// through the full accept() path
+void bench_accept(std::mt19937_64& rng) {
+    const size_t roots = 2000, depth = 4;
+    std::vector<crypto::PrivateKey> keys(20);
+    std::vector<crypto::PublicKey> pubs(keys.begin(), keys.end());
+
+    // A chain of 100 headers for lock times and coinbase maturity
+    std::vector<BlockIndexEntry> headers(100);
+    for (uint32_t h = 0; h < headers.size(); h++) {
+        headers[h].height = h;
+        headers[h].timestamp = 1600000000 + 600 * h;
+        headers[h].parent = h ? &headers[h - 1] : nullptr;
+    }
+    const BlockIndexEntry* tip = &headers.back();
+
+    UtxoSet chain;
+    std::vector<TransactionRef> transactions;   // parents before children
+    for (size_t i = 0; i < roots; i++) {
+        size_t k = i % keys.size();
+        OutPoint outpoint(random_hash(rng), 0);
+        TransactionOutput coin(1000000, make_p2wpkh(crypto::Hash::hash160(pubs[k].get_bytes())));
+        chain.add_coin(outpoint, Coin(coin, 10, false));
+        for (size_t d = 0; d < depth; d++) {
+            TransactionRef tx = signed_spend(keys[k], pubs[k], outpoint, coin, 2000 + rng() % 5000);
+            transactions.push_back(tx);
+            outpoint = OutPoint(tx->get_txid(), 0);
+            coin = tx->outputs[0];
+        }
+    }
+
+    SignatureCache cache;
+    Mempool pool(Mempool::DEFAULT_MAX_MEMORY, &cache);
+    size_t accepted = 0;
+    auto start = Clock::now();
+    for (const TransactionRef& tx : transactions) accepted += pool.accept(tx, chain, tip) == MempoolReject::OK;
+    double seconds = seconds_since(start);
+    std::printf("accept(): %zu/%zu signed transactions (chains of %zu), %.0f tx/s\n", accepted, transactions.size(),
+                depth, transactions.size() / seconds);
+}
+
+// Unsigned transactions added with add_unchecked(), one in four spending an
+// earlier pool output up to 10 deep, until memory use reaches `target`
+void bench_large_pool(std::mt19937_64& rng, size_t target) {
+    Mempool pool(SIZE_MAX);
+    std::vector<std::pair<OutPoint, int>> unspent;      // pool outputs and their depth
+    size_t added = 0;
+    double add_seconds = 0;
+    auto build_start = Clock::now();
+    while (pool.stats().memory_usage < target) {
+        std::vector<TransactionRef> batch;
+        std::vector<uint64_t> fees;
+        for (int i = 0; i < 10000; i++) {
+            TransactionBuilder builder;
+            int depth = 0;
+            for (int j = 1 + rng() % 2; j > 0; j--) {
+                OutPoint outpoint(random_hash(rng), 0);
+                if (unspent.size() > 1000 && rng() % 4 == 0) {
+                    size_t pick = rng() % unspent.size();
+                    if (unspent[pick].second < 10) {
+                        outpoint = unspent[pick].first;
+                        depth = std::max(depth, unspent[pick].second + 1);
+                        unspent[pick] = unspent.back();
+                        unspent.pop_back();
+                    }
+                }
+                builder.add_input(TransactionInput(outpoint.txid, outpoint.vout, std::string(107, 's')));
+            }
+            for (int o = 0; o < 2; o++) {
+                builder.add_output(TransactionOutput(1000 + rng() % 100000, make_p2wpkh(crypto::Hash160())));
+            }
+            TransactionRef tx = std::move(builder).build();
+            for (uint32_t o = 0; o < 2; o++) unspent.push_back({OutPoint(tx->get_txid(), o), depth});
+            batch.push_back(tx);
+            fees.push_back(200 + rng() % 30000);
+        }
+        auto start = Clock::now();
+        for (size_t i = 0; i < batch.size(); i++) pool.add_unchecked(batch[i], fees[i]);
+        add_seconds += seconds_since(start);
+        added += batch.size();
+    }
+    MempoolStats stats = pool.stats();
+    std::printf("pool: %zu transactions, %.0f MB, %.1f MvB, built in %.1f s, add_unchecked() %.0f tx/s\n",
+                stats.transactions, stats.memory_usage / 1048576.0, stats.total_vsize / 1e6,
+                seconds_since(build_start), added / add_seconds);
+
+    for (int round = 0; round < 3; round++) {
+        uint64_t fees = 0;
+        auto start = Clock::now();
+        std::vector<TransactionRef> block_txs = pool.build_block_template(MAX_BLOCK_WEIGHT - 4000, &fees);
+        double template_seconds = seconds_since(start);
+
+        Block block;
+        block.transactions = std::move(block_txs);
+        start = Clock::now();
+        pool.remove_for_block(block);
+        std::printf("  block %d: template of %zu in %.1f ms, remove_for_block() %.1f ms\n", round,
+                    block.transactions.size(), template_seconds * 1e3, seconds_since(start) * 1e3);
+    }
+
+    auto start = Clock::now();
+    pool.trim_to_size(target * 2 / 3);
+    std::printf("  trim_to_size() to two thirds: %.0f ms, %llu evicted\n", seconds_since(start) * 1e3,
+                (unsigned long long)pool.stats().evicted);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    crypto::sha256::auto_detect();
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+    std::mt19937_64 rng(2022);
+    bench_accept(rng);
+    bench_large_pool(rng, megabytes << 20);
+    return 0;
+}
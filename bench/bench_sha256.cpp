@@ -0,0 +1,123 @@
+// bench/bench_sha256.cpp
+//
+// Hashing 80-byte headers and 250-byte transactions: the original
+// hex-string double_sha256 against the streaming Sha256Writer, then the
+// writer on each SHA-256 backend, and the batched mining and merkle paths.
+
+#include <openssl/sha.h>
+
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "blockchain/block.h"
+#include "crypto/hash.h"
+#include "crypto/sha256.h"
+
+using namespace crypto;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+// How Hash::double_sha256 used to work: hex-encode the first digest through
+// a stringstream and hash the 64 characters of text
+std::string old_sha256_hex(const std::string& input) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256((const unsigned char*)input.data(), input.size(), hash);
+    std::stringstream ss;
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+    }
+    return ss.str();
+}
+
+std::string old_double_sha256(const std::string& input) {
+    return old_sha256_hex(old_sha256_hex(input));
+}
+
+// And how BlockHeader::calculate_hash fed it: the fields streamed as text
+std::string old_header_hash(const bitcoin::BlockHeader& header) {
+    std::stringstream data;
+    data << header.version << header.previous_block_hash.to_hex() << header.merkle_root.to_hex()
+         << header.timestamp << header.bits << header.nonce;
+    return old_double_sha256(data.str());
+}
+
+void report(const char* name, double seconds, double bytes) {
+    std::printf("  %-34s %8.0f ns  %8.1f MB/s\n", name, seconds * 1e9, bytes / seconds / 1e6);
+}
+
+void bench_writer(const char* backend, bitcoin::BlockHeader& header, const Bytes& tx) {
+    std::printf("Sha256Writer, %s:\n", backend);
+    report("header calculate_hash()", measure([&] {
+               header.nonce++;
+               do_not_optimize(header.calculate_hash());
+           }), 80);
+    report("250-byte tx double_sha256()", measure([&] {
+               do_not_optimize(Hash::double_sha256(tx.data(), tx.size()));
+           }), tx.size());
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(2002);
+    bitcoin::BlockHeader header;
+    header.version = 0x20000000;
+    for (unsigned char& b : header.previous_block_hash) b = (unsigned char)rng();
+    for (unsigned char& b : header.merkle_root) b = (unsigned char)rng();
+    header.timestamp = 1700000000;
+    header.bits = 0x17034219;
+    Bytes tx(250);
+    for (unsigned char& b : tx) b = (unsigned char)rng();
+    std::string tx_string(tx.begin(), tx.end());
+
+    std::printf("Old hex-string path:\n");
+    report("header calculate_hash()", measure([&] {
+               header.nonce++;
+               do_not_optimize(old_header_hash(header));
+           }), 80);
+    report("250-byte tx double_sha256()", measure([&] {
+               do_not_optimize(old_double_sha256(tx_string));
+           }), tx.size());
+
+    // Before auto_detect() the writer runs the portable code
+    bench_writer("scalar", header, tx);
+    std::string backend = sha256::auto_detect();
+    bench_writer(backend.c_str(), header, tx);
+
+    // Batched paths: nonces for mining, 64-byte pairs for merkle levels
+    std::printf("Batched, %s:\n", backend.c_str());
+    auto bytes = header.to_bytes();
+    uint32_t midstate[8];
+    std::memcpy(midstate, sha256::INITIAL_STATE, sizeof(midstate));
+    sha256::transform(midstate, bytes.data(), 1);
+    unsigned char tail[64] = {0};
+    std::memcpy(tail, bytes.data() + 64, 16);
+    tail[16] = 0x80;
+    tail[62] = 0x02;
+    tail[63] = 0x80;
+    unsigned char digests[32 * sha256::MAX_HEADER_LANES];
+    uint32_t nonce = 0;
+    size_t lanes = sha256::header_lanes();
+    double per_call = measure([&] {
+        sha256::hash_headers(digests, midstate, tail, nonce);
+        nonce += (uint32_t)lanes;
+        do_not_optimize(digests[0]);
+    });
+    report("header hash_headers() per nonce", per_call / lanes, 80);
+
+    const size_t pairs = 1024;
+    Bytes level(64 * pairs), out(32 * pairs);
+    for (unsigned char& b : level) b = (unsigned char)rng();
+    double batch = measure([&] {
+        sha256::sha256d64(out.data(), level.data(), pairs);
+        do_not_optimize(out[0]);
+    });
+    report("merkle pair sha256d64() per pair", batch / pairs, 64);
+    return 0;
+}
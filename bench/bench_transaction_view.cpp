@@ -0,0 +1,103 @@
+// bench/bench_transaction_view.cpp
+//
+// Transaction codec throughput on a synthetic block: a mix of P2WPKH,
+// P2PKH and 2-of-3 multisig spends shaped like mainnet traffic.
+
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "crypto/hash.h"
+#include "crypto/sha256.h"
+#include "transaction/transaction_view.h"
+
+using namespace bitcoin;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+std::string random_string(std::mt19937_64& rng, size_t size) {
+    std::string out(size, '\0');
+    for (char& c : out) c = (char)rng();
+    return out;
+}
+
+Script random_script(std::mt19937_64& rng, size_t size) {
+    std::string bytes = random_string(rng, size);
+    const unsigned char* begin = (const unsigned char*)bytes.data();
+    return Script(begin, begin + size);
+}
+
+TransactionRef realistic_transaction(std::mt19937_64& rng) {
+    TransactionBuilder builder;
+    builder.set_version(2);
+    size_t kind = rng() % 10;               // 6 in 10 segwit, 3 legacy, 1 multisig
+    size_t input_count = 1 + rng() % 3;
+    for (size_t i = 0; i < input_count; i++) {
+        TransactionInput input(crypto::Hash::sha256(random_string(rng, 8)), (uint32_t)(rng() % 4), "");
+        input.sequence = 0xfffffffd;
+        if (kind < 6) {
+            input.witness = {random_string(rng, 72), random_string(rng, 33)};
+        } else if (kind < 9) {
+            input.script_sig = random_string(rng, 106);
+        } else {
+            input.witness = {"", random_string(rng, 72), random_string(rng, 72), random_string(rng, 105)};
+        }
+        builder.add_input(input);
+    }
+    for (size_t i = 0; i < 2; i++) builder.add_output(TransactionOutput(rng() % 100000000, random_script(rng, 22 + 3 * (kind >= 6))));
+    return std::move(builder).build();
+}
+
+} // namespace
+
+int main() {
+    crypto::sha256::auto_detect();
+    std::mt19937_64 rng(2010);
+    std::vector<TransactionRef> transactions;
+    Bytes block, bytes;
+    while (block.size() < 1500000) {
+        transactions.push_back(realistic_transaction(rng));
+        serialize_transaction(*transactions.back(), bytes);
+        block.insert(block.end(), bytes.begin(), bytes.end());
+    }
+    double mb = block.size() / 1e6;
+    std::printf("synthetic block: %zu transactions, %.2f MB\n", transactions.size(), mb);
+
+    TransactionView view;
+    double parse = measure([&] {
+        SpanReader reader(block);
+        while (!reader.empty()) view.parse(reader);
+        do_not_optimize(view.locktime);
+    });
+    std::printf("  TransactionView::parse      %8.0f MB/s\n", mb / parse);
+
+    double hash = measure([&] {
+        SpanReader reader(block);
+        while (!reader.empty()) {
+            view.parse(reader);
+            do_not_optimize(view.compute_txid());
+            do_not_optimize(view.compute_wtxid());
+        }
+    });
+    std::printf("  parse + txid/wtxid          %8.0f MB/s\n", mb / hash);
+
+    double decode = measure([&] {
+        SpanReader reader(block);
+        while (!reader.empty()) {
+            view.parse(reader);
+            do_not_optimize(view.to_transaction());
+        }
+    });
+    std::printf("  parse + to_transaction      %8.0f MB/s\n", mb / decode);
+
+    double encode = measure([&] {
+        for (const TransactionRef& tx : transactions) {
+            serialize_transaction(*tx, bytes);
+            do_not_optimize(bytes.data());
+        }
+    });
+    std::printf("  serialize_transaction       %8.0f MB/s\n", mb / encode);
+    return 0;
+}
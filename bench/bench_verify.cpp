@@ -0,0 +1,103 @@
+// bench/bench_verify.cpp
+//
+// Signature verifications per second. The per-call OpenSSL path
+// verify_signature() used to take is the baseline for the native
+// secp256k1 code, with fresh and cached public keys, and BIP340 one by one
+// against SchnorrBatch.
+
+// The EC_KEY API is deprecated in OpenSSL 3, but it's what the old path used
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/obj_mac.h>
+
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "crypto/hash.h"
+#include "crypto/hex.h"
+#include "crypto/keys.h"
+#include "crypto/sha256.h"
+
+using namespace crypto;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+// A new EC_KEY and a reparsed key for every signature, as before
+bool openssl_verify(const Bytes& pubkey, const Hash256& digest, const Bytes& der) {
+    EC_KEY* key = EC_KEY_new_by_curve_name(NID_secp256k1);
+    const unsigned char* p = pubkey.data();
+    bool ok = o2i_ECPublicKey(&key, &p, (long)pubkey.size()) != nullptr &&
+              ECDSA_verify(0, digest.data(), (int)digest.size(), der.data(), (int)der.size(), key) == 1;
+    EC_KEY_free(key);
+    return ok;
+}
+
+void report(const char* name, double seconds_per_verify) {
+    std::printf("  %-32s %9.0f /s\n", name, 1 / seconds_per_verify);
+}
+
+} // namespace
+
+int main() {
+    sha256::auto_detect();
+    std::mt19937_64 rng(2016);
+    const size_t count = 256;
+
+    std::vector<PublicKey> keys;
+    std::vector<XOnlyPublicKey> xonly_keys;
+    std::vector<Hash256> digests;
+    std::vector<Bytes> ecdsa, schnorr;
+    for (size_t i = 0; i < count; i++) {
+        Bytes secret(32);
+        for (unsigned char& b : secret) b = (unsigned char)rng();
+        secret[0] &= 0x7f;                  // below the group order
+        PrivateKey key(bytes_to_hex(secret));
+        Hash256 digest = Hash::sha256(secret.data(), secret.size());
+        keys.emplace_back(key);
+        xonly_keys.emplace_back(key);
+        digests.push_back(digest);
+        ecdsa.push_back(key.sign(digest));
+        schnorr.push_back(key.sign_schnorr(digest));
+    }
+
+    // Timing a path that rejects everything would be pointless
+    for (size_t k = 0; k < count; k++) {
+        if (!openssl_verify(keys[k].get_bytes(), digests[k], ecdsa[k]) || !keys[k].verify_digest(digests[k], ecdsa[k]) ||
+            !xonly_keys[k].verify_schnorr(digests[k], schnorr[k])) {
+            std::printf("signature %zu doesn't verify\n", k);
+            return 1;
+        }
+    }
+
+    std::printf("ECDSA verifications:\n");
+    size_t i = 0;
+    report("OpenSSL, EC_KEY per call", measure([&] {
+               i = (i + 1) % count;
+               do_not_optimize(openssl_verify(keys[i].get_bytes(), digests[i], ecdsa[i]));
+           }));
+    report("PublicKey decoded per call", measure([&] {
+               i = (i + 1) % count;
+               PublicKey fresh(std::span<const unsigned char>(keys[i].get_bytes()));
+               do_not_optimize(fresh.verify_digest(digests[i], ecdsa[i]));
+           }));
+    report("PublicKey, cached point", measure([&] {
+               i = (i + 1) % count;
+               do_not_optimize(keys[i].verify_digest(digests[i], ecdsa[i]));
+           }));
+
+    std::printf("BIP340 verifications:\n");
+    report("verify_schnorr() one by one", measure([&] {
+               i = (i + 1) % count;
+               do_not_optimize(xonly_keys[i].verify_schnorr(digests[i], schnorr[i]));
+           }));
+    SchnorrBatch batch;
+    report("SchnorrBatch of 256", measure([&] {
+               batch.clear();
+               for (size_t k = 0; k < count; k++) batch.add(xonly_keys[k], digests[k], schnorr[k]);
+               do_not_optimize(batch.verify());
+           }) / count);
+    return 0;
+}
@@ -1,85 +1,154 @@
 // src/blockchain/block.cpp
 #include "block.h"
+#include "../coins/coins.h"
 #include "../crypto/hash.h"
+#include "merkle.h"
+#include "pow.h"
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 #include <ctime>
+#include <cstring>
 
 namespace bitcoin
 {
 
-std::string BlockHeader::calculate_hash() const {
-    // In real Bitcoin, this serializes the 80-byte blcok header and double SHA256s it
-    std::stringstream header_data;
-    header_data << version << previous_block_hash << merkle_root
-                << timestamp << bits << nonce;
+crypto::Hash256 BlockHeader::calculate_hash() const {
+    // Double SHA256 of the packed 80-byte header
+    std::array<unsigned char, SERIALIZED_SIZE> bytes = to_bytes();
+    return crypto::Hash::double_sha256(bytes.data(), bytes.size());
+}
+
+std::array<unsigned char, BlockHeader::SERIALIZED_SIZE> BlockHeader::to_bytes() const {
+    // Tiny stream over the fixed buffer so the layout lives in serialize() only
+    struct FixedWriter {
+        unsigned char* pos;
+        void write(std::span<const unsigned char> data) {
+            std::memcpy(pos, data.data(), data.size());
+            pos += data.size();
+        }
+    };
 
-    std::string data = header_data.str();
-    return crypto::Hash::double_sha256(data);
+    std::array<unsigned char, SERIALIZED_SIZE> bytes;
+    FixedWriter writer{bytes.data()};
+    serialize(writer);
+    return bytes;
+}
+
+BlockHeader BlockHeader::from_bytes(const unsigned char* bytes) {
+    BlockHeader header;
+    header.version = read_le32(bytes);
+    header.previous_block_hash = crypto::Hash256(bytes + 4);
+    header.merkle_root = crypto::Hash256(bytes + 36);
+    header.timestamp = read_le32(bytes + TIMESTAMP_OFFSET);
+    header.bits = read_le32(bytes + 72);
+    header.nonce = read_le32(bytes + NONCE_OFFSET);
+    return header;
 }
 
 bool BlockHeader::has_valid_proof_of_work() const {
-    std::string block_hash = calculate_hash();
+    bool negative, overflow;
+    crypto::ArithUint256 target;
+    target.set_compact(bits, &negative, &overflow);
+    if (negative || overflow || target == crypto::ArithUint256(0)) {
+        return false;
+    }
 
-    // Very simple proof-of-work check: hash must start with at least one zero
-    // Real Bitcoin uses the 'bits' field to determine required difficulty
-    return block_hash.substr(0, 1) == "0";
+    // The hash, read as a little-endian number, must not exceed the target
+    return target.is_met_by(calculate_hash().data());
 }
 
-std::string BlockHeader::get_target() const {
-    // This is a simplified version. Real Bitcoin uses compact target format. 
-    // For now, just return a simple target based on bits value
-    std::stringstream target;
-    target << std::string(bits / 4, '0') << std::string(64 - bits / 4, 'f');
-    return target.str();
+crypto::ArithUint256 BlockHeader::get_target() const {
+    crypto::ArithUint256 target;
+    target.set_compact(bits);
+    return target;
 }
 
 void BlockHeader::print() const {
     std::cout << "Block Header:" << std::endl;
     std::cout << "  Version:           " << version << std::endl;
-    std::cout << "  Previous Hash:     " << previous_block_hash << std::endl;
-    std::cout << "  Merkle Root:       " << merkle_root << std::endl;
+    std::cout << "  Previous Hash:     " << previous_block_hash.to_hex() << std::endl;
+    std::cout << "  Merkle Root:       " << merkle_root.to_hex() << std::endl;
     
     // Convert timestamp to readable format
     std::time_t time = static_cast<std::time_t>(timestamp);
     std::cout << "  Timestamp:         " << timestamp << " (" << std::ctime(&time) << ")" << std::endl;
-    std::cout << "  Bits (Difficulty): " << bits << std::endl;
+    std::cout << "  Bits (Difficulty): 0x" << std::hex << std::setw(8) << std::setfill('0') << bits
+              << std::dec << std::setfill(' ') << " (" << get_difficulty(bits) << ")" << std::endl;
     std::cout << "  Nonce:             " << nonce << std::endl;
-    std::cout << "  Block Hash:        " << calculate_hash() << std::endl;
+    std::cout << "  Block Hash:        " << calculate_hash().to_hex() << std::endl;
     std::cout << "  Valid PoW:         " << (has_valid_proof_of_work() ? "Yes" : "No") << std::endl;
 }
 
-std::string Block::calculate_merkle_root() const {
-    if (transactions.empty()) {
-        return std::string(64, '0'); // All zeros if not transactions
+// Leaves of the merkle tree: every txid in block order (cached, so no rehashing)
+static std::vector<crypto::Hash256> collect_txids(const std::vector<TransactionRef>& transactions) {
+    std::vector<crypto::Hash256> txids;
+    txids.reserve(transactions.size());
+    for (const auto& tx : transactions) {
+        txids.push_back(tx->get_txid());
     }
+    return txids;
+}
 
-    // Simplified merkle root calculation
-    // Real Bitcoin builds a binary tree of transaction hashes
-    std::stringstream all_txids;
-    for (const auto& tx : transactions) {
-        all_txids << tx.calculate_txid();
+crypto::Hash256 Block::calculate_merkle_root(bool* mutated) const {
+    // Binary tree of transaction hashes - all zeros if no transactions
+    return compute_merkle_root(collect_txids(transactions), mutated);
+}
+
+bool Block::check_witness_commitment() const {
+    if (transactions.empty()) return false;
+    const Transaction& coinbase = *transactions[0];
+    const Script* commitment = nullptr;
+    for (const auto& output : coinbase.outputs) {
+        if (is_witness_commitment(output.script_pubkey.span())) commitment = &output.script_pubkey;
+    }
+    if (!commitment) {
+        for (const auto& tx : transactions) {
+            if (tx->has_witness()) return false;
+        }
+        return true;
+    }
+
+    // The coinbase's witness is the reserved value and nothing else
+    if (coinbase.inputs.size() != 1 || coinbase.inputs[0].witness.size() != 1 ||
+        coinbase.inputs[0].witness[0].size() != 32) {
+        return false;
     }
+    std::vector<crypto::Hash256> wtxids;
+    wtxids.reserve(transactions.size());
+    wtxids.emplace_back();      // the coinbase's counts as zero
+    for (size_t i = 1; i < transactions.size(); i++) wtxids.push_back(transactions[i]->get_wtxid());
+    const std::string& reserved = coinbase.inputs[0].witness[0];
+    return compute_witness_commitment(std::move(wtxids), std::span<const unsigned char>(
+                                          reinterpret_cast<const unsigned char*>(reserved.data()), reserved.size())) ==
+           crypto::Hash256(commitment->data() + WITNESS_COMMITMENT_HEADER);
+}
 
-    return crypto::Hash::double_sha256(all_txids.str());
+std::vector<crypto::Hash256> Block::get_merkle_branch(size_t index) const {
+    return compute_merkle_branch(collect_txids(transactions), index);
 }
 
 uint64_t Block::get_block_reward() const {
-    if (transactions.empty() || !transactions[0].is_coinbase()) {
+    if (transactions.empty() || !transactions[0]->is_coinbase()) {
         return 0;
     }
 
     // The coinbase transaction (first transaction) contains the block reward
-    return transactions[0].get_total_output_value();
+    return transactions[0]->get_total_output_value();
 }
 
-uint64_t Block::get_total_fees() const {
+uint64_t Block::get_total_fees(const BlockUndo& undo) const {
     uint64_t total_fees = 0;
 
-    // Skip coinbase transaction (index 0)
-    for (size_t i = 0; i < transactions.size(); ++i) {
-        total_fees += transactions[i].get_fee();
+    // Undo data has one entry per non-coinbase transaction, holding the coins it spent
+    size_t u = 0;
+    for (size_t i = 0; i < transactions.size() && u < undo.txs.size(); ++i) {
+        if (transactions[i]->is_coinbase()) continue;
+        uint64_t input_value = 0;
+        for (const Coin& coin : undo.txs[u++].spent) {
+            input_value += coin.out.value;
+        }
+        uint64_t output_value = transactions[i]->get_total_output_value();
+        if (input_value > output_value) total_fees += input_value - output_value;
     }
 
     return total_fees;
@@ -91,13 +160,13 @@ bool Block::validate_transactions() const {
     }
 
     // First transaction must be coinbase
-    if (!transactions[0].is_coinbase()) {
+    if (!transactions[0]->is_coinbase()) {
         return false;
     }
 
     // All other transactions must not be coinbase
     for (size_t i = 1; i < transactions.size(); ++i) {
-        if (transactions[i].is_coinbase()) {
+        if (transactions[i]->is_coinbase()) {
             return false;
         }
     }
@@ -108,7 +177,7 @@ bool Block::validate_transactions() const {
 
 bool Block::is_genesis_block() const {
     // Genesis block has previous hash of all zeros
-    return header.previous_block_hash == std::string(64, '0');
+    return header.previous_block_hash.is_null();
 }
 
 void Block::print() const {
@@ -117,14 +186,13 @@ void Block::print() const {
     std::cout << "\nBlock Details:" << std::endl;
     std::cout << "  Transaction Count: " << transactions.size() << std::endl;
     std::cout << "  Block Reward:      " << get_block_reward() << " satoshis" << std::endl;
-    std::cout << "  Total Fees:        " << get_total_fees() << " satoshis" << std::endl;
     std::cout << "  Is Genesis:        " << (is_genesis_block() ? "Yes" : "No") << std::endl;
     std::cout << "  Valid Transactions:" << (validate_transactions() ? "Yes" : "No") << std::endl;
     
     std::cout << "\nTransactions:" << std::endl;
     for (size_t i = 0; i < transactions.size(); ++i) {
         std::cout << "\n--- Transaction " << i << " ---" << std::endl;
-        transactions[i].print();
+        transactions[i]->print();
     }
     std::cout << "=============================================" << std::endl;
 }
@@ -1,12 +1,16 @@
 // src/blockchain/block.h
 #pragma once
+#include <array>
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "../crypto/arith_uint256.h"
 #include "../transaction/transaction.h"
 
 namespace bitcoin
 {
+struct BlockUndo;   // coins/coins.h
+
     /**
      * Bitcoin Block Structure
      * 
@@ -17,45 +21,86 @@ namespace bitcoin
 class BlockHeader {
 public:
     uint32_t version;                   // Block version number
-    std::string previous_block_hash;    // Hash of the previous block (64 hex)
-    std::string merkle_root;            // Merkle root of all transactions in this block
+    crypto::Hash256 previous_block_hash; // Hash of the previous block
+    crypto::Hash256 merkle_root;        // Merkle root of all transactions in this block
     uint32_t timestamp;                 // Unix timestamp when blcok was created
     uint32_t bits;                      // Difficulty target in compact format
     uint32_t nonce;                     // Proof-of-work nonce
 
+    // Packed layout: version(4) prev(32) merkle(32) time(4) bits(4) nonce(4), little endian
+    static constexpr size_t SERIALIZED_SIZE = 80;
+    static constexpr size_t TIMESTAMP_OFFSET = 68;
+    static constexpr size_t NONCE_OFFSET = 76;
+
     BlockHeader() : version(1), timestamp(0), bits(0), nonce(0) {}
 
     // Calculate the hash of this block header
-    std::string calculate_hash() const;
+    crypto::Hash256 calculate_hash() const;
+
+    // Write the 80-byte header in Bitcoin's raw format
+    template <typename Stream>
+    void serialize(Stream& s) const;
+
+    // The same 80 bytes as a fixed buffer (what miners actually hash)
+    std::array<unsigned char, SERIALIZED_SIZE> to_bytes() const;
+    static BlockHeader from_bytes(const unsigned char* bytes);
 
-    // Check if this block header has valid proof-of-work
+    // Check if the block hash meets the target encoded in `bits`
+    // (see pow.h for the full consensus check including the pow limit)
     bool has_valid_proof_of_work() const;
 
-    // Get difficulty target from bits field
-    std::string get_target() const;
+    // Decode the compact `bits` field into a 256-bit target
+    crypto::ArithUint256 get_target() const;
 
     // For debugging
     void print() const;
 };
 
+template <typename Stream>
+void BlockHeader::serialize(Stream& s) const {
+    write_le32(s, version);
+    write_bytes(s, previous_block_hash.data(), previous_block_hash.size());
+    write_bytes(s, merkle_root.data(), merkle_root.size());
+    write_le32(s, timestamp);
+    write_le32(s, bits);
+    write_le32(s, nonce);
+}
+
 class Block {
 public: 
     BlockHeader header;                     // Block header (80 bytes in real Bitcoin)
-    std::vector<Transaction> transactions;   // All transactions in this block
+    std::vector<TransactionRef> transactions; // All transactions in this block (shared, never copied)
 
     Block() {}
 
     // Calculate block hash (hash of the header)
-    std::string calculate_hash() const { return header.calculate_hash(); }
+    crypto::Hash256 calculate_hash() const { return header.calculate_hash(); }
+
+    // Header, transaction count, then every transaction (with witness data)
+    template <typename Stream>
+    void serialize(Stream& s) const {
+        header.serialize(s);
+        write_compact_size(s, transactions.size());
+        for (const auto& tx : transactions) tx->serialize(s);
+    }
 
     // Calculate merkle root of all transactions
-    std::string calculate_merkle_root() const;
+    // (`mutated` reports duplicate-transaction malleation, see merkle.h)
+    crypto::Hash256 calculate_merkle_root(bool* mutated = nullptr) const;
+
+    // Does the coinbase commit to every transaction's witness (BIP141)? A
+    // block without a witness commitment may carry no witness data at all.
+    bool check_witness_commitment() const;
+
+    // Merkle proof that transaction `index` is in this block (for SPV clients)
+    std::vector<crypto::Hash256> get_merkle_branch(size_t index) const;
 
     // Get total block reward (coinbase + fees)
     uint64_t get_block_reward() const;
 
-    // Get total transaction fees in this block
-    uint64_t get_total_fees() const;
+    // Get total transaction fees in this block, from the coins it spent
+    // (the undo data written by connect_block, see coins/coins.h)
+    uint64_t get_total_fees(const BlockUndo& undo) const;
 
     // Validate all transactions in this block
     bool validate_transactions() const;
@@ -0,0 +1,186 @@
+// src/blockchain/block_index.cpp
+#include "block_index.h"
+#include "pow.h"
+#include <algorithm>
+
+namespace bitcoin {
+
+static constexpr int MEDIAN_TIME_SPAN = 11;
+
+// Clear the lowest set bit
+static uint32_t invert_lowest_one(uint32_t n) { return n & (n - 1); }
+
+// Height the skip pointer at `height` points to (Bitcoin Core's choice: any
+// ancestor is reachable in O(log n) skips and parent steps)
+static uint32_t get_skip_height(uint32_t height) {
+    if (height < 2) return 0;
+    // Odd heights jump further back than even ones, so walks that alternate
+    // between them don't end up taking only short steps
+    return (height & 1) ? invert_lowest_one(invert_lowest_one(height - 1)) + 1 : invert_lowest_one(height);
+}
+
+BlockHeader BlockIndexEntry::get_header() const {
+    BlockHeader header;
+    header.version = version;
+    if (parent) header.previous_block_hash = parent->get_hash();
+    header.merkle_root = merkle_root;
+    header.timestamp = timestamp;
+    header.bits = bits;
+    header.nonce = nonce;
+    return header;
+}
+
+const BlockIndexEntry* BlockIndexEntry::get_ancestor(uint32_t target) const {
+    if (target > height) return nullptr;
+
+    const BlockIndexEntry* walk = this;
+    uint32_t walk_height = height;
+    while (walk_height > target) {
+        uint32_t skip_height = get_skip_height(walk_height);
+        uint32_t skip_height_prev = get_skip_height(walk_height - 1);
+        // Take the skip unless it overshoots, or the parent's skip gets
+        // there with a shorter overshoot
+        if (walk->skip && (skip_height == target ||
+                           (skip_height > target &&
+                            !(skip_height_prev + 2 < skip_height && skip_height_prev >= target)))) {
+            walk = walk->skip;
+            walk_height = skip_height;
+        } else {
+            walk = walk->parent;
+            walk_height--;
+        }
+    }
+    return walk;
+}
+
+BlockIndexEntry* BlockIndexEntry::get_ancestor(uint32_t target) {
+    return const_cast<BlockIndexEntry*>(static_cast<const BlockIndexEntry*>(this)->get_ancestor(target));
+}
+
+int64_t BlockIndexEntry::get_median_time_past() const {
+    int64_t times[MEDIAN_TIME_SPAN];
+    int count = 0;
+    for (const BlockIndexEntry* walk = this; walk && count < MEDIAN_TIME_SPAN; walk = walk->parent) {
+        times[count++] = walk->timestamp;
+    }
+    std::sort(times, times + count);
+    return times[count / 2];
+}
+
+const BlockIndexEntry* find_fork(const BlockIndexEntry* a, const BlockIndexEntry* b) {
+    if (!a || !b) return nullptr;
+    if (a->height > b->height) a = a->get_ancestor(b->height);
+    if (b->height > a->height) b = b->get_ancestor(a->height);
+
+    // Same height, so the skips land on the same height too: if they differ,
+    // the fork is further down and both can jump
+    while (a != b) {
+        if (a->skip != b->skip) {
+            a = a->skip;
+            b = b->skip;
+        } else {
+            a = a->parent;
+            b = b->parent;
+        }
+    }
+    return a;
+}
+
+std::vector<crypto::Hash256> get_locator(const BlockIndexEntry* entry) {
+    std::vector<crypto::Hash256> locator;
+    if (!entry) return locator;
+    locator.reserve(32);
+
+    uint32_t step = 1;
+    while (true) {
+        locator.push_back(entry->get_hash());
+        if (entry->height == 0) break;
+        entry = entry->get_ancestor(entry->height > step ? entry->height - step : 0);
+        if (locator.size() > 10) step *= 2;
+    }
+    return locator;
+}
+
+BlockIndexEntry* BlockIndex::add_header(const BlockHeader& header) {
+    crypto::Hash256 hash = header.calculate_hash();
+    auto known = entries.find(hash);
+    if (known != entries.end()) return &known->second;
+
+    // Only the first header may come without a parent
+    BlockIndexEntry* parent = nullptr;
+    if (!entries.empty()) {
+        auto it = entries.find(header.previous_block_hash);
+        if (it == entries.end()) return nullptr;
+        parent = &it->second;
+    }
+
+    auto [it, inserted] = entries.try_emplace(hash);
+    BlockIndexEntry& entry = it->second;
+    entry.hash = &it->first;
+    entry.parent = parent;
+    entry.height = parent ? parent->height + 1 : 0;
+    entry.skip = parent ? parent->get_ancestor(get_skip_height(entry.height)) : nullptr;
+    entry.chain_work = get_block_work(header.bits);
+    if (parent) entry.chain_work += parent->chain_work;
+    entry.status = BLOCK_VALID_HEADER | (parent ? parent->status & BLOCK_FAILED : 0);
+
+    entry.version = header.version;
+    entry.merkle_root = header.merkle_root;
+    entry.timestamp = header.timestamp;
+    entry.bits = header.bits;
+    entry.nonce = header.nonce;
+
+    update_best_header(&entry);
+    return &entry;
+}
+
+BlockIndexEntry* BlockIndex::lookup(const crypto::Hash256& hash) {
+    auto it = entries.find(hash);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+const BlockIndexEntry* BlockIndex::lookup(const crypto::Hash256& hash) const {
+    auto it = entries.find(hash);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+void BlockIndex::update_best_header(BlockIndexEntry* entry) {
+    if (entry->is_valid() && (!best_header || entry->chain_work > best_header->chain_work)) {
+        best_header = entry;
+    }
+}
+
+void BlockIndex::mark_failed(BlockIndexEntry* failed) {
+    failed->status |= BLOCK_FAILED;
+    for (auto& [hash, entry] : entries) {
+        if (entry.height > failed->height && entry.get_ancestor(failed->height) == failed) {
+            entry.status |= BLOCK_FAILED;
+        }
+    }
+
+    if (best_header && !best_header->is_valid()) {
+        best_header = nullptr;
+        for (auto& [hash, entry] : entries) update_best_header(&entry);
+    }
+}
+
+void Chain::set_tip(const BlockIndexEntry* entry) {
+    if (!entry) {
+        blocks.clear();
+        return;
+    }
+    // Rewrite heights from the new tip down to where the old chain agrees
+    blocks.resize(entry->height + 1);
+    while (entry && blocks[entry->height] != entry) {
+        blocks[entry->height] = entry;
+        entry = entry->parent;
+    }
+}
+
+const BlockIndexEntry* Chain::find_fork(const BlockIndexEntry* entry) const {
+    if (!entry || blocks.empty()) return nullptr;
+    if (contains(entry)) return entry;
+    return bitcoin::find_fork(tip(), entry);
+}
+
+} // namespace bitcoin
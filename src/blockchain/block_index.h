@@ -0,0 +1,147 @@
+// src/blockchain/block_index.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "block.h"
+#include "../crypto/arith_uint256.h"
+
+namespace bitcoin {
+
+// How far along a block is (flags, only ever raised - except FAILED)
+enum BlockStatus : uint32_t {
+    BLOCK_VALID_HEADER = 1 << 0,    // header checked and linked to its parent
+    BLOCK_HAVE_DATA = 1 << 1,       // full block stored
+    BLOCK_VALID_SCRIPTS = 1 << 2,   // connected once: every transaction checked
+    BLOCK_FAILED = 1 << 3,          // invalid, or descends from an invalid block
+};
+
+/**
+ * One header in the block tree
+ *
+ * Holds the header minus the previous hash (that's `parent`) plus what's
+ * derived from the chain below it: height and total work. `skip` points at
+ * an ancestor far below (chosen as in Bitcoin Core), so get_ancestor()
+ * takes O(log n) steps instead of walking every parent.
+ */
+struct BlockIndexEntry {
+    const crypto::Hash256* hash = nullptr;      // the key in BlockIndex, never moves
+    BlockIndexEntry* parent = nullptr;
+    BlockIndexEntry* skip = nullptr;
+    uint32_t height = 0;
+    uint32_t status = 0;
+    crypto::ArithUint256 chain_work;            // work of this block and all its ancestors
+
+    uint32_t version = 0;
+    crypto::Hash256 merkle_root;
+    uint32_t timestamp = 0;
+    uint32_t bits = 0;
+    uint32_t nonce = 0;
+
+    const crypto::Hash256& get_hash() const { return *hash; }
+    BlockHeader get_header() const;
+
+    bool is_valid() const { return (status & BLOCK_VALID_HEADER) && !(status & BLOCK_FAILED); }
+
+    // The ancestor at `height` (itself at its own height), nullptr above it
+    const BlockIndexEntry* get_ancestor(uint32_t height) const;
+    BlockIndexEntry* get_ancestor(uint32_t height);
+
+    // Median timestamp of this block and the ten before it (BIP113: the
+    // clock lock times and the next block's timestamp are checked against)
+    int64_t get_median_time_past() const;
+};
+
+// Highest block both `a` and `b` descend from (nullptr if they're in different trees)
+const BlockIndexEntry* find_fork(const BlockIndexEntry* a, const BlockIndexEntry* b);
+
+// Hashes to send a peer so it can find where our chains split: `entry` and
+// the eleven blocks below it, then doubling steps back, then the genesis block
+std::vector<crypto::Hash256> get_locator(const BlockIndexEntry* entry);
+
+/**
+ * Every header we know of, as a tree
+ *
+ * Keyed by block hash. Entries are never removed or moved, so pointers to
+ * them (parents, skips, Chain) stay valid for the index's lifetime.
+ *
+ * Not thread-safe: callers hold their chain state lock around it.
+ */
+class BlockIndex {
+private:
+    std::unordered_map<crypto::Hash256, BlockIndexEntry> entries;
+    BlockIndexEntry* best_header = nullptr;
+
+    void update_best_header(BlockIndexEntry* entry);
+
+public:
+    BlockIndex() = default;
+    BlockIndex(const BlockIndex&) = delete;
+    BlockIndex& operator=(const BlockIndex&) = delete;
+
+    /**
+     * Add a header whose parent is already known (or the genesis block, into
+     * an empty index) and mark it BLOCK_VALID_HEADER
+     *
+     * Checking proof of work and the rest of the header is up to the
+     * caller. Returns the existing entry if the header is known, nullptr
+     * if its parent isn't. Children of failed blocks are failed too.
+     */
+    BlockIndexEntry* add_header(const BlockHeader& header);
+
+    BlockIndexEntry* lookup(const crypto::Hash256& hash);
+    const BlockIndexEntry* lookup(const crypto::Hash256& hash) const;
+
+    // Raise status flags (BLOCK_FAILED goes through mark_failed)
+    void set_status(BlockIndexEntry* entry, uint32_t flags) { entry->status |= flags & ~BLOCK_FAILED; }
+
+    // Mark a block and all its descendants invalid. Walks the whole index,
+    // which is fine for something that happens once per bad block.
+    void mark_failed(BlockIndexEntry* entry);
+
+    // Valid header with the most work
+    const BlockIndexEntry* get_best_header() const { return best_header; }
+
+    size_t size() const { return entries.size(); }
+};
+
+/**
+ * One branch of the tree, from the genesis block to a tip, indexed by height
+ *
+ * Membership and height lookups are O(1). Moving the tip only rewrites the
+ * heights above the fork point.
+ */
+class Chain {
+private:
+    std::vector<const BlockIndexEntry*> blocks;
+
+public:
+    const BlockIndexEntry* genesis() const { return blocks.empty() ? nullptr : blocks.front(); }
+    const BlockIndexEntry* tip() const { return blocks.empty() ? nullptr : blocks.back(); }
+    int height() const { return (int)blocks.size() - 1; }      // -1 when empty
+
+    // nullptr past the tip
+    const BlockIndexEntry* operator[](uint32_t height) const {
+        return height < blocks.size() ? blocks[height] : nullptr;
+    }
+
+    bool contains(const BlockIndexEntry* entry) const {
+        return entry && (*this)[entry->height] == entry;
+    }
+
+    // The block after `entry` on this chain (nullptr at the tip or off the chain)
+    const BlockIndexEntry* next(const BlockIndexEntry* entry) const {
+        return contains(entry) ? (*this)[entry->height + 1] : nullptr;
+    }
+
+    // Make `entry` the tip (nullptr clears the chain)
+    void set_tip(const BlockIndexEntry* entry);
+
+    // Last block of this chain that `entry` descends from
+    const BlockIndexEntry* find_fork(const BlockIndexEntry* entry) const;
+
+    std::vector<crypto::Hash256> get_locator() const { return bitcoin::get_locator(tip()); }
+};
+
+} // namespace bitcoin
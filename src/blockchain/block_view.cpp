@@ -0,0 +1,94 @@
+// src/blockchain/block_view.cpp
+#include "block_view.h"
+#include "merkle.h"
+#include <cstring>
+
+namespace bitcoin {
+
+// Smallest transaction: version, one empty input, no outputs, locktime
+static constexpr size_t MIN_TRANSACTION_SIZE = 4 + 1 + 41 + 1 + 4;
+
+// The views take about as much memory again as the bytes they describe
+static size_t initial_arena_size(size_t block_size, bool copy_bytes) {
+    return (copy_bytes ? 2 : 1) * block_size + 4096;
+}
+
+BlockView::BlockView(ByteSpan bytes, bool copy_bytes)
+    : arena(initial_arena_size(bytes.size(), copy_bytes)), transactions(&arena) {
+    if (copy_bytes) {
+        unsigned char* copy = static_cast<unsigned char*>(arena.allocate(bytes.size(), 1));
+        std::memcpy(copy, bytes.data(), bytes.size());
+        raw = ByteSpan(copy, bytes.size());
+    } else {
+        raw = bytes;
+    }
+
+    SpanReader reader(raw);
+    header = BlockHeader::from_bytes(reader.read(BlockHeader::SERIALIZED_SIZE).data());
+
+    uint64_t count = read_compact_size(reader);
+    if (count > reader.remaining() / MIN_TRANSACTION_SIZE) {
+        throw DeserializeError("Transaction count exceeds block size");
+    }
+    // Reserved up front so views are never moved once parsed
+    transactions.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+        transactions.emplace_back(&arena).parse(reader);
+    }
+    if (!reader.empty()) throw DeserializeError("Trailing data after block");
+}
+
+std::vector<crypto::Hash256> BlockView::compute_txids() const {
+    std::vector<crypto::Hash256> txids;
+    txids.reserve(transactions.size());
+    for (const TransactionView& tx : transactions) {
+        txids.push_back(tx.compute_txid());
+    }
+    return txids;
+}
+
+crypto::Hash256 BlockView::compute_merkle_root(bool* mutated) const {
+    return bitcoin::compute_merkle_root(compute_txids(), mutated);
+}
+
+bool BlockView::check_merkle_root() const {
+    bool mutated = false;
+    return compute_merkle_root(&mutated) == header.merkle_root && !mutated;
+}
+
+bool BlockView::check_witness_commitment() const {
+    if (transactions.empty()) return false;
+    const TransactionView& coinbase = transactions[0];
+    ByteSpan commitment;
+    for (const OutputView& output : coinbase.outputs) {
+        if (is_witness_commitment(output.script_pubkey)) commitment = output.script_pubkey;
+    }
+    if (commitment.empty()) {
+        for (const TransactionView& tx : transactions) {
+            if (tx.has_witness()) return false;
+        }
+        return true;
+    }
+
+    if (coinbase.inputs.size() != 1 || coinbase.witness(0).size() != 1 || coinbase.witness(0)[0].size() != 32) {
+        return false;
+    }
+    std::vector<crypto::Hash256> wtxids;
+    wtxids.reserve(transactions.size());
+    wtxids.emplace_back();      // the coinbase's counts as zero
+    for (size_t i = 1; i < transactions.size(); i++) wtxids.push_back(transactions[i].compute_wtxid());
+    return compute_witness_commitment(std::move(wtxids), coinbase.witness(0)[0]) ==
+           crypto::Hash256(commitment.data() + WITNESS_COMMITMENT_HEADER);
+}
+
+Block BlockView::to_block() const {
+    Block block;
+    block.header = header;
+    block.transactions.reserve(transactions.size());
+    for (const TransactionView& tx : transactions) {
+        block.transactions.push_back(tx.to_transaction());
+    }
+    return block;
+}
+
+} // namespace bitcoin
@@ -0,0 +1,53 @@
+// src/blockchain/block_view.h
+#pragma once
+#include <memory_resource>
+#include <vector>
+#include "block.h"
+#include "../transaction/transaction_view.h"
+
+namespace bitcoin {
+
+/**
+ * Block decoded into a single arena
+ *
+ * The raw bytes, every TransactionView and all of their input, output and
+ * witness arrays live in one monotonic buffer owned by the view. Loading a
+ * block is a handful of large allocations instead of one per script, and
+ * dropping it frees everything at once. Scripts stay spans into the raw
+ * bytes, so hashing is the only real work left.
+ */
+class BlockView {
+private:
+    std::pmr::monotonic_buffer_resource arena;
+    ByteSpan raw;
+
+public:
+    BlockHeader header;
+    std::pmr::vector<TransactionView> transactions;
+
+    // Parse a serialized block (throws DeserializeError). With copy_bytes
+    // false the caller keeps `bytes` alive (e.g. a memory-mapped file).
+    explicit BlockView(ByteSpan bytes, bool copy_bytes = true);
+
+    // Views point into the arena - share the whole object instead of copying
+    BlockView(const BlockView&) = delete;
+    BlockView& operator=(const BlockView&) = delete;
+
+    ByteSpan get_raw() const { return raw; }
+
+    // Transaction ids hashed straight from the raw bytes
+    std::vector<crypto::Hash256> compute_txids() const;
+
+    crypto::Hash256 compute_merkle_root(bool* mutated = nullptr) const;
+
+    // Does the header commit to exactly these transactions?
+    bool check_merkle_root() const;
+
+    // Does the coinbase commit to the witness data (Block::check_witness_commitment())?
+    bool check_witness_commitment() const;
+
+    // Owning copy (allocates per script - only for blocks you keep around)
+    Block to_block() const;
+};
+
+} // namespace bitcoin
@@ -0,0 +1,183 @@
+// src/blockchain/merkle.cpp
+#include "merkle.h"
+#include "../crypto/sha256.h"
+#include <cstring>
+#include <thread>
+
+namespace bitcoin {
+
+// Levels smaller than this are faster on one thread than the thread start-up
+static constexpr size_t PARALLEL_MIN_PAIRS = 1 << 14;
+
+static_assert(sizeof(crypto::Hash256) == 32, "merkle levels hash Hash256 arrays as raw bytes");
+
+void hash_merkle_level(crypto::Hash256* out, const crypto::Hash256* in, size_t pairs) {
+    size_t threads = std::thread::hardware_concurrency();
+    if (pairs < PARALLEL_MIN_PAIRS || threads <= 1) {
+        crypto::sha256::sha256d64(out->data(), in->data(), pairs);
+        return;
+    }
+
+    // Contiguous chunks, rounded to 16 pairs so every thread fills whole SIMD batches
+    size_t chunk = ((pairs + threads - 1) / threads + 15) & ~(size_t)15;
+    std::vector<std::thread> workers;
+    for (size_t start = chunk; start < pairs; start += chunk) {
+        size_t count = pairs - start < chunk ? pairs - start : chunk;
+        workers.emplace_back([=] { crypto::sha256::sha256d64(out[start].data(), in[2 * start].data(), count); });
+    }
+    crypto::sha256::sha256d64(out->data(), in->data(), chunk < pairs ? chunk : pairs);
+    for (auto& worker : workers) worker.join();
+}
+
+crypto::Hash256 compute_merkle_root(std::vector<crypto::Hash256> leaves, bool* mutated) {
+    if (mutated) *mutated = false;
+    if (leaves.empty()) return crypto::Hash256();
+
+    std::vector<crypto::Hash256> next((leaves.size() + 1) / 2);
+    while (leaves.size() > 1) {
+        if (mutated) {
+            for (size_t i = 0; i + 1 < leaves.size(); i += 2) {
+                if (leaves[i] == leaves[i + 1]) *mutated = true;
+            }
+        }
+        // Odd level: pair the last hash with itself
+        if (leaves.size() & 1) leaves.push_back(leaves.back());
+
+        size_t pairs = leaves.size() / 2;
+        next.resize(pairs);
+        hash_merkle_level(next.data(), leaves.data(), pairs);
+        leaves.swap(next);
+    }
+    return leaves[0];
+}
+
+bool is_witness_commitment(std::span<const unsigned char> script) {
+    static constexpr unsigned char HEADER[WITNESS_COMMITMENT_HEADER] = {0x6a, 0x24, 0xaa, 0x21, 0xa9, 0xed};
+    return script.size() >= WITNESS_COMMITMENT_HEADER + 32 &&
+           std::memcmp(script.data(), HEADER, WITNESS_COMMITMENT_HEADER) == 0;
+}
+
+crypto::Hash256 compute_witness_commitment(std::vector<crypto::Hash256> wtxids,
+                                           std::span<const unsigned char> reserved_value) {
+    if (!wtxids.empty()) wtxids[0] = crypto::Hash256();
+    crypto::Hash256 in[2] = {compute_merkle_root(std::move(wtxids)), crypto::Hash256(reserved_value.data())};
+    crypto::Hash256 commitment;
+    hash_merkle_level(&commitment, in, 1);
+    return commitment;
+}
+
+std::vector<crypto::Hash256> compute_merkle_branch(const std::vector<crypto::Hash256>& leaves, size_t index) {
+    std::vector<crypto::Hash256> branch;
+    if (index >= leaves.size()) return branch;
+
+    std::vector<crypto::Hash256> level = leaves;
+    std::vector<crypto::Hash256> next;
+    while (level.size() > 1) {
+        if (level.size() & 1) level.push_back(level.back());
+        branch.push_back(level[index ^ 1]);
+
+        size_t pairs = level.size() / 2;
+        next.resize(pairs);
+        hash_merkle_level(next.data(), level.data(), pairs);
+        level.swap(next);
+        index >>= 1;
+    }
+    return branch;
+}
+
+crypto::Hash256 compute_root_from_branch(const crypto::Hash256& leaf, const std::vector<crypto::Hash256>& branch,
+                                         size_t index) {
+    crypto::Hash256 pair[2];
+    crypto::Hash256 hash = leaf;
+    for (const auto& sibling : branch) {
+        // Our position's low bit says whether we are the left or right child
+        pair[index & 1] = hash;
+        pair[(index & 1) ^ 1] = sibling;
+        crypto::sha256::sha256d64(hash.data(), pair[0].data(), 1);
+        index >>= 1;
+    }
+    return hash;
+}
+
+bool verify_merkle_branch(const crypto::Hash256& leaf, const std::vector<crypto::Hash256>& branch, size_t index,
+                          const crypto::Hash256& root) {
+    // The index must fit in a tree of this height
+    if (branch.size() < sizeof(size_t) * 8 && (index >> branch.size()) != 0) return false;
+    return compute_root_from_branch(leaf, branch, index) == root;
+}
+
+MerkleTree::MerkleTree(std::vector<crypto::Hash256> leaves) {
+    if (leaves.empty()) return;
+    levels.push_back(std::move(leaves));
+    rehash(0, levels[0].size() - 1);
+}
+
+crypto::Hash256 MerkleTree::root() const {
+    return levels.empty() ? crypto::Hash256() : levels.back()[0];
+}
+
+void MerkleTree::append(const crypto::Hash256& leaf) {
+    if (levels.empty()) levels.emplace_back();
+    levels[0].push_back(leaf);
+    rehash(levels[0].size() - 1, levels[0].size() - 1);
+}
+
+void MerkleTree::replace(size_t index, const crypto::Hash256& leaf) {
+    levels[0][index] = leaf;
+    rehash(index, index);
+}
+
+void MerkleTree::remove(size_t index) {
+    levels[0].erase(levels[0].begin() + index);
+    if (levels[0].empty()) {
+        levels.clear();
+        return;
+    }
+    // Removing the last leaf only changes its old parent's pairing
+    size_t first = index < levels[0].size() ? index : levels[0].size() - 1;
+    rehash(first, levels[0].size() - 1);
+}
+
+void MerkleTree::rehash(size_t first, size_t last) {
+    std::vector<crypto::Hash256> pairs;
+    size_t k = 0;
+    while (levels[k].size() > 1) {
+        if (levels.size() == k + 1) levels.emplace_back();
+        const std::vector<crypto::Hash256>& level = levels[k];
+        size_t parent_count = (level.size() + 1) / 2;
+        levels[k + 1].resize(parent_count);
+
+        // Parents of the changed range, pairing an odd last node with itself
+        size_t parent_first = first / 2;
+        size_t parent_last = last / 2 < parent_count ? last / 2 : parent_count - 1;
+        size_t count = parent_last - parent_first + 1;
+        pairs.resize(2 * count);
+        for (size_t p = parent_first; p <= parent_last; p++) {
+            size_t left = 2 * p;
+            size_t right = left + 1 < level.size() ? left + 1 : left;
+            pairs[2 * (p - parent_first)] = level[left];
+            pairs[2 * (p - parent_first) + 1] = level[right];
+        }
+        hash_merkle_level(&levels[k + 1][parent_first], pairs.data(), count);
+
+        first = parent_first;
+        last = parent_last;
+        k++;
+    }
+    // Drop levels left over from a bigger tree
+    levels.resize(k + 1);
+}
+
+std::vector<crypto::Hash256> MerkleTree::branch(size_t index) const {
+    std::vector<crypto::Hash256> result;
+    if (index >= size()) return result;
+
+    for (size_t k = 0; k + 1 < levels.size(); k++) {
+        size_t sibling = index ^ 1;
+        result.push_back(sibling < levels[k].size() ? levels[k][sibling] : levels[k][index]);
+        index >>= 1;
+    }
+    return result;
+}
+
+} // namespace bitcoin
@@ -0,0 +1,90 @@
+// src/blockchain/merkle.h
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "../crypto/uint256.h"
+
+namespace bitcoin {
+
+/**
+ * Bitcoin merkle tree
+ *
+ * Leaves (txids) are hashed pairwise with double SHA256 until one hash is
+ * left. A level with an odd number of nodes pairs its last node with itself.
+ * Whole levels go through sha256d64() in one batch so SIMD lanes stay full,
+ * and very large levels are split across threads.
+ *
+ * A merkle branch is the list of sibling hashes from a leaf up to the root -
+ * enough for an SPV client to check that a transaction is in a block.
+ */
+
+// Root of the tree over `leaves` (all zeros if empty). `mutated` is set if
+// two identical hashes were paired, which lets an attacker produce another
+// transaction list with the same root (CVE-2012-2459).
+crypto::Hash256 compute_merkle_root(std::vector<crypto::Hash256> leaves, bool* mutated = nullptr);
+
+// Sibling hashes from leaf `index` up to (not including) the root
+std::vector<crypto::Hash256> compute_merkle_branch(const std::vector<crypto::Hash256>& leaves, size_t index);
+
+// Fold a branch back up to the root it commits to
+crypto::Hash256 compute_root_from_branch(const crypto::Hash256& leaf, const std::vector<crypto::Hash256>& branch,
+                                         size_t index);
+
+// SPV check: is `leaf` at position `index` under `root`?
+bool verify_merkle_branch(const crypto::Hash256& leaf, const std::vector<crypto::Hash256>& branch, size_t index,
+                          const crypto::Hash256& root);
+
+// Hash one level in place of the next: out[i] = SHA256d(in[2i] || in[2i+1]).
+// `in` must hold 2 * pairs hashes; `out` must not overlap it.
+void hash_merkle_level(crypto::Hash256* out, const crypto::Hash256* in, size_t pairs);
+
+// BIP141 witness commitment: a coinbase output script of OP_RETURN, a 36
+// byte push and the tag aa21a9ed, then the commitment hash (more bytes may
+// follow). If several outputs match, the last one counts.
+static constexpr size_t WITNESS_COMMITMENT_HEADER = 6;
+bool is_witness_commitment(std::span<const unsigned char> script);
+
+// The hash a witness commitment holds: SHA256d(root of the wtxid tree ||
+// the coinbase's 32 byte witness reserved value). The coinbase's own wtxid
+// (wtxids[0]) is replaced by zeros.
+crypto::Hash256 compute_witness_commitment(std::vector<crypto::Hash256> wtxids,
+                                           std::span<const unsigned char> reserved_value);
+
+/**
+ * Merkle tree that keeps every interior node
+ *
+ * Changing one leaf only rehashes the path above it - O(log n) hashes
+ * instead of rebuilding the whole tree. That is what block templates need:
+ * transactions get appended, and the coinbase changes on every extranonce.
+ */
+class MerkleTree {
+private:
+    // levels[0] = leaves, levels.back() = { root } (empty tree: no levels)
+    std::vector<std::vector<crypto::Hash256>> levels;
+
+    // Rehash parents of leaves first..last (inclusive) up to the root
+    void rehash(size_t first, size_t last);
+
+public:
+    MerkleTree() {}
+    explicit MerkleTree(std::vector<crypto::Hash256> leaves);
+
+    size_t size() const { return levels.empty() ? 0 : levels[0].size(); }
+    const crypto::Hash256& leaf(size_t index) const { return levels[0][index]; }
+
+    // Root (all zeros if empty)
+    crypto::Hash256 root() const;
+
+    // O(log n) hashes
+    void append(const crypto::Hash256& leaf);
+    void replace(size_t index, const crypto::Hash256& leaf);
+
+    // Everything to the right of `index` shifts, so this rehashes O(n - index)
+    void remove(size_t index);
+
+    // Branch from cached nodes - no hashing at all
+    std::vector<crypto::Hash256> branch(size_t index) const;
+};
+
+} // namespace bitcoin
@@ -0,0 +1,95 @@
+// src/blockchain/pow.cpp
+#include "pow.h"
+
+namespace bitcoin {
+
+ConsensusParams ConsensusParams::mainnet() {
+    ConsensusParams params;
+    params.genesis_hash = crypto::Hash256::from_hex("000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f");
+    params.pow_limit = crypto::ArithUint256::from_hash(
+        crypto::Hash256::from_hex("00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+    return params;
+}
+
+ConsensusParams ConsensusParams::regtest() {
+    ConsensusParams params;
+    params.genesis_hash = crypto::Hash256::from_hex("0f9188f13cb7b2c71f2a335e3a4fc328bf5beb436012afca590b1a11466e2206");
+    params.pow_limit = crypto::ArithUint256::from_hash(
+        crypto::Hash256::from_hex("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+    params.no_retargeting = true;
+    params.subsidy_halving_interval = 150;
+    return params;
+}
+
+bool decode_target(uint32_t bits, const ConsensusParams& params, crypto::ArithUint256& target) {
+    bool negative, overflow;
+    target.set_compact(bits, &negative, &overflow);
+    return !negative && !overflow && target != crypto::ArithUint256(0) && target <= params.pow_limit;
+}
+
+bool check_proof_of_work(const crypto::Hash256& hash, uint32_t bits, const ConsensusParams& params) {
+    crypto::ArithUint256 target;
+    if (!decode_target(bits, params, target)) return false;
+    return target.is_met_by(hash.data());
+}
+
+uint32_t get_next_work_required(uint32_t height, uint32_t last_bits, int64_t first_block_time,
+                                int64_t last_block_time, const ConsensusParams& params) {
+    if (params.no_retargeting || height % params.retarget_interval() != 0) {
+        return last_bits;
+    }
+    return calculate_next_work_required(last_bits, first_block_time, last_block_time, params);
+}
+
+uint32_t calculate_next_work_required(uint32_t last_bits, int64_t first_block_time,
+                                      int64_t last_block_time, const ConsensusParams& params) {
+    // Limit the adjustment step
+    int64_t actual_timespan = last_block_time - first_block_time;
+    if (actual_timespan < params.target_timespan / 4) actual_timespan = params.target_timespan / 4;
+    if (actual_timespan > params.target_timespan * 4) actual_timespan = params.target_timespan * 4;
+
+    crypto::ArithUint256 target;
+    target.set_compact(last_bits);
+
+    // target * actual / expected, scaled down first if the product could overflow
+    crypto::ArithUint256 limit = params.pow_limit;
+    bool shifted = target.bits() > 256 - 32;
+    if (shifted) {
+        target >>= 32;
+        limit >>= 32;
+    }
+    target *= (uint32_t)actual_timespan;
+    target /= crypto::ArithUint256((uint64_t)params.target_timespan);
+    if (target > limit) target = limit;
+    if (shifted) target <<= 32;
+
+    return target.get_compact();
+}
+
+crypto::ArithUint256 get_block_work(uint32_t bits) {
+    bool negative, overflow;
+    crypto::ArithUint256 target;
+    target.set_compact(bits, &negative, &overflow);
+    if (negative || overflow || target == crypto::ArithUint256(0)) return crypto::ArithUint256(0);
+    // 2^256 doesn't fit, but it's (2^256 - target - 1) / (target + 1) + 1
+    return (~target / (target + crypto::ArithUint256(1))) + crypto::ArithUint256(1);
+}
+
+double get_difficulty(uint32_t bits) {
+    // difficulty = genesis target / current target, computed from the compact form
+    if ((bits & 0x00ffffff) == 0) return 0.0;
+
+    int shift = (bits >> 24) & 0xff;
+    double difficulty = (double)0x0000ffff / (double)(bits & 0x00ffffff);
+    while (shift < 29) {
+        difficulty *= 256.0;
+        shift++;
+    }
+    while (shift > 29) {
+        difficulty /= 256.0;
+        shift--;
+    }
+    return difficulty;
+}
+
+} // namespace bitcoin
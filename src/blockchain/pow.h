@@ -0,0 +1,54 @@
+// src/blockchain/pow.h
+#pragma once
+#include <cstdint>
+#include "../crypto/arith_uint256.h"
+
+namespace bitcoin {
+
+/**
+ * Proof-of-work consensus parameters
+ *
+ * Difficulty is retargeted every retarget_interval() blocks so that blocks
+ * keep arriving every target_spacing seconds on average.
+ */
+struct ConsensusParams {
+    crypto::Hash256 genesis_hash;           // the only header allowed without a parent
+    crypto::ArithUint256 pow_limit;         // easiest allowed target
+    int64_t target_timespan = 14 * 24 * 60 * 60; // two weeks
+    int64_t target_spacing = 10 * 60;       // ten minutes
+    bool no_retargeting = false;            // regtest keeps difficulty fixed
+    uint32_t subsidy_halving_interval = 210000;
+
+    int64_t retarget_interval() const { return target_timespan / target_spacing; } // 2016
+
+    static ConsensusParams mainnet();
+    static ConsensusParams regtest();
+};
+
+// Decode nBits into a target, rejecting negative, zero, overflowing and
+// too-easy (above pow_limit) values. Returns false for an invalid nBits.
+bool decode_target(uint32_t bits, const ConsensusParams& params, crypto::ArithUint256& target);
+
+// Does this block hash satisfy the nBits difficulty?
+bool check_proof_of_work(const crypto::Hash256& hash, uint32_t bits, const ConsensusParams& params);
+
+// nBits for the block at `height`, given the previous block's nBits and the
+// timestamps of the first and last block of the period that just ended.
+// Only changes on retarget boundaries (height % retarget_interval() == 0).
+uint32_t get_next_work_required(uint32_t height, uint32_t last_bits, int64_t first_block_time,
+                                int64_t last_block_time, const ConsensusParams& params);
+
+// The retarget formula itself: scale the old target by actual/expected time,
+// limited to a factor of 4 either way and never easier than pow_limit
+uint32_t calculate_next_work_required(uint32_t last_bits, int64_t first_block_time,
+                                      int64_t last_block_time, const ConsensusParams& params);
+
+// Expected number of hashes to find a block at this nBits: 2^256 / (target + 1).
+// Summed along a chain it's the chain work that picks the best chain. 0 for an
+// invalid nBits.
+crypto::ArithUint256 get_block_work(uint32_t bits);
+
+// Human friendly difficulty (1.0 = the genesis block target)
+double get_difficulty(uint32_t bits);
+
+} // namespace bitcoin
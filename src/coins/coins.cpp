@@ -0,0 +1,205 @@
+// src/coins/coins.cpp
+#include "coins.h"
+#include "../blockchain/block.h"
+#include <random>
+#include <stdexcept>
+
+namespace bitcoin {
+
+// Final mixer from MurmurHash3 - spreads every input bit over the output
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+SaltedOutPointHasher::SaltedOutPointHasher() {
+    std::random_device rd;
+    k0 = ((uint64_t)rd() << 32) | rd();
+    k1 = ((uint64_t)rd() << 32) | rd();
+}
+
+size_t SaltedOutPointHasher::operator()(const OutPoint& outpoint) const noexcept {
+    uint64_t a = outpoint.txid.get_uint64(0) ^ k0;
+    uint64_t b = outpoint.txid.get_uint64(1) ^ k1;
+    return mix64(a ^ mix64(b + outpoint.vout));
+}
+
+uint64_t compress_amount(uint64_t amount) {
+    if (amount == 0) return 0;
+    int exponent = 0;
+    while (amount % 10 == 0 && exponent < 9) {
+        amount /= 10;
+        exponent++;
+    }
+    if (exponent < 9) {
+        uint64_t last_digit = amount % 10;    // 1..9
+        amount /= 10;
+        return 1 + (amount * 9 + last_digit - 1) * 10 + exponent;
+    }
+    return 1 + (amount - 1) * 10 + 9;
+}
+
+uint64_t decompress_amount(uint64_t compressed) {
+    if (compressed == 0) return 0;
+    compressed--;
+    int exponent = compressed % 10;
+    compressed /= 10;
+    uint64_t amount;
+    if (exponent < 9) {
+        uint64_t last_digit = compressed % 9 + 1;
+        compressed /= 9;
+        amount = compressed * 10 + last_digit;
+    } else {
+        amount = compressed + 1;
+    }
+    while (exponent--) amount *= 10;
+    return amount;
+}
+
+Coin deserialize_coin(SpanReader& reader) {
+    uint64_t code = read_varint(reader);
+    if (code >> 32) throw DeserializeError("Coin height out of range");
+    uint64_t value = decompress_amount(read_varint(reader));
+    Script script = decompress_script(reader);
+    return Coin(TransactionOutput(value, std::move(script)), (uint32_t)(code >> 1), code & 1);
+}
+
+BlockUndo BlockUndo::deserialize(SpanReader& reader) {
+    BlockUndo undo;
+    uint64_t tx_count = read_compact_size(reader);
+    // Each entry is at least one byte - don't trust the count further than that
+    if (tx_count > reader.remaining()) throw DeserializeError("Undo count exceeds data");
+    undo.txs.resize(tx_count);
+    for (TxUndo& tx : undo.txs) {
+        uint64_t coin_count = read_compact_size(reader);
+        if (coin_count > reader.remaining()) throw DeserializeError("Undo count exceeds data");
+        tx.spent.reserve(coin_count);
+        for (uint64_t i = 0; i < coin_count; i++) {
+            tx.spent.push_back(deserialize_coin(reader));
+        }
+    }
+    return undo;
+}
+
+void add_coins(MutableCoinsView& view, const Transaction& tx, uint32_t height, bool possible_overwrite) {
+    bool coinbase = tx.is_coinbase();
+    const crypto::Hash256& txid = tx.get_txid();
+    for (size_t i = 0; i < tx.outputs.size(); i++) {
+        if (tx.outputs[i].script_pubkey.is_unspendable()) continue;
+        view.add_coin(OutPoint(txid, (uint32_t)i), Coin(tx.outputs[i], height, coinbase), possible_overwrite);
+    }
+}
+
+// Undo one transaction: remove its outputs, then restore what it spent
+static bool disconnect_transaction(MutableCoinsView& view, const Transaction& tx, const TxUndo* undo) {
+    bool clean = true;
+    const crypto::Hash256& txid = tx.get_txid();
+    for (size_t i = 0; i < tx.outputs.size(); i++) {
+        if (tx.outputs[i].script_pubkey.is_unspendable()) continue;
+        if (!view.spend_coin(OutPoint(txid, (uint32_t)i))) clean = false;
+    }
+    if (!undo) return clean;
+
+    for (size_t i = undo->spent.size(); i-- > 0;) {
+        OutPoint prevout(tx.inputs[i]);
+        if (view.have_coin(prevout)) clean = false;
+        view.add_coin(prevout, undo->spent[i], true);
+    }
+    return clean;
+}
+
+// Undo the first `count` transactions of a partially connected block
+static void roll_back(MutableCoinsView& view, const Block& block, size_t count, BlockUndo& undo) {
+    for (size_t t = count; t-- > 0;) {
+        const Transaction& tx = *block.transactions[t];
+        disconnect_transaction(view, tx, tx.is_coinbase() ? nullptr : &undo.txs.back());
+        if (!tx.is_coinbase()) undo.txs.pop_back();
+    }
+}
+
+bool connect_block(MutableCoinsView& view, const Block& block, uint32_t height, BlockUndo& undo, uint64_t* fees) {
+    undo.txs.clear();
+    undo.txs.reserve(block.transactions.empty() ? 0 : block.transactions.size() - 1);
+    uint64_t total_fees = 0;
+
+    for (size_t t = 0; t < block.transactions.size(); t++) {
+        const Transaction& tx = *block.transactions[t];
+        uint64_t output_value = 0;
+        bool valid = tx.get_output_value_checked(output_value);
+
+        if (valid && !tx.is_coinbase()) {
+            TxUndo& tx_undo = undo.txs.emplace_back();
+            tx_undo.spent.reserve(tx.inputs.size());
+            uint64_t input_value = 0;
+
+            for (const TransactionInput& input : tx.inputs) {
+                Coin coin;
+                if (!view.spend_coin(OutPoint(input), &coin)) {
+                    valid = false;
+                    break;
+                }
+                // Coinbase outputs can't be spent until COINBASE_MATURITY blocks later
+                bool immature = coin.coinbase && height - coin.height < Coin::COINBASE_MATURITY;
+                input_value += coin.out.value;
+                tx_undo.spent.push_back(std::move(coin));
+                if (immature || !money_range(tx_undo.spent.back().out.value) || !money_range(input_value)) {
+                    valid = false;
+                    break;
+                }
+            }
+
+            // Missing, immature or out of range input, or a transaction creating
+            // money: put everything back
+            if (!valid || output_value > input_value) {
+                for (size_t i = tx_undo.spent.size(); i-- > 0;) {
+                    view.add_coin(OutPoint(tx.inputs[i]), std::move(tx_undo.spent[i]), true);
+                }
+                undo.txs.pop_back();
+                valid = false;
+            } else {
+                total_fees += input_value - output_value;
+            }
+        }
+        // BIP30: a coinbase can't replace unspent outputs of an earlier one
+        // with the same txid. Any other transaction's txid is new, as it
+        // spends outputs nothing before it could have.
+        if (valid && tx.is_coinbase()) {
+            const crypto::Hash256& txid = tx.get_txid();
+            for (uint32_t i = 0; i < tx.outputs.size() && valid; i++) valid = !view.have_coin(OutPoint(txid, i));
+        }
+        if (!valid) {
+            roll_back(view, block, t, undo);
+            return false;
+        }
+
+        add_coins(view, tx, height);
+    }
+
+    if (fees) *fees = total_fees;
+    return true;
+}
+
+bool disconnect_block(MutableCoinsView& view, const Block& block, const BlockUndo& undo) {
+    // Check the undo data fits the block before touching the view
+    size_t u = 0;
+    for (const auto& tx : block.transactions) {
+        if (tx->is_coinbase()) continue;
+        if (u >= undo.txs.size() || undo.txs[u].spent.size() != tx->inputs.size()) return false;
+        u++;
+    }
+    if (u != undo.txs.size()) return false;
+
+    bool clean = true;
+    for (size_t t = block.transactions.size(); t-- > 0;) {
+        const Transaction& tx = *block.transactions[t];
+        const TxUndo* tx_undo = tx.is_coinbase() ? nullptr : &undo.txs[--u];
+        if (!disconnect_transaction(view, tx, tx_undo)) clean = false;
+    }
+    return clean;
+}
+
+} // namespace bitcoin
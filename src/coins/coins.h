@@ -0,0 +1,138 @@
+// src/coins/coins.h
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../crypto/uint256.h"
+#include "../transaction/transaction.h"
+#include "../util/serialize.h"
+
+namespace bitcoin {
+
+class Block;
+
+// Reference to one output of a transaction (what an input spends)
+struct OutPoint {
+    crypto::Hash256 txid;
+    uint32_t vout = 0;
+
+    OutPoint() {}
+    OutPoint(const crypto::Hash256& hash, uint32_t index) : txid(hash), vout(index) {}
+    explicit OutPoint(const TransactionInput& input) : txid(input.previous_txid), vout(input.vout) {}
+
+    friend bool operator==(const OutPoint& a, const OutPoint& b) { return a.vout == b.vout && a.txid == b.txid; }
+    friend bool operator!=(const OutPoint& a, const OutPoint& b) { return !(a == b); }
+};
+
+// Outpoint hash for hash tables. txids are already hashes, but a random
+// per-instance salt keeps peers from choosing them to collide.
+class SaltedOutPointHasher {
+private:
+    uint64_t k0, k1;
+
+public:
+    SaltedOutPointHasher();
+    size_t operator()(const OutPoint& outpoint) const noexcept;
+};
+
+/**
+ * An unspent transaction output
+ *
+ * The output itself plus where it was created: coinbase outputs can only be
+ * spent after COINBASE_MATURITY blocks. 64 bytes - one cache line.
+ */
+struct Coin {
+    TransactionOutput out;
+    uint32_t height : 31;
+    uint32_t coinbase : 1;
+
+    static constexpr uint32_t COINBASE_MATURITY = 100;
+
+    Coin() : height(0), coinbase(0) {}
+    Coin(TransactionOutput output, uint32_t created_height, bool is_coinbase)
+        : out(std::move(output)), height(created_height), coinbase(is_coinbase) {}
+};
+
+// Satoshi amounts with trailing zeros squeezed out (Bitcoin Core's
+// CompressAmount): 50 BTC becomes a single byte as a VARINT
+uint64_t compress_amount(uint64_t amount);
+uint64_t decompress_amount(uint64_t compressed);
+
+// Storage form of a coin: VARINT(height * 2 + coinbase), VARINT(compressed
+// amount), compressed script. Shared by undo records and the coins database.
+template <typename Stream>
+void serialize_coin(Stream& s, const Coin& coin) {
+    write_varint(s, (uint64_t)coin.height * 2 + coin.coinbase);
+    write_varint(s, compress_amount(coin.out.value));
+    compress_script(s, coin.out.script_pubkey);
+}
+
+Coin deserialize_coin(SpanReader& reader);
+
+/**
+ * Undo data for one block
+ *
+ * connect_block() moves every coin the block spends in here, one list per
+ * non-coinbase transaction in input order. disconnect_block() puts them back.
+ */
+struct TxUndo {
+    std::vector<Coin> spent;
+};
+
+struct BlockUndo {
+    std::vector<TxUndo> txs;
+
+    template <typename Stream>
+    void serialize(Stream& s) const {
+        write_compact_size(s, txs.size());
+        for (const TxUndo& tx : txs) {
+            write_compact_size(s, tx.spent.size());
+            for (const Coin& coin : tx.spent) serialize_coin(s, coin);
+        }
+    }
+
+    // Throws DeserializeError on malformed data
+    static BlockUndo deserialize(SpanReader& reader);
+};
+
+// Read access to a set of coins (in-memory set, cache, database...)
+class CoinsView {
+public:
+    virtual ~CoinsView() {}
+
+    // Copy the unspent coin at `outpoint` into `coin`; false if there is none
+    virtual bool get_coin(const OutPoint& outpoint, Coin& coin) const = 0;
+
+    virtual bool have_coin(const OutPoint& outpoint) const {
+        Coin coin;
+        return get_coin(outpoint, coin);
+    }
+};
+
+// A view that blocks can be connected to and disconnected from
+class MutableCoinsView : public CoinsView {
+public:
+    // Throws std::logic_error if an unspent coin is already there, unless
+    // `possible_overwrite` (the two historic duplicate coinbases, BIP30)
+    virtual void add_coin(const OutPoint& outpoint, Coin coin, bool possible_overwrite = false) = 0;
+
+    // Remove a coin, moving it into `moved` if given; false if it is not there
+    virtual bool spend_coin(const OutPoint& outpoint, Coin* moved = nullptr) = 0;
+};
+
+// Add every spendable output of `tx` as a coin created at `height`
+void add_coins(MutableCoinsView& view, const Transaction& tx, uint32_t height, bool possible_overwrite = false);
+
+// Spend the block's inputs and add its outputs, recording the spent coins in
+// `undo` and the fees collected in `fees` (if given). If an input is missing
+// or an immature coinbase, a value or sum is outside MAX_MONEY, a
+// transaction spends more than its inputs, or a coinbase would overwrite
+// unspent outputs (BIP30), the block is rolled back and false is returned -
+// the view is unchanged.
+bool connect_block(MutableCoinsView& view, const Block& block, uint32_t height, BlockUndo& undo,
+                   uint64_t* fees = nullptr);
+
+// Reverse connect_block(). Returns false if the view did not match the block
+// (missing outputs or overwritten inputs); the rest is still restored.
+bool disconnect_block(MutableCoinsView& view, const Block& block, const BlockUndo& undo);
+
+} // namespace bitcoin
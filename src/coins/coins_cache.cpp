@@ -0,0 +1,134 @@
+// src/coins/coins_cache.cpp
+#include "coins_cache.h"
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace bitcoin {
+
+CoinsViewCache::CoinsViewCache(CoinsViewDB& base_view, size_t max_memory_bytes)
+    : base(base_view), max_memory(max_memory_bytes), best_block(base_view.get_best_block()) {}
+
+size_t CoinsViewCache::heap_bytes(const Coin& coin) {
+    size_t capacity = coin.out.script_pubkey.capacity();
+    return capacity > Script::INLINE_CAPACITY ? capacity : 0;
+}
+
+CoinsViewCache::Entry* CoinsViewCache::fetch(const OutPoint& outpoint) const {
+    auto it = coins.find(outpoint);
+    if (it != coins.end()) {
+        counters.hits++;
+        return &it->second;
+    }
+
+    counters.misses++;
+    Coin coin;
+    if (!base.get_coin(outpoint, coin)) return nullptr;
+    // Clean entry: matches the database, nothing to write back
+    Entry& entry = coins.emplace(outpoint, Entry{std::move(coin)}).first->second;
+    script_bytes += heap_bytes(entry.coin);
+    return &entry;
+}
+
+void CoinsViewCache::mark_dirty(Entry& entry, uint8_t flags) {
+    if (!(entry.flags & DIRTY)) dirty_count++;
+    entry.flags |= DIRTY | flags;
+}
+
+bool CoinsViewCache::get_coin(const OutPoint& outpoint, Coin& coin) const {
+    const Entry* entry = fetch(outpoint);
+    if (!entry || entry->spent) return false;
+    coin = entry->coin;
+    return true;
+}
+
+bool CoinsViewCache::have_coin(const OutPoint& outpoint) const {
+    const Entry* entry = fetch(outpoint);
+    return entry && !entry->spent;
+}
+
+void CoinsViewCache::add_coin(const OutPoint& outpoint, Coin coin, bool possible_overwrite) {
+    // Only the cache is checked - looking every new output up on disk would
+    // cost a read per output. connect_block() makes sure there's nothing
+    // there: it looks up coinbase outputs (BIP30), and any other new
+    // transaction has a txid no coin can have yet.
+    auto [it, inserted] = coins.try_emplace(outpoint);
+    Entry& entry = it->second;
+    bool fresh = false;
+    if (!possible_overwrite) {
+        if (!inserted && !entry.spent) throw std::logic_error("Adding a coin that is already unspent");
+        // A dirty spent entry means the database still has the old coin, which
+        // the next flush must overwrite - so the new one can't be FRESH
+        fresh = !(entry.flags & DIRTY);
+    }
+
+    script_bytes -= heap_bytes(entry.coin);
+    entry.coin = std::move(coin);
+    entry.spent = false;
+    script_bytes += heap_bytes(entry.coin);
+    mark_dirty(entry, fresh ? FRESH : 0);
+}
+
+bool CoinsViewCache::spend_coin(const OutPoint& outpoint, Coin* moved) {
+    Entry* entry = fetch(outpoint);
+    if (!entry || entry->spent) return false;
+
+    script_bytes -= heap_bytes(entry->coin);
+    if (moved) *moved = std::move(entry->coin);
+
+    if (entry->flags & FRESH) {
+        // Never reached the database - just forget it
+        if (entry->flags & DIRTY) dirty_count--;
+        coins.erase(outpoint);
+    } else {
+        entry->coin = Coin();
+        entry->spent = true;
+        mark_dirty(*entry, 0);
+    }
+    return true;
+}
+
+size_t CoinsViewCache::memory_usage() const {
+    // Node estimate: key/value plus next pointer and cached hash, and the bucket array
+    size_t node = sizeof(CoinsMap::value_type) + 2 * sizeof(void*);
+    return coins.size() * node + coins.bucket_count() * sizeof(void*) + script_bytes;
+}
+
+void CoinsViewCache::flush() {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<CoinChange> changes;
+    changes.reserve(dirty_count);
+    for (const auto& [outpoint, entry] : coins) {
+        if (!(entry.flags & DIRTY)) continue;
+        changes.push_back(CoinChange{outpoint, entry.spent ? nullptr : &entry.coin});
+    }
+    base.write_coins(changes, best_block);
+
+    // Start over with an empty table so the buckets are freed too
+    coins = CoinsMap();
+    script_bytes = 0;
+    dirty_count = 0;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    counters.flushes++;
+    counters.coins_written += changes.size();
+    counters.last_flush_seconds = seconds;
+    counters.total_flush_seconds += seconds;
+}
+
+bool CoinsViewCache::flush_if_needed() {
+    if (!needs_flush()) return false;
+    flush();
+    return true;
+}
+
+CoinsCacheStats CoinsViewCache::stats() const {
+    CoinsCacheStats result = counters;
+    result.cached_coins = coins.size();
+    result.dirty_coins = dirty_count;
+    result.memory_usage = memory_usage();
+    return result;
+}
+
+} // namespace bitcoin
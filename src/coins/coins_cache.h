@@ -0,0 +1,95 @@
+// src/coins/coins_cache.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "coins.h"
+#include "coins_db.h"
+
+namespace bitcoin {
+
+struct CoinsCacheStats {
+    uint64_t hits = 0;              // lookups answered from memory
+    uint64_t misses = 0;            // lookups that went to disk
+    uint64_t flushes = 0;
+    uint64_t coins_written = 0;     // puts + deletes sent to disk, all flushes
+    double last_flush_seconds = 0;
+    double total_flush_seconds = 0;
+    size_t cached_coins = 0;
+    size_t dirty_coins = 0;
+    size_t memory_usage = 0;        // bytes, compared against the cache limit
+
+    double hit_rate() const { return hits + misses ? (double)hits / (hits + misses) : 0; }
+};
+
+/**
+ * Write-back coin cache in front of the database
+ *
+ * Connecting blocks only touches memory. Every entry carries two flags:
+ *   DIRTY - differs from the database, must be written on flush
+ *   FRESH - the database does not have it, so if it is spent before the
+ *           next flush it can simply be forgotten (most new coins)
+ * Spent coins that the database still has stay in the cache as dirty
+ * "spent" entries until the flush deletes them.
+ *
+ * flush() writes all dirty entries plus the best block as one atomic batch
+ * and empties the cache. Call flush_if_needed() between blocks to keep
+ * memory under `max_memory` (like bitcoind's -dbcache).
+ *
+ * Not thread-safe: one validation thread owns the cache.
+ */
+class CoinsViewCache : public MutableCoinsView {
+public:
+    static constexpr size_t DEFAULT_MAX_MEMORY = 450 << 20;
+
+    explicit CoinsViewCache(CoinsViewDB& base, size_t max_memory = DEFAULT_MAX_MEMORY);
+
+    bool get_coin(const OutPoint& outpoint, Coin& coin) const override;
+    bool have_coin(const OutPoint& outpoint) const override;
+    void add_coin(const OutPoint& outpoint, Coin coin, bool possible_overwrite = false) override;
+    bool spend_coin(const OutPoint& outpoint, Coin* moved = nullptr) override;
+
+    // Block the cached state corresponds to (written out with the next flush)
+    const crypto::Hash256& get_best_block() const { return best_block; }
+    void set_best_block(const crypto::Hash256& hash) { best_block = hash; }
+
+    size_t memory_usage() const;
+    bool needs_flush() const { return memory_usage() > max_memory; }
+
+    // Write every dirty entry to the database and empty the cache
+    void flush();
+
+    // flush() if over the memory limit; returns whether it flushed
+    bool flush_if_needed();
+
+    CoinsCacheStats stats() const;
+
+private:
+    enum : uint8_t { DIRTY = 1, FRESH = 2 };
+
+    struct Entry {
+        Coin coin;
+        bool spent = false;
+        uint8_t flags = 0;
+    };
+
+    using CoinsMap = std::unordered_map<OutPoint, Entry, SaltedOutPointHasher>;
+
+    CoinsViewDB& base;
+    size_t max_memory;
+    crypto::Hash256 best_block;
+
+    mutable CoinsMap coins;
+    mutable size_t script_bytes = 0;    // scripts spilled to the heap
+    size_t dirty_count = 0;
+    mutable CoinsCacheStats counters;
+
+    // Cached entry for `outpoint`, loading it from the database on a miss.
+    // nullptr if neither has it.
+    Entry* fetch(const OutPoint& outpoint) const;
+
+    static size_t heap_bytes(const Coin& coin);
+    void mark_dirty(Entry& entry, uint8_t flags);
+};
+
+} // namespace bitcoin
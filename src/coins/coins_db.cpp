@@ -0,0 +1,76 @@
+// src/coins/coins_db.cpp
+#include "coins_db.h"
+#include <algorithm>
+
+namespace bitcoin {
+
+static constexpr unsigned char DB_COIN = 'C';
+static constexpr unsigned char DB_BEST_BLOCK = 'B';
+
+// 'C' + txid + VARINT(vout): at most 38 bytes, so it lives on the stack
+struct CoinKey {
+    unsigned char bytes[1 + 32 + 10];
+    size_t size;
+
+    explicit CoinKey(const OutPoint& outpoint) {
+        struct Writer {
+            CoinKey* key;
+            void write(std::span<const unsigned char> data) {
+                std::copy(data.begin(), data.end(), key->bytes + key->size);
+                key->size += data.size();
+            }
+        } writer{this};
+
+        bytes[0] = DB_COIN;
+        std::copy(outpoint.txid.begin(), outpoint.txid.end(), bytes + 1);
+        size = 33;
+        write_varint(writer, outpoint.vout);
+    }
+
+    KvBytes span() const { return {bytes, size}; }
+};
+
+CoinsViewDB::CoinsViewDB(const std::string& directory, KvStoreOptions options) : store(directory, options) {}
+
+bool CoinsViewDB::get_coin(const OutPoint& outpoint, Coin& coin) const {
+    std::vector<unsigned char> value;
+    if (!store.get(CoinKey(outpoint).span(), value)) return false;
+    SpanReader reader(value);
+    coin = deserialize_coin(reader);
+    return true;
+}
+
+bool CoinsViewDB::have_coin(const OutPoint& outpoint) const {
+    return store.contains(CoinKey(outpoint).span());
+}
+
+crypto::Hash256 CoinsViewDB::get_best_block() const {
+    std::vector<unsigned char> value;
+    if (!store.get(KvBytes(&DB_BEST_BLOCK, 1), value) || value.size() != 32) return crypto::Hash256();
+    return crypto::Hash256(value.data());
+}
+
+void CoinsViewDB::write_coins(std::span<const CoinChange> changes, const crypto::Hash256& best_block) {
+    WriteBatch batch;
+    std::vector<unsigned char> value;
+    for (const CoinChange& change : changes) {
+        CoinKey key(change.outpoint);
+        if (change.coin) {
+            value.clear();
+            VectorWriter writer(value);
+            serialize_coin(writer, *change.coin);
+            batch.put(key.span(), value);
+        } else {
+            batch.erase(key.span());
+        }
+    }
+    batch.put(KvBytes(&DB_BEST_BLOCK, 1), KvBytes(best_block.data(), best_block.size()));
+    store.write(batch);
+}
+
+size_t CoinsViewDB::coin_count() const {
+    size_t count = store.size();
+    return store.contains(KvBytes(&DB_BEST_BLOCK, 1)) ? count - 1 : count;
+}
+
+} // namespace bitcoin
@@ -0,0 +1,46 @@
+// src/coins/coins_db.h
+#pragma once
+#include <span>
+#include <string>
+#include "coins.h"
+#include "../storage/kv_store.h"
+
+namespace bitcoin {
+
+// One change for CoinsViewDB::write_coins (coin == nullptr: the coin was spent)
+struct CoinChange {
+    OutPoint outpoint;
+    const Coin* coin;
+};
+
+/**
+ * Coins on disk
+ *
+ * Each coin is one key ('C' + txid + VARINT(vout)) in a KvStore, stored in
+ * the compact form from serialize_coin(). The hash of the block the set
+ * corresponds to is stored next to them and updated in the same batch, so
+ * after a crash the coins always match some block.
+ */
+class CoinsViewDB : public CoinsView {
+private:
+    KvStore store;
+
+public:
+    explicit CoinsViewDB(const std::string& directory, KvStoreOptions options = KvStoreOptions());
+
+    bool get_coin(const OutPoint& outpoint, Coin& coin) const override;
+    bool have_coin(const OutPoint& outpoint) const override;
+
+    // Block the stored coins correspond to (null for an empty database)
+    crypto::Hash256 get_best_block() const;
+
+    // Apply `changes` and move the best block, as one atomic batch
+    void write_coins(std::span<const CoinChange> changes, const crypto::Hash256& best_block);
+
+    // Coins stored (not counting the best block record)
+    size_t coin_count() const;
+
+    KvStore& get_store() { return store; }
+};
+
+} // namespace bitcoin
@@ -0,0 +1,166 @@
+// src/coins/utxo_set.cpp
+#include "utxo_set.h"
+#include <mutex>
+#include <stdexcept>
+
+namespace bitcoin {
+
+static_assert(UtxoSet::SHARD_COUNT == 64, "shard_for() uses the top 6 hash bits");
+
+static constexpr size_t MIN_CAPACITY = 16;
+
+size_t UtxoSet::Table::find(const OutPoint& outpoint, uint64_t hash) const {
+    if (tags.empty()) return NOT_FOUND;
+    size_t mask = tags.size() - 1;
+    uint8_t tag = tag_of(hash);
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint8_t t = tags[i];
+        if (t == EMPTY) return NOT_FOUND;
+        if (t == tag && slots[i].outpoint == outpoint) return i;
+    }
+}
+
+void UtxoSet::Table::insert(const OutPoint& outpoint, Coin coin, uint64_t hash) {
+    // Keep at most 3/4 of the slots used (live or deleted) so probes stay short
+    if ((count + deleted + 1) * 4 > tags.size() * 3) {
+        size_t capacity = tags.empty() ? MIN_CAPACITY : tags.size();
+        // Only grow if live entries need it; otherwise just sweep out tombstones
+        if ((count + 1) * 2 > capacity) capacity *= 2;
+        rehash(capacity);
+    }
+
+    size_t mask = tags.size() - 1;
+    size_t i = hash & mask;
+    while (tags[i] & 0x80) i = (i + 1) & mask;
+    if (tags[i] == DELETED) deleted--;
+    tags[i] = tag_of(hash);
+    slots[i].outpoint = outpoint;
+    slots[i].coin = std::move(coin);
+    count++;
+}
+
+void UtxoSet::Table::erase(size_t index) {
+    size_t mask = tags.size() - 1;
+    // The end of a probe chain can go straight back to empty
+    if (tags[(index + 1) & mask] == EMPTY) {
+        tags[index] = EMPTY;
+    } else {
+        tags[index] = DELETED;
+        deleted++;
+    }
+    slots[index].coin = Coin();    // frees a spilled script now, not at the next rehash
+    count--;
+}
+
+void UtxoSet::Table::rehash(size_t new_capacity) {
+    std::vector<uint8_t> old_tags(new_capacity, EMPTY);
+    std::vector<Slot> old_slots(new_capacity);
+    old_tags.swap(tags);
+    old_slots.swap(slots);
+
+    size_t mask = new_capacity - 1;
+    for (size_t j = 0; j < old_tags.size(); j++) {
+        if (!(old_tags[j] & 0x80)) continue;
+        uint64_t h = (*hasher)(old_slots[j].outpoint);
+        size_t i = h & mask;
+        while (tags[i] != EMPTY) i = (i + 1) & mask;
+        tags[i] = old_tags[j];
+        slots[i] = std::move(old_slots[j]);
+    }
+    deleted = 0;
+}
+
+size_t UtxoSet::Table::memory_usage() const {
+    size_t bytes = tags.capacity() + slots.capacity() * sizeof(Slot);
+    for (size_t i = 0; i < tags.size(); i++) {
+        const Script& script = slots[i].coin.out.script_pubkey;
+        if ((tags[i] & 0x80) && script.capacity() > Script::INLINE_CAPACITY) bytes += script.capacity();
+    }
+    return bytes;
+}
+
+void UtxoSet::Table::clear() {
+    tags.clear();
+    tags.shrink_to_fit();
+    slots.clear();
+    slots.shrink_to_fit();
+    count = 0;
+    deleted = 0;
+}
+
+UtxoSet::UtxoSet() {
+    shards.reserve(SHARD_COUNT);
+    for (size_t i = 0; i < SHARD_COUNT; i++) {
+        shards.push_back(std::make_unique<Shard>(&hasher));
+    }
+}
+
+bool UtxoSet::get_coin(const OutPoint& outpoint, Coin& coin) const {
+    uint64_t h = hasher(outpoint);
+    const Shard& shard = shard_for(h);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    size_t index = shard.table.find(outpoint, h);
+    if (index == Table::NOT_FOUND) return false;
+    coin = shard.table.slot(index).coin;
+    return true;
+}
+
+bool UtxoSet::have_coin(const OutPoint& outpoint) const {
+    uint64_t h = hasher(outpoint);
+    const Shard& shard = shard_for(h);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.table.find(outpoint, h) != Table::NOT_FOUND;
+}
+
+void UtxoSet::add_coin(const OutPoint& outpoint, Coin coin, bool possible_overwrite) {
+    uint64_t h = hasher(outpoint);
+    Shard& shard = shard_for(h);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    size_t index = shard.table.find(outpoint, h);
+    if (index != Table::NOT_FOUND) {
+        if (!possible_overwrite) {
+            throw std::logic_error("Attempted to overwrite an unspent coin");
+        }
+        shard.table.slot(index).coin = std::move(coin);
+        return;
+    }
+    shard.table.insert(outpoint, std::move(coin), h);
+}
+
+bool UtxoSet::spend_coin(const OutPoint& outpoint, Coin* moved) {
+    uint64_t h = hasher(outpoint);
+    Shard& shard = shard_for(h);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    size_t index = shard.table.find(outpoint, h);
+    if (index == Table::NOT_FOUND) return false;
+    if (moved) *moved = std::move(shard.table.slot(index).coin);
+    shard.table.erase(index);
+    return true;
+}
+
+size_t UtxoSet::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->table.size();
+    }
+    return total;
+}
+
+size_t UtxoSet::memory_usage() const {
+    size_t total = sizeof(*this) + shards.size() * sizeof(Shard);
+    for (const auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        total += shard->table.memory_usage();
+    }
+    return total;
+}
+
+void UtxoSet::clear() {
+    for (auto& shard : shards) {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        shard->table.clear();
+    }
+}
+
+} // namespace bitcoin
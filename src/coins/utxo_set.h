@@ -0,0 +1,100 @@
+// src/coins/utxo_set.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+#include "coins.h"
+
+namespace bitcoin {
+
+/**
+ * In-memory UTXO set
+ *
+ * Coins live in open-addressing hash tables (linear probing). Each table has
+ * a separate array of one-byte control tags - empty, deleted, or 7 bits of
+ * the hash - so a probe scans a single cache line of tags and only touches
+ * a slot when its tag matches.
+ *
+ * The set is split into SHARD_COUNT shards by outpoint hash, each behind
+ * its own reader/writer lock, so lookups from many threads rarely meet.
+ * The hash is salted per instance (SaltedOutPointHasher) so peers cannot
+ * aim txids at one bucket.
+ */
+class UtxoSet : public MutableCoinsView {
+public:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    UtxoSet();
+
+    // Tables point back at this instance's hasher
+    UtxoSet(const UtxoSet&) = delete;
+    UtxoSet& operator=(const UtxoSet&) = delete;
+
+    bool get_coin(const OutPoint& outpoint, Coin& coin) const override;
+    bool have_coin(const OutPoint& outpoint) const override;
+    void add_coin(const OutPoint& outpoint, Coin coin, bool possible_overwrite = false) override;
+    bool spend_coin(const OutPoint& outpoint, Coin* moved = nullptr) override;
+
+    // Number of unspent coins
+    size_t size() const;
+
+    // Bytes held by the tables and by scripts that spilled to the heap
+    size_t memory_usage() const;
+
+    void clear();
+
+private:
+    struct Slot {
+        OutPoint outpoint;
+        Coin coin;
+    };
+
+    class Table {
+    public:
+        explicit Table(const SaltedOutPointHasher* owner_hasher) : hasher(owner_hasher) {}
+
+        static constexpr uint8_t EMPTY = 0;
+        static constexpr uint8_t DELETED = 1;
+        static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+        size_t find(const OutPoint& outpoint, uint64_t hash) const;
+        Slot& slot(size_t index) { return slots[index]; }
+        const Slot& slot(size_t index) const { return slots[index]; }
+
+        // `outpoint` must not be present
+        void insert(const OutPoint& outpoint, Coin coin, uint64_t hash);
+        void erase(size_t index);
+
+        size_t size() const { return count; }
+        size_t memory_usage() const;
+        void clear();
+
+    private:
+        const SaltedOutPointHasher* hasher;     // owner's, to rehash on growth
+        std::vector<uint8_t> tags;
+        std::vector<Slot> slots;
+        size_t count = 0;
+        size_t deleted = 0;
+
+        // Low bits pick the bucket, bits 51-57 the tag, the top 6 the shard
+        static uint8_t tag_of(uint64_t hash) { return 0x80 | (uint8_t)((hash >> 51) & 0x7f); }
+        void rehash(size_t new_capacity);
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        Table table;
+
+        explicit Shard(const SaltedOutPointHasher* hasher) : table(hasher) {}
+    };
+
+    SaltedOutPointHasher hasher;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    Shard& shard_for(uint64_t hash) { return *shards[hash >> 58]; }
+    const Shard& shard_for(uint64_t hash) const { return *shards[hash >> 58]; }
+};
+
+} // namespace bitcoin
@@ -0,0 +1,216 @@
+// src/crypto/arith_uint256.cpp
+#include "arith_uint256.h"
+#include <stdexcept>
+
+namespace crypto {
+
+ArithUint256::ArithUint256(uint64_t value) {
+    words[0] = (uint32_t)value;
+    words[1] = (uint32_t)(value >> 32);
+    for (int i = 2; i < WIDTH; i++) words[i] = 0;
+}
+
+ArithUint256 ArithUint256::from_hash(const Hash256& hash) {
+    ArithUint256 result;
+    const unsigned char* p = hash.data();
+    for (int i = 0; i < WIDTH; i++) {
+        result.words[i] = (uint32_t)p[4 * i] | ((uint32_t)p[4 * i + 1] << 8) |
+                          ((uint32_t)p[4 * i + 2] << 16) | ((uint32_t)p[4 * i + 3] << 24);
+    }
+    return result;
+}
+
+Hash256 ArithUint256::to_hash() const {
+    Hash256 result;
+    unsigned char* p = result.data();
+    for (int i = 0; i < WIDTH; i++) {
+        p[4 * i] = (unsigned char)words[i];
+        p[4 * i + 1] = (unsigned char)(words[i] >> 8);
+        p[4 * i + 2] = (unsigned char)(words[i] >> 16);
+        p[4 * i + 3] = (unsigned char)(words[i] >> 24);
+    }
+    return result;
+}
+
+ArithUint256& ArithUint256::set_compact(uint32_t compact, bool* negative, bool* overflow) {
+    int size = compact >> 24;
+    uint32_t mantissa = compact & 0x007fffff;
+    if (size <= 3) {
+        mantissa >>= 8 * (3 - size);
+        *this = ArithUint256(mantissa);
+    } else {
+        *this = ArithUint256(mantissa);
+        *this <<= 8 * (size - 3);
+    }
+
+    // 0x00800000 is a sign bit - targets are never negative
+    if (negative) *negative = mantissa != 0 && (compact & 0x00800000) != 0;
+    // Anything that does not fit in 256 bits
+    if (overflow) {
+        *overflow = mantissa != 0 && ((size > 34) ||
+                                      (mantissa > 0xff && size > 33) ||
+                                      (mantissa > 0xffff && size > 32));
+    }
+    return *this;
+}
+
+uint32_t ArithUint256::get_compact(bool negative) const {
+    int size = (bits() + 7) / 8;
+    uint32_t compact;
+    if (size <= 3) {
+        compact = (uint32_t)(get_low64() << 8 * (3 - size));
+    } else {
+        compact = (uint32_t)(*this >> 8 * (size - 3)).get_low64();
+    }
+
+    // Keep the mantissa's top bit clear, it would read as a sign
+    if (compact & 0x00800000) {
+        compact >>= 8;
+        size++;
+    }
+    compact |= (uint32_t)size << 24;
+    if (negative && (compact & 0x007fffff)) compact |= 0x00800000;
+    return compact;
+}
+
+unsigned int ArithUint256::bits() const {
+    for (int pos = WIDTH - 1; pos >= 0; pos--) {
+        if (words[pos]) {
+            return 32 * pos + (32 - __builtin_clz(words[pos]));
+        }
+    }
+    return 0;
+}
+
+double ArithUint256::get_double() const {
+    double result = 0.0;
+    double factor = 1.0;
+    for (int i = 0; i < WIDTH; i++) {
+        result += factor * words[i];
+        factor *= 4294967296.0;
+    }
+    return result;
+}
+
+int ArithUint256::compare(const ArithUint256& other) const {
+    for (int i = WIDTH - 1; i >= 0; i--) {
+        if (words[i] < other.words[i]) return -1;
+        if (words[i] > other.words[i]) return 1;
+    }
+    return 0;
+}
+
+bool ArithUint256::is_met_by(const unsigned char* hash) const {
+    for (int i = WIDTH - 1; i >= 0; i--) {
+        const unsigned char* p = hash + 4 * i;
+        uint32_t word = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        if (word < words[i]) return true;
+        if (word > words[i]) return false;
+    }
+    return true; // equal counts as meeting the target
+}
+
+ArithUint256 ArithUint256::operator~() const {
+    ArithUint256 result;
+    for (int i = 0; i < WIDTH; i++) result.words[i] = ~words[i];
+    return result;
+}
+
+ArithUint256& ArithUint256::operator+=(const ArithUint256& b) {
+    uint64_t carry = 0;
+    for (int i = 0; i < WIDTH; i++) {
+        uint64_t n = carry + words[i] + b.words[i];
+        words[i] = (uint32_t)n;
+        carry = n >> 32;
+    }
+    return *this;
+}
+
+ArithUint256& ArithUint256::operator-=(const ArithUint256& b) {
+    // a - b == a + (~b + 1) in two's complement
+    ArithUint256 negated = ~b;
+    ++negated;
+    return *this += negated;
+}
+
+ArithUint256& ArithUint256::operator++() {
+    for (int i = 0; i < WIDTH && ++words[i] == 0; i++) {
+    }
+    return *this;
+}
+
+ArithUint256& ArithUint256::operator*=(uint32_t b) {
+    uint64_t carry = 0;
+    for (int i = 0; i < WIDTH; i++) {
+        uint64_t n = carry + (uint64_t)b * words[i];
+        words[i] = (uint32_t)n;
+        carry = n >> 32;
+    }
+    return *this;
+}
+
+ArithUint256& ArithUint256::operator*=(const ArithUint256& b) {
+    ArithUint256 result;
+    for (int j = 0; j < WIDTH; j++) {
+        uint64_t carry = 0;
+        for (int i = 0; i + j < WIDTH; i++) {
+            uint64_t n = carry + result.words[i + j] + (uint64_t)words[j] * b.words[i];
+            result.words[i + j] = (uint32_t)n;
+            carry = n >> 32;
+        }
+    }
+    *this = result;
+    return *this;
+}
+
+ArithUint256& ArithUint256::operator/=(const ArithUint256& b) {
+    // Binary long division
+    ArithUint256 divisor = b;
+    ArithUint256 remainder = *this;
+    *this = ArithUint256();
+
+    int remainder_bits = remainder.bits();
+    int divisor_bits = divisor.bits();
+    if (divisor_bits == 0) {
+        throw std::domain_error("division by zero");
+    }
+    if (divisor_bits > remainder_bits) return *this;
+
+    int shift = remainder_bits - divisor_bits;
+    divisor <<= shift;
+    while (shift >= 0) {
+        if (remainder >= divisor) {
+            remainder -= divisor;
+            words[shift / 32] |= (1u << (shift & 31));
+        }
+        divisor >>= 1;
+        shift--;
+    }
+    return *this;
+}
+
+ArithUint256& ArithUint256::operator<<=(unsigned int shift) {
+    ArithUint256 source = *this;
+    *this = ArithUint256();
+    int k = shift / 32;
+    shift %= 32;
+    for (int i = 0; i < WIDTH; i++) {
+        if (i + k + 1 < WIDTH && shift != 0) words[i + k + 1] |= (source.words[i] >> (32 - shift));
+        if (i + k < WIDTH) words[i + k] |= (source.words[i] << shift);
+    }
+    return *this;
+}
+
+ArithUint256& ArithUint256::operator>>=(unsigned int shift) {
+    ArithUint256 source = *this;
+    *this = ArithUint256();
+    int k = shift / 32;
+    shift %= 32;
+    for (int i = 0; i < WIDTH; i++) {
+        if (i - k - 1 >= 0 && shift != 0) words[i - k - 1] |= (source.words[i] << (32 - shift));
+        if (i - k >= 0) words[i - k] |= (source.words[i] >> shift);
+    }
+    return *this;
+}
+
+} // namespace crypto
@@ -0,0 +1,73 @@
+// src/crypto/arith_uint256.h
+#pragma once
+#include <cstdint>
+#include <string>
+#include "uint256.h"
+
+namespace crypto {
+
+/**
+ * 256-bit unsigned integer for proof-of-work math
+ *
+ * Hash256 is just bytes; this is the same value read as a number (little
+ * endian, eight 32-bit words) so targets can be decoded from nBits,
+ * compared, scaled for retargeting and summed into chain work.
+ */
+class ArithUint256 {
+private:
+    static constexpr int WIDTH = 8;
+    uint32_t words[WIDTH];  // least significant word first
+
+public:
+    ArithUint256() { for (int i = 0; i < WIDTH; i++) words[i] = 0; }
+    ArithUint256(uint64_t value);
+
+    // Reinterpret hash bytes as a number (and back)
+    static ArithUint256 from_hash(const Hash256& hash);
+    Hash256 to_hash() const;
+
+    // Compact "nBits" format: 1 byte exponent + 3 byte mantissa (with sign bit)
+    // target = mantissa * 256^(exponent - 3)
+    ArithUint256& set_compact(uint32_t compact, bool* negative = nullptr, bool* overflow = nullptr);
+    uint32_t get_compact(bool negative = false) const;
+
+    // Position of the highest set bit + 1 (0 for zero)
+    unsigned int bits() const;
+    uint64_t get_low64() const { return words[0] | ((uint64_t)words[1] << 32); }
+    double get_double() const;
+    std::string to_hex() const { return to_hash().to_hex(); }
+
+    // -1, 0 or 1, comparing from the most significant word down
+    int compare(const ArithUint256& other) const;
+
+    ArithUint256 operator~() const;
+    ArithUint256& operator+=(const ArithUint256& b);
+    ArithUint256& operator-=(const ArithUint256& b);
+    ArithUint256& operator*=(uint32_t b);
+    ArithUint256& operator*=(const ArithUint256& b);
+    ArithUint256& operator/=(const ArithUint256& b);   // throws std::domain_error on divide by zero
+    ArithUint256& operator<<=(unsigned int shift);
+    ArithUint256& operator>>=(unsigned int shift);
+    ArithUint256& operator++();
+
+    friend ArithUint256 operator+(ArithUint256 a, const ArithUint256& b) { return a += b; }
+    friend ArithUint256 operator-(ArithUint256 a, const ArithUint256& b) { return a -= b; }
+    friend ArithUint256 operator*(ArithUint256 a, const ArithUint256& b) { return a *= b; }
+    friend ArithUint256 operator*(ArithUint256 a, uint32_t b) { return a *= b; }
+    friend ArithUint256 operator/(ArithUint256 a, const ArithUint256& b) { return a /= b; }
+    friend ArithUint256 operator<<(ArithUint256 a, unsigned int shift) { return a <<= shift; }
+    friend ArithUint256 operator>>(ArithUint256 a, unsigned int shift) { return a >>= shift; }
+
+    friend bool operator==(const ArithUint256& a, const ArithUint256& b) { return a.compare(b) == 0; }
+    friend bool operator!=(const ArithUint256& a, const ArithUint256& b) { return a.compare(b) != 0; }
+    friend bool operator<(const ArithUint256& a, const ArithUint256& b) { return a.compare(b) < 0; }
+    friend bool operator<=(const ArithUint256& a, const ArithUint256& b) { return a.compare(b) <= 0; }
+    friend bool operator>(const ArithUint256& a, const ArithUint256& b) { return a.compare(b) > 0; }
+    friend bool operator>=(const ArithUint256& a, const ArithUint256& b) { return a.compare(b) >= 0; }
+
+    // Is the 32-byte little-endian number at `hash` <= this? Word-wise from
+    // the top, so nearly every miss is decided by the first comparison.
+    bool is_met_by(const unsigned char* hash) const;
+};
+
+} // namespace crypto
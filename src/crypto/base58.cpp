@@ -1,70 +1,199 @@
 // src/crypto/base58.cpp
 #include "base58.h"
-#include <openssl/sha.h>
+#include "hash.h"
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 
 namespace crypto {
 
-static const std::string BASE58_ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-
-std::string Base58::encode(const std::vector<unsigned char>& data) {
-    // Count leading zeros 
-    int leading_zeros = 0;
-    for (unsigned char byte : data) {
-        if (byte != 0) break;
-        leading_zeros++;
+static const char BASE58_ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+static constexpr uint64_t POW58_5 = 58ULL * 58 * 58 * 58 * 58;    // 656356768, one limb of 5 digits
+
+// Character -> digit value, -1 outside the alphabet
+static const std::array<int8_t, 256> BASE58_VALUES = [] {
+    std::array<int8_t, 256> values;
+    values.fill(-1);
+    for (int i = 0; i < 58; i++) values[(unsigned char)BASE58_ALPHABET[i]] = (int8_t)i;
+    return values;
+}();
+
+// Scratch space: on the stack for the usual sizes, on the heap past them
+template <typename T, size_t N>
+class ScratchBuffer {
+private:
+    T local[N];
+    std::vector<T> heap;
+    T* ptr;
+
+public:
+    explicit ScratchBuffer(size_t size) : ptr(local) {
+        if (size > N) {
+            heap.resize(size);
+            ptr = heap.data();
+        }
     }
-
-    // Convert to base58
-    std::vector<unsigned char> temp_data = data;
-    std::string result;
-
-    while (!temp_data.empty()) {
-        // Divide by 58
-        int remainder = 0; 
-        for (auto& byte : temp_data) {
-            int temp = remainder * 256 + byte;
-            byte = temp / 58;
-            remainder = temp % 58;
+    T* data() { return ptr; }
+};
+
+size_t Base58::encode(std::span<const unsigned char> data, char* out) {
+    // Count leading zeros
+    size_t leading_zeros = 0;
+    while (leading_zeros < data.size() && data[leading_zeros] == 0) leading_zeros++;
+    std::span<const unsigned char> rest = data.subspan(leading_zeros);
+
+    // Convert to base 58^5, least significant limb first. Each step multiplies
+    // the number so far by 2^32 and adds the next 4 bytes (the first step
+    // takes the odd 1-3 bytes so the rest line up).
+    ScratchBuffer<uint32_t, max_encoded_size(STACK_SIZE) / 5 + 2> buffer(max_encoded_size(rest.size()) / 5 + 2);
+    uint32_t* limbs = buffer.data();
+    size_t used = 0;
+    size_t pos = 0;
+    while (pos < rest.size()) {
+        size_t take = pos == 0 && rest.size() % 4 ? rest.size() % 4 : 4;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < take; i++) carry = (carry << 8) | rest[pos + i];
+        pos += take;
+
+        for (size_t i = 0; i < used; i++) {
+            uint64_t value = ((uint64_t)limbs[i] << (8 * take)) + carry;
+            limbs[i] = (uint32_t)(value % POW58_5);
+            carry = value / POW58_5;
         }
-
-        result = BASE58_ALPHABET[remainder] + result;
-
-        // Remove leading zeros
-        while (!temp_data.empty() && temp_data[0] == 0) {
-            temp_data.erase(temp_data.begin());
+        while (carry) {
+            limbs[used++] = (uint32_t)(carry % POW58_5);
+            carry /= POW58_5;
         }
     }
 
-    // Add leading 1s for leading zeros
-    result = std::string(leading_zeros, '1') + result;
+    // Add leading 1s for leading zeros, then the digits: the top limb without
+    // its leading zeros, every other one as exactly 5 digits
+    char* p = out;
+    std::memset(p, '1', leading_zeros);
+    p += leading_zeros;
+    for (size_t i = used; i-- > 0;) {
+        char digits[5];
+        uint32_t value = limbs[i];
+        for (int d = 4; d >= 0; d--) {
+            digits[d] = BASE58_ALPHABET[value % 58];
+            value /= 58;
+        }
+        int first = 0;
+        if (i == used - 1) {
+            while (digits[first] == '1') first++;
+        }
+        std::memcpy(p, digits + first, 5 - first);
+        p += 5 - first;
+    }
+    return p - out;
+}
 
+std::string Base58::encode(std::span<const unsigned char> data) {
+    std::string result(max_encoded_size(data.size()), '\0');
+    result.resize(encode(data, result.data()));
     return result;
 }
 
-std::vector<unsigned char> Base58::double_sha256_bytes(const std::vector<unsigned char>& data) {
-    // First SHA256
-    unsigned char first_hash[SHA256_DIGEST_LENGTH];
-    SHA256(data.data(), data.size(), first_hash);
+std::string Base58::encode_check(std::span<const unsigned char> data) {
+    // Step 1: Calculate checksum (first 4 bytes of double SHA256)
+    Hash256 checksum = Hash::double_sha256(data.data(), data.size());
 
-    // Second SHA256
-    unsigned char second_hash[SHA256_DIGEST_LENGTH];
-    SHA256(first_hash, SHA_DIGEST_LENGTH, second_hash);
+    // Step 2: Append checksum to data
+    ScratchBuffer<unsigned char, STACK_SIZE + 4> buffer(data.size() + 4);
+    unsigned char* data_with_checksum = buffer.data();
+    std::copy(data.begin(), data.end(), data_with_checksum);
+    std::memcpy(data_with_checksum + data.size(), checksum.data(), 4);
 
-    return std::vector<unsigned char>(second_hash, second_hash + SHA256_DIGEST_LENGTH);
+    // Step 3: Encode in Base58
+    return encode({data_with_checksum, data.size() + 4});
 }
 
-std::string Base58::encode_check(const std::vector<unsigned char>& data) {
-    // Step 1: Calculate checksum (first 4 vytes of double SHA256)
-    auto checksum_full = double_sha256_bytes(data);
-    std::vector<unsigned char> checksum(checksum_full.begin(), checksum_full.begin() + 4);
+bool Base58::decode(std::string_view str, unsigned char* out, size_t max_len, size_t& out_len) {
+    size_t leading_ones = 0;
+    while (leading_ones < str.size() && str[leading_ones] == '1') leading_ones++;
+    std::string_view rest = str.substr(leading_ones);
+
+    // n digits (the first nonzero) are at least (n - 1) * log(58) / log(256)
+    // bytes - reject anything that long before doing the work
+    if (!rest.empty() && leading_ones + (rest.size() - 1) * 732 / 1000 > max_len) return false;
+
+    // Convert to base 2^32, least significant limb first, 5 digits per step
+    size_t max_bytes = rest.size() * 733 / 1000 + 1;
+    ScratchBuffer<uint32_t, STACK_SIZE / 4 + 2> buffer(max_bytes / 4 + 2);
+    uint32_t* limbs = buffer.data();
+    size_t used = 0;
+    size_t pos = 0;
+    while (pos < rest.size()) {
+        size_t take = pos == 0 && rest.size() % 5 ? rest.size() % 5 : 5;
+        uint64_t carry = 0;
+        uint64_t scale = 1;
+        for (size_t i = 0; i < take; i++) {
+            int digit = BASE58_VALUES[(unsigned char)rest[pos + i]];
+            if (digit < 0) return false;
+            carry = carry * 58 + digit;
+            scale *= 58;
+        }
+        pos += take;
 
-    // Step 2: Append checksum to data
-    std::vector<unsigned char> data_with_checksum = data;
-    data_with_checksum.insert(data_with_checksum.end(), checksum.begin(), checksum.end());
+        for (size_t i = 0; i < used; i++) {
+            uint64_t value = (uint64_t)limbs[i] * scale + carry;
+            limbs[i] = (uint32_t)value;
+            carry = value >> 32;
+        }
+        if (carry) limbs[used++] = (uint32_t)carry;
+    }
 
-    // Step 3: Encode in Base58
-    return encode(data_with_checksum);
+    // Big-endian bytes without the top limb's leading zeros, after a zero
+    // byte for every leading '1'
+    size_t bytes = used * 4;
+    if (used > 0) {
+        uint32_t top = limbs[used - 1];
+        while (!(top >> 24)) {
+            top <<= 8;
+            bytes--;
+        }
+    }
+    if (leading_ones + bytes > max_len) return false;
+
+    std::memset(out, 0, leading_ones);
+    unsigned char* p = out + leading_ones + bytes;
+    for (size_t i = 0; i < used; i++) {
+        uint32_t limb = limbs[i];
+        for (int b = 0; b < 4 && p > out + leading_ones; b++) {
+            *--p = (unsigned char)limb;
+            limb >>= 8;
+        }
+    }
+    out_len = leading_ones + bytes;
+    return true;
+}
+
+bool Base58::decode(std::string_view str, std::vector<unsigned char>& out, size_t max_len) {
+    out.resize(std::min(max_len, str.size()));  // never more bytes than characters
+    size_t len = 0;
+    if (!decode(str, out.data(), out.size(), len)) {
+        out.clear();
+        return false;
+    }
+    out.resize(len);
+    return true;
+}
+
+bool Base58::decode_check(std::string_view str, std::vector<unsigned char>& out, size_t max_len) {
+    if (!decode(str, out, max_len > SIZE_MAX - 4 ? SIZE_MAX : max_len + 4) || out.size() < 4) {
+        out.clear();
+        return false;
+    }
+    size_t payload = out.size() - 4;
+    Hash256 checksum = Hash::double_sha256(out.data(), payload);
+    if (std::memcmp(checksum.data(), out.data() + payload, 4) != 0) {
+        out.clear();
+        return false;
+    }
+    out.resize(payload);
+    return true;
 }
 
-}
\ No newline at end of file
+} // namespace crypto
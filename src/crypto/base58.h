@@ -1,20 +1,52 @@
 // src/crypto/base58.h
 #pragma once
+#include <cstddef>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace crypto
 {
 
+/**
+ * Base58 and Base58Check (addresses, WIF keys)
+ *
+ * The number is converted 4 bytes or 5 characters at a time through 64-bit
+ * arithmetic - 58^5 still fits in 32 bits - instead of one byte per long
+ * division, with working buffers on the stack for anything up to
+ * STACK_SIZE bytes. The only allocation is the result itself, and the
+ * pointer overloads don't even make that.
+ */
 class Base58 {
-public: 
-    // Simple Base58Check encoding for Bitcoin address
-    static std::string encode_check(const std::vector<unsigned char>& data);
+public:
+    // Inputs up to this many bytes are converted without touching the heap
+    static constexpr size_t STACK_SIZE = 128;
 
-private:
-    static std::string encode(const std::vector<unsigned char>& data);
-    static std::vector<unsigned char> double_sha256_bytes(const std::vector<unsigned char>& data);
+    // Default limit for decoding (see decode())
+    static constexpr size_t MAX_DECODED_SIZE = 256;
+
+    // Longest possible encoding of `len` bytes (log(256) / log(58) < 1.38)
+    static constexpr size_t max_encoded_size(size_t len) { return len * 138 / 100 + 1; }
+
+    // Leading zero bytes become leading '1's
+    static std::string encode(std::span<const unsigned char> data);
+
+    // Into `out`, which must hold max_encoded_size(data.size()) chars; returns the length
+    static size_t encode(std::span<const unsigned char> data, char* out);
+
+    // Simple Base58Check encoding for Bitcoin address (data + first 4 bytes of its double SHA256)
+    static std::string encode_check(std::span<const unsigned char> data);
+
+    // False on a character outside the alphabet or a result over `max_len` bytes
+    static bool decode(std::string_view str, std::vector<unsigned char>& out, size_t max_len = MAX_DECODED_SIZE);
+
+    // Into `out` (at most `max_len` bytes), setting `out_len`
+    static bool decode(std::string_view str, unsigned char* out, size_t max_len, size_t& out_len);
+
+    // decode() that also verifies and strips the 4-byte checksum
+    static bool decode_check(std::string_view str, std::vector<unsigned char>& out,
+                             size_t max_len = MAX_DECODED_SIZE);
 };
 
 } // namespace crypto
-
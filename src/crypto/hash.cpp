@@ -1,57 +1,55 @@
 // src/crypto/hash/cpp
 #include "hash.h"
-#include <openssl/sha.h>
+#include "sha256.h"
 #include <openssl/ripemd.h>
-#include <iomanip>
-#include <sstream>
+#include <openssl/sha.h>
 
 namespace crypto {
 
-std::string Hash::sha256(const std::string& input) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)input.c_str(), input.length(), hash);
-
-    std::stringstream ss;
-    for(int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-    }
-    return ss.str();
+Hash256 Hash::sha256(const unsigned char* data, size_t len) {
+    return Sha256Writer().update(data, len).finalize();
 }
 
-std::string Hash::double_sha256(const std::string& input) {
-    // hash once
-    std::string first_hash = sha256(input);
+Hash256 Hash::sha256(const std::string& input) {
+    return sha256((const unsigned char*)input.data(), input.length());
+}
 
-    // hash again - this is what bitcoin does
+Hash256 Hash::double_sha256(const unsigned char* data, size_t len) {
+    // hash once, then hash the raw 32-byte digest again - this is what bitcoin does
     // prevents certain cryptographic attacks
-    return sha256(first_hash);
+    return Sha256Writer().update(data, len).finalize_double();
+}
+
+Hash256 Hash::double_sha256(const std::string& input) {
+    return double_sha256((const unsigned char*)input.data(), input.length());
 }
 
-std::string Hash::ripemd160(const std::string& input) {
-    unsigned char hash[RIPEMD160_DIGEST_LENGTH];
-    RIPEMD160((unsigned char*)input.c_str(), input.length(), hash);
+Hash160 Hash::ripemd160(const unsigned char* data, size_t len) {
+    Hash160 result;
+    RIPEMD160(data, len, result.data());
+    return result;
+}
+
+Hash160 Hash::ripemd160(const std::string& input) {
+    return ripemd160((const unsigned char*)input.data(), input.length());
+}
 
-    std::stringstream ss;
-    for (int i = 0; i < RIPEMD160_DIGEST_LENGTH; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-    }
-    return ss.str();
+Hash160 Hash::sha1(const unsigned char* data, size_t len) {
+    Hash160 result;
+    SHA1(data, len, result.data());
+    return result;
 }
 
-std::string Hash::hash160(const std::string& input) {
+Hash160 Hash::hash160(const unsigned char* data, size_t len) {
     // Step 1: SHA256 the input
-    std::string sha_result = sha256(input);
+    Hash256 sha_result = sha256(data, len);
 
-    // Step 2: RIPEM160 the SHA256 result
-    // Convert hex string back to binary for RIPEMD160
-    std::string binary_sha;
-    for (size_t i = 0; i < sha_result.length(); i += 2) {
-        std::string byte_str = sha_result.substr(i, 2);
-        char byte = (char)strtol(byte_str.c_str(), nullptr, 16);
-        binary_sha.push_back(byte);
-    }
-    
-    return ripemd160(binary_sha);
+    // Step 2: RIPEM160 the raw SHA256 digest
+    return ripemd160(sha_result.data(), sha_result.size());
 }
 
-}
\ No newline at end of file
+Hash160 Hash::hash160(const std::vector<unsigned char>& input) {
+    return hash160(input.data(), input.size());
+}
+
+}
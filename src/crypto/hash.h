@@ -1,23 +1,30 @@
-// src/crypto/hash.h
 #pragma once
 #include <string>
 #include <vector>
+#include "uint256.h"
 
 namespace crypto {
 
 class Hash {
 public:
     // basic SHA-256 - main hash function for bitcoin
-    static std::string sha256(const std::string& input);
+    static Hash256 sha256(const unsigned char* data, size_t len);
+    static Hash256 sha256(const std::string& input);
 
     // double SHA 256 - what bitcoin actually uses for most things
-    static std::string double_sha256(const std::string& input);
+    static Hash256 double_sha256(const unsigned char* data, size_t len);
+    static Hash256 double_sha256(const std::string& input);
 
     // RIPEM160 - used in Bitcoin address generation
-    static std::string ripemd160(const std::string& input);
+    static Hash160 ripemd160(const unsigned char* data, size_t len);
+    static Hash160 ripemd160(const std::string& input);
+
+    // SHA-1 - only for OP_SHA1 in scripts
+    static Hash160 sha1(const unsigned char* data, size_t len);
 
     // Hash160 - SHA256 + RIPEMD160 (Bitcoin's address hash)
-    static std::string hash160(const std::string& input);
+    static Hash160 hash160(const unsigned char* data, size_t len);
+    static Hash160 hash160(const std::vector<unsigned char>& input);
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,51 @@
+// src/crypto/hex.cpp
+#include "hex.h"
+#include <stdexcept>
+
+namespace crypto {
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string bytes_to_hex(const unsigned char* data, size_t len) {
+    std::string result(len * 2, '0');
+    for (size_t i = 0; i < len; i++) {
+        result[2 * i] = HEX_DIGITS[data[i] >> 4];
+        result[2 * i + 1] = HEX_DIGITS[data[i] & 0x0f];
+    }
+    return result;
+}
+
+std::string bytes_to_hex(const std::vector<unsigned char>& bytes) {
+    return bytes_to_hex(bytes.data(), bytes.size());
+}
+
+std::vector<unsigned char> hex_to_bytes(const std::string& hex) {
+    if (hex.length() % 2 != 0) {
+        throw std::invalid_argument("hex string must have an even length");
+    }
+    std::vector<unsigned char> bytes(hex.length() / 2);
+    if (!hex_to_bytes(hex, bytes.data(), bytes.size())) {
+        throw std::invalid_argument("invalid hex string");
+    }
+    return bytes;
+}
+
+bool hex_to_bytes(const std::string& hex, unsigned char* out, size_t len) {
+    if (hex.length() != len * 2) return false;
+    for (size_t i = 0; i < len; i++) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = (unsigned char)((hi << 4) | lo);
+    }
+    return true;
+}
+
+} // namespace crypto
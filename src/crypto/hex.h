@@ -0,0 +1,21 @@
+// src/crypto/hex.h
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace crypto {
+
+// Hex is only for display and user input - everything internal stays binary.
+
+// bytes -> lowercase hex string (same byte order as the input)
+std::string bytes_to_hex(const unsigned char* data, size_t len);
+std::string bytes_to_hex(const std::vector<unsigned char>& bytes);
+
+// hex string -> bytes, throws std::invalid_argument on bad input
+std::vector<unsigned char> hex_to_bytes(const std::string& hex);
+
+// decode exactly `len` bytes of hex into `out`, returns false on bad input
+bool hex_to_bytes(const std::string& hex, unsigned char* out, size_t len);
+
+} // namespace crypto
@@ -2,13 +2,12 @@
 #include "keys.h"
 #include "hash.h"
 #include "base58.h"
-#include <openssl/ec.h>
+#include "hex.h"
+#include "secp256k1.h"
 #include <openssl/rand.h>
-#include <openssl/bn.h>
-#include <openssl/sha.h>
-#include <openssl/ecdsa.h>
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 
 namespace crypto {
@@ -20,34 +19,26 @@ namespace crypto {
 // 5. everyone can verify signature w/ public key
 
 
-// helper function to convert bytes to hex
-std::string bytes_to_hex(const std::vector<unsigned char>& bytes) {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (unsigned char byte : bytes) {
-        ss << std::setw(2) << (int)byte;
-    }
-    return ss.str();
-}
+struct CachedPoint {
+    std::once_flag once;
+    std::optional<secp256k1::AffinePoint> point;    // empty if the bytes weren't a valid key
+};
 
-// helper function to convert hex to bytes
-std::vector<unsigned char> hex_to_bytes(const std::string& hex) {
-    std::vector<unsigned char> bytes;
-    for (size_t i = 0; i < hex.length(); i +=2) {
-        std::string byte_str = hex.substr(i, 2);
-        unsigned char byte = (unsigned char)strtol(byte_str.c_str(), nullptr, 16);
-        bytes.push_back(byte);
-    }
-    return bytes;
+// key bytes as a scalar; false unless 0 < key < n
+static bool parse_private_key(const std::vector<unsigned char>& bytes, secp256k1::Scalar& key) {
+    return bytes.size() == 32 && key.set_bytes(bytes.data()) && !key.is_zero();
 }
 
 // PriateKey implementation
 PrivateKey::PrivateKey() {
-    // generate 32 random bytes
+    // generate 32 random bytes (retrying in the ~2^-128 case they aren't a valid key)
     key_data.resize(32);
-    if (RAND_bytes(key_data.data(), 32) != 1) {
-        throw std::runtime_error("failed to generate random private key");
-    }
+    secp256k1::Scalar key;
+    do {
+        if (RAND_bytes(key_data.data(), 32) != 1) {
+            throw std::runtime_error("failed to generate random private key");
+        }
+    } while (!parse_private_key(key_data, key));
 }
 
 PrivateKey::PrivateKey(const std::string& hex) {
@@ -56,6 +47,10 @@ PrivateKey::PrivateKey(const std::string& hex) {
     if (key_data.size() != 32) {
         throw std::runtime_error("private key must be 32 bytes");
     }
+    secp256k1::Scalar key;
+    if (!parse_private_key(key_data, key)) {
+        throw std::runtime_error("private key out of range");
+    }
 }
 
 std::string PrivateKey::to_hex() const {
@@ -63,180 +58,184 @@ std::string PrivateKey::to_hex() const {
 }
 
 // DIGITAL SIGNATURES IMPLEMENTATION
+std::vector<unsigned char> PrivateKey::sign(const Hash256& digest) const {
+    // deterministic nonce (RFC6979) and low s, like Bitcoin Core
+    secp256k1::Scalar key, r, s;
+    parse_private_key(key_data, key);
+    secp256k1::ecdsa_sign(key, digest, r, s);
+    return secp256k1::serialize_der_signature(r, s);
+}
+
+std::vector<unsigned char> PrivateKey::sign(std::span<const unsigned char> message) const {
+    // Bitcoin signs the hash and not the raw message
+    return sign(Hash::sha256(message.data(), message.size()));
+}
+
 std::string PrivateKey::sign_message(const std::string& message) const {
-    // Step 1: Hash the message (Bitcoin signs the hash and not the raw message)
-    std::vector<unsigned char> message_bytes(message.begin(), message.end());
-    unsigned char hash[32];
-    SHA256(message_bytes.data(), message_bytes.size(), hash);
-
-    // Step 2: Setup elliptic curve for signing
-    EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!ec_key) {
-        throw std::runtime_error("Failedto create EC_KEY for signing");
+    std::span<const unsigned char> bytes(reinterpret_cast<const unsigned char*>(message.data()), message.size());
+    return bytes_to_hex(sign(bytes));
+}
+
+std::vector<unsigned char> PrivateKey::sign_schnorr(const Hash256& digest) const {
+    Hash256 aux_rand;
+    if (RAND_bytes(aux_rand.data(), (int)aux_rand.size()) != 1) {
+        throw std::runtime_error("failed to generate signing randomness");
     }
+    return sign_schnorr(digest, aux_rand);
+}
 
-    // Step 3: Set private key
-    BIGNUM* priv_bn = BN_bin2bn(key_data.data(), 32, nullptr);
-    EC_KEY_set_private_key(ec_key, priv_bn);
-
-    // Step 4: Create the signature
-    // This is the mathematical proof that we own the private key
-    ECDSA_SIG* sig = ECDSA_do_sign(hash, 32, ec_key);
-    if (!sig) {
-        BN_free(priv_bn);
-        EC_KEY_free(ec_key);
-        throw std::runtime_error("Failed to create signature");
+std::vector<unsigned char> PrivateKey::sign_schnorr(const Hash256& digest, const Hash256& aux_rand) const {
+    secp256k1::Scalar key;
+    parse_private_key(key_data, key);
+    std::vector<unsigned char> signature(64);
+    if (!secp256k1::schnorr_sign(key, digest, aux_rand.data(), signature.data())) {
+        throw std::runtime_error("schnorr nonce is zero");
     }
+    return signature;
+}
 
-    // Step 5: Convert signature to bytes
-    int sig_len = i2d_ECDSA_SIG(sig, nullptr);
-    std::vector<unsigned char> sig_bytes(sig_len);
-    unsigned char* sig_ptr = sig_bytes.data();
-    i2d_ECDSA_SIG(sig, &sig_ptr);
-
-    // Clean up
-    ECDSA_SIG_free(sig);
-    BN_free(priv_bn);
-    EC_KEY_free(ec_key);
-
-    // Return signature as hex string
-    return bytes_to_hex(sig_bytes);
-}
-
-bool PublicKey::verify_signature(const std::string& message, const std::string& signature) const{
-    try {
-        // Step 1: Hash the message (same as signing)
-        std::vector<unsigned char> message_bytes(message.begin(), message.end());
-        unsigned char hash[32];
-        SHA256(message_bytes.data(), message_bytes.size(), hash);
-
-        // Step 2: Convert signature grom hex to bytes
-        std::vector<unsigned char> sig_bytes = hex_to_bytes(signature);
-
-        // Step 3: Set up elliptic curve for verification
-        EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_secp256k1);
-        if (!ec_key) return false;
-
-        // Step 4: Set out public key
-        const EC_GROUP* group = EC_KEY_get0_group(ec_key);
-        EC_POINT* pub_point = EC_POINT_new(group);
-        if (EC_POINT_oct2point(group, pub_point, key_data.data(), key_data.size(), nullptr) != 1) {
-                EC_POINT_free(pub_point);
-                EC_KEY_free(ec_key);
-                return false;
-        }
-        EC_KEY_set_public_key(ec_key, pub_point);
-
-        // Step 5: Parse the signature
-        const unsigned char* sig_ptr = sig_bytes.data();
-        ECDSA_SIG* sig = d2i_ECDSA_SIG(nullptr, &sig_ptr, sig_bytes.size());
-        if (!sig) {
-            EC_POINT_free(pub_point);
-            EC_KEY_free(ec_key);
-            return false;
-        }
+const secp256k1::AffinePoint* PublicKey::point() const {
+    std::call_once(cache->once, [this] {
+        // decode the point once - every later verify reuses it
+        secp256k1::AffinePoint decoded;
+        if (secp256k1::parse_public_key(key_data, decoded)) cache->point = decoded;
+    });
+    return cache->point ? &*cache->point : nullptr;
+}
 
-        // Step 6: Verification - Does this signature match this public key + message
-        int result = ECDSA_do_verify(hash, 32, sig, ec_key);
+bool PublicKey::verify_signature(const std::string& message, const std::string& signature) const {
+    unsigned char sig_bytes[72];    // longest DER secp256k1 signature
+    size_t sig_len = signature.size() / 2;
+    if (sig_len > sizeof(sig_bytes) || !hex_to_bytes(signature, sig_bytes, sig_len)) return false;
+    std::span<const unsigned char> bytes(reinterpret_cast<const unsigned char*>(message.data()), message.size());
+    return verify(bytes, {sig_bytes, sig_len});
+}
 
-        // Clean up
-        ECDSA_SIG_free(sig);
-        EC_POINT_free(pub_point);
-        EC_KEY_free(ec_key);
+bool PublicKey::verify(std::span<const unsigned char> message, std::span<const unsigned char> der_signature) const {
+    return verify_digest(Hash::sha256(message.data(), message.size()), der_signature);
+}
 
-        return result == 1; // 1 = valid signature, 0 = invalid
-    } catch (...) {
-        return false;
-    }
+bool PublicKey::verify_digest(const Hash256& digest, std::span<const unsigned char> der_signature) const {
+    const secp256k1::AffinePoint* key = point();
+    secp256k1::Scalar r, s;
+    // strict DER (BIP66), then: does this signature match this public key + message
+    return key && secp256k1::parse_der_signature(der_signature, r, s) &&
+           secp256k1::ecdsa_verify(*key, digest, r, s);
 }
 
 std::string PublicKey::to_bitcoin_address() const {
-    // Step 1: Get public key as hex string
-    std::string pub_key_hex = to_hex();
-
-    // Step 2: Convert hex to binary for hashing
-    std::string pub_key_binary;
-    for (size_t i = 0; i < pub_key_hex.length(); i += 2) {
-        std::string byte_str = pub_key_hex.substr(i, 2);
-        char byte = (char)strtol(byte_str.c_str(), nullptr, 16);
-        pub_key_binary.push_back(byte);
-    }
-
-    // Step 3: Hash160 the public key (SHA256 + RIPEMD160)
-    std::string hash160_result = crypto::Hash::hash160(pub_key_binary);
+    // Step 1: Hash160 the public key (SHA256 + RIPEMD160)
+    Hash160 pub_key_hash = crypto::Hash::hash160(key_data);
 
-    // Step 4: Add verion byte (0x00 for mainet)
+    // Step 2: Add verion byte (0x00 for mainet)
     std::vector<unsigned char> versionned_hash;
     versionned_hash.push_back(0x00); // Version byte for mainned P2PKH
+    versionned_hash.insert(versionned_hash.end(), pub_key_hash.begin(), pub_key_hash.end());
 
-    // Convert hash160 hex to bytes
-    for (size_t i = 0; i < hash160_result.length(); i += 2) {
-        std::string byte_str = hash160_result.substr(i, 2);
-        unsigned char byte = (unsigned char)strtol(byte_str.c_str(), nullptr, 16);
-        versionned_hash.push_back(byte);
-    }
-
-    // Step 5: Base58Check encode
+    // Step 3: Base58Check encode
     return crypto::Base58::encode_check(versionned_hash);
 }
 
 // PublicKey implementation
 // elliptic curve math: Public = Private * G (G is a location on a curve)
-PublicKey::PublicKey(const PrivateKey& private_key) {
-    // create EC_KEY object for secp256k1 curve
-    EC_KEY* ec_key = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!ec_key) {
-        throw std::runtime_error("failed to create EC_KEY");
-    }
-
-    // convert private key bytes to BIGNUM
-    BIGNUM* priv_bn = BN_bin2bn(private_key.get_bytes().data(), 32, nullptr);
-    if (!priv_bn) {
-        EC_KEY_free(ec_key);
-        throw std::runtime_error("failed to create BIGNUM from private keys");
-    }
-
-    // set the private key
-    if (EC_KEY_set_private_key(ec_key, priv_bn) != 1) {
-        BN_free(priv_bn);
-        EC_KEY_free(ec_key);
-        throw std::runtime_error("failed to set private key");
-    }
+PublicKey::PublicKey(const PrivateKey& private_key) : cache(std::make_shared<CachedPoint>()) {
+    secp256k1::Scalar key;
+    parse_private_key(private_key.get_bytes(), key);
 
-    // generate public key using elliptic curve math
+    // generate public key using elliptic curve math (constant time, from a table of multiples of G)
     // the follow does: Public Key = Private * G (where G is the generated point)
-    const EC_GROUP* group = EC_KEY_get0_group(ec_key);
-    EC_POINT* pub_point = EC_POINT_new(group);
-    if (EC_POINT_mul(group, pub_point, priv_bn, nullptr, nullptr, nullptr) != 1) {
-        EC_POINT_free(pub_point);
-        BN_free(priv_bn);
-        EC_KEY_free(ec_key);
-        throw std::runtime_error("failed to generate public key");
-    }
+    secp256k1::AffinePoint pub_point = secp256k1::multiply_generator(key).to_affine();
 
-    // convert to compressed format (33 bytes)
-    size_t pub_key_len = EC_POINT_point2oct(group, pub_point, POINT_CONVERSION_COMPRESSED, nullptr, 0, nullptr);
-    key_data.resize(pub_key_len);
-    EC_POINT_point2oct(group, pub_point, POINT_CONVERSION_COMPRESSED, key_data.data(), pub_key_len, nullptr);
-
-    // cleanup
-    EC_POINT_free(pub_point);
-    BN_free(priv_bn);
-    EC_KEY_free(ec_key);
+    // convert to compressed format (33 bytes), and keep the point for verifying
+    key_data = secp256k1::serialize_public_key(pub_point, true);
+    std::call_once(cache->once, [&] { cache->point = pub_point; });
 
     // result: there is now a public key that mathematically relates to the private key
     // this process can't be reversed to get the private key though
 }
 
-PublicKey::PublicKey(const std::string& hex) {
+PublicKey::PublicKey(const std::string& hex) : cache(std::make_shared<CachedPoint>()) {
     key_data = hex_to_bytes(hex);
     if (key_data.size() != 33 && key_data.size() != 65) {
         throw std::invalid_argument("public key must be 33 or 65 bytes");
     }
 }
 
+PublicKey::PublicKey(std::span<const unsigned char> bytes)
+    : key_data(bytes.begin(), bytes.end()), cache(std::make_shared<CachedPoint>()) {
+    if (key_data.size() != 33 && key_data.size() != 65) {
+        throw std::invalid_argument("public key must be 33 or 65 bytes");
+    }
+}
+
 std::string PublicKey::to_hex() const {
     return bytes_to_hex(key_data);
 }
 
-}
\ No newline at end of file
+// XOnlyPublicKey implementation
+XOnlyPublicKey::XOnlyPublicKey(const PrivateKey& private_key) : cache(std::make_shared<CachedPoint>()) {
+    // same point as the full public key - BIP340 just drops the y coordinate and
+    // always means the even one (signing negates the key when that's the other one)
+    PublicKey full(private_key);
+    key_data.assign(full.get_bytes().begin() + 1, full.get_bytes().end());
+}
+
+XOnlyPublicKey::XOnlyPublicKey(const std::string& hex) : cache(std::make_shared<CachedPoint>()) {
+    key_data = hex_to_bytes(hex);
+    if (key_data.size() != 32) {
+        throw std::invalid_argument("x-only public key must be 32 bytes");
+    }
+}
+
+XOnlyPublicKey::XOnlyPublicKey(std::span<const unsigned char> bytes)
+    : key_data(bytes.begin(), bytes.end()), cache(std::make_shared<CachedPoint>()) {
+    if (key_data.size() != 32) {
+        throw std::invalid_argument("x-only public key must be 32 bytes");
+    }
+}
+
+const secp256k1::AffinePoint* XOnlyPublicKey::point() const {
+    std::call_once(cache->once, [this] {
+        secp256k1::AffinePoint lifted;
+        if (secp256k1::lift_x(key_data.data(), lifted)) cache->point = lifted;
+    });
+    return cache->point ? &*cache->point : nullptr;
+}
+
+std::string XOnlyPublicKey::to_hex() const {
+    return bytes_to_hex(key_data);
+}
+
+bool XOnlyPublicKey::verify_schnorr(const Hash256& digest, std::span<const unsigned char> signature) const {
+    const secp256k1::AffinePoint* key = point();
+    return key && signature.size() == 64 && secp256k1::schnorr_verify(*key, digest, signature.data());
+}
+
+// SchnorrBatch implementation
+void SchnorrBatch::add(const XOnlyPublicKey& key, const Hash256& digest, std::span<const unsigned char> signature) {
+    if (signature.size() != 64) {
+        malformed = true;
+        return;
+    }
+    Entry& entry = entries.emplace_back(Entry{key, digest, {}});
+    std::copy(signature.begin(), signature.end(), entry.signature.begin());
+}
+
+bool SchnorrBatch::verify() const {
+    if (malformed) return false;
+    std::vector<secp256k1::SchnorrBatchEntry> batch;
+    batch.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        const secp256k1::AffinePoint* key = entry.key.point();
+        if (!key) return false;
+        batch.push_back({key, &entry.digest, entry.signature.data()});
+    }
+    return secp256k1::schnorr_verify_batch(batch);
+}
+
+void SchnorrBatch::clear() {
+    entries.clear();
+    malformed = false;
+}
+
+}
@@ -1,19 +1,28 @@
 // src/crypto/keys.h
 #pragma once
+#include <array>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
+#include "uint256.h"
 
 namespace crypto {
 
+namespace secp256k1 { struct AffinePoint; }
+
+// Decoded curve point, built on first use and shared by copies of a key
+struct CachedPoint;
+
 class PrivateKey {
 private: 
-    std::vector<unsigned char> key_data; // 32 bytes
+    std::vector<unsigned char> key_data; // 32 bytes, in [1, n-1]
 
 public: 
     // generate a random private key
     PrivateKey();
 
-    // create from hex string
+    // create from hex string (throws std::runtime_error unless it is a valid key)
     PrivateKey(const std::string& hex);
 
     // get as hex string
@@ -23,13 +32,30 @@ public:
     const std::vector<unsigned char>& get_bytes() const { return key_data;}
 
     // DIGITAL SIGNATURES
-    // Sign a message with private key
+    // Sign a message with private key (SHA256 of the message, hex DER signature)
     std::string sign_message(const std::string& message) const;
+
+    // DER signature over an already hashed message (a sighash)
+    std::vector<unsigned char> sign(const Hash256& digest) const;
+
+    // DER signature over SHA256(message)
+    std::vector<unsigned char> sign(std::span<const unsigned char> message) const;
+
+    // BIP340 Schnorr signature (64 bytes) over an already hashed message,
+    // with fresh random bytes mixed into the nonce
+    std::vector<unsigned char> sign_schnorr(const Hash256& digest) const;
+
+    // Same with caller-chosen auxiliary randomness (deterministic)
+    std::vector<unsigned char> sign_schnorr(const Hash256& digest, const Hash256& aux_rand) const;
 };
 
 class PublicKey {
 private:
     std::vector<unsigned char> key_data; // 33 bytes (compressed)
+    std::shared_ptr<CachedPoint> cache;  // curve point, decoded on first verify
+
+    // nullptr if the bytes aren't a point on the curve
+    const secp256k1::AffinePoint* point() const;
 
 public: 
     // create from private key
@@ -38,6 +64,9 @@ public:
     // create from hex string
     PublicKey(const std::string& hex);
 
+    // create from raw bytes (33 compressed or 65 uncompressed)
+    explicit PublicKey(std::span<const unsigned char> bytes);
+
     // get as hex string
     std::string to_hex() const;
 
@@ -48,9 +77,81 @@ public:
     // Verify that a signature was made by the private key that matches this public key
     bool verify_signature(const std::string& message, const std::string& signature) const;
 
+    // Same with raw bytes - no hex on the way
+    bool verify(std::span<const unsigned char> message, std::span<const unsigned char> der_signature) const;
+
+    // Verify a strict DER signature over an already hashed message (a sighash)
+    bool verify_digest(const Hash256& digest, std::span<const unsigned char> der_signature) const;
+
+    // Is this a point on the curve? (decodes and caches it)
+    bool is_valid() const { return point() != nullptr; }
+
     // BITCOIN ADDRESS GENERATION
     // Convert this public key into a Bitcoin address
     std::string to_bitcoin_address() const;
 };
 
+// BIP340 public key: only the x coordinate (32 bytes) of a point with even y
+class XOnlyPublicKey {
+private:
+    std::vector<unsigned char> key_data; // 32 bytes
+    std::shared_ptr<CachedPoint> cache;  // curve point, lifted on first verify
+
+    // nullptr if no point has this x coordinate
+    const secp256k1::AffinePoint* point() const;
+
+    friend class SchnorrBatch;
+
+public:
+    // create from private key (the key itself may belong to the odd-y point)
+    XOnlyPublicKey(const PrivateKey& private_key);
+
+    // create from hex string
+    XOnlyPublicKey(const std::string& hex);
+
+    // create from raw bytes (32)
+    explicit XOnlyPublicKey(std::span<const unsigned char> bytes);
+
+    // get as hex string
+    std::string to_hex() const;
+
+    // get the raw bytes
+    const std::vector<unsigned char>& get_bytes() const { return key_data;}
+
+    // Verify a 64-byte BIP340 signature over an already hashed message
+    bool verify_schnorr(const Hash256& digest, std::span<const unsigned char> signature) const;
+
+    // Is this the x coordinate of a point on the curve? (lifts and caches it)
+    bool is_valid() const { return point() != nullptr; }
+};
+
+/**
+ * Batch BIP340 verification
+ *
+ * Collects signatures and checks all of them with one multi-scalar
+ * multiplication, which for a block's worth of signatures is a few times
+ * cheaper than verifying them one by one. verify() only says whether every
+ * signature is valid; to find the bad one, check them individually.
+ */
+class SchnorrBatch {
+private:
+    struct Entry {
+        XOnlyPublicKey key;
+        Hash256 digest;
+        std::array<unsigned char, 64> signature;
+    };
+
+    std::vector<Entry> entries;
+    bool malformed = false;     // a signature that wasn't 64 bytes was added
+
+public:
+    void add(const XOnlyPublicKey& key, const Hash256& digest, std::span<const unsigned char> signature);
+
+    // True if every added signature is valid (an empty batch is)
+    bool verify() const;
+
+    size_t size() const { return entries.size(); }
+    void clear();
+};
+
 }
\ No newline at end of file
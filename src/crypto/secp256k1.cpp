@@ -0,0 +1,974 @@
+// src/crypto/secp256k1.cpp
+#include "secp256k1.h"
+#include "sha256.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace crypto {
+namespace secp256k1 {
+
+static uint64_t read_be64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static void write_be64(unsigned char* p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (unsigned char)v;
+        v >>= 8;
+    }
+}
+
+// FIELD
+
+bool FieldElement::set_bytes(const unsigned char* bytes) {
+    uint64_t w0 = read_be64(bytes + 24), w1 = read_be64(bytes + 16), w2 = read_be64(bytes + 8), w3 = read_be64(bytes);
+    n[0] = w0 & M52;
+    n[1] = ((w0 >> 52) | (w1 << 12)) & M52;
+    n[2] = ((w1 >> 40) | (w2 << 24)) & M52;
+    n[3] = ((w2 >> 28) | (w3 << 36)) & M52;
+    n[4] = w3 >> 16;
+    bool overflow = n[4] == M48 && (n[3] & n[2] & n[1]) == M52 && n[0] >= 0xFFFFEFFFFFC2FULL;
+    normalize();
+    return !overflow;
+}
+
+void FieldElement::get_bytes(unsigned char* out) const {
+    FieldElement t = *this;
+    t.normalize();
+    write_be64(out + 24, t.n[0] | (t.n[1] << 52));
+    write_be64(out + 16, (t.n[1] >> 12) | (t.n[2] << 40));
+    write_be64(out + 8, (t.n[2] >> 24) | (t.n[3] << 28));
+    write_be64(out, (t.n[3] >> 36) | (t.n[4] << 16));
+}
+
+// Shared start of the inverse and square root chains: a^(2^223 - 1), plus
+// the a^(2^22 - 1) and a^(2^2 - 1) steps the tails need
+static FieldElement pow_2_223_minus_1(const FieldElement& a, FieldElement& x22, FieldElement& x2) {
+    x2 = a.square() * a;
+    FieldElement x3 = x2.square() * a;
+    FieldElement x6 = x3.square(3) * x3;
+    FieldElement x9 = x6.square(3) * x3;
+    FieldElement x11 = x9.square(2) * x2;
+    x22 = x11.square(11) * x11;
+    FieldElement x44 = x22.square(22) * x22;
+    FieldElement x88 = x44.square(44) * x44;
+    FieldElement x176 = x88.square(88) * x88;
+    FieldElement x220 = x176.square(44) * x44;
+    return x220.square(3) * x3;
+}
+
+FieldElement FieldElement::inverse() const {
+    FieldElement x22, x2;
+    FieldElement t = pow_2_223_minus_1(*this, x22, x2);
+    t = t.square(23) * x22;
+    t = t.square(5) * *this;
+    t = t.square(3) * x2;
+    return t.square(2) * *this;
+}
+
+bool FieldElement::sqrt(FieldElement& root) const {
+    FieldElement x22, x2;
+    FieldElement t = pow_2_223_minus_1(*this, x22, x2);
+    t = t.square(23) * x22;
+    t = t.square(6) * x2;
+    root = t.square(2);
+    return root.square() == *this;
+}
+
+// SCALAR
+
+static constexpr Scalar make_scalar(uint64_t d0, uint64_t d1, uint64_t d2, uint64_t d3) {
+    Scalar s;
+    s.d[0] = d0; s.d[1] = d1; s.d[2] = d2; s.d[3] = d3;
+    return s;
+}
+
+// r = a - b over 256 bits; returns the borrow
+static uint64_t sub256(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        u128 t = (u128)a[i] - b[i] - borrow;
+        r[i] = (uint64_t)t;
+        borrow = (uint64_t)(t >> 64) & 1;
+    }
+    return borrow;
+}
+
+// Subtract n if the value (plus an overflow bit) is at least n - constant time
+static void reduce_once(uint64_t d[4], uint64_t overflow) {
+    uint64_t t[4];
+    uint64_t borrow = sub256(t, d, Scalar::N);
+    uint64_t mask = 0 - ((borrow ^ 1) | overflow);
+    for (int i = 0; i < 4; i++) d[i] ^= mask & (d[i] ^ t[i]);
+}
+
+bool Scalar::set_bytes(const unsigned char* bytes) {
+    for (int i = 0; i < 4; i++) d[i] = read_be64(bytes + 24 - 8 * i);
+    uint64_t t[4];
+    bool overflow = !sub256(t, d, N);
+    reduce_once(d, 0);
+    return !overflow;
+}
+
+void Scalar::get_bytes(unsigned char* out) const {
+    for (int i = 0; i < 4; i++) write_be64(out + 24 - 8 * i, d[i]);
+}
+
+bool Scalar::is_high() const {
+    static constexpr uint64_t HALF[4] = {0xDFE92F46681B20A0ULL, 0x5D576E7357A4501DULL,
+                                         0xFFFFFFFFFFFFFFFFULL, 0x7FFFFFFFFFFFFFFFULL};
+    uint64_t t[4];
+    return sub256(t, HALF, d);
+}
+
+Scalar operator+(const Scalar& a, const Scalar& b) {
+    Scalar r;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        u128 t = (u128)a.d[i] + b.d[i] + carry;
+        r.d[i] = (uint64_t)t;
+        carry = (uint64_t)(t >> 64);
+    }
+    reduce_once(r.d, carry);
+    return r;
+}
+
+Scalar Scalar::operator-() const {
+    Scalar r;
+    sub256(r.d, N, d);
+    uint64_t mask = 0 - (uint64_t)!is_zero();
+    for (int i = 0; i < 4; i++) r.d[i] &= mask;
+    return r;
+}
+
+static void mul512(uint64_t l[8], const uint64_t a[4], const uint64_t b[4]) {
+    std::memset(l, 0, 8 * sizeof(uint64_t));
+    for (int i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; j++) {
+            u128 t = (u128)a[i] * b[j] + l[i + j] + carry;
+            l[i + j] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        l[i + 4] = carry;
+    }
+}
+
+// 512-bit value mod n. Folding the top half in as hi * (2^256 - n) shrinks it
+// to 385, 258, 131 and finally 256 bits; the fixed pass count keeps it
+// constant time.
+static Scalar reduce512(const uint64_t in[8]) {
+    uint64_t l[8];
+    std::memcpy(l, in, sizeof(l));
+    for (int pass = 0; pass < 5; pass++) {
+        uint64_t out[8] = {l[0], l[1], l[2], l[3], 0, 0, 0, 0};
+        for (int i = 0; i < 4; i++) {
+            uint64_t carry = 0;
+            for (int j = 0; j < 3; j++) {
+                u128 t = (u128)l[4 + i] * Scalar::N_C[j] + out[i + j] + carry;
+                out[i + j] = (uint64_t)t;
+                carry = (uint64_t)(t >> 64);
+            }
+            for (int k = i + 3; k < 8; k++) {
+                u128 t = (u128)out[k] + carry;
+                out[k] = (uint64_t)t;
+                carry = (uint64_t)(t >> 64);
+            }
+        }
+        std::memcpy(l, out, sizeof(l));
+    }
+    Scalar r = make_scalar(l[0], l[1], l[2], l[3]);
+    reduce_once(r.d, 0);
+    return r;
+}
+
+Scalar operator*(const Scalar& a, const Scalar& b) {
+    uint64_t l[8];
+    mul512(l, a.d, b.d);
+    return reduce512(l);
+}
+
+Scalar Scalar::inverse() const {
+    // Fixed 4-bit windows over n - 2, table entries picked without branching
+    static constexpr Scalar EXPONENT = make_scalar(0xBFD25E8CD036413FULL, 0xBAAEDCE6AF48A03BULL,
+                                                   0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL);
+    Scalar powers[16];
+    powers[0] = Scalar(1);
+    for (int i = 1; i < 16; i++) powers[i] = powers[i - 1] * *this;
+
+    Scalar r(1);
+    for (int w = 63; w >= 0; w--) {
+        for (int i = 0; i < 4; i++) r = r * r;
+        uint32_t bits = EXPONENT.get_bits(4 * w, 4);
+        Scalar factor;
+        for (uint32_t i = 0; i < 16; i++) factor.cmov(powers[i], i == bits);
+        r = r * factor;
+    }
+    return r;
+}
+
+// round(a * b / 2^384)
+static Scalar mul_shift_384(const Scalar& a, const Scalar& b) {
+    uint64_t l[8];
+    mul512(l, a.d, b.d);
+    uint64_t round = l[5] >> 63;
+    u128 lo = (u128)l[6] + round;
+    return make_scalar((uint64_t)lo, l[7] + (uint64_t)(lo >> 64), 0, 0);
+}
+
+// GLV decomposition constants (libsecp256k1's scalar_split_lambda)
+static constexpr Scalar LAMBDA = make_scalar(0xDF02967C1B23BD72ULL, 0x122E22EA20816678ULL,
+                                             0xA5261C028812645AULL, 0x5363AD4CC05C30E0ULL);
+static constexpr Scalar MINUS_B1 = make_scalar(0x6F547FA90ABFE4C3ULL, 0xE4437ED6010E8828ULL, 0, 0);
+static constexpr Scalar MINUS_B2 = make_scalar(0xD765CDA83DB1562CULL, 0x8A280AC50774346DULL,
+                                               0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL);
+static constexpr Scalar G1 = make_scalar(0xE893209A45DBB031ULL, 0x3DAA8A1471E8CA7FULL,
+                                         0xE86C90E49284EB15ULL, 0x3086D221A7D46BCDULL);
+static constexpr Scalar G2 = make_scalar(0x1571B4AE8AC47F71ULL, 0x221208AC9DF506C6ULL,
+                                         0x6F547FA90ABFE4C4ULL, 0xE4437ED6010E8828ULL);
+
+void Scalar::split_lambda(Scalar& r1, Scalar& r2) const {
+    Scalar c1 = mul_shift_384(*this, G1);
+    Scalar c2 = mul_shift_384(*this, G2);
+    r2 = c1 * MINUS_B1 + c2 * MINUS_B2;
+    r1 = *this + -(r2 * LAMBDA);
+}
+
+// GROUP
+
+static const unsigned char GENERATOR_X[32] = {
+    0x79, 0xBE, 0x66, 0x7E, 0xF9, 0xDC, 0xBB, 0xAC, 0x55, 0xA0, 0x62, 0x95, 0xCE, 0x87, 0x0B, 0x07,
+    0x02, 0x9B, 0xFC, 0xDB, 0x2D, 0xCE, 0x28, 0xD9, 0x59, 0xF2, 0x81, 0x5B, 0x16, 0xF8, 0x17, 0x98};
+static const unsigned char GENERATOR_Y[32] = {
+    0x48, 0x3A, 0xDA, 0x77, 0x26, 0xA3, 0xC4, 0x65, 0x5D, 0xA4, 0xFB, 0xFC, 0x0E, 0x11, 0x08, 0xA8,
+    0xFD, 0x17, 0xB4, 0x48, 0xA6, 0x85, 0x54, 0x19, 0x9C, 0x47, 0xD0, 0x8F, 0xFB, 0x10, 0xD4, 0xB8};
+// Cube root of unity mod p: lambda * (x, y) = (beta * x, y)
+static const unsigned char BETA[32] = {
+    0x7A, 0xE9, 0x6A, 0x2B, 0x65, 0x7C, 0x07, 0x10, 0x6E, 0x64, 0x47, 0x9E, 0xAC, 0x34, 0x34, 0xE9,
+    0x9C, 0xF0, 0x49, 0x75, 0x12, 0xF5, 0x89, 0x95, 0xC1, 0x39, 0x6C, 0x28, 0x71, 0x95, 0x01, 0xEE};
+
+static FieldElement field_from_bytes(const unsigned char* bytes) {
+    FieldElement f;
+    f.set_bytes(bytes);
+    return f;
+}
+
+const AffinePoint& generator() {
+    static const AffinePoint g(field_from_bytes(GENERATOR_X), field_from_bytes(GENERATOR_Y));
+    return g;
+}
+
+static const FieldElement& beta() {
+    static const FieldElement b = field_from_bytes(BETA);
+    return b;
+}
+
+bool AffinePoint::is_on_curve() const {
+    if (infinity) return false;
+    return y.square() == x.square() * x + FieldElement(7);
+}
+
+JacobianPoint JacobianPoint::doubled() const {
+    if (infinity) return *this;
+    JacobianPoint r;
+    r.infinity = false;
+    FieldElement y2 = y.square();
+    FieldElement s = (x * y2).mul_int(4);
+    FieldElement m = x.square().mul_int(3);
+    r.x = m.square() - s.mul_int(2);
+    r.y = m * (s - r.x) - y2.square().mul_int(8);
+    r.z = (y * z).mul_int(2);
+    return r;
+}
+
+// Shared tail of both additions: H = U2 - U1, R = S2 - S1
+static JacobianPoint finish_add(const FieldElement& u1, const FieldElement& s1, const FieldElement& h,
+                                const FieldElement& rr, const FieldElement& z) {
+    JacobianPoint r;
+    r.infinity = false;
+    FieldElement hh = h.square();
+    FieldElement hhh = h * hh;
+    FieldElement v = u1 * hh;
+    r.x = rr.square() - hhh - v.mul_int(2);
+    r.y = rr * (v - r.x) - s1 * hhh;
+    r.z = z * h;
+    return r;
+}
+
+JacobianPoint JacobianPoint::add(const JacobianPoint& b) const {
+    if (infinity) return b;
+    if (b.infinity) return *this;
+    FieldElement z1z1 = z.square();
+    FieldElement z2z2 = b.z.square();
+    FieldElement u1 = x * z2z2;
+    FieldElement s1 = y * b.z * z2z2;
+    FieldElement h = b.x * z1z1 - u1;
+    FieldElement rr = b.y * z * z1z1 - s1;
+    if (h.is_zero()) return rr.is_zero() ? doubled() : JacobianPoint();
+    return finish_add(u1, s1, h, rr, z * b.z);
+}
+
+JacobianPoint JacobianPoint::add(const AffinePoint& b) const {
+    if (infinity) return JacobianPoint(b);
+    if (b.infinity) return *this;
+    FieldElement z1z1 = z.square();
+    FieldElement h = b.x * z1z1 - x;
+    FieldElement rr = b.y * z * z1z1 - y;
+    if (h.is_zero()) return rr.is_zero() ? doubled() : JacobianPoint();
+    return finish_add(x, y, h, rr, z);
+}
+
+// Mixed addition with no special cases: the caller guarantees neither point
+// is infinity and a != +-b (and discards the result otherwise)
+static JacobianPoint add_unchecked(const JacobianPoint& a, const AffinePoint& b) {
+    FieldElement z1z1 = a.z.square();
+    FieldElement h = b.x * z1z1 - a.x;
+    FieldElement rr = b.y * a.z * z1z1 - a.y;
+    return finish_add(a.x, a.y, h, rr, a.z);
+}
+
+JacobianPoint JacobianPoint::negate() const {
+    JacobianPoint r = *this;
+    r.y = -y;
+    return r;
+}
+
+AffinePoint JacobianPoint::to_affine() const {
+    if (infinity) return AffinePoint();
+    FieldElement zi = z.inverse();
+    FieldElement zi2 = zi.square();
+    AffinePoint r(x * zi2, y * zi2 * zi);
+    r.x.normalize();
+    r.y.normalize();
+    return r;
+}
+
+std::vector<AffinePoint> batch_to_affine(std::span<const JacobianPoint> points) {
+    // Montgomery's trick: invert the product of all z, then peel off each one
+    std::vector<AffinePoint> out(points.size());
+    std::vector<FieldElement> prefix(points.size());
+    FieldElement acc(1);
+    for (size_t i = 0; i < points.size(); i++) {
+        prefix[i] = acc;
+        if (!points[i].infinity) acc = acc * points[i].z;
+    }
+    FieldElement inv = acc.inverse();
+    for (size_t i = points.size(); i-- > 0;) {
+        if (points[i].infinity) continue;
+        FieldElement zi = inv * prefix[i];
+        inv = inv * points[i].z;
+        FieldElement zi2 = zi.square();
+        out[i] = AffinePoint(points[i].x * zi2, points[i].y * zi2 * zi);
+        out[i].x.normalize();
+        out[i].y.normalize();
+    }
+    return out;
+}
+
+// PRECOMPUTED TABLES
+
+static constexpr int GEN_WINDOWS = 64;      // 4-bit windows for constant-time k * G
+static constexpr int WINDOW_A = 5;          // wNAF width for the verified key
+static constexpr int WINDOW_G = 10;         // wNAF width for G (static tables)
+static constexpr int TABLE_G_SIZE = 1 << (WINDOW_G - 2);
+
+struct Tables {
+    AffinePoint gen[GEN_WINDOWS][16];       // gen[i][j] = j * 16^i * G, j >= 1
+    AffinePoint g_odd[TABLE_G_SIZE];        // (2j + 1) * G
+    AffinePoint g128_odd[TABLE_G_SIZE];     // (2j + 1) * 2^128 * G
+};
+
+// Odd multiples P, 3P, 5P, ... as Jacobian points
+static std::vector<JacobianPoint> odd_multiples(const JacobianPoint& p, size_t count) {
+    std::vector<JacobianPoint> out(count);
+    JacobianPoint twice = p.doubled();
+    out[0] = p;
+    for (size_t i = 1; i < count; i++) out[i] = out[i - 1].add(twice);
+    return out;
+}
+
+static std::unique_ptr<Tables> build_tables() {
+    auto tables = std::make_unique<Tables>();
+
+    std::vector<JacobianPoint> gen;
+    gen.reserve(GEN_WINDOWS * 15);
+    JacobianPoint base(generator());
+    for (int i = 0; i < GEN_WINDOWS; i++) {
+        JacobianPoint multiple = base;
+        for (int j = 1; j < 16; j++) {
+            gen.push_back(multiple);
+            multiple = multiple.add(base);
+        }
+        base = multiple;    // 16 * base
+    }
+    std::vector<AffinePoint> affine = batch_to_affine(gen);
+    for (int i = 0; i < GEN_WINDOWS; i++) {
+        for (int j = 1; j < 16; j++) tables->gen[i][j] = affine[i * 15 + j - 1];
+    }
+
+    JacobianPoint g(generator());
+    JacobianPoint g128 = g;
+    for (int i = 0; i < 128; i++) g128 = g128.doubled();
+    std::vector<JacobianPoint> odd = odd_multiples(g, TABLE_G_SIZE);
+    std::vector<JacobianPoint> odd128 = odd_multiples(g128, TABLE_G_SIZE);
+    odd.insert(odd.end(), odd128.begin(), odd128.end());
+    affine = batch_to_affine(odd);
+    std::copy(affine.begin(), affine.begin() + TABLE_G_SIZE, tables->g_odd);
+    std::copy(affine.begin() + TABLE_G_SIZE, affine.end(), tables->g128_odd);
+    return tables;
+}
+
+// Built on first use (a few milliseconds), then read-only and shared by all threads
+static const Tables& tables() {
+    static const std::unique_ptr<Tables> instance = build_tables();
+    return *instance;
+}
+
+JacobianPoint multiply_generator(const Scalar& k) {
+    const Tables& t = tables();
+    JacobianPoint r;
+    r.x = r.y = r.z = FieldElement(1);
+    bool empty = true;
+
+    for (int i = 0; i < GEN_WINDOWS; i++) {
+        uint32_t bits = k.get_bits(4 * i, 4);
+        // Read every entry so the memory access pattern doesn't depend on k
+        AffinePoint entry(FieldElement(1), FieldElement(1));
+        for (uint32_t j = 1; j < 16; j++) {
+            entry.x.cmov(t.gen[i][j].x, j == bits);
+            entry.y.cmov(t.gen[i][j].y, j == bits);
+        }
+
+        // r and entry can't be equal or opposite: r is a sum of lower windows
+        JacobianPoint sum = add_unchecked(r, entry);
+        bool take_sum = bits != 0 && !empty;
+        bool take_entry = bits != 0 && empty;
+        r.x.cmov(sum.x, take_sum);
+        r.y.cmov(sum.y, take_sum);
+        r.z.cmov(sum.z, take_sum);
+        r.x.cmov(entry.x, take_entry);
+        r.y.cmov(entry.y, take_entry);
+        r.z.cmov(FieldElement(1), take_entry);
+        empty = empty && bits == 0;
+    }
+    r.infinity = empty;
+    return r;
+}
+
+// Width-w NAF of a non-negative value: odd digits in (-2^(w-1), 2^(w-1)),
+// least significant first. Returns the number of digits.
+static int wnaf(int* out, const Scalar& value, int w) {
+    uint64_t v[5] = {value.d[0], value.d[1], value.d[2], value.d[3], 0};
+    int len = 0;
+    while (v[0] | v[1] | v[2] | v[3] | v[4]) {
+        int digit = 0;
+        if (v[0] & 1) {
+            digit = (int)(v[0] & ((1u << w) - 1));
+            if (digit >= (1 << (w - 1))) digit -= 1 << w;
+            // v -= digit (adding when negative), carrying through the limbs
+            if (digit > 0) {
+                v[0] -= (uint64_t)digit;
+            } else {
+                uint64_t add = (uint64_t)-digit;
+                for (int i = 0; i < 5 && add; i++) {
+                    v[i] += add;
+                    add = v[i] < add ? 1 : 0;
+                }
+            }
+        }
+        out[len++] = digit;
+        for (int i = 0; i < 4; i++) v[i] = (v[i] >> 1) | (v[i + 1] << 63);
+        v[4] >>= 1;
+    }
+    return len;
+}
+
+static JacobianPoint add_digit(const JacobianPoint& r, const AffinePoint* odd, int digit) {
+    return digit > 0 ? r.add(odd[(digit - 1) / 2]) : r.add(odd[(-digit - 1) / 2].negate());
+}
+
+static constexpr int MAX_DIGITS = 258;
+static constexpr int TABLE_A_SIZE = 1 << (WINDOW_A - 2);
+static constexpr size_t PIPPENGER_THRESHOLD = 64;   // points; fewer go through Strauss
+
+// wNAF of a GLV half, which may come out negative (high)
+static int wnaf_signed(int* out, Scalar k, int w) {
+    bool negate = k.is_high();
+    if (negate) k = -k;
+    int len = wnaf(out, k, w);
+    if (negate) for (int i = 0; i < len; i++) out[i] = -out[i];
+    return len;
+}
+
+static JacobianPoint strauss(std::span<const AffinePoint> points, std::span<const Scalar> scalars, const Scalar& ng) {
+    const Tables& t = tables();
+    size_t n = points.size();
+
+    // Every na * a becomes a1 * a + a2 * (lambda * a) with both halves ~128
+    // bits; lambda * A is (beta * x, y), so its table costs no additions
+    std::vector<int> digits(2 * n * MAX_DIGITS);
+    std::vector<int> lengths(2 * n, 0);
+    std::vector<JacobianPoint> odd(n * TABLE_A_SIZE);
+    int len = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (points[i].infinity || scalars[i].is_zero()) continue;
+        Scalar a1, a2;
+        scalars[i].split_lambda(a1, a2);
+        lengths[2 * i] = wnaf_signed(&digits[2 * i * MAX_DIGITS], a1, WINDOW_A);
+        lengths[2 * i + 1] = wnaf_signed(&digits[(2 * i + 1) * MAX_DIGITS], a2, WINDOW_A);
+        len = std::max({len, lengths[2 * i], lengths[2 * i + 1]});
+
+        JacobianPoint* table = &odd[i * TABLE_A_SIZE];
+        table[0] = JacobianPoint(points[i]);
+        JacobianPoint twice = table[0].doubled();
+        for (int j = 1; j < TABLE_A_SIZE; j++) table[j] = table[j - 1].add(twice);
+    }
+
+    // Affine tables (one shared inversion) make every addition a cheaper mixed one
+    std::vector<AffinePoint> affine = batch_to_affine(odd);
+    std::vector<AffinePoint> tables_a(2 * n * TABLE_A_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        for (int j = 0; j < TABLE_A_SIZE; j++) {
+            const AffinePoint& p = affine[i * TABLE_A_SIZE + j];
+            tables_a[2 * i * TABLE_A_SIZE + j] = p;
+            tables_a[(2 * i + 1) * TABLE_A_SIZE + j] = AffinePoint(p.x * beta(), p.y);
+        }
+    }
+
+    // ng = g1 + g2 * 2^128, against the tables for G and 2^128 * G
+    int wg1[MAX_DIGITS], wg2[MAX_DIGITS];
+    Scalar g1 = ng, g2;
+    g1.d[2] = g1.d[3] = 0;
+    g2.d[0] = ng.d[2];
+    g2.d[1] = ng.d[3];
+    int lg1 = wnaf(wg1, g1, WINDOW_G);
+    int lg2 = wnaf(wg2, g2, WINDOW_G);
+
+    // One chain of doublings shared by every point
+    JacobianPoint r;
+    len = std::max({len, lg1, lg2});
+    for (int i = len - 1; i >= 0; i--) {
+        r = r.doubled();
+        for (size_t j = 0; j < 2 * n; j++) {
+            int digit = i < lengths[j] ? digits[j * MAX_DIGITS + i] : 0;
+            if (digit) r = add_digit(r, &tables_a[j * TABLE_A_SIZE], digit);
+        }
+        if (i < lg1 && wg1[i]) r = add_digit(r, t.g_odd, wg1[i]);
+        if (i < lg2 && wg2[i]) r = add_digit(r, t.g128_odd, wg2[i]);
+    }
+    return r;
+}
+
+JacobianPoint multiply(const AffinePoint& a, const Scalar& na, const Scalar& ng) {
+    return strauss({&a, 1}, {&na, 1}, ng);
+}
+
+// An affine point times a non-negative scalar below 2^128
+struct MultiTerm {
+    AffinePoint point;
+    Scalar scalar;
+};
+
+static void add_term(std::vector<MultiTerm>& terms, const AffinePoint& point, const Scalar& k) {
+    if (k.is_zero()) return;
+    if (k.is_high()) {
+        terms.push_back({point.negate(), -k});
+    } else {
+        terms.push_back({point, k});
+    }
+}
+
+static JacobianPoint pippenger(std::span<const MultiTerm> terms) {
+    // Signed c-bit digits in [-2^(c-1), 2^(c-1)]: -P is free, so only 2^(c-1)
+    // buckets. Each window costs an addition per term plus two per bucket.
+    static constexpr int BITS = 130;    // 128-bit scalars plus the last carry
+    size_t n = terms.size();
+    int c = 2;
+    for (int w = 3; w <= 14; w++) {
+        auto cost = [n](int bits) { return (double)((BITS + bits - 1) / bits) * (double)(n + (2u << (bits - 1))); };
+        if (cost(w) < cost(c)) c = w;
+    }
+    int windows = (BITS + c - 1) / c;
+    int half = 1 << (c - 1);
+
+    std::vector<int16_t> digits(n * windows);
+    for (size_t i = 0; i < n; i++) {
+        int carry = 0;
+        for (int w = 0; w < windows; w++) {
+            int digit = (int)terms[i].scalar.get_bits(w * c, c) + carry;
+            carry = digit > half;
+            if (carry) digit -= 1 << c;
+            digits[i * windows + w] = (int16_t)digit;
+        }
+    }
+
+    std::vector<JacobianPoint> buckets(half);
+    JacobianPoint r;
+    for (int w = windows - 1; w >= 0; w--) {
+        for (int i = 0; i < c; i++) r = r.doubled();
+        std::fill(buckets.begin(), buckets.end(), JacobianPoint());
+        for (size_t i = 0; i < n; i++) {
+            int digit = digits[i * windows + w];
+            if (digit > 0) {
+                buckets[digit - 1] = buckets[digit - 1].add(terms[i].point);
+            } else if (digit < 0) {
+                buckets[-digit - 1] = buckets[-digit - 1].add(terms[i].point.negate());
+            }
+        }
+        // sum(b * bucket[b - 1]) as a running sum from the top bucket down
+        JacobianPoint running, window_sum;
+        for (int b = half - 1; b >= 0; b--) {
+            running = running.add(buckets[b]);
+            window_sum = window_sum.add(running);
+        }
+        r = r.add(window_sum);
+    }
+    return r;
+}
+
+JacobianPoint multi_multiply(std::span<const AffinePoint> points, std::span<const Scalar> scalars,
+                             const Scalar& ng) {
+    if (points.size() < PIPPENGER_THRESHOLD) return strauss(points, scalars, ng);
+
+    // GLV halves of every point, and ng's halves against G and 2^128 * G
+    std::vector<MultiTerm> terms;
+    terms.reserve(2 * points.size() + 2);
+    for (size_t i = 0; i < points.size(); i++) {
+        if (points[i].infinity) continue;
+        Scalar k1, k2;
+        scalars[i].split_lambda(k1, k2);
+        AffinePoint lambda_point(points[i].x * beta(), points[i].y);
+        add_term(terms, points[i], k1);
+        add_term(terms, lambda_point, k2);
+    }
+    const Tables& t = tables();
+    Scalar g1 = ng, g2;
+    g1.d[2] = g1.d[3] = 0;
+    g2.d[0] = ng.d[2];
+    g2.d[1] = ng.d[3];
+    add_term(terms, t.g_odd[0], g1);
+    add_term(terms, t.g128_odd[0], g2);
+    return pippenger(terms);
+}
+
+// KEYS AND SIGNATURES
+
+// The point with this x coordinate and y parity, if x is on the curve
+static bool decompress(const unsigned char* x32, bool odd, AffinePoint& point) {
+    FieldElement x, y;
+    if (!x.set_bytes(x32)) return false;
+    if (!(x.square() * x + FieldElement(7)).sqrt(y)) return false;
+    y.normalize();
+    if (y.is_odd() != odd) y = -y;
+    point = AffinePoint(x, y);
+    point.y.normalize();
+    return true;
+}
+
+bool parse_public_key(std::span<const unsigned char> bytes, AffinePoint& point) {
+    if (bytes.size() == 33 && (bytes[0] == 0x02 || bytes[0] == 0x03)) {
+        return decompress(&bytes[1], bytes[0] == 0x03, point);
+    }
+    // Uncompressed, or "hybrid" (06/07: uncompressed with the parity in the prefix)
+    if (bytes.size() == 65 && (bytes[0] == 0x04 || bytes[0] == 0x06 || bytes[0] == 0x07)) {
+        FieldElement x, y;
+        if (!x.set_bytes(&bytes[1]) || !y.set_bytes(&bytes[33])) return false;
+        if (bytes[0] != 0x04 && y.is_odd() != (bytes[0] == 0x07)) return false;
+        point = AffinePoint(x, y);
+        return point.is_on_curve();
+    }
+    return false;
+}
+
+std::vector<unsigned char> serialize_public_key(const AffinePoint& point, bool compressed) {
+    std::vector<unsigned char> out(compressed ? 33 : 65);
+    point.x.get_bytes(&out[1]);
+    if (compressed) {
+        out[0] = point.y.is_odd() ? 0x03 : 0x02;
+    } else {
+        out[0] = 0x04;
+        point.y.get_bytes(&out[33]);
+    }
+    return out;
+}
+
+// One DER INTEGER of a signature: positive, minimally encoded, at most 32 bytes of value
+static bool parse_der_integer(std::span<const unsigned char> bytes, Scalar& out) {
+    if (bytes.empty() || (bytes[0] & 0x80)) return false;
+    if (bytes.size() > 1 && bytes[0] == 0 && !(bytes[1] & 0x80)) return false;
+    if (bytes[0] == 0) bytes = bytes.subspan(1);
+    if (bytes.size() > 32) return false;
+    unsigned char padded[32] = {0};
+    std::copy(bytes.begin(), bytes.end(), padded + 32 - bytes.size());
+    return out.set_bytes(padded) && !out.is_zero();
+}
+
+bool parse_der_signature(std::span<const unsigned char> der, Scalar& r, Scalar& s) {
+    // 0x30 [total] 0x02 [R-length] [R] 0x02 [S-length] [S] (BIP66, without the hash type)
+    if (der.size() < 8 || der.size() > 72) return false;
+    if (der[0] != 0x30 || der[1] != der.size() - 2) return false;
+    size_t r_len = der[3];
+    if (der[2] != 0x02 || 5 + r_len >= der.size()) return false;
+    size_t s_len = der[5 + r_len];
+    if (der[4 + r_len] != 0x02 || r_len + s_len + 6 != der.size()) return false;
+    return parse_der_integer(der.subspan(4, r_len), r) && parse_der_integer(der.subspan(6 + r_len, s_len), s);
+}
+
+static void append_der_integer(std::vector<unsigned char>& out, const Scalar& value) {
+    unsigned char bytes[33];
+    bytes[0] = 0;
+    value.get_bytes(bytes + 1);
+    size_t start = 0;
+    while (start < 32 && bytes[start] == 0 && !(bytes[start + 1] & 0x80)) start++;
+    out.push_back(0x02);
+    out.push_back((unsigned char)(33 - start));
+    out.insert(out.end(), bytes + start, bytes + 33);
+}
+
+std::vector<unsigned char> serialize_der_signature(const Scalar& r, const Scalar& s) {
+    std::vector<unsigned char> out = {0x30, 0};
+    append_der_integer(out, r);
+    append_der_integer(out, s);
+    out[1] = (unsigned char)(out.size() - 2);
+    return out;
+}
+
+// HMAC-SHA256 (RFC 2104) for the nonce generator
+class HmacSha256 {
+private:
+    Sha256Writer inner, outer;
+
+public:
+    explicit HmacSha256(std::span<const unsigned char, 32> key) {
+        unsigned char pad[64];
+        std::memset(pad, 0x36, sizeof(pad));
+        for (size_t i = 0; i < key.size(); i++) pad[i] ^= key[i];
+        inner.update(pad, sizeof(pad));
+        std::memset(pad, 0x5c, sizeof(pad));
+        for (size_t i = 0; i < key.size(); i++) pad[i] ^= key[i];
+        outer.update(pad, sizeof(pad));
+    }
+
+    HmacSha256& write(std::span<const unsigned char> data) {
+        inner.update(data);
+        return *this;
+    }
+
+    Hash256 finalize() {
+        Hash256 digest = inner.finalize();
+        return outer.update(digest.data(), digest.size()).finalize();
+    }
+};
+
+// RFC6979 HMAC-DRBG seeded with the key and message, as libsecp256k1 does it
+class Rfc6979 {
+private:
+    Hash256 v, k;
+    bool retry = false;
+
+    Hash256 hmac(std::span<const unsigned char> a, std::span<const unsigned char> b = {}) const {
+        return HmacSha256(std::span<const unsigned char, 32>(k.data(), 32)).write(a).write(b).finalize();
+    }
+
+public:
+    Rfc6979(const unsigned char* key32, const unsigned char* msg32) {
+        std::memset(v.data(), 0x01, 32);
+        std::memset(k.data(), 0x00, 32);
+        unsigned char seed[65];
+        std::memcpy(seed + 1, key32, 32);
+        std::memcpy(seed + 33, msg32, 32);
+        for (unsigned char round = 0; round < 2; round++) {
+            seed[0] = round;
+            k = hmac(std::span<const unsigned char>(v.data(), 32), seed);
+            v = hmac(std::span<const unsigned char>(v.data(), 32));
+        }
+        std::memset(seed, 0, sizeof(seed));
+    }
+
+    void generate(unsigned char* out32) {
+        if (retry) {
+            unsigned char zero = 0;
+            k = hmac(std::span<const unsigned char>(v.data(), 32), {&zero, 1});
+            v = hmac(std::span<const unsigned char>(v.data(), 32));
+        }
+        v = hmac(std::span<const unsigned char>(v.data(), 32));
+        std::memcpy(out32, v.data(), 32);
+        retry = true;
+    }
+};
+
+void ecdsa_sign(const Scalar& key, const Hash256& digest, Scalar& r, Scalar& s) {
+    unsigned char key32[32], msg32[32], nonce32[32];
+    Scalar message;
+    message.set_bytes(digest.data());
+    key.get_bytes(key32);
+    message.get_bytes(msg32);
+    Rfc6979 nonces(key32, msg32);
+
+    while (true) {
+        Scalar k;
+        nonces.generate(nonce32);
+        if (!k.set_bytes(nonce32) || k.is_zero()) continue;
+
+        AffinePoint point = multiply_generator(k).to_affine();
+        unsigned char x32[32];
+        point.x.get_bytes(x32);
+        r.set_bytes(x32);
+        s = k.inverse() * (message + r * key);
+        if (r.is_zero() || s.is_zero()) continue;
+
+        // Low s (BIP62/146): the other valid s is n - s
+        s.cmov(-s, s.is_high());
+        break;
+    }
+    std::memset(key32, 0, sizeof(key32));
+    std::memset(nonce32, 0, sizeof(nonce32));
+}
+
+bool ecdsa_verify(const AffinePoint& public_key, const Hash256& digest, const Scalar& r, const Scalar& s) {
+    if (r.is_zero() || s.is_zero() || public_key.infinity) return false;
+    Scalar message;
+    message.set_bytes(digest.data());
+    Scalar w = s.inverse();
+    JacobianPoint point = multiply(public_key, r * w, message * w);
+    if (point.infinity) return false;
+
+    // x(point) mod n == r, without leaving Jacobian coordinates: r * z^2 == X.
+    // x is below p, so r + n is also a candidate when that is still below p.
+    unsigned char r32[32];
+    r.get_bytes(r32);
+    FieldElement xr;
+    xr.set_bytes(r32);
+    FieldElement z2 = point.z.square();
+    if (xr * z2 == point.x) return true;
+
+    static constexpr uint64_t P_MINUS_N[4] = {0x402DA1722FC9BAEEULL, 0x4551231950B75FC4ULL, 1, 0};
+    uint64_t t[4];
+    if (!sub256(t, r.d, P_MINUS_N)) return false;   // r >= p - n
+    static const unsigned char N_BYTES[32] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE,
+        0xBA, 0xAE, 0xDC, 0xE6, 0xAF, 0x48, 0xA0, 0x3B, 0xBF, 0xD2, 0x5E, 0x8C, 0xD0, 0x36, 0x41, 0x41};
+    xr = xr + field_from_bytes(N_BYTES);
+    return xr * z2 == point.x;
+}
+
+// BIP340
+
+// Hash state after SHA256(tag) || SHA256(tag): a tagged hash copies it and
+// only pays for its own input
+static Sha256Writer tagged_hasher(const char* tag) {
+    Hash256 tag_hash = Sha256Writer().update(reinterpret_cast<const unsigned char*>(tag), std::strlen(tag)).finalize();
+    Sha256Writer hasher;
+    hasher.update(tag_hash.data(), tag_hash.size()).update(tag_hash.data(), tag_hash.size());
+    return hasher;
+}
+
+// e = H_challenge(R.x || P.x || m) mod n
+static Scalar challenge(const unsigned char* r32, const unsigned char* px32, const Hash256& digest) {
+    static const Sha256Writer tagged = tagged_hasher("BIP0340/challenge");
+    Sha256Writer hasher = tagged;
+    Hash256 hash = hasher.update(r32, 32).update(px32, 32).update(digest.data(), digest.size()).finalize();
+    Scalar e;
+    e.set_bytes(hash.data());
+    return e;
+}
+
+bool lift_x(const unsigned char* x32, AffinePoint& point) {
+    return decompress(x32, false, point);
+}
+
+bool schnorr_sign(const Scalar& key, const Hash256& digest, const unsigned char* aux32, unsigned char* sig64) {
+    static const Sha256Writer aux_tagged = tagged_hasher("BIP0340/aux");
+    static const Sha256Writer nonce_tagged = tagged_hasher("BIP0340/nonce");
+
+    // Sign with whichever of key and -key has the even-y public key
+    AffinePoint p = multiply_generator(key).to_affine();
+    Scalar d = key;
+    d.cmov(-key, p.y.is_odd());
+    unsigned char px[32];
+    p.x.get_bytes(px);
+
+    // Nonce from the key (masked with the hashed aux randomness), public key and message
+    unsigned char masked[32];
+    d.get_bytes(masked);
+    Sha256Writer aux_hasher = aux_tagged;
+    Hash256 mask = aux_hasher.update(aux32, 32).finalize();
+    for (int i = 0; i < 32; i++) masked[i] ^= mask.data()[i];
+    Sha256Writer nonce_hasher = nonce_tagged;
+    Hash256 nonce = nonce_hasher.update(masked, 32).update(px, 32).update(digest.data(), digest.size()).finalize();
+    Scalar k;
+    k.set_bytes(nonce.data());
+    std::memset(masked, 0, sizeof(masked));
+    std::memset(nonce.data(), 0, nonce.size());
+    if (k.is_zero()) return false;
+
+    AffinePoint r = multiply_generator(k).to_affine();
+    k.cmov(-k, r.y.is_odd());
+    r.x.get_bytes(sig64);
+    (k + challenge(sig64, px, digest) * d).get_bytes(sig64 + 32);
+    return true;
+}
+
+bool schnorr_verify(const AffinePoint& public_key, const Hash256& digest, const unsigned char* sig64) {
+    FieldElement rx;
+    Scalar s;
+    if (public_key.infinity || !rx.set_bytes(sig64) || !s.set_bytes(sig64 + 32)) return false;
+    unsigned char px[32];
+    public_key.x.get_bytes(px);
+
+    // R = s * G - e * P must exist, have even y and match r
+    JacobianPoint r = multiply(public_key, -challenge(sig64, px, digest), s);
+    if (r.infinity) return false;
+    AffinePoint ra = r.to_affine();
+    return !ra.y.is_odd() && ra.x == rx;
+}
+
+bool schnorr_verify_batch(std::span<const SchnorrBatchEntry> entries) {
+    static const Sha256Writer batch_tagged = tagged_hasher("BIP0340/batch");
+    size_t n = entries.size();
+
+    // The randomizers come from a seed that commits to every input, so nobody
+    // can pick invalid signatures whose errors cancel out in the sum
+    std::vector<unsigned char> keys(32 * n);
+    Sha256Writer seed_hasher = batch_tagged;
+    for (size_t i = 0; i < n; i++) {
+        const SchnorrBatchEntry& entry = entries[i];
+        if (!entry.public_key || entry.public_key->infinity) return false;
+        entry.public_key->x.get_bytes(&keys[32 * i]);
+        seed_hasher.update(&keys[32 * i], 32).update(entry.digest->data(), entry.digest->size()).update(entry.signature, 64);
+    }
+    Hash256 seed = seed_hasher.finalize();
+
+    // a_i * (s_i * G - R_i - e_i * P_i) summed over every entry (a_0 = 1) must be infinity
+    std::vector<AffinePoint> points;
+    std::vector<Scalar> scalars;
+    points.reserve(2 * n);
+    scalars.reserve(2 * n);
+    Scalar ng;
+    for (size_t i = 0; i < n; i++) {
+        const SchnorrBatchEntry& entry = entries[i];
+        AffinePoint r;
+        Scalar s;
+        if (!lift_x(entry.signature, r) || !s.set_bytes(entry.signature + 32)) return false;
+
+        Scalar a(1);
+        if (i > 0) {
+            unsigned char index[4] = {(unsigned char)i, (unsigned char)(i >> 8), (unsigned char)(i >> 16),
+                                      (unsigned char)(i >> 24)};
+            a.set_bytes(Sha256Writer().update(seed.data(), seed.size()).update(index, 4).finalize().data());
+        }
+        Scalar e = challenge(entry.signature, &keys[32 * i], *entry.digest);
+        ng = ng + a * s;
+        points.push_back(r);
+        scalars.push_back(-a);
+        points.push_back(*entry.public_key);
+        scalars.push_back(-(a * e));
+    }
+    return multi_multiply(points, scalars, ng).infinity;
+}
+
+} // namespace secp256k1
+} // namespace crypto
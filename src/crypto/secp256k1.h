@@ -0,0 +1,311 @@
+// src/crypto/secp256k1.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "uint256.h"
+
+namespace crypto {
+namespace secp256k1 {
+
+/**
+ * Native secp256k1 arithmetic
+ *
+ * Field and scalar arithmetic follow libsecp256k1's layout: field elements
+ * as five 52-bit limbs (so additions never carry and products fit 128-bit
+ * accumulators), scalars as four 64-bit limbs. Everything a signature
+ * touches with secret data - scalar arithmetic, the generator
+ * multiplication, inversion - runs in constant time. Verification works on
+ * public data and takes the faster variable-time paths.
+ */
+
+using u128 = unsigned __int128;
+
+// Field element mod p = 2^256 - 2^32 - 977. Every operation returns a weakly
+// normalized value (limbs 0-3 under 2^52, limb 4 barely over 48 bits), which
+// any other operation accepts; normalize() gives the unique form for
+// comparisons.
+struct FieldElement {
+    uint64_t n[5] = {0, 0, 0, 0, 0};
+
+    static constexpr uint64_t M52 = 0xFFFFFFFFFFFFFULL;
+    static constexpr uint64_t M48 = 0x0FFFFFFFFFFFFULL;
+
+    FieldElement() {}
+    explicit FieldElement(uint32_t value) { n[0] = value; }
+
+    // False (and the value reduced) if `bytes` is not below p
+    bool set_bytes(const unsigned char* bytes);
+    void get_bytes(unsigned char* out) const;
+
+    FieldElement& normalize_weak() {
+        uint64_t t0 = n[0], t1 = n[1], t2 = n[2], t3 = n[3], t4 = n[4];
+        uint64_t x = t4 >> 48;
+        t4 &= M48;
+        t0 += x * 0x1000003D1ULL;
+        t1 += t0 >> 52; t0 &= M52;
+        t2 += t1 >> 52; t1 &= M52;
+        t3 += t2 >> 52; t2 &= M52;
+        t4 += t3 >> 52; t3 &= M52;
+        n[0] = t0; n[1] = t1; n[2] = t2; n[3] = t3; n[4] = t4;
+        return *this;
+    }
+
+    FieldElement& normalize() {
+        normalize_weak();
+        uint64_t t0 = n[0], t1 = n[1], t2 = n[2], t3 = n[3], t4 = n[4];
+        // At most one subtraction of p is left: is the value >= p?
+        uint64_t m = t1 & t2 & t3;
+        uint64_t x = (t4 >> 48) | ((t4 == M48) & (m == M52) & (t0 >= 0xFFFFEFFFFFC2FULL));
+        t0 += x * 0x1000003D1ULL;
+        t1 += t0 >> 52; t0 &= M52;
+        t2 += t1 >> 52; t1 &= M52;
+        t3 += t2 >> 52; t2 &= M52;
+        t4 += t3 >> 52; t3 &= M52;
+        t4 &= M48;
+        n[0] = t0; n[1] = t1; n[2] = t2; n[3] = t3; n[4] = t4;
+        return *this;
+    }
+
+    bool is_zero() const {
+        FieldElement t = *this;
+        t.normalize();
+        return (t.n[0] | t.n[1] | t.n[2] | t.n[3] | t.n[4]) == 0;
+    }
+
+    bool is_odd() const {
+        FieldElement t = *this;
+        t.normalize();
+        return t.n[0] & 1;
+    }
+
+    friend bool operator==(const FieldElement& a, const FieldElement& b) { return (a - b).is_zero(); }
+    friend bool operator!=(const FieldElement& a, const FieldElement& b) { return !(a == b); }
+
+    friend FieldElement operator+(const FieldElement& a, const FieldElement& b) {
+        FieldElement r;
+        for (int i = 0; i < 5; i++) r.n[i] = a.n[i] + b.n[i];
+        return r.normalize_weak();
+    }
+
+    FieldElement operator-() const {
+        // 4p - a: large enough for any weakly normalized input
+        FieldElement r;
+        r.n[0] = 0xFFFFEFFFFFC2FULL * 4 - n[0];
+        r.n[1] = M52 * 4 - n[1];
+        r.n[2] = M52 * 4 - n[2];
+        r.n[3] = M52 * 4 - n[3];
+        r.n[4] = M48 * 4 - n[4];
+        return r.normalize_weak();
+    }
+
+    friend FieldElement operator-(const FieldElement& a, const FieldElement& b) {
+        FieldElement r;
+        r.n[0] = a.n[0] + 0xFFFFEFFFFFC2FULL * 4 - b.n[0];
+        r.n[1] = a.n[1] + M52 * 4 - b.n[1];
+        r.n[2] = a.n[2] + M52 * 4 - b.n[2];
+        r.n[3] = a.n[3] + M52 * 4 - b.n[3];
+        r.n[4] = a.n[4] + M48 * 4 - b.n[4];
+        return r.normalize_weak();
+    }
+
+    FieldElement mul_int(uint32_t k) const {
+        FieldElement r;
+        for (int i = 0; i < 5; i++) r.n[i] = n[i] * k;
+        return r.normalize_weak();
+    }
+
+    // libsecp256k1's 5x52 multiplication: 2^260 = 0x1000003D10 (mod p) folds
+    // the upper half back in while the partial products are summed
+    friend FieldElement operator*(const FieldElement& x, const FieldElement& y) {
+        const uint64_t* a = x.n;
+        const uint64_t* b = y.n;
+        const uint64_t R = 0x1000003D10ULL;
+        u128 c, d;
+        uint64_t t3, t4, tx, u0;
+        FieldElement out;
+        uint64_t* r = out.n;
+
+        d = (u128)a[0] * b[3] + (u128)a[1] * b[2] + (u128)a[2] * b[1] + (u128)a[3] * b[0];
+        c = (u128)a[4] * b[4];
+        d += (u128)R * (uint64_t)c; c >>= 64;
+        t3 = (uint64_t)d & M52; d >>= 52;
+
+        d += (u128)a[0] * b[4] + (u128)a[1] * b[3] + (u128)a[2] * b[2] + (u128)a[3] * b[1] + (u128)a[4] * b[0];
+        d += (u128)(R << 12) * (uint64_t)c;
+        t4 = (uint64_t)d & M52; d >>= 52;
+        tx = t4 >> 48; t4 &= M48;
+
+        c = (u128)a[0] * b[0];
+        d += (u128)a[1] * b[4] + (u128)a[2] * b[3] + (u128)a[3] * b[2] + (u128)a[4] * b[1];
+        u0 = (uint64_t)d & M52; d >>= 52;
+        u0 = (u0 << 4) | tx;
+        c += (u128)u0 * (R >> 4);
+        r[0] = (uint64_t)c & M52; c >>= 52;
+
+        c += (u128)a[0] * b[1] + (u128)a[1] * b[0];
+        d += (u128)a[2] * b[4] + (u128)a[3] * b[3] + (u128)a[4] * b[2];
+        c += (u128)((uint64_t)d & M52) * R; d >>= 52;
+        r[1] = (uint64_t)c & M52; c >>= 52;
+
+        c += (u128)a[0] * b[2] + (u128)a[1] * b[1] + (u128)a[2] * b[0];
+        d += (u128)a[3] * b[4] + (u128)a[4] * b[3];
+        c += (u128)R * (uint64_t)d; d >>= 64;
+        r[2] = (uint64_t)c & M52; c >>= 52;
+
+        c += (u128)(R << 12) * (uint64_t)d + t3;
+        r[3] = (uint64_t)c & M52; c >>= 52;
+        r[4] = (uint64_t)c + t4;
+        return out;
+    }
+
+    FieldElement square() const { return *this * *this; }
+
+    FieldElement square(int times) const {
+        FieldElement r = *this;
+        for (int i = 0; i < times; i++) r = r.square();
+        return r;
+    }
+
+    // a^(p-2), constant time
+    FieldElement inverse() const;
+
+    // Square root if there is one ((p+1)/4 power, checked by squaring)
+    bool sqrt(FieldElement& root) const;
+
+    // Constant-time: *this = a if flag
+    void cmov(const FieldElement& a, bool flag) {
+        uint64_t mask = 0 - (uint64_t)flag;
+        for (int i = 0; i < 5; i++) n[i] ^= mask & (n[i] ^ a.n[i]);
+    }
+};
+
+// Integer mod the group order n, little-endian 64-bit limbs
+struct Scalar {
+    uint64_t d[4] = {0, 0, 0, 0};
+
+    static constexpr uint64_t N[4] = {0xBFD25E8CD0364141ULL, 0xBAAEDCE6AF48A03BULL,
+                                      0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL};
+    // 2^256 - n
+    static constexpr uint64_t N_C[3] = {0x402DA1732FC9BEBFULL, 0x4551231950B75FC4ULL, 1};
+
+    constexpr Scalar() {}
+    constexpr explicit Scalar(uint64_t value) { d[0] = value; }
+
+    // Reduces mod n; returns false if `bytes` was not below n
+    bool set_bytes(const unsigned char* bytes);
+    void get_bytes(unsigned char* out) const;
+
+    bool is_zero() const { return (d[0] | d[1] | d[2] | d[3]) == 0; }
+    bool is_high() const;     // above n/2 (negative, in a signed view)
+
+    friend bool operator==(const Scalar& a, const Scalar& b) {
+        return ((a.d[0] ^ b.d[0]) | (a.d[1] ^ b.d[1]) | (a.d[2] ^ b.d[2]) | (a.d[3] ^ b.d[3])) == 0;
+    }
+
+    friend Scalar operator+(const Scalar& a, const Scalar& b);
+    friend Scalar operator*(const Scalar& a, const Scalar& b);
+    Scalar operator-() const;
+
+    // a^(n-2), constant time
+    Scalar inverse() const;
+
+    // `count` (<= 32) bits starting at `offset`
+    uint32_t get_bits(unsigned offset, unsigned count) const {
+        unsigned limb = offset >> 6, shift = offset & 63;
+        uint64_t bits = d[limb] >> shift;
+        if (shift + count > 64 && limb < 3) bits |= d[limb + 1] << (64 - shift);
+        return (uint32_t)(bits & ((1ULL << count) - 1));
+    }
+
+    void cmov(const Scalar& a, bool flag) {
+        uint64_t mask = 0 - (uint64_t)flag;
+        for (int i = 0; i < 4; i++) d[i] ^= mask & (d[i] ^ a.d[i]);
+    }
+
+    // k = r1 + r2 * lambda (mod n) with r1, r2 about 128 bits each (GLV)
+    void split_lambda(Scalar& r1, Scalar& r2) const;
+};
+
+struct AffinePoint {
+    FieldElement x, y;
+    bool infinity = true;
+
+    AffinePoint() {}
+    AffinePoint(const FieldElement& px, const FieldElement& py) : x(px), y(py), infinity(false) {}
+
+    bool is_on_curve() const;
+    AffinePoint negate() const { return infinity ? *this : AffinePoint(x, -y); }
+};
+
+// (X, Y, Z) is the point (X/Z^2, Y/Z^3)
+struct JacobianPoint {
+    FieldElement x, y, z;
+    bool infinity = true;
+
+    JacobianPoint() {}
+    explicit JacobianPoint(const AffinePoint& a) : x(a.x), y(a.y), z(1), infinity(a.infinity) {}
+
+    JacobianPoint doubled() const;
+    JacobianPoint add(const JacobianPoint& b) const;
+    JacobianPoint add(const AffinePoint& b) const;
+    JacobianPoint negate() const;
+    AffinePoint to_affine() const;
+};
+
+// Many Jacobian points to affine with a single inversion
+std::vector<AffinePoint> batch_to_affine(std::span<const JacobianPoint> points);
+
+const AffinePoint& generator();
+
+// k * G, constant time in k
+JacobianPoint multiply_generator(const Scalar& k);
+
+// na * a + ng * G, variable time (verification)
+JacobianPoint multiply(const AffinePoint& a, const Scalar& na, const Scalar& ng);
+
+// sum(scalars[i] * points[i]) + ng * G in one pass, variable time. Strauss
+// (interleaved wNAF, one shared chain of doublings) for a few points,
+// Pippenger's bucket method once there are enough of them.
+JacobianPoint multi_multiply(std::span<const AffinePoint> points, std::span<const Scalar> scalars,
+                             const Scalar& ng);
+
+// Public keys: 33-byte compressed or 65-byte uncompressed
+bool parse_public_key(std::span<const unsigned char> bytes, AffinePoint& point);
+std::vector<unsigned char> serialize_public_key(const AffinePoint& point, bool compressed = true);
+
+// Strict DER (BIP66) with r and s in [1, n-1]
+bool parse_der_signature(std::span<const unsigned char> der, Scalar& r, Scalar& s);
+std::vector<unsigned char> serialize_der_signature(const Scalar& r, const Scalar& s);
+
+// ECDSA with an RFC6979 deterministic nonce, low-s normalized (Bitcoin Core
+// produces the same signatures). Constant time in the key and nonce.
+void ecdsa_sign(const Scalar& key, const Hash256& digest, Scalar& r, Scalar& s);
+bool ecdsa_verify(const AffinePoint& public_key, const Hash256& digest, const Scalar& r, const Scalar& s);
+
+// BIP340 Schnorr signatures: a public key is just the 32-byte x coordinate of
+// a point with even y, a signature is R.x (32 bytes) followed by s (32 bytes)
+
+// The even-y point with this x coordinate; false if there is none
+bool lift_x(const unsigned char* x32, AffinePoint& point);
+
+// `aux32` is fresh randomness mixed into the nonce (all zero still gives a
+// safe, deterministic signature). Constant time in the key and nonce. False
+// only if the nonce hashes to zero (probability 2^-256).
+bool schnorr_sign(const Scalar& key, const Hash256& digest, const unsigned char* aux32, unsigned char* sig64);
+bool schnorr_verify(const AffinePoint& public_key, const Hash256& digest, const unsigned char* sig64);
+
+struct SchnorrBatchEntry {
+    const AffinePoint* public_key;      // as returned by lift_x
+    const Hash256* digest;
+    const unsigned char* signature;     // 64 bytes
+};
+
+// True only if every signature is valid (with overwhelming probability). A
+// random linear combination of all the verification equations is checked
+// with a single multi_multiply, so a failure doesn't say which one is bad.
+bool schnorr_verify_batch(std::span<const SchnorrBatchEntry> entries);
+
+} // namespace secp256k1
+} // namespace crypto
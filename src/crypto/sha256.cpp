@@ -0,0 +1,399 @@
+// src/crypto/sha256.cpp
+#include "sha256.h"
+#include <cstring>
+#include <mutex>
+#include <openssl/sha.h>
+
+#if defined(ENABLE_SSE41) || defined(ENABLE_AVX2) || defined(ENABLE_AVX512) || defined(ENABLE_X86_SHANI)
+#include <cpuid.h>
+#endif
+
+namespace crypto {
+
+namespace sha256 {
+
+const uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+static inline uint32_t ch(uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); }
+static inline uint32_t maj(uint32_t x, uint32_t y, uint32_t z) { return (x & y) | (z & (x | y)); }
+static inline uint32_t big_sigma0(uint32_t x) { return rotr(x, 2) ^ rotr(x, 13) ^ rotr(x, 22); }
+static inline uint32_t big_sigma1(uint32_t x) { return rotr(x, 6) ^ rotr(x, 11) ^ rotr(x, 25); }
+static inline uint32_t small_sigma0(uint32_t x) { return rotr(x, 7) ^ rotr(x, 18) ^ (x >> 3); }
+static inline uint32_t small_sigma1(uint32_t x) { return rotr(x, 17) ^ rotr(x, 19) ^ (x >> 10); }
+
+static inline uint32_t read_be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline void write_be32(unsigned char* p, uint32_t x) {
+    p[0] = (unsigned char)(x >> 24);
+    p[1] = (unsigned char)(x >> 16);
+    p[2] = (unsigned char)(x >> 8);
+    p[3] = (unsigned char)x;
+}
+
+static void transform_scalar(uint32_t* state, const unsigned char* chunk, size_t blocks) {
+    while (blocks--) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) w[i] = read_be32(chunk + 4 * i);
+        for (int i = 16; i < 64; i++) {
+            w[i] = small_sigma1(w[i - 2]) + w[i - 7] + small_sigma0(w[i - 15]) + w[i - 16];
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + big_sigma1(e) + ch(e, f, g) + K[i] + w[i];
+            uint32_t t2 = big_sigma0(a) + maj(a, b, c);
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        chunk += 64;
+    }
+}
+
+void write_digest(const uint32_t* state, unsigned char* out) {
+    for (int i = 0; i < 8; i++) write_be32(out + 4 * i, state[i]);
+}
+
+// SHA256d of one 64-byte input using whichever single-lane transform is active
+static void transform_d64_1way(unsigned char* out, const unsigned char* in) {
+    Sha256Writer hasher;
+    Hash256 digest = hasher.update(in, 64).finalize_double();
+    std::memcpy(out, digest.data(), 32);
+}
+
+// SHA256d of one 80-byte header from its midstate
+static void hash_headers_1way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail,
+                              uint32_t first_nonce) {
+    unsigned char block[64];
+    std::memcpy(block, tail, sizeof(block));
+    block[12] = (unsigned char)first_nonce;
+    block[13] = (unsigned char)(first_nonce >> 8);
+    block[14] = (unsigned char)(first_nonce >> 16);
+    block[15] = (unsigned char)(first_nonce >> 24);
+
+    uint32_t state[8];
+    std::memcpy(state, midstate, sizeof(state));
+    transform(state, block, 1);
+
+    std::memset(block, 0, sizeof(block));
+    write_digest(state, block);
+    block[32] = 0x80;
+    block[62] = 0x01; // 256 bits
+
+    std::memcpy(state, INITIAL_STATE, sizeof(state));
+    transform(state, block, 1);
+    write_digest(state, out);
+}
+
+// Active backend - plain C++ until auto_detect() finds something better
+typedef void (*TransformFn)(uint32_t*, const unsigned char*, size_t);
+typedef void (*TransformD64Fn)(unsigned char*, const unsigned char*);
+typedef void (*HashHeadersFn)(unsigned char*, const uint32_t*, const unsigned char*, uint32_t);
+
+static TransformFn transform_impl = transform_scalar;
+static TransformD64Fn transform_d64_impl = transform_d64_1way;
+static TransformD64Fn transform_d64_4way = nullptr;
+static TransformD64Fn transform_d64_8way = nullptr;
+static TransformD64Fn transform_d64_16way = nullptr;
+static HashHeadersFn hash_headers_impl = hash_headers_1way;
+static size_t hash_headers_lanes = 1;
+
+void transform(uint32_t* state, const unsigned char* chunk, size_t blocks) {
+    transform_impl(state, chunk, blocks);
+}
+
+void sha256d64(unsigned char* out, const unsigned char* in, size_t count) {
+    if (transform_d64_16way) {
+        for (; count >= 16; count -= 16, in += 64 * 16, out += 32 * 16) transform_d64_16way(out, in);
+    }
+    if (transform_d64_8way) {
+        for (; count >= 8; count -= 8, in += 64 * 8, out += 32 * 8) transform_d64_8way(out, in);
+    }
+    if (transform_d64_4way) {
+        for (; count >= 4; count -= 4, in += 64 * 4, out += 32 * 4) transform_d64_4way(out, in);
+    }
+    for (; count > 0; count--, in += 64, out += 32) transform_d64_impl(out, in);
+}
+
+size_t header_lanes() {
+    return hash_headers_lanes;
+}
+
+void hash_headers(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce) {
+    hash_headers_impl(out, midstate, tail, first_nonce);
+}
+
+} // namespace sha256
+
+#ifdef ENABLE_SSE41
+namespace sha256_sse41 {
+void transform_d64_4way(unsigned char* out, const unsigned char* in);
+void hash_headers_4way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+}
+#endif
+#ifdef ENABLE_AVX2
+namespace sha256_avx2 {
+void transform_d64_8way(unsigned char* out, const unsigned char* in);
+void hash_headers_8way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+}
+#endif
+#ifdef ENABLE_AVX512
+namespace sha256_avx512 {
+void transform_d64_16way(unsigned char* out, const unsigned char* in);
+void hash_headers_16way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+}
+#endif
+#ifdef ENABLE_X86_SHANI
+namespace sha256_x86_shani {
+void transform(uint32_t* state, const unsigned char* chunk, size_t blocks);
+void transform_d64(unsigned char* out, const unsigned char* in);
+}
+#endif
+
+namespace sha256 {
+
+#if defined(ENABLE_SSE41) || defined(ENABLE_AVX2) || defined(ENABLE_AVX512) || defined(ENABLE_X86_SHANI)
+#define HAVE_X86_DISPATCH
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+}
+
+// Extended register state the OS saves on context switch (XCR0)
+static uint32_t os_saved_state() {
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return a;
+}
+#endif
+
+// Compare a candidate backend with OpenSSL on a spread of inputs
+static bool self_test(TransformFn transform_fn, TransformD64Fn d64_fn, size_t lanes) {
+    unsigned char data[64 * 16];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (unsigned char)(i * 7 + 3);
+
+    if (transform_fn) {
+        // Multi-block messages of every length class (<1, 1, >1 blocks)
+        for (size_t len : {0, 3, 55, 56, 64, 100, 200, 448}) {
+            uint32_t state[8];
+            std::memcpy(state, INITIAL_STATE, sizeof(state));
+
+            unsigned char padded[64 * 9] = {0};
+            std::memcpy(padded, data, len);
+            size_t blocks = (len + 8) / 64 + 1;
+            padded[len] = 0x80;
+            uint64_t bit_length = (uint64_t)len * 8;
+            for (int i = 0; i < 8; i++) padded[blocks * 64 - 1 - i] = (unsigned char)(bit_length >> (8 * i));
+            transform_fn(state, padded, blocks);
+
+            unsigned char got[32], expected[32];
+            write_digest(state, got);
+            SHA256(data, len, expected);
+            if (std::memcmp(got, expected, 32) != 0) return false;
+        }
+    }
+
+    if (d64_fn) {
+        unsigned char got[32 * 16];
+        d64_fn(got, data);
+        for (size_t lane = 0; lane < lanes; lane++) {
+            unsigned char first[32], expected[32];
+            SHA256(data + 64 * lane, 64, first);
+            SHA256(first, 32, expected);
+            if (std::memcmp(got + 32 * lane, expected, 32) != 0) return false;
+        }
+    }
+    return true;
+}
+
+// Same for the header kernels: hash 80-byte headers with consecutive nonces
+static bool self_test_headers(HashHeadersFn fn, size_t lanes) {
+    unsigned char header[80];
+    for (size_t i = 0; i < sizeof(header); i++) header[i] = (unsigned char)(i * 13 + 5);
+
+    uint32_t midstate[8];
+    std::memcpy(midstate, INITIAL_STATE, sizeof(midstate));
+    transform_scalar(midstate, header, 1);
+    unsigned char tail[64] = {0};
+    std::memcpy(tail, header + 64, 16);
+    tail[16] = 0x80;
+    tail[62] = 0x02;
+    tail[63] = 0x80;
+
+    const uint32_t first_nonce = 0xfffffff8; // crosses the 32-bit wrap
+    unsigned char got[32 * 16];
+    fn(got, midstate, tail, first_nonce);
+    for (size_t lane = 0; lane < lanes; lane++) {
+        uint32_t nonce = first_nonce + (uint32_t)lane;
+        for (int i = 0; i < 4; i++) header[76 + i] = (unsigned char)(nonce >> (8 * i));
+        unsigned char first[32], expected[32];
+        SHA256(header, 80, first);
+        SHA256(first, 32, expected);
+        if (std::memcmp(got + 32 * lane, expected, 32) != 0) return false;
+    }
+    return true;
+}
+
+std::string auto_detect() {
+    static std::once_flag detected;
+    static std::string description = "scalar";
+
+    std::call_once(detected, [] {
+        if (!self_test(transform_scalar, transform_d64_1way, 1) || !self_test_headers(hash_headers_1way, 1)) {
+            // Should never happen - keep going on the reference code but say so
+            description = "scalar (self-test FAILED)";
+            return;
+        }
+
+#ifdef HAVE_X86_DISPATCH
+        uint32_t eax, ebx, ecx, edx;
+        cpuid(0, 0, eax, ebx, ecx, edx);
+        uint32_t max_leaf = eax;
+        cpuid(1, 0, eax, ebx, ecx, edx);
+        bool have_sse41 = (ecx >> 19) & 1;
+        bool have_xsave = ((ecx >> 27) & 1) && ((ecx >> 28) & 1);
+        uint32_t xcr0 = have_xsave ? os_saved_state() : 0;
+        bool have_avx = have_xsave && (xcr0 & 0x06) == 0x06;
+        bool have_avx512_state = have_xsave && (xcr0 & 0xe6) == 0xe6;
+        bool have_avx2 = false, have_avx512 = false, have_shani = false;
+        if (max_leaf >= 7) {
+            cpuid(7, 0, eax, ebx, ecx, edx);
+            have_avx2 = have_avx && ((ebx >> 5) & 1);
+            have_avx512 = have_avx512_state && ((ebx >> 16) & 1);
+            have_shani = (ebx >> 29) & 1;
+        }
+        (void)have_sse41; (void)have_avx2; (void)have_avx512; (void)have_shani;
+
+#ifdef ENABLE_X86_SHANI
+        if (have_shani && have_sse41 &&
+            self_test(sha256_x86_shani::transform, sha256_x86_shani::transform_d64, 1)) {
+            transform_impl = sha256_x86_shani::transform;
+            transform_d64_impl = sha256_x86_shani::transform_d64;
+            description = "shani(1way)";
+        }
+#endif
+#ifdef ENABLE_SSE41
+        // SHA-NI beats four SSE lanes for headers, but not for batched d64
+        if (have_sse41 && self_test(nullptr, sha256_sse41::transform_d64_4way, 4) &&
+            self_test_headers(sha256_sse41::hash_headers_4way, 4)) {
+            transform_d64_4way = sha256_sse41::transform_d64_4way;
+            if (transform_impl == transform_scalar) {
+                hash_headers_impl = sha256_sse41::hash_headers_4way;
+                hash_headers_lanes = 4;
+            }
+            description += ",sse41(4way)";
+        }
+#endif
+#ifdef ENABLE_AVX2
+        if (have_avx2 && self_test(nullptr, sha256_avx2::transform_d64_8way, 8) &&
+            self_test_headers(sha256_avx2::hash_headers_8way, 8)) {
+            transform_d64_8way = sha256_avx2::transform_d64_8way;
+            hash_headers_impl = sha256_avx2::hash_headers_8way;
+            hash_headers_lanes = 8;
+            description += ",avx2(8way)";
+        }
+#endif
+#ifdef ENABLE_AVX512
+        if (have_avx512 && self_test(nullptr, sha256_avx512::transform_d64_16way, 16) &&
+            self_test_headers(sha256_avx512::hash_headers_16way, 16)) {
+            transform_d64_16way = sha256_avx512::transform_d64_16way;
+            hash_headers_impl = sha256_avx512::hash_headers_16way;
+            hash_headers_lanes = 16;
+            description += ",avx512(16way)";
+        }
+#endif
+#endif
+    });
+
+    return description;
+}
+
+} // namespace sha256
+
+Sha256Writer& Sha256Writer::reset() {
+    std::memcpy(state, sha256::INITIAL_STATE, sizeof(state));
+    bytes_written = 0;
+    return *this;
+}
+
+Sha256Writer& Sha256Writer::update(std::span<const unsigned char> data) {
+    const unsigned char* ptr = data.data();
+    size_t len = data.size();
+    size_t buffered = bytes_written % 64;
+    bytes_written += len;
+
+    // Top up a partially filled block first
+    if (buffered > 0) {
+        size_t take = 64 - buffered < len ? 64 - buffered : len;
+        std::memcpy(buffer + buffered, ptr, take);
+        ptr += take;
+        len -= take;
+        if (buffered + take < 64) return *this;
+        sha256::transform(state, buffer, 1);
+    }
+
+    // Whole blocks straight from the caller's memory
+    if (len >= 64) {
+        size_t blocks = len / 64;
+        sha256::transform(state, ptr, blocks);
+        ptr += blocks * 64;
+        len -= blocks * 64;
+    }
+
+    if (len > 0) std::memcpy(buffer, ptr, len);
+    return *this;
+}
+
+Hash256 Sha256Writer::finalize() {
+    // Padding: 0x80, zeros, then the message length in bits (big endian)
+    static const unsigned char PADDING[64] = {0x80};
+    unsigned char length_bytes[8];
+    uint64_t bit_length = bytes_written << 3;
+    for (int i = 0; i < 8; i++) length_bytes[i] = (unsigned char)(bit_length >> (56 - 8 * i));
+
+    update(PADDING, 1 + ((119 - (bytes_written % 64)) % 64));
+    update(length_bytes, 8);
+
+    Hash256 result;
+    sha256::write_digest(state, result.data());
+    return result;
+}
+
+Hash256 Sha256Writer::finalize_double() {
+    Hash256 first = finalize();
+
+    // A 32-byte message always pads to exactly one block, so build it directly
+    unsigned char block[64] = {0};
+    std::memcpy(block, first.data(), 32);
+    block[32] = 0x80;
+    block[62] = 0x01; // 256 bits
+
+    uint32_t second_state[8];
+    std::memcpy(second_state, sha256::INITIAL_STATE, sizeof(second_state));
+    sha256::transform(second_state, block, 1);
+
+    Hash256 result;
+    sha256::write_digest(second_state, result.data());
+    return result;
+}
+
+} // namespace crypto
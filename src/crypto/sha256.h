@@ -0,0 +1,76 @@
+// src/crypto/sha256.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include "uint256.h"
+
+namespace crypto {
+
+/**
+ * Streaming SHA-256
+ *
+ * Serializers write straight into the hash state (see util/serialize.h), so
+ * hashing a transaction or header never builds an intermediate buffer.
+ */
+class Sha256Writer {
+private:
+    uint32_t state[8];
+    unsigned char buffer[64];
+    uint64_t bytes_written;
+
+public:
+    static constexpr size_t OUTPUT_SIZE = 32;
+
+    Sha256Writer() { reset(); }
+
+    // Start over with a fresh hash state
+    Sha256Writer& reset();
+
+    // Feed more data into the hash
+    Sha256Writer& update(std::span<const unsigned char> data);
+    Sha256Writer& update(const unsigned char* data, size_t len) { return update({data, len}); }
+
+    // Stream interface used by the serializers
+    void write(std::span<const unsigned char> data) { update(data); }
+
+    // SHA256 of everything written so far (the writer must be reset before reuse)
+    Hash256 finalize();
+
+    // SHA256(SHA256(data)) - Bitcoin's txid / block hash function
+    Hash256 finalize_double();
+};
+
+namespace sha256 {
+
+// Initial hash values and round constants (FIPS 180-4 sections 4.2.2 / 5.3.3)
+extern const uint32_t INITIAL_STATE[8];
+extern const uint32_t K[64];
+
+// Pick the fastest backend this CPU supports (SHA-NI, AVX-512, AVX2, SSE4.1 or
+// plain C++) and cross-check it against OpenSSL before enabling it.
+// Call once at startup; returns a description of what was selected.
+std::string auto_detect();
+
+// Compress `blocks` consecutive 64-byte chunks into `state`
+void transform(uint32_t* state, const unsigned char* chunk, size_t blocks);
+
+// Batch SHA256d of `count` independent 64-byte inputs (in[64 * i]) into
+// `count` digests (out[32 * i]) - spread across SIMD lanes when available
+void sha256d64(unsigned char* out, const unsigned char* in, size_t count);
+
+// Mining: hash header_lanes() headers at once, differing only in the nonce.
+// `midstate` is the state after header bytes 0..63; `tail` is bytes 64..79
+// followed by SHA-256 padding for an 80-byte message. out[32 * i] receives
+// SHA256d of the header with nonce first_nonce + i.
+static constexpr size_t MAX_HEADER_LANES = 16;
+size_t header_lanes();
+void hash_headers(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+
+// Write the big-endian state words as a digest
+void write_digest(const uint32_t* state, unsigned char* out);
+
+} // namespace sha256
+
+} // namespace crypto
@@ -0,0 +1,22 @@
+// src/crypto/sha256_avx2.cpp
+// Compiled with -mavx -mavx2 - only call after sha256::auto_detect() says so
+#ifdef ENABLE_AVX2
+#include "sha256_lanes.h"
+
+namespace crypto {
+namespace sha256_avx2 {
+
+typedef uint32_t v8u32 __attribute__((vector_size(32)));
+
+void transform_d64_8way(unsigned char* out, const unsigned char* in) {
+    sha256_lanes::transform_d64<v8u32, 8>(out, in);
+}
+
+void hash_headers_8way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail,
+                       uint32_t first_nonce) {
+    sha256_lanes::hash_headers<v8u32, 8>(out, midstate, tail, first_nonce);
+}
+
+} // namespace sha256_avx2
+} // namespace crypto
+#endif
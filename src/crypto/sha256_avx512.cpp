@@ -0,0 +1,22 @@
+// src/crypto/sha256_avx512.cpp
+// Compiled with -mavx512f - only call after sha256::auto_detect() says so
+#ifdef ENABLE_AVX512
+#include "sha256_lanes.h"
+
+namespace crypto {
+namespace sha256_avx512 {
+
+typedef uint32_t v16u32 __attribute__((vector_size(64)));
+
+void transform_d64_16way(unsigned char* out, const unsigned char* in) {
+    sha256_lanes::transform_d64<v16u32, 16>(out, in);
+}
+
+void hash_headers_16way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail,
+                        uint32_t first_nonce) {
+    sha256_lanes::hash_headers<v16u32, 16>(out, midstate, tail, first_nonce);
+}
+
+} // namespace sha256_avx512
+} // namespace crypto
+#endif
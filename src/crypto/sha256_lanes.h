@@ -0,0 +1,126 @@
+// src/crypto/sha256_lanes.h
+#pragma once
+#include <cstdint>
+#include "sha256.h"
+
+/**
+ * Multi-lane SHA256d kernels
+ *
+ * Written once over GCC vector types and included by the per-ISA files
+ * (sha256_sse41.cpp, sha256_avx2.cpp, sha256_avx512.cpp: 4, 8 and 16
+ * lanes), which are compiled with the matching -m flags. Each lane hashes
+ * an independent message, so N inputs cost about as much as one:
+ *   - transform_d64: SHA256d of 64-byte inputs - merkle tree levels
+ *   - hash_headers: SHA256d of one 80-byte header for consecutive nonces,
+ *     starting from its midstate - mining
+ */
+
+namespace crypto {
+namespace sha256_lanes {
+namespace {
+
+template <typename V>
+inline V rotr(V x, int n) { return (x >> n) | (x << (32 - n)); }
+
+template <typename V>
+inline V broadcast(uint32_t x) { return V{} + x; }
+
+inline uint32_t read_be32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+inline void write_be32(unsigned char* p, uint32_t x) {
+    p[0] = (unsigned char)(x >> 24);
+    p[1] = (unsigned char)(x >> 16);
+    p[2] = (unsigned char)(x >> 8);
+    p[3] = (unsigned char)x;
+}
+
+// One compression over a 16-word block for every lane at once
+template <typename V>
+inline void compress(V* state, V* w) {
+    V a = state[0], b = state[1], c = state[2], d = state[3];
+    V e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i++) {
+        if (i >= 16) {
+            V w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            V s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            V s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+            w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+        }
+        V t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + (g ^ (e & (f ^ g)))
+                 + sha256::K[i] + w[i & 15];
+        V t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) | (c & (a | b)));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+// out[32 * LANES] = SHA256d(in[64 * i]) for each lane i
+template <typename V, int LANES>
+inline void transform_d64(unsigned char* out, const unsigned char* in) {
+    V state[8], w[16];
+
+    // First hash, block 1: the 64-byte inputs themselves
+    for (int i = 0; i < 8; i++) state[i] = broadcast<V>(sha256::INITIAL_STATE[i]);
+    for (int i = 0; i < 16; i++) {
+        for (int lane = 0; lane < LANES; lane++) w[i][lane] = read_be32(in + 64 * lane + 4 * i);
+    }
+    compress(state, w);
+
+    // First hash, block 2: padding for a 512-bit message (identical for every lane)
+    w[0] = broadcast<V>(0x80000000);
+    for (int i = 1; i < 15; i++) w[i] = broadcast<V>(0);
+    w[15] = broadcast<V>(512);
+    compress(state, w);
+
+    // Second hash: the 32-byte digest plus padding in a single block
+    for (int i = 0; i < 8; i++) w[i] = state[i];
+    w[8] = broadcast<V>(0x80000000);
+    for (int i = 9; i < 15; i++) w[i] = broadcast<V>(0);
+    w[15] = broadcast<V>(256);
+    for (int i = 0; i < 8; i++) state[i] = broadcast<V>(sha256::INITIAL_STATE[i]);
+    compress(state, w);
+
+    for (int lane = 0; lane < LANES; lane++) {
+        for (int i = 0; i < 8; i++) write_be32(out + 32 * lane + 4 * i, state[i][lane]);
+    }
+}
+
+// Mining: SHA256d of an 80-byte header for LANES consecutive nonces.
+// `midstate` is the state after header bytes 0..63, `tail` holds bytes 64..79
+// plus padding. out[32 * i] receives the hash for nonce first_nonce + i.
+template <typename V, int LANES>
+inline void hash_headers(unsigned char* out, const uint32_t* midstate, const unsigned char* tail,
+                         uint32_t first_nonce) {
+    V state[8], w[16];
+
+    // First hash, block 2: same tail for every lane except the nonce word
+    for (int i = 0; i < 8; i++) state[i] = broadcast<V>(midstate[i]);
+    for (int i = 0; i < 16; i++) w[i] = broadcast<V>(read_be32(tail + 4 * i));
+    for (int lane = 0; lane < LANES; lane++) {
+        uint32_t nonce = first_nonce + lane;
+        w[3][lane] = __builtin_bswap32(nonce); // stored little endian, read big endian
+    }
+    compress(state, w);
+
+    // Second hash over the 32-byte digest
+    for (int i = 0; i < 8; i++) w[i] = state[i];
+    w[8] = broadcast<V>(0x80000000);
+    for (int i = 9; i < 15; i++) w[i] = broadcast<V>(0);
+    w[15] = broadcast<V>(256);
+    for (int i = 0; i < 8; i++) state[i] = broadcast<V>(sha256::INITIAL_STATE[i]);
+    compress(state, w);
+
+    for (int lane = 0; lane < LANES; lane++) {
+        for (int i = 0; i < 8; i++) write_be32(out + 32 * lane + 4 * i, state[i][lane]);
+    }
+}
+
+} // namespace
+} // namespace sha256_lanes
+} // namespace crypto
@@ -0,0 +1,22 @@
+// src/crypto/sha256_sse41.cpp
+// Compiled with -msse4.1 - only call after sha256::auto_detect() says so
+#ifdef ENABLE_SSE41
+#include "sha256_lanes.h"
+
+namespace crypto {
+namespace sha256_sse41 {
+
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+
+void transform_d64_4way(unsigned char* out, const unsigned char* in) {
+    sha256_lanes::transform_d64<v4u32, 4>(out, in);
+}
+
+void hash_headers_4way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail,
+                       uint32_t first_nonce) {
+    sha256_lanes::hash_headers<v4u32, 4>(out, midstate, tail, first_nonce);
+}
+
+} // namespace sha256_sse41
+} // namespace crypto
+#endif
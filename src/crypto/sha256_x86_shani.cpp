@@ -0,0 +1,84 @@
+// src/crypto/sha256_x86_shani.cpp
+// Compiled with -msse4.1 -msha - only call after sha256::auto_detect() says so
+#ifdef ENABLE_X86_SHANI
+#include <cstring>
+#include <immintrin.h>
+#include "sha256.h"
+
+namespace crypto {
+namespace sha256_x86_shani {
+
+// Byte swap each 32-bit word (SHA-256 reads big-endian words)
+static inline __m128i load_be(const unsigned char* p) {
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)p), MASK);
+}
+
+void transform(uint32_t* state, const unsigned char* chunk, size_t blocks) {
+    // The SHA instructions want the state as ABEF / CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1); // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B); // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);     // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);          // CDGH
+
+    while (blocks--) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+        __m128i msg[4];
+
+        for (int i = 0; i < 16; i++) {
+            if (i < 4) {
+                msg[i] = load_be(chunk + 16 * i);
+            } else {
+                // Message schedule for W[4i..4i+3]
+                __m128i next = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+                msg[i & 3] = _mm_sha256msg2_epu32(next, msg[(i + 3) & 3]);
+            }
+
+            __m128i k = _mm_loadu_si128((const __m128i*)&sha256::K[4 * i]);
+            __m128i wk = _mm_add_epi32(msg[i & 3], k);
+            state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        chunk += 64;
+    }
+
+    // Back to ABCD / EFGH
+    tmp = _mm_shuffle_epi32(state0, 0x1B);                // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);             // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);          // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);             // HGFE
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+void transform_d64(unsigned char* out, const unsigned char* in) {
+    // First hash: the 64-byte input plus one block of fixed padding
+    static const unsigned char PADDING_512[64] = {
+        0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0x00,
+    };
+    uint32_t state[8];
+    std::memcpy(state, sha256::INITIAL_STATE, sizeof(state));
+    transform(state, in, 1);
+    transform(state, PADDING_512, 1);
+
+    // Second hash: digest + padding fits in one block
+    unsigned char block[64] = {0};
+    sha256::write_digest(state, block);
+    block[32] = 0x80;
+    block[62] = 0x01;
+    std::memcpy(state, sha256::INITIAL_STATE, sizeof(state));
+    transform(state, block, 1);
+    sha256::write_digest(state, out);
+}
+
+} // namespace sha256_x86_shani
+} // namespace crypto
+#endif
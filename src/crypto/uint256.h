@@ -0,0 +1,108 @@
+// src/crypto/uint256.h
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include "hex.h"
+
+namespace crypto {
+
+/**
+ * Fixed-size binary hash value
+ *
+ * Bytes are stored exactly as the hash function produced them. Bitcoin reads
+ * them as a little-endian number, so the hex form is byte-reversed - that is
+ * why block hashes print with their leading zeros first.
+ */
+template <size_t BYTES>
+class BaseBlob {
+private:
+    std::array<unsigned char, BYTES> blob_data;
+
+public:
+    static constexpr size_t SIZE = BYTES;
+
+    constexpr BaseBlob() : blob_data{} {}
+
+    explicit BaseBlob(const unsigned char* bytes) {
+        std::memcpy(blob_data.data(), bytes, BYTES);
+    }
+
+    // All zeros (e.g. "no previous transaction")
+    bool is_null() const {
+        unsigned char acc = 0;
+        for (unsigned char byte : blob_data) acc |= byte;
+        return acc == 0;
+    }
+
+    void set_null() { blob_data.fill(0); }
+
+    unsigned char* data() { return blob_data.data(); }
+    const unsigned char* data() const { return blob_data.data(); }
+    unsigned char* begin() { return blob_data.data(); }
+    unsigned char* end() { return blob_data.data() + BYTES; }
+    const unsigned char* begin() const { return blob_data.data(); }
+    const unsigned char* end() const { return blob_data.data() + BYTES; }
+    static constexpr size_t size() { return BYTES; }
+
+    // Read 8 bytes at `pos` (little endian) - handy for hash tables
+    uint64_t get_uint64(size_t pos) const {
+        uint64_t value;
+        std::memcpy(&value, blob_data.data() + pos * 8, 8);
+        return value;
+    }
+
+    // Display form (byte-reversed, like every block explorer)
+    std::string to_hex() const {
+        std::array<unsigned char, BYTES> reversed;
+        std::reverse_copy(blob_data.begin(), blob_data.end(), reversed.begin());
+        return bytes_to_hex(reversed.data(), BYTES);
+    }
+
+    // Parse the display form back, throws std::invalid_argument on bad input
+    static BaseBlob from_hex(const std::string& hex) {
+        BaseBlob result;
+        if (!hex_to_bytes(hex, result.blob_data.data(), BYTES)) {
+            throw std::invalid_argument("hash must be " + std::to_string(BYTES * 2) + " hex characters");
+        }
+        std::reverse(result.blob_data.begin(), result.blob_data.end());
+        return result;
+    }
+
+    // Constant-time: no early exit on the first differing byte
+    friend bool operator==(const BaseBlob& a, const BaseBlob& b) {
+        unsigned char diff = 0;
+        for (size_t i = 0; i < BYTES; i++) diff |= a.blob_data[i] ^ b.blob_data[i];
+        return diff == 0;
+    }
+    friend bool operator!=(const BaseBlob& a, const BaseBlob& b) { return !(a == b); }
+
+    // Byte-wise ordering so hashes can key ordered containers
+    friend bool operator<(const BaseBlob& a, const BaseBlob& b) {
+        return std::memcmp(a.blob_data.data(), b.blob_data.data(), BYTES) < 0;
+    }
+};
+
+using Hash256 = BaseBlob<32>;   // SHA256 / double SHA256 (txids, block hashes)
+using Hash160 = BaseBlob<20>;   // RIPEMD160 / Hash160 (addresses)
+
+static_assert(std::is_trivially_copyable<Hash256>::value, "Hash256 must be trivially copyable");
+static_assert(sizeof(Hash256) == 32, "Hash256 must not carry any padding");
+
+} // namespace crypto
+
+namespace std {
+
+// Hash output is already uniformly distributed, so any 8 bytes make a good key
+template <size_t BYTES>
+struct hash<crypto::BaseBlob<BYTES>> {
+    size_t operator()(const crypto::BaseBlob<BYTES>& blob) const {
+        return static_cast<size_t>(blob.get_uint64(0));
+    }
+};
+
+} // namespace std
@@ -2,12 +2,18 @@
 #include <iostream>
 #include <ctime>
 #include "crypto/hash.h"
+#include "crypto/sha256.h"
 #include "crypto/keys.h"
 #include "transaction/transaction.h"
 #include "blockchain/block.h"
+#include "mining/miner.h"
+#include "mempool/mempool.h"
 
 int main() {
     std::cout << "🤔 === UNDERSTANDING WHAT WE BUILT === 🤔" << std::endl;
+
+    // Pick the fastest SHA-256 implementation for this CPU before hashing anything
+    std::cout << "SHA-256 backend: " << crypto::sha256::auto_detect() << std::endl;
     
     // ====================================================================
     // PART 1: COINBASE TRANSACTION (How new bitcoins are created)
@@ -15,17 +21,17 @@ int main() {
     std::cout << "\n🏦 PART 1: COINBASE TRANSACTION" << std::endl;
     std::cout << "This is how NEW bitcoins enter the system!" << std::endl;
     
-    bitcoin::Transaction coinbase;
+    bitcoin::TransactionBuilder coinbase;
     
     // COINBASE INPUT: Special input that doesn't spend existing bitcoins
     std::cout << "\n--- Coinbase Input (Special!) ---" << std::endl;
     bitcoin::TransactionInput coinbase_input;
-    coinbase_input.previous_txid = std::string(64, '0'); // All zeros = "no previous transaction"
+    coinbase_input.previous_txid.set_null();             // All zeros = "no previous transaction"
     coinbase_input.vout = 0xFFFFFFFF;                    // Special number = "creating new money"
     coinbase_input.script_sig = "Mining reward for block #123456";
-    coinbase.inputs.push_back(coinbase_input);
+    coinbase.add_input(coinbase_input);
     
-    std::cout << "Previous TXID: " << coinbase_input.previous_txid.substr(0, 16) << "... (all zeros = new money)" << std::endl;
+    std::cout << "Previous TXID: " << coinbase_input.previous_txid.to_hex().substr(0, 16) << "... (all zeros = new money)" << std::endl;
     std::cout << "Message: " << coinbase_input.script_sig << std::endl;
     
     // COINBASE OUTPUT: Where the new bitcoins go (to the miner)
@@ -36,8 +42,9 @@ int main() {
     
     bitcoin::TransactionOutput coinbase_output;
     coinbase_output.value = 5000000000; // 50 BTC (early Bitcoin reward)
-    coinbase_output.script_pubkey = "Pay 50 BTC to: " + miner_address;
-    coinbase.outputs.push_back(coinbase_output);
+    // Locking script behind the address: OP_DUP OP_HASH160 <key hash> OP_EQUALVERIFY OP_CHECKSIG
+    coinbase_output.script_pubkey = bitcoin::make_p2pkh(crypto::Hash::hash160(miner_public.get_bytes()));
+    coinbase.add_output(coinbase_output);
     
     std::cout << "Miner gets: " << coinbase_output.get_btc_amount() << " BTC" << std::endl;
     std::cout << "Miner's address: " << miner_address << std::endl;
@@ -49,7 +56,7 @@ int main() {
     std::cout << "\n💳 PART 2: REGULAR TRANSACTION" << std::endl;
     std::cout << "Alice sends bitcoin to Bob (normal payment)" << std::endl;
     
-    bitcoin::Transaction payment;
+    bitcoin::TransactionBuilder payment;
     
     // Create Alice and Bob
     crypto::PrivateKey alice_key;
@@ -63,12 +70,12 @@ int main() {
     // ALICE'S INPUT: She's spending bitcoins she received before
     std::cout << "\n--- Alice's Input (What she's spending) ---" << std::endl;
     bitcoin::TransactionInput alice_input;
-    alice_input.previous_txid = "abc123def456..."; // Some previous transaction where Alice received bitcoins
+    alice_input.previous_txid = crypto::Hash::double_sha256("Alice's earlier payment"); // Some previous transaction where Alice received bitcoins
     alice_input.vout = 0;                          // She's spending output #0 from that transaction
     alice_input.script_sig = "Alice's signature proving she owns those bitcoins";
-    payment.inputs.push_back(alice_input);
+    payment.add_input(alice_input);
     
-    std::cout << "Alice is spending from transaction: " << alice_input.previous_txid << std::endl;
+    std::cout << "Alice is spending from transaction: " << alice_input.previous_txid.to_hex() << std::endl;
     std::cout << "Output index: " << alice_input.vout << std::endl;
     std::cout << "💡 Alice proves ownership with her digital signature!" << std::endl;
     
@@ -78,14 +85,14 @@ int main() {
     // Output 1: Payment to Bob
     bitcoin::TransactionOutput to_bob;
     to_bob.value = 100000000; // 1 BTC
-    to_bob.script_pubkey = "Pay 1 BTC to: " + bob_public.to_bitcoin_address();
-    payment.outputs.push_back(to_bob);
+    to_bob.script_pubkey = bitcoin::make_p2pkh(crypto::Hash::hash160(bob_public.get_bytes()));
+    payment.add_output(to_bob);
     
     // Output 2: Change back to Alice (if she had more than 1 BTC)
     bitcoin::TransactionOutput change_to_alice;
     change_to_alice.value = 50000000; // 0.5 BTC change
-    change_to_alice.script_pubkey = "Pay 0.5 BTC back to: " + alice_public.to_bitcoin_address();
-    payment.outputs.push_back(change_to_alice);
+    change_to_alice.script_pubkey = bitcoin::make_p2pkh(crypto::Hash::hash160(alice_public.get_bytes()));
+    payment.add_output(change_to_alice);
     
     std::cout << "Bob receives: " << to_bob.get_btc_amount() << " BTC" << std::endl;
     std::cout << "Alice gets change: " << change_to_alice.get_btc_amount() << " BTC" << std::endl;
@@ -97,21 +104,31 @@ int main() {
     std::cout << "\n📦 PART 3: BLOCK" << std::endl;
     std::cout << "Bundling transactions into a block (like a page in a ledger)" << std::endl;
     
+    // Payments wait in the mempool until a miner picks them up. Alice's input is
+    // made up, so it goes in unchecked with the fee she would be paying.
+    bitcoin::Mempool mempool;
+    mempool.add_unchecked(std::move(payment).build(), 10000);
+    std::cout << "Mempool: " << mempool.size() << " transaction(s) waiting" << std::endl;
+
     bitcoin::Block block;
-    block.transactions.push_back(coinbase);  // First transaction = coinbase (mining reward)
-    block.transactions.push_back(payment);   // Other transactions = regular payments
+    // build() freezes each transaction; the block just shares the finished copies
+    block.transactions.push_back(std::move(coinbase).build()); // First transaction = coinbase (mining reward)
+    // Other transactions = regular payments, best fee rate first (room left for the coinbase)
+    for (const auto& tx : mempool.build_block_template(bitcoin::MAX_BLOCK_WEIGHT - 4000)) {
+        block.transactions.push_back(tx);
+    }
     
     // BLOCK HEADER: Metadata about this block
     std::cout << "\n--- Block Header (Block's ID card) ---" << std::endl;
     block.header.version = 1;
-    block.header.previous_block_hash = "000000b873e79784647a6c82962c70d228557d24a747ea4d1b8bbe878e1206";
+    block.header.previous_block_hash = crypto::Hash256::from_hex("00000000839a8e6886ab5951d76f411475428afc90947ee320161bbf18eb6048");
     block.header.merkle_root = block.calculate_merkle_root();
     block.header.timestamp = static_cast<uint32_t>(std::time(nullptr));
-    block.header.bits = 4; // Difficulty
+    block.header.bits = 0x200fffff; // Difficulty in compact form: target 0x0fffff00..00, so the hash must start with a zero
     block.header.nonce = 0; // We'll find this through mining
     
-    std::cout << "Previous block: " << block.header.previous_block_hash.substr(0, 16) << "..." << std::endl;
-    std::cout << "Merkle root: " << block.header.merkle_root.substr(0, 16) << "... (summary of all transactions)" << std::endl;
+    std::cout << "Previous block: " << block.header.previous_block_hash.to_hex().substr(0, 16) << "..." << std::endl;
+    std::cout << "Merkle root: " << block.header.merkle_root.to_hex().substr(0, 16) << "... (summary of all transactions)" << std::endl;
     std::cout << "Timestamp: " << block.header.timestamp << std::endl;
     std::cout << "💡 This links to the previous block, creating a chain!" << std::endl;
     
@@ -122,20 +139,24 @@ int main() {
     std::cout << "Finding a nonce that makes the block hash start with zeros" << std::endl;
     
     std::cout << "\nBefore mining:" << std::endl;
-    std::cout << "Block hash: " << block.calculate_hash() << std::endl;
+    std::cout << "Block hash: " << block.calculate_hash().to_hex() << std::endl;
     std::cout << "Starts with zero? " << (block.header.has_valid_proof_of_work() ? "YES" : "NO") << std::endl;
     
     std::cout << "\nMining..." << std::endl;
-    uint32_t attempts = 0;
-    while (!block.header.has_valid_proof_of_work() && attempts < 100000) {
-        block.header.nonce++;
-        attempts++;
+    bitcoin::Miner miner; // one worker thread per CPU core
+    std::optional<bitcoin::BlockHeader> mined = miner.mine(block.header);
+    if (mined) {
+        block.header = *mined;
     }
+    bitcoin::MinerStats mining = miner.stats();
+    uint64_t attempts = mining.total_hashes;
     
     std::cout << "\nAfter mining:" << std::endl;
     std::cout << "Found nonce: " << block.header.nonce << " after " << attempts << " attempts" << std::endl;
-    std::cout << "Block hash: " << block.calculate_hash() << std::endl;
+    std::cout << "Block hash: " << block.calculate_hash().to_hex() << std::endl;
     std::cout << "Starts with zero? " << (block.header.has_valid_proof_of_work() ? "YES ✅" : "NO") << std::endl;
+    std::cout << "Hash rate: " << (uint64_t)mining.hashrate() << " hashes/sec across "
+              << miner.thread_count() << " thread(s)" << std::endl;
     std::cout << "💡 This proves the miner did computational work!" << std::endl;
     
     // ====================================================================
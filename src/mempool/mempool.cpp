@@ -0,0 +1,494 @@
+// src/mempool/mempool.cpp
+#include "mempool.h"
+#include "../validation/validation.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <unordered_set>
+
+namespace bitcoin {
+
+// fee_a / size_a > fee_b / size_b, exactly (cross-multiplied in 128 bits)
+static bool higher_feerate(uint64_t fee_a, uint64_t size_a, uint64_t fee_b, uint64_t size_b) {
+    return (unsigned __int128)fee_a * size_b > (unsigned __int128)fee_b * size_a;
+}
+
+// Rough heap footprint of a pool entry: the transaction plus the map, index
+// and spent-outpoint nodes that point at it
+static size_t entry_usage(const Transaction& tx) {
+    static constexpr size_t NODE_OVERHEAD = 48;     // allocator header + links, per node
+    size_t usage = sizeof(Transaction) + 16 + sizeof(Mempool::Entry) + sizeof(crypto::Hash256) + 3 * NODE_OVERHEAD;
+    for (const TransactionInput& input : tx.inputs) {
+        usage += sizeof(TransactionInput) + sizeof(OutPoint) + sizeof(void*) + NODE_OVERHEAD;
+        if (input.script_sig.size() >= sizeof(std::string)) usage += input.script_sig.capacity();
+        for (const std::string& item : input.witness) {
+            usage += sizeof(std::string);
+            if (item.size() >= sizeof(std::string)) usage += item.capacity();
+        }
+    }
+    for (const TransactionOutput& output : tx.outputs) {
+        usage += sizeof(TransactionOutput);
+        if (output.script_pubkey.capacity() > Script::INLINE_CAPACITY) usage += output.script_pubkey.capacity();
+    }
+    return usage;
+}
+
+const char* mempool_reject_name(MempoolReject reason) {
+    switch (reason) {
+        case MempoolReject::OK: return "ok";
+        case MempoolReject::ALREADY_KNOWN: return "already in the mempool";
+        case MempoolReject::COINBASE: return "coinbase";
+        case MempoolReject::EMPTY: return "no inputs or outputs";
+        case MempoolReject::BAD_AMOUNT: return "amount out of range";
+        case MempoolReject::NON_FINAL: return "non-final";
+        case MempoolReject::DUPLICATE_INPUTS: return "duplicate inputs";
+        case MempoolReject::MISSING_INPUTS: return "missing inputs";
+        case MempoolReject::PREMATURE_COINBASE_SPEND: return "immature coinbase spend";
+        case MempoolReject::CONFLICT: return "conflicts with a mempool transaction";
+        case MempoolReject::OUTPUTS_EXCEED_INPUTS: return "outputs exceed inputs";
+        case MempoolReject::FEE_TOO_LOW: return "fee too low";
+        case MempoolReject::TOO_MANY_ANCESTORS: return "too many unconfirmed ancestors";
+        case MempoolReject::TOO_MANY_DESCENDANTS: return "too many unconfirmed descendants";
+        case MempoolReject::SCRIPT_FAILED: return "script verification failed";
+        case MempoolReject::MEMPOOL_FULL: return "mempool full";
+    }
+    return "unknown";
+}
+
+bool Mempool::ByAncestorFeerate::operator()(const Entry* a, const Entry* b) const {
+    if (higher_feerate(a->ancestor_fee, a->ancestor_size, b->ancestor_fee, b->ancestor_size)) return true;
+    if (higher_feerate(b->ancestor_fee, b->ancestor_size, a->ancestor_fee, a->ancestor_size)) return false;
+    return a->sequence < b->sequence;
+}
+
+bool Mempool::ByDescendantFeerate::operator()(const Entry* a, const Entry* b) const {
+    if (higher_feerate(b->descendant_fee, b->descendant_size, a->descendant_fee, a->descendant_size)) return true;
+    if (higher_feerate(a->descendant_fee, a->descendant_size, b->descendant_fee, b->descendant_size)) return false;
+    return a->sequence > b->sequence;
+}
+
+Mempool::Mempool(size_t max_memory, SignatureCache* sig_cache, uint64_t min_fee_rate)
+    : max_memory(max_memory), sig_cache(sig_cache), min_fee_rate(min_fee_rate) {}
+
+std::vector<Mempool::Entry*> Mempool::collect_ancestors(const std::vector<Entry*>& parents) const {
+    uint64_t epoch = ++visit_epoch;
+    std::vector<Entry*> result;
+    for (Entry* parent : parents) {
+        if (parent->visited == epoch) continue;
+        parent->visited = epoch;
+        result.push_back(parent);
+    }
+    for (size_t i = 0; i < result.size(); i++) {
+        for (Entry* parent : result[i]->parents) {
+            if (parent->visited == epoch) continue;
+            parent->visited = epoch;
+            result.push_back(parent);
+        }
+    }
+    return result;
+}
+
+std::vector<Mempool::Entry*> Mempool::collect_descendants(Entry* entry) const {
+    uint64_t epoch = ++visit_epoch;
+    entry->visited = epoch;
+    std::vector<Entry*> result;
+    for (size_t i = 0; i <= result.size(); i++) {
+        const Entry* from = i == 0 ? entry : result[i - 1];
+        for (Entry* child : from->children) {
+            if (child->visited == epoch) continue;
+            child->visited = epoch;
+            result.push_back(child);
+        }
+    }
+    return result;
+}
+
+Mempool::Entry* Mempool::add_entry(TransactionRef tx, uint64_t fee, uint32_t weight, uint64_t sigop_cost,
+                                   std::vector<Entry*> parents, const std::vector<Entry*>& ancestors) {
+    Entry& entry = entries.try_emplace(tx->get_txid()).first->second;
+    entry.tx = std::move(tx);
+    entry.fee = fee;
+    entry.weight = weight;
+    entry.sigop_cost = sigop_cost;
+    entry.vsize = (weight + WITNESS_SCALE_FACTOR - 1) / WITNESS_SCALE_FACTOR;
+    entry.usage = entry_usage(*entry.tx);
+    entry.sequence = next_sequence++;
+
+    entry.ancestor_count = 1 + ancestors.size();
+    entry.ancestor_size = entry.vsize;
+    entry.ancestor_fee = fee;
+    entry.ancestor_sigop_cost = sigop_cost;
+    for (const Entry* ancestor : ancestors) {
+        entry.ancestor_size += ancestor->vsize;
+        entry.ancestor_fee += ancestor->fee;
+        entry.ancestor_sigop_cost += ancestor->sigop_cost;
+    }
+    entry.descendant_count = 1;
+    entry.descendant_size = entry.vsize;
+    entry.descendant_fee = fee;
+
+    // Every ancestor gains a descendant (re-sorted: its key changes)
+    for (Entry* ancestor : ancestors) {
+        by_descendant_feerate.erase(ancestor);
+        ancestor->descendant_count++;
+        ancestor->descendant_size += entry.vsize;
+        ancestor->descendant_fee += fee;
+        by_descendant_feerate.insert(ancestor);
+    }
+
+    entry.parents = std::move(parents);
+    for (Entry* parent : entry.parents) parent->children.push_back(&entry);
+    for (const TransactionInput& input : entry.tx->inputs) spent_by[OutPoint(input)] = &entry;
+    by_ancestor_feerate.insert(&entry);
+    by_descendant_feerate.insert(&entry);
+
+    counters.transactions++;
+    counters.total_vsize += entry.vsize;
+    counters.total_fees += fee;
+    counters.memory_usage += entry.usage;
+    return &entry;
+}
+
+void Mempool::remove_entry(Entry* entry) {
+    // Ancestors lose a descendant, descendants lose an ancestor
+    for (Entry* ancestor : collect_ancestors(entry->parents)) {
+        by_descendant_feerate.erase(ancestor);
+        ancestor->descendant_count--;
+        ancestor->descendant_size -= entry->vsize;
+        ancestor->descendant_fee -= entry->fee;
+        by_descendant_feerate.insert(ancestor);
+    }
+    for (Entry* descendant : collect_descendants(entry)) {
+        by_ancestor_feerate.erase(descendant);
+        descendant->ancestor_count--;
+        descendant->ancestor_size -= entry->vsize;
+        descendant->ancestor_fee -= entry->fee;
+        descendant->ancestor_sigop_cost -= entry->sigop_cost;
+        by_ancestor_feerate.insert(descendant);
+    }
+
+    for (Entry* parent : entry->parents) {
+        parent->children.erase(std::find(parent->children.begin(), parent->children.end(), entry));
+    }
+    for (Entry* child : entry->children) {
+        child->parents.erase(std::find(child->parents.begin(), child->parents.end(), entry));
+    }
+    for (const TransactionInput& input : entry->tx->inputs) spent_by.erase(OutPoint(input));
+    by_ancestor_feerate.erase(entry);
+    by_descendant_feerate.erase(entry);
+
+    counters.transactions--;
+    counters.total_vsize -= entry->vsize;
+    counters.total_fees -= entry->fee;
+    counters.memory_usage -= entry->usage;
+
+    crypto::Hash256 txid = entry->tx->get_txid();
+    entries.erase(txid);
+}
+
+void Mempool::remove_with_descendants(Entry* entry) {
+    // Leaves first, so nothing removed is still some remaining entry's
+    // descendant: a descendant always has more ancestors than its ancestors
+    std::vector<Entry*> doomed = collect_descendants(entry);
+    doomed.push_back(entry);
+    std::sort(doomed.begin(), doomed.end(),
+              [](const Entry* a, const Entry* b) { return a->ancestor_count > b->ancestor_count; });
+    for (Entry* e : doomed) remove_entry(e);
+}
+
+void Mempool::trim(size_t max_bytes) {
+    while (counters.memory_usage > max_bytes && !by_descendant_feerate.empty()) {
+        size_t before = counters.transactions;
+        remove_with_descendants(*by_descendant_feerate.begin());
+        counters.evicted += before - counters.transactions;
+    }
+}
+
+MempoolReject Mempool::accept(TransactionRef tx, const CoinsView& chain, const BlockIndexEntry* tip) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto reject = [&](MempoolReject reason) {
+        counters.rejected++;
+        return reason;
+    };
+
+    const Transaction& t = *tx;
+    if (t.is_coinbase()) return reject(MempoolReject::COINBASE);
+    if (!check_transaction(t)) return reject(MempoolReject::EMPTY);
+    if (entries.count(t.get_txid())) return reject(MempoolReject::ALREADY_KNOWN);
+
+    uint64_t output_value = 0;
+    if (!t.get_output_value_checked(output_value)) return reject(MempoolReject::BAD_AMOUNT);
+
+    // Final in the next block: the time cutoff is the tip's median time past
+    uint32_t next_height = tip ? tip->height + 1 : 0;
+    if (!is_final_transaction(t, next_height, tip ? tip->get_median_time_past() : 0)) {
+        return reject(MempoolReject::NON_FINAL);
+    }
+
+    // Each outpoint at most once
+    std::vector<OutPoint> outpoints;
+    outpoints.reserve(t.inputs.size());
+    for (const TransactionInput& input : t.inputs) outpoints.emplace_back(input);
+    std::sort(outpoints.begin(), outpoints.end(), [](const OutPoint& a, const OutPoint& b) {
+        int order = std::memcmp(a.txid.data(), b.txid.data(), a.txid.size());
+        return order < 0 || (order == 0 && a.vout < b.vout);
+    });
+    if (std::adjacent_find(outpoints.begin(), outpoints.end()) != outpoints.end()) {
+        return reject(MempoolReject::DUPLICATE_INPUTS);
+    }
+
+    // What each input spends: an output of a pool transaction or an unspent coin
+    std::vector<Coin> spent;
+    spent.reserve(t.inputs.size());
+    std::vector<uint32_t> coin_heights;     // pool outputs count as in the next block
+    coin_heights.reserve(t.inputs.size());
+    std::vector<Entry*> parents;
+    uint64_t input_value = 0;
+    for (const TransactionInput& input : t.inputs) {
+        OutPoint outpoint(input);
+        if (spent_by.count(outpoint)) return reject(MempoolReject::CONFLICT);
+        auto parent = entries.find(outpoint.txid);
+        if (parent != entries.end()) {
+            const std::vector<TransactionOutput>& outputs = parent->second.tx->outputs;
+            if (outpoint.vout >= outputs.size()) return reject(MempoolReject::MISSING_INPUTS);
+            spent.emplace_back(outputs[outpoint.vout], next_height, false);
+            coin_heights.push_back(next_height);
+            if (std::find(parents.begin(), parents.end(), &parent->second) == parents.end()) {
+                parents.push_back(&parent->second);
+            }
+        } else {
+            Coin coin;
+            if (!chain.get_coin(outpoint, coin)) return reject(MempoolReject::MISSING_INPUTS);
+            if (coin.coinbase && next_height - coin.height < Coin::COINBASE_MATURITY) {
+                return reject(MempoolReject::PREMATURE_COINBASE_SPEND);
+            }
+            coin_heights.push_back(coin.height);
+            spent.push_back(std::move(coin));
+        }
+        input_value += spent.back().out.value;
+        if (!money_range(spent.back().out.value) || !money_range(input_value)) return reject(MempoolReject::BAD_AMOUNT);
+    }
+    if (!check_sequence_locks(t, coin_heights, tip)) return reject(MempoolReject::NON_FINAL);
+
+    if (output_value > input_value) return reject(MempoolReject::OUTPUTS_EXCEED_INPUTS);
+    uint64_t fee = input_value - output_value;
+    uint32_t weight = (uint32_t)t.get_weight();
+    uint64_t vsize = (weight + WITNESS_SCALE_FACTOR - 1) / WITNESS_SCALE_FACTOR;
+    if (fee * 1000 < min_fee_rate * vsize) return reject(MempoolReject::FEE_TOO_LOW);
+
+    std::vector<Entry*> ancestors = collect_ancestors(parents);
+    if (ancestors.size() + 1 > ANCESTOR_LIMIT) return reject(MempoolReject::TOO_MANY_ANCESTORS);
+    for (const Entry* ancestor : ancestors) {
+        if (ancestor->descendant_count + 1 > DESCENDANT_LIMIT) return reject(MempoolReject::TOO_MANY_DESCENDANTS);
+    }
+
+    // Scripts last - they're the expensive part
+    std::optional<PrecomputedSighash> precomputed;
+    if (t.has_witness()) precomputed.emplace(t);
+    for (size_t i = 0; i < t.inputs.size(); i++) {
+        if (!verify_input_script(t, i, spent[i].out, sig_cache, precomputed ? &*precomputed : nullptr)) {
+            return reject(MempoolReject::SCRIPT_FAILED);
+        }
+    }
+
+    crypto::Hash256 txid = t.get_txid();
+    uint64_t sigop_cost = get_transaction_sigop_cost(t, spent);
+    add_entry(std::move(tx), fee, weight, sigop_cost, std::move(parents), ancestors);
+    trim(max_memory);
+    if (!entries.count(txid)) return reject(MempoolReject::MEMPOOL_FULL);
+    counters.accepted++;
+    return MempoolReject::OK;
+}
+
+bool Mempool::add_unchecked(TransactionRef tx, uint64_t fee) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.count(tx->get_txid())) return false;
+    std::vector<Entry*> parents;
+    for (const TransactionInput& input : tx->inputs) {
+        auto parent = entries.find(input.previous_txid);
+        if (parent != entries.end() && std::find(parents.begin(), parents.end(), &parent->second) == parents.end()) {
+            parents.push_back(&parent->second);
+        }
+    }
+    std::vector<Entry*> ancestors = collect_ancestors(parents);
+    uint32_t weight = (uint32_t)tx->get_weight();
+    uint64_t sigop_cost = get_transaction_sigop_cost(*tx, {});
+    add_entry(std::move(tx), fee, weight, sigop_cost, std::move(parents), ancestors);
+    return true;
+}
+
+bool Mempool::contains(const crypto::Hash256& txid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.count(txid) != 0;
+}
+
+TransactionRef Mempool::get(const crypto::Hash256& txid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(txid);
+    return it == entries.end() ? nullptr : it->second.tx;
+}
+
+bool Mempool::get_entry(const crypto::Hash256& txid, Entry& entry) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(txid);
+    if (it == entries.end()) return false;
+    entry = it->second;
+    return true;
+}
+
+size_t Mempool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void Mempool::remove_for_block(const Block& block) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Confirmed: in block order, so parents go before their children and
+    // the children simply lose an ancestor
+    for (const TransactionRef& tx : block.transactions) {
+        auto it = entries.find(tx->get_txid());
+        if (it != entries.end()) remove_entry(&it->second);
+    }
+    // Whatever still spends the same outputs is now a double spend
+    for (const TransactionRef& tx : block.transactions) {
+        if (tx->is_coinbase()) continue;
+        for (const TransactionInput& input : tx->inputs) {
+            auto it = spent_by.find(OutPoint(input));
+            if (it != spent_by.end()) remove_with_descendants(it->second);
+        }
+    }
+}
+
+void Mempool::remove_recursive(const crypto::Hash256& txid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(txid);
+    if (it != entries.end()) remove_with_descendants(&it->second);
+}
+
+void Mempool::trim_to_size(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    trim(max_bytes);
+}
+
+MempoolStats Mempool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+std::vector<TransactionRef> Mempool::build_block_template(size_t max_weight, uint64_t* fees,
+                                                          uint64_t max_sigop_cost) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // A package whose size, fee and sigop cost shrank because some of its
+    // ancestors are already in the block
+    struct Package {
+        Entry* entry;
+        uint64_t size;
+        uint64_t fee;
+        uint64_t sigop_cost;
+    };
+    auto better = [](const Package& a, const Package& b) {
+        if (higher_feerate(a.fee, a.size, b.fee, b.size)) return true;
+        if (higher_feerate(b.fee, b.size, a.fee, a.size)) return false;
+        return a.entry->sequence < b.entry->sequence;
+    };
+    auto whole_package = [](Entry* entry) {
+        return Package{entry, entry->ancestor_size, entry->ancestor_fee, entry->ancestor_sigop_cost};
+    };
+    std::set<Package, decltype(better)> modified(better);
+    std::unordered_map<const Entry*, std::set<Package, decltype(better)>::iterator> modified_at;
+    std::unordered_set<const Entry*> in_block, failed;
+
+    std::vector<TransactionRef> result;
+    uint64_t total_fees = 0;
+    size_t block_weight = 0;
+    uint64_t block_sigop_cost = 0;
+    int failures = 0;
+    auto next = by_ancestor_feerate.begin();
+    while (true) {
+        // Entries already taken, re-rated or given up on come from elsewhere
+        while (next != by_ancestor_feerate.end() &&
+               (in_block.count(*next) || modified_at.count(*next) || failed.count(*next))) {
+            ++next;
+        }
+        if (next == by_ancestor_feerate.end() && modified.empty()) break;
+
+        // Best of the untouched index and the re-rated packages
+        Package best;
+        bool from_modified;
+        if (next != by_ancestor_feerate.end() &&
+            (modified.empty() || better(whole_package(*next), *modified.begin()))) {
+            best = whole_package(*next);
+            from_modified = false;
+            ++next;
+        } else {
+            best = *modified.begin();
+            from_modified = true;
+        }
+
+        if (block_weight + best.size * WITNESS_SCALE_FACTOR > max_weight ||
+            block_sigop_cost + best.sigop_cost > max_sigop_cost) {
+            if (from_modified) {
+                modified_at.erase(best.entry);
+                modified.erase(modified.begin());
+            }
+            failed.insert(best.entry);
+            // Nearly full and nothing has fitted for a while: stop looking
+            if (++failures > 1000 && block_weight + 4000 > max_weight) break;
+            continue;
+        }
+        failures = 0;
+
+        // The package: this entry and its ancestors not in the block yet,
+        // parents first (a descendant has more ancestors than any of its ancestors)
+        uint64_t epoch = ++visit_epoch;
+        std::vector<Entry*> package{best.entry};
+        best.entry->visited = epoch;
+        for (size_t i = 0; i < package.size(); i++) {
+            for (Entry* parent : package[i]->parents) {
+                if (parent->visited == epoch || in_block.count(parent)) continue;
+                parent->visited = epoch;
+                package.push_back(parent);
+            }
+        }
+        std::sort(package.begin(), package.end(), [](const Entry* a, const Entry* b) {
+            return a->ancestor_count < b->ancestor_count ||
+                   (a->ancestor_count == b->ancestor_count && a->sequence < b->sequence);
+        });
+
+        for (Entry* entry : package) {
+            result.push_back(entry->tx);
+            in_block.insert(entry);
+            block_weight += entry->weight;
+            block_sigop_cost += entry->sigop_cost;
+            total_fees += entry->fee;
+            auto at = modified_at.find(entry);
+            if (at != modified_at.end()) {
+                modified.erase(at->second);
+                modified_at.erase(at);
+            }
+        }
+
+        // Re-rate what's left of the descendants' packages
+        for (Entry* entry : package) {
+            for (Entry* descendant : collect_descendants(entry)) {
+                if (in_block.count(descendant)) continue;
+                Package updated = whole_package(descendant);
+                auto at = modified_at.find(descendant);
+                if (at != modified_at.end()) {
+                    updated = *at->second;
+                    modified.erase(at->second);
+                }
+                updated.size -= entry->vsize;
+                updated.fee -= entry->fee;
+                updated.sigop_cost -= entry->sigop_cost;
+                modified_at[descendant] = modified.insert(updated).first;
+            }
+        }
+    }
+
+    if (fees) *fees = total_fees;
+    return result;
+}
+
+} // namespace bitcoin
@@ -0,0 +1,199 @@
+// src/mempool/mempool.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "../blockchain/block.h"
+#include "../blockchain/block_index.h"
+#include "../coins/coins.h"
+#include "../script/sig_cache.h"
+#include "../transaction/transaction.h"
+
+namespace bitcoin {
+
+// Why a transaction was turned away
+enum class MempoolReject : uint8_t {
+    OK,
+    ALREADY_KNOWN,
+    COINBASE,                   // only valid in a block
+    EMPTY,                      // no inputs or no outputs (check_transaction())
+    BAD_AMOUNT,                 // an amount or total above MAX_MONEY
+    NON_FINAL,                  // lock time or BIP68 sequence lock not reached in the next block
+    DUPLICATE_INPUTS,
+    MISSING_INPUTS,             // not in the chain or the pool (or already spent)
+    PREMATURE_COINBASE_SPEND,
+    CONFLICT,                   // spends an output another pool transaction spends
+    OUTPUTS_EXCEED_INPUTS,
+    FEE_TOO_LOW,
+    TOO_MANY_ANCESTORS,
+    TOO_MANY_DESCENDANTS,       // would push an ancestor over the limit
+    SCRIPT_FAILED,
+    MEMPOOL_FULL,               // evicted again straight away
+};
+
+const char* mempool_reject_name(MempoolReject reason);
+
+struct MempoolStats {
+    size_t transactions = 0;
+    uint64_t total_vsize = 0;
+    uint64_t total_fees = 0;
+    size_t memory_usage = 0;        // bytes, compared against the pool limit
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+    uint64_t evicted = 0;           // removed by trim_to_size()
+};
+
+/**
+ * Unconfirmed transactions
+ *
+ * Every entry knows its in-pool parents and children and keeps running
+ * totals (count, vsize, fees; sigop cost for ancestors) over itself plus
+ * all its ancestors and over itself plus all its descendants. Adding or
+ * removing a transaction only updates the totals of its relatives, which
+ * the ancestor and descendant limits keep to a couple of dozen entries.
+ *
+ * Two ordered indexes sit on top of the entries:
+ *   - ancestor feerate, highest first: block templates take packages (a
+ *     transaction with its unconfirmed ancestors) from the front, so
+ *     building one only touches what ends up in the block
+ *   - descendant feerate, lowest first: trim_to_size() evicts from the front
+ *
+ * Transactions are shared (TransactionRef), never copied. Thread-safe.
+ */
+class Mempool {
+public:
+    static constexpr size_t DEFAULT_MAX_MEMORY = 300 << 20;
+    static constexpr size_t ANCESTOR_LIMIT = 25;            // transactions, counting itself
+    static constexpr size_t DESCENDANT_LIMIT = 25;
+    static constexpr uint64_t DEFAULT_MIN_FEE_RATE = 1000;  // satoshis per 1000 vbytes
+
+    struct Entry {
+        TransactionRef tx;
+        uint64_t fee = 0;
+        uint32_t weight = 0;
+        uint32_t vsize = 0;             // weight / 4, rounded up
+        uint64_t sigop_cost = 0;        // BIP141, as blocks count it
+        size_t usage = 0;               // memory, entry and indexes included
+        uint64_t sequence = 0;          // admission order, breaks feerate ties
+
+        std::vector<Entry*> parents;    // in-pool transactions this one spends
+        std::vector<Entry*> children;
+
+        // Totals over this entry and all its ancestors / descendants
+        uint64_t ancestor_count = 1;
+        uint64_t ancestor_size = 0;
+        uint64_t ancestor_fee = 0;
+        uint64_t ancestor_sigop_cost = 0;
+        uint64_t descendant_count = 1;
+        uint64_t descendant_size = 0;
+        uint64_t descendant_fee = 0;
+
+        uint64_t visited = 0;           // last graph walk that reached this entry
+    };
+
+    // `sig_cache` (optional) should be the one block validation uses, so
+    // signatures checked here are free when the block arrives
+    explicit Mempool(size_t max_memory = DEFAULT_MAX_MEMORY, SignatureCache* sig_cache = nullptr,
+                     uint64_t min_fee_rate = DEFAULT_MIN_FEE_RATE);
+
+    Mempool(const Mempool&) = delete;
+    Mempool& operator=(const Mempool&) = delete;
+
+    /**
+     * Validate `tx` and add it
+     *
+     * Inputs come from `chain` (the coins at `tip`) or from transactions
+     * already in the pool. The transaction must be able to go in the next
+     * block: coinbase maturity, lock time and sequence locks are checked
+     * against the block after `tip` (nullptr: the genesis block). Scripts
+     * are checked with every consensus rule. No replacement: a conflict
+     * with a pool transaction is a rejection.
+     */
+    MempoolReject accept(TransactionRef tx, const CoinsView& chain, const BlockIndexEntry* tip);
+
+    // Add a transaction the caller vouches for (checks, limits and the
+    // memory limit are skipped). Without the spent coins only its legacy
+    // sigops are counted. False if it's already there.
+    bool add_unchecked(TransactionRef tx, uint64_t fee);
+
+    bool contains(const crypto::Hash256& txid) const;
+    TransactionRef get(const crypto::Hash256& txid) const;     // nullptr if not there
+
+    // Copy a pool entry with its package totals into `entry` (its parent and
+    // child pointers aren't for following); false if not there
+    bool get_entry(const crypto::Hash256& txid, Entry& entry) const;
+
+    size_t size() const;
+
+    // A block was connected: drop its transactions and anything that now
+    // conflicts with it (plus their descendants)
+    void remove_for_block(const Block& block);
+
+    // Remove a transaction and everything that spends it
+    void remove_recursive(const crypto::Hash256& txid);
+
+    // Sigop cost build_block_template() leaves for the coinbase by default
+    static constexpr uint64_t COINBASE_SIGOP_RESERVE = 400;
+
+    /**
+     * Transactions for a block of at most `max_weight` and `max_sigop_cost`
+     * (leave room for the coinbase), parents before children
+     *
+     * Greedy by ancestor feerate, as Bitcoin Core's BlockAssembler: take
+     * the best package, then re-rate the descendants of what was taken -
+     * their packages got smaller - and repeat. A package that would break
+     * either limit is skipped. The total fees go in `fees`.
+     */
+    std::vector<TransactionRef> build_block_template(size_t max_weight, uint64_t* fees = nullptr,
+                                                     uint64_t max_sigop_cost = MAX_BLOCK_SIGOPS_COST -
+                                                                               COINBASE_SIGOP_RESERVE) const;
+
+    // Evict the lowest descendant-feerate packages until memory use is under `max_bytes`
+    void trim_to_size(size_t max_bytes);
+
+    MempoolStats stats() const;
+
+private:
+    // Orders by fee / size, highest first (ties: older first)
+    struct ByAncestorFeerate {
+        bool operator()(const Entry* a, const Entry* b) const;
+    };
+    // Lowest first (ties: newer first - evicted before older ones)
+    struct ByDescendantFeerate {
+        bool operator()(const Entry* a, const Entry* b) const;
+    };
+    struct TxidHasher {
+        SaltedOutPointHasher hasher;
+        size_t operator()(const crypto::Hash256& txid) const noexcept { return hasher(OutPoint(txid, 0)); }
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<crypto::Hash256, Entry, TxidHasher> entries;
+    std::unordered_map<OutPoint, Entry*, SaltedOutPointHasher> spent_by;   // outpoint -> pool spender
+    std::set<Entry*, ByAncestorFeerate> by_ancestor_feerate;
+    std::set<Entry*, ByDescendantFeerate> by_descendant_feerate;
+
+    size_t max_memory;
+    SignatureCache* sig_cache;
+    uint64_t min_fee_rate;
+    uint64_t next_sequence = 0;
+    MempoolStats counters;              // totals kept up to date on every change
+
+    // Graph walks mark what they reach with a new epoch instead of filling a visited set
+    mutable uint64_t visit_epoch = 0;
+
+    // All in-pool ancestors of a transaction with these parents (not itself)
+    std::vector<Entry*> collect_ancestors(const std::vector<Entry*>& parents) const;
+    std::vector<Entry*> collect_descendants(Entry* entry) const;
+
+    Entry* add_entry(TransactionRef tx, uint64_t fee, uint32_t weight, uint64_t sigop_cost,
+                     std::vector<Entry*> parents, const std::vector<Entry*>& ancestors);
+    void remove_entry(Entry* entry);
+    void remove_with_descendants(Entry* entry);
+    void trim(size_t max_bytes);
+};
+
+} // namespace bitcoin
@@ -0,0 +1,51 @@
+// src/mining/block_template.cpp
+#include "block_template.h"
+#include <stdexcept>
+
+namespace bitcoin {
+
+BlockTemplate::BlockTemplate(const BlockHeader& header) {
+    block.header = header;
+    update_header();
+}
+
+void BlockTemplate::set_coinbase(TransactionRef coinbase) {
+    if (!block.transactions.empty() && block.transactions[0]->is_coinbase()) {
+        tree.replace(0, coinbase->get_txid());
+        block.transactions[0] = std::move(coinbase);
+    } else {
+        // Inserting at the front shifts every leaf, so rebuild once
+        block.transactions.insert(block.transactions.begin(), std::move(coinbase));
+        std::vector<crypto::Hash256> txids;
+        txids.reserve(block.transactions.size());
+        for (const auto& tx : block.transactions) txids.push_back(tx->get_txid());
+        tree = MerkleTree(std::move(txids));
+    }
+    update_header();
+}
+
+void BlockTemplate::add_transaction(TransactionRef tx) {
+    tree.append(tx->get_txid());
+    block.transactions.push_back(std::move(tx));
+    update_header();
+}
+
+void BlockTemplate::replace_transaction(size_t index, TransactionRef tx) {
+    if (index >= block.transactions.size()) {
+        throw std::out_of_range("Transaction index out of range");
+    }
+    tree.replace(index, tx->get_txid());
+    block.transactions[index] = std::move(tx);
+    update_header();
+}
+
+void BlockTemplate::remove_transaction(size_t index) {
+    if (index >= block.transactions.size()) {
+        throw std::out_of_range("Transaction index out of range");
+    }
+    block.transactions.erase(block.transactions.begin() + index);
+    tree.remove(index);
+    update_header();
+}
+
+} // namespace bitcoin
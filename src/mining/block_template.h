@@ -0,0 +1,43 @@
+// src/mining/block_template.h
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "../blockchain/block.h"
+#include "../blockchain/merkle.h"
+
+namespace bitcoin {
+
+/**
+ * Candidate block that a miner keeps refreshing
+ *
+ * Holds the block together with a MerkleTree over its txids, so adding a
+ * transaction or swapping the coinbase (new extranonce) only rehashes one
+ * path of the tree. header.merkle_root is always kept up to date.
+ */
+class BlockTemplate {
+private:
+    Block block;
+    MerkleTree tree;
+
+    void update_header() { block.header.merkle_root = tree.root(); }
+
+public:
+    explicit BlockTemplate(const BlockHeader& header = BlockHeader());
+
+    const Block& get_block() const { return block; }
+    const BlockHeader& get_header() const { return block.header; }
+    BlockHeader& get_header() { return block.header; }
+    size_t size() const { return block.transactions.size(); }
+
+    // Put the coinbase at index 0 (replacing the old one if there is one)
+    void set_coinbase(TransactionRef coinbase);
+
+    void add_transaction(TransactionRef tx);
+    void replace_transaction(size_t index, TransactionRef tx);
+    void remove_transaction(size_t index);
+
+    // Coinbase merkle branch - pool servers send this to miners (stratum)
+    std::vector<crypto::Hash256> get_coinbase_branch() const { return tree.branch(0); }
+};
+
+} // namespace bitcoin
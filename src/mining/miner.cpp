@@ -0,0 +1,133 @@
+// src/mining/miner.cpp
+#include "miner.h"
+#include "mining_engine.h"
+
+namespace bitcoin {
+
+// Nonces hashed between checks of the stop flag
+static constexpr uint64_t STOP_CHECK_INTERVAL = 1 << 16;
+
+Miner::Miner(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = 1;
+    }
+
+    for (size_t i = 0; i < num_threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (auto& worker : workers) {
+        Worker* w = worker.get();
+        w->thread = std::thread([this, w] { worker_loop(*w); });
+    }
+}
+
+Miner::~Miner() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+        stop_flag = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+std::optional<BlockHeader> Miner::mine(const BlockHeader& header, uint64_t max_hashes, RollFunction roll,
+                                       std::optional<uint64_t> generation) {
+    std::lock_guard<std::mutex> job_lock(job_mutex);
+    std::unique_lock<std::mutex> lock(mutex);
+
+    job_generation = generation ? *generation : cancel_generation.load();
+    job_header = header;
+    job_target = header.get_target();
+    job_roll = roll ? std::move(roll) : [](BlockHeader& h, uint64_t n) { h.timestamp += (uint32_t)n; };
+    job_units = max_hashes / NONCES_PER_UNIT + (max_hashes % NONCES_PER_UNIT ? 1 : 0);
+    solution.reset();
+    for (auto& worker : workers) worker->hashes = 0;
+    next_unit = 0;
+    stop_flag = false;
+    busy_workers = workers.size();
+    job_start = std::chrono::steady_clock::now();
+    job_id++;
+
+    work_cv.notify_all();
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    job_end = std::chrono::steady_clock::now();
+    return solution;
+}
+
+MinerStats Miner::stats() const {
+    MinerStats result;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto& worker : workers) {
+        uint64_t hashes = worker->hashes.load(std::memory_order_relaxed);
+        result.thread_hashes.push_back(hashes);
+        result.total_hashes += hashes;
+    }
+    auto end = busy_workers > 0 ? std::chrono::steady_clock::now() : job_end;
+    result.seconds = std::chrono::duration<double>(end - job_start).count();
+    return result;
+}
+
+void Miner::worker_loop(Worker& worker) {
+    uint64_t seen_job = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [&] { return shutting_down || job_id != seen_job; });
+            if (shutting_down) return;
+            seen_job = job_id;
+        }
+
+        run_job(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0) done_cv.notify_all();
+    }
+}
+
+void Miner::run_job(Worker& worker) {
+    // Job fields are only written while no worker is busy, so reading them here is safe
+    uint64_t current_roll = UINT64_MAX;
+    BlockHeader header;
+
+    while (!stopped()) {
+        uint64_t unit = next_unit.fetch_add(1, std::memory_order_relaxed);
+        if (unit >= job_units) return;
+
+        // Each roll gives a fresh header with its own 2^32 nonces
+        uint64_t roll = unit / UNITS_PER_ROLL;
+        if (roll != current_roll) {
+            header = job_header;
+            if (roll > 0) job_roll(header, roll);
+            current_roll = roll;
+        }
+        HeaderHasher hasher(header);
+
+        uint32_t first_nonce = (uint32_t)((unit % UNITS_PER_ROLL) * NONCES_PER_UNIT);
+        for (uint64_t done = 0; done < NONCES_PER_UNIT; done += STOP_CHECK_INTERVAL) {
+            if (stopped()) return;
+
+            uint32_t found_nonce = 0;
+            uint64_t hashes = 0;
+            bool found = hasher.scan(first_nonce + (uint32_t)done, STOP_CHECK_INTERVAL, job_target,
+                                     found_nonce, hashes);
+            worker.hashes.fetch_add(hashes, std::memory_order_relaxed);
+
+            if (found) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!solution) {
+                    solution = header;
+                    solution->nonce = found_nonce;
+                }
+                stop_flag = true;
+                return;
+            }
+        }
+    }
+}
+
+} // namespace bitcoin
@@ -0,0 +1,118 @@
+// src/mining/miner.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "../blockchain/block.h"
+
+namespace bitcoin {
+
+// Hash counters for the current (or last) mining job
+struct MinerStats {
+    std::vector<uint64_t> thread_hashes;    // nonces tried by each worker
+    uint64_t total_hashes = 0;
+    double seconds = 0;
+
+    double hashrate() const { return seconds > 0 ? total_hashes / seconds : 0; }
+    double thread_hashrate(size_t i) const { return seconds > 0 ? thread_hashes[i] / seconds : 0; }
+};
+
+/**
+ * Multithreaded nonce search
+ *
+ * The search space is cut into work units of NONCES_PER_UNIT nonces. Workers
+ * grab units from a shared atomic counter, so fast and slow threads stay
+ * balanced. Once all 2^32 nonces of a header are used up the header is
+ * "rolled" (timestamp by default, or extranonce via a callback) and the
+ * nonce space starts over. The first worker to find a solution raises an
+ * atomic stop flag.
+ *
+ * cancel() bumps a generation counter instead of touching that flag. A job
+ * runs under the generation it was started with and stops as soon as the
+ * counter moves on, so a cancel can't be undone by a job that starts
+ * just after it: pass mine() the generation() read when the template was
+ * built, and a new tip that arrives in between stops the job before it
+ * hashes anything.
+ *
+ * One job at a time: concurrent mine() calls run one after the other.
+ */
+class Miner {
+public:
+    // Produce header variant number `roll` (>= 1) when the nonce space runs out.
+    // Called from worker threads concurrently, so it must be thread-safe.
+    using RollFunction = std::function<void(BlockHeader& header, uint64_t roll)>;
+
+    static constexpr uint64_t NONCES_PER_UNIT = 1ull << 24;
+    static constexpr uint64_t UNITS_PER_ROLL = (1ull << 32) / NONCES_PER_UNIT;
+
+    // num_threads == 0 means one worker per hardware thread
+    explicit Miner(size_t num_threads = 0);
+    ~Miner();
+
+    Miner(const Miner&) = delete;
+    Miner& operator=(const Miner&) = delete;
+
+    // Search for a header meeting its own target, starting at nonce 0 and trying
+    // about `max_hashes` nonces (rounded up to whole work units). Blocks until
+    // solved, exhausted or cancelled. `generation` (default: the current one,
+    // once this call's turn comes) is the cancel generation the job belongs to.
+    std::optional<BlockHeader> mine(const BlockHeader& header, uint64_t max_hashes = UINT64_MAX,
+                                    RollFunction roll = nullptr, std::optional<uint64_t> generation = std::nullopt);
+
+    // Stop the running search, and any job of an older generation, from any
+    // thread (e.g. a new tip arrived)
+    void cancel() { cancel_generation.fetch_add(1); }
+
+    uint64_t generation() const { return cancel_generation.load(); }
+
+    size_t thread_count() const { return workers.size(); }
+
+    MinerStats stats() const;
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::atomic<uint64_t> hashes{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex job_mutex;                   // held by mine() for a whole job
+    mutable std::mutex mutex;
+    std::condition_variable work_cv;        // workers wait for a new job
+    std::condition_variable done_cv;        // mine() waits for workers to finish
+    uint64_t job_id = 0;
+    bool shutting_down = false;
+    size_t busy_workers = 0;
+
+    // Current job (written under `mutex` before workers are woken)
+    BlockHeader job_header;
+    crypto::ArithUint256 job_target;
+    RollFunction job_roll;
+    uint64_t job_units = 0;
+    uint64_t job_generation = 0;
+    std::optional<BlockHeader> solution;
+    std::chrono::steady_clock::time_point job_start;
+    std::chrono::steady_clock::time_point job_end;
+
+    std::atomic<uint64_t> next_unit{0};
+    std::atomic<bool> stop_flag{false};     // solved, or shutting down
+    std::atomic<uint64_t> cancel_generation{0};
+
+    bool stopped() const {
+        return stop_flag.load(std::memory_order_relaxed) ||
+               cancel_generation.load(std::memory_order_relaxed) != job_generation;
+    }
+
+    void worker_loop(Worker& worker);
+    void run_job(Worker& worker);
+};
+
+} // namespace bitcoin
@@ -0,0 +1,66 @@
+// src/mining/mining_engine.cpp
+#include "mining_engine.h"
+#include "../crypto/sha256.h"
+#include <chrono>
+#include <cstring>
+
+namespace bitcoin {
+
+HeaderHasher::HeaderHasher(const BlockHeader& header) {
+    std::array<unsigned char, BlockHeader::SERIALIZED_SIZE> bytes = header.to_bytes();
+
+    // Hash the constant first block once
+    std::memcpy(midstate, crypto::sha256::INITIAL_STATE, sizeof(midstate));
+    crypto::sha256::transform(midstate, bytes.data(), 1);
+
+    // Second block: the last 16 header bytes, then padding for an 80-byte message
+    std::memset(tail, 0, sizeof(tail));
+    std::memcpy(tail, bytes.data() + 64, 16);
+    tail[16] = 0x80;
+    tail[62] = 0x02; // 640 bits, big endian
+    tail[63] = 0x80;
+}
+
+crypto::Hash256 HeaderHasher::hash(uint32_t nonce) const {
+    unsigned char digests[32 * crypto::sha256::MAX_HEADER_LANES];
+    crypto::sha256::hash_headers(digests, midstate, tail, nonce);
+    return crypto::Hash256(digests);
+}
+
+bool HeaderHasher::scan(uint32_t first_nonce, uint64_t count, const crypto::ArithUint256& target,
+                        uint32_t& found_nonce, uint64_t& hashes_done) const {
+    // SIMD backends hash several consecutive nonces per call
+    const uint64_t lanes = crypto::sha256::header_lanes();
+    unsigned char digests[32 * crypto::sha256::MAX_HEADER_LANES];
+
+    for (uint64_t done = 0; done < count; done += lanes) {
+        crypto::sha256::hash_headers(digests, midstate, tail, first_nonce + (uint32_t)done);
+        uint64_t batch = count - done < lanes ? count - done : lanes;
+        for (uint64_t i = 0; i < batch; i++) {
+            if (target.is_met_by(digests + 32 * i)) {
+                hashes_done += done + i + 1;
+                found_nonce = first_nonce + (uint32_t)(done + i);
+                return true;
+            }
+        }
+    }
+    hashes_done += count;
+    return false;
+}
+
+MiningResult mine_header(BlockHeader& header, uint64_t max_attempts) {
+    MiningResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    HeaderHasher hasher(header);
+    uint32_t found_nonce = 0;
+    result.found = hasher.scan(header.nonce, max_attempts, header.get_target(), found_nonce, result.hashes);
+    if (result.found) {
+        header.nonce = found_nonce;
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace bitcoin
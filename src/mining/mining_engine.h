@@ -0,0 +1,47 @@
+// src/mining/mining_engine.h
+#pragma once
+#include <cstdint>
+#include "../blockchain/block.h"
+
+namespace bitcoin {
+
+/**
+ * Proof-of-work hashing for one header template
+ *
+ * SHA-256 eats 64 bytes at a time. The first 64 bytes of the header (version,
+ * previous hash, most of the merkle root) never change while we search
+ * nonces, so their hash state (the "midstate") is computed once. Each nonce
+ * then costs one compression for the 16-byte tail plus one for the second
+ * SHA256 - instead of serializing and hashing the whole header again. With
+ * SIMD backends several nonces are hashed side by side (sha256::hash_headers).
+ */
+class HeaderHasher {
+private:
+    uint32_t midstate[8];       // SHA-256 state after header bytes 0..63
+    unsigned char tail[64];     // header bytes 64..79 + padding (nonce at offset 12)
+
+public:
+    explicit HeaderHasher(const BlockHeader& header);
+
+    // Block hash for this template with the given nonce
+    crypto::Hash256 hash(uint32_t nonce) const;
+
+    // Try `count` nonces starting at `first_nonce`. Returns true and sets
+    // `found_nonce` on the first hash <= target. `hashes_done` counts attempts.
+    bool scan(uint32_t first_nonce, uint64_t count, const crypto::ArithUint256& target,
+              uint32_t& found_nonce, uint64_t& hashes_done) const;
+};
+
+struct MiningResult {
+    bool found = false;
+    uint64_t hashes = 0;        // nonces tried
+    double seconds = 0;         // wall-clock time spent
+
+    double hashrate() const { return seconds > 0 ? hashes / seconds : 0; }
+};
+
+// Single-threaded nonce search from header.nonce, trying at most `max_attempts`
+// nonces. On success header.nonce holds the winning nonce.
+MiningResult mine_header(BlockHeader& header, uint64_t max_attempts);
+
+} // namespace bitcoin
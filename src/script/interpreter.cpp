@@ -0,0 +1,965 @@
+// src/script/interpreter.cpp
+#include "interpreter.h"
+#include "../crypto/hash.h"
+#include "../crypto/secp256k1.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace bitcoin {
+
+namespace {
+
+/**
+ * One stack element
+ *
+ * Pushed data is a view into the script or witness it came from (both
+ * outlive the evaluation); what opcodes compute - numbers, booleans,
+ * hashes - is at most 32 bytes and kept in the item itself. Either way
+ * pushing never allocates.
+ */
+struct StackItem {
+    const unsigned char* ptr;
+    uint32_t size;
+    bool local;
+    unsigned char bytes[32];
+
+    std::span<const unsigned char> span() const { return {local ? bytes : ptr, size}; }
+};
+
+StackItem view_item(std::span<const unsigned char> data) {
+    StackItem item;
+    item.ptr = data.data();
+    item.size = (uint32_t)data.size();
+    item.local = false;
+    return item;
+}
+
+StackItem local_item(const unsigned char* data, size_t size) {
+    StackItem item;
+    item.ptr = nullptr;
+    item.size = (uint32_t)size;
+    item.local = true;
+    std::memcpy(item.bytes, data, size);
+    return item;
+}
+
+/**
+ * Stack with room for MAX_STACK_SIZE items plus what one opcode can push
+ * before the size check after it (3, for OP_3DUP)
+ *
+ * Items aren't initialized, so an empty stack costs nothing to set up.
+ * Positions count from the top: top(1) is the top item.
+ */
+class ItemStack {
+private:
+    static constexpr size_t CAPACITY = MAX_STACK_SIZE + 4;
+    StackItem items[CAPACITY];
+    size_t count = 0;
+
+public:
+    ItemStack() {}
+    ItemStack(const ItemStack&) = delete;
+    ItemStack& operator=(const ItemStack&) = delete;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    StackItem& top(size_t i = 1) { return items[count - i]; }
+
+    void push(const StackItem& item) {
+        if (count == CAPACITY) throw std::logic_error("Script stack overflow");
+        items[count++] = item;
+    }
+    void pop(size_t n = 1) { count -= n; }
+    void clear() { count = 0; }
+
+    // Remove the item `i` from the top
+    void erase(size_t i) {
+        std::memmove(&items[count - i], &items[count - i + 1], (i - 1) * sizeof(StackItem));
+        count--;
+    }
+    void swap(size_t i, size_t j) { std::swap(items[count - i], items[count - j]); }
+
+    // Copy just the items in use
+    void assign(const ItemStack& other) {
+        count = other.count;
+        std::copy_n(other.items, count, items);
+    }
+};
+
+/**
+ * IF/ELSE/ENDIF nesting as a depth and the position of the first false
+ * branch - all that matters is whether every branch is taken
+ */
+class ConditionStack {
+private:
+    static constexpr uint32_t NO_FALSE = UINT32_MAX;
+    uint32_t depth = 0;
+    uint32_t first_false = NO_FALSE;
+
+public:
+    bool empty() const { return depth == 0; }
+    bool all_true() const { return first_false == NO_FALSE; }
+
+    void push(bool value) {
+        if (first_false == NO_FALSE && !value) first_false = depth;
+        depth++;
+    }
+    void pop() {
+        depth--;
+        if (first_false == depth) first_false = NO_FALSE;
+    }
+    void toggle_top() {
+        if (first_false == NO_FALSE) {
+            first_false = depth - 1;
+        } else if (first_false == depth - 1) {
+            first_false = NO_FALSE;
+        }
+    }
+};
+
+// What the main loop needs to know about an opcode before dispatching it
+enum OpcodeClass : uint8_t {
+    OPCLASS_PUSH,           // OP_0 .. OP_PUSHDATA4
+    OPCLASS_SMALL_NUMBER,   // OP_1NEGATE, OP_RESERVED, OP_1 .. OP_16: not counted as operations
+    OPCLASS_OPERATION,      // counts toward MAX_OPS_PER_SCRIPT
+    OPCLASS_CONDITIONAL,    // OP_IF .. OP_ENDIF: handled in unexecuted branches too
+    OPCLASS_DISABLED,       // fails the script even in an unexecuted branch
+};
+
+constexpr std::array<uint8_t, 256> OPCODE_CLASSES = [] {
+    std::array<uint8_t, 256> classes{};
+    for (int op = 0; op < 256; op++) {
+        if (op <= OP_PUSHDATA4) {
+            classes[op] = OPCLASS_PUSH;
+        } else if (op <= OP_16) {
+            classes[op] = OPCLASS_SMALL_NUMBER;
+        } else if (op >= OP_IF && op <= OP_ENDIF) {
+            classes[op] = OPCLASS_CONDITIONAL;
+        } else {
+            classes[op] = OPCLASS_OPERATION;
+        }
+    }
+    for (Opcode op : {OP_CAT, OP_SUBSTR, OP_LEFT, OP_RIGHT, OP_INVERT, OP_AND, OP_OR, OP_XOR, OP_2MUL,
+                      OP_2DIV, OP_MUL, OP_DIV, OP_MOD, OP_LSHIFT, OP_RSHIFT}) {
+        classes[op] = OPCLASS_DISABLED;
+    }
+    return classes;
+}();
+
+bool fail(ScriptError& error, ScriptError reason) {
+    error = reason;
+    return false;
+}
+
+// Script numbers: little endian, sign bit in the top byte. Operands are at
+// most 4 bytes (5 for lock times); results may be a byte longer.
+bool read_number(const StackItem& item, int64_t& n, size_t max_size = 4) {
+    std::span<const unsigned char> bytes = item.span();
+    if (bytes.size() > max_size) return false;
+    n = 0;
+    if (bytes.empty()) return true;
+    for (size_t i = 0; i < bytes.size(); i++) n |= (int64_t)bytes[i] << (8 * i);
+    if (bytes.back() & 0x80) n = -(n & ~((int64_t)0x80 << (8 * (bytes.size() - 1))));
+    return true;
+}
+
+StackItem number_item(int64_t n) {
+    unsigned char bytes[9];
+    size_t size = 0;
+    bool negative = n < 0;
+    uint64_t value = negative ? 0 - (uint64_t)n : (uint64_t)n;
+    while (value) {
+        bytes[size++] = (unsigned char)value;
+        value >>= 8;
+    }
+    // The top bit is the sign: add a byte if it's taken
+    if (size > 0 && (bytes[size - 1] & 0x80)) {
+        bytes[size++] = negative ? 0x80 : 0x00;
+    } else if (negative) {
+        bytes[size - 1] |= 0x80;
+    }
+    return local_item(bytes, size);
+}
+
+StackItem bool_item(bool value) {
+    static const unsigned char TRUE_BYTE = 1;
+    return local_item(&TRUE_BYTE, value ? 1 : 0);
+}
+
+// Any nonzero byte is true - except a lone sign bit at the end (negative zero)
+bool cast_to_bool(const StackItem& item) {
+    std::span<const unsigned char> bytes = item.span();
+    for (size_t i = 0; i < bytes.size(); i++) {
+        if (bytes[i] != 0) return !(i == bytes.size() - 1 && bytes[i] == 0x80);
+    }
+    return false;
+}
+
+// BIP66 strict DER plus the hash type byte
+bool is_valid_signature_encoding(std::span<const unsigned char> sig) {
+    // 0x30 [total-length] 0x02 [R-length] [R] 0x02 [S-length] [S] [sighash]
+    if (sig.size() < 9 || sig.size() > 73) return false;
+    if (sig[0] != 0x30 || sig[1] != sig.size() - 3) return false;
+    size_t len_r = sig[3];
+    if (5 + len_r >= sig.size()) return false;
+    size_t len_s = sig[5 + len_r];
+    if (len_r + len_s + 7 != sig.size()) return false;
+
+    // Positive integers without excess zero padding
+    if (sig[2] != 0x02 || len_r == 0 || (sig[4] & 0x80)) return false;
+    if (len_r > 1 && sig[4] == 0x00 && !(sig[5] & 0x80)) return false;
+    if (sig[len_r + 4] != 0x02 || len_s == 0 || (sig[len_r + 6] & 0x80)) return false;
+    if (len_s > 1 && sig[len_r + 6] == 0x00 && !(sig[len_r + 7] & 0x80)) return false;
+    return true;
+}
+
+bool check_signature_encoding(std::span<const unsigned char> sig, ScriptError& error) {
+    // Empty is allowed: the compact way to provide a failing signature
+    if (!sig.empty() && !is_valid_signature_encoding(sig)) return fail(error, ScriptError::SIG_DER);
+    return true;
+}
+
+bool is_push_only(std::span<const unsigned char> script) {
+    Opcode op;
+    while (!script.empty()) {
+        if (!get_script_op(script, op) || op > OP_16) return false;
+    }
+    return true;
+}
+
+// `data` as a script push, the way the original client wrote it
+size_t write_push(std::span<const unsigned char> data, unsigned char* out) {
+    size_t prefix;
+    if (data.size() < OP_PUSHDATA1) {
+        out[0] = (unsigned char)data.size();
+        prefix = 1;
+    } else if (data.size() <= 0xff) {
+        out[0] = OP_PUSHDATA1;
+        out[1] = (unsigned char)data.size();
+        prefix = 2;
+    } else {
+        out[0] = OP_PUSHDATA2;
+        out[1] = (unsigned char)data.size();
+        out[2] = (unsigned char)(data.size() >> 8);
+        prefix = 3;
+    }
+    std::memcpy(out + prefix, data.data(), data.size());
+    return prefix + data.size();
+}
+
+/**
+ * Legacy scripts sign their script code minus the signature itself: every
+ * push of `signature` starting at an opcode boundary is cut out (the
+ * original FindAndDelete). Returns `script_code` untouched in the usual
+ * case of no match, otherwise the result, stored in `storage`.
+ */
+std::span<const unsigned char> remove_signature(std::span<const unsigned char> script_code,
+                                                std::span<const unsigned char> signature,
+                                                std::vector<unsigned char>& storage) {
+    unsigned char buffer[3 + MAX_SCRIPT_ELEMENT_SIZE];
+    std::span<const unsigned char> pattern(buffer, write_push(signature, buffer));
+
+    auto scan = [&](std::vector<unsigned char>* out) {
+        bool found = false;
+        std::span<const unsigned char> pc = script_code;
+        const unsigned char* kept = pc.data();     // start of what hasn't been copied yet
+        Opcode op;
+        do {
+            if (out) out->insert(out->end(), kept, pc.data());
+            while (pc.size() >= pattern.size() && std::equal(pattern.begin(), pattern.end(), pc.begin())) {
+                pc = pc.subspan(pattern.size());
+                found = true;
+            }
+            kept = pc.data();
+        } while (get_script_op(pc, op));
+        if (out) out->insert(out->end(), kept, script_code.data() + script_code.size());
+        return found;
+    };
+
+    if (!scan(nullptr)) return script_code;
+    std::vector<unsigned char> result;
+    scan(&result);
+    storage = std::move(result);
+    return storage;
+}
+
+bool eval_script(ItemStack& stack, std::span<const unsigned char> script, uint32_t flags,
+                 const SignatureChecker& checker, SigVersion sigversion, ScriptError& error) {
+    if (script.size() > Script::MAX_SCRIPT_SIZE) return fail(error, ScriptError::SCRIPT_SIZE);
+
+    ItemStack altstack;
+    ConditionStack conditions;
+    std::span<const unsigned char> pc = script;
+    const unsigned char* code_start = script.data();    // signed script code starts after the last OP_CODESEPARATOR
+    const unsigned char* script_end = script.data() + script.size();
+    int op_count = 0;
+
+    while (!pc.empty()) {
+        bool executing = conditions.all_true();
+        Opcode op;
+        std::span<const unsigned char> push;
+        if (!get_script_op(pc, op, &push)) return fail(error, ScriptError::BAD_OPCODE);
+        if (push.size() > MAX_SCRIPT_ELEMENT_SIZE) return fail(error, ScriptError::PUSH_SIZE);
+
+        uint8_t op_class = OPCODE_CLASSES[op];
+        if (op_class >= OPCLASS_OPERATION && ++op_count > MAX_OPS_PER_SCRIPT) {
+            return fail(error, ScriptError::OP_COUNT);
+        }
+        if (op_class == OPCLASS_DISABLED) return fail(error, ScriptError::DISABLED_OPCODE);
+        if (!executing && op_class != OPCLASS_CONDITIONAL) continue;
+
+        if (op_class == OPCLASS_PUSH) {
+            stack.push(view_item(push));
+        } else switch (op) {
+            // Numbers
+            case OP_1NEGATE:
+            case OP_1: case OP_2: case OP_3: case OP_4: case OP_5: case OP_6: case OP_7: case OP_8:
+            case OP_9: case OP_10: case OP_11: case OP_12: case OP_13: case OP_14: case OP_15: case OP_16:
+                stack.push(number_item((int)op - (int)(OP_1 - 1)));
+                break;
+
+            // Flow control
+            case OP_NOP:
+            case OP_NOP1: case OP_NOP4: case OP_NOP5: case OP_NOP6: case OP_NOP7: case OP_NOP8:
+            case OP_NOP9: case OP_NOP10:
+                break;
+
+            case OP_CHECKLOCKTIMEVERIFY: {
+                if (!(flags & SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY)) break;
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                // 5 bytes: lock times go up to 2^32 - 1
+                int64_t locktime;
+                if (!read_number(stack.top(), locktime, 5)) return fail(error, ScriptError::SCRIPTNUM);
+                if (locktime < 0) return fail(error, ScriptError::NEGATIVE_LOCKTIME);
+                if (!checker.check_locktime(locktime)) return fail(error, ScriptError::UNSATISFIED_LOCKTIME);
+                break;
+            }
+
+            case OP_CHECKSEQUENCEVERIFY: {
+                if (!(flags & SCRIPT_VERIFY_CHECKSEQUENCEVERIFY)) break;
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                int64_t sequence;
+                if (!read_number(stack.top(), sequence, 5)) return fail(error, ScriptError::SCRIPTNUM);
+                if (sequence < 0) return fail(error, ScriptError::NEGATIVE_LOCKTIME);
+                // The disable flag makes it a NOP again (room for future soft forks)
+                if (sequence & SEQUENCE_LOCKTIME_DISABLE_FLAG) break;
+                if (!checker.check_sequence(sequence)) return fail(error, ScriptError::UNSATISFIED_LOCKTIME);
+                break;
+            }
+
+            case OP_IF:
+            case OP_NOTIF: {
+                bool value = false;
+                if (executing) {
+                    if (stack.empty()) return fail(error, ScriptError::UNBALANCED_CONDITIONAL);
+                    value = cast_to_bool(stack.top()) == (op == OP_IF);
+                    stack.pop();
+                }
+                conditions.push(value);
+                break;
+            }
+
+            case OP_ELSE:
+                if (conditions.empty()) return fail(error, ScriptError::UNBALANCED_CONDITIONAL);
+                conditions.toggle_top();
+                break;
+
+            case OP_ENDIF:
+                if (conditions.empty()) return fail(error, ScriptError::UNBALANCED_CONDITIONAL);
+                conditions.pop();
+                break;
+
+            case OP_VERIFY:
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                if (!cast_to_bool(stack.top())) return fail(error, ScriptError::VERIFY);
+                stack.pop();
+                break;
+
+            case OP_RETURN:
+                return fail(error, ScriptError::OP_RETURN);
+
+            // Stack
+            case OP_TOALTSTACK:
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                altstack.push(stack.top());
+                stack.pop();
+                break;
+
+            case OP_FROMALTSTACK:
+                if (altstack.empty()) return fail(error, ScriptError::INVALID_ALTSTACK_OPERATION);
+                stack.push(altstack.top());
+                altstack.pop();
+                break;
+
+            case OP_2DROP:
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.pop(2);
+                break;
+
+            case OP_2DUP: {
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                StackItem a = stack.top(2), b = stack.top(1);
+                stack.push(a);
+                stack.push(b);
+                break;
+            }
+
+            case OP_3DUP: {
+                if (stack.size() < 3) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                StackItem a = stack.top(3), b = stack.top(2), c = stack.top(1);
+                stack.push(a);
+                stack.push(b);
+                stack.push(c);
+                break;
+            }
+
+            case OP_2OVER: {
+                if (stack.size() < 4) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                StackItem a = stack.top(4), b = stack.top(3);
+                stack.push(a);
+                stack.push(b);
+                break;
+            }
+
+            case OP_2ROT: {
+                if (stack.size() < 6) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                StackItem a = stack.top(6), b = stack.top(5);
+                stack.erase(6);
+                stack.erase(5);
+                stack.push(a);
+                stack.push(b);
+                break;
+            }
+
+            case OP_2SWAP:
+                if (stack.size() < 4) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.swap(4, 2);
+                stack.swap(3, 1);
+                break;
+
+            case OP_IFDUP:
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                if (cast_to_bool(stack.top())) stack.push(stack.top());
+                break;
+
+            case OP_DEPTH:
+                stack.push(number_item((int64_t)stack.size()));
+                break;
+
+            case OP_DROP:
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.pop();
+                break;
+
+            case OP_DUP:
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.push(stack.top());
+                break;
+
+            case OP_NIP:
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.erase(2);
+                break;
+
+            case OP_OVER:
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.push(stack.top(2));
+                break;
+
+            case OP_PICK:
+            case OP_ROLL: {
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                int64_t n;
+                if (!read_number(stack.top(), n)) return fail(error, ScriptError::SCRIPTNUM);
+                stack.pop();
+                if (n < 0 || (uint64_t)n >= stack.size()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                StackItem item = stack.top(n + 1);
+                if (op == OP_ROLL) stack.erase(n + 1);
+                stack.push(item);
+                break;
+            }
+
+            case OP_ROT:
+                if (stack.size() < 3) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.swap(3, 2);
+                stack.swap(2, 1);
+                break;
+
+            case OP_SWAP:
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.swap(2, 1);
+                break;
+
+            case OP_TUCK: {
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                StackItem a = stack.top(2), b = stack.top(1);
+                stack.pop(2);
+                stack.push(b);
+                stack.push(a);
+                stack.push(b);
+                break;
+            }
+
+            case OP_SIZE:
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                stack.push(number_item(stack.top().size));
+                break;
+
+            // Bit logic
+            case OP_EQUAL:
+            case OP_EQUALVERIFY: {
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                std::span<const unsigned char> a = stack.top(2).span(), b = stack.top(1).span();
+                bool equal = std::equal(a.begin(), a.end(), b.begin(), b.end());
+                stack.pop(2);
+                if (op == OP_EQUALVERIFY) {
+                    if (!equal) return fail(error, ScriptError::EQUALVERIFY);
+                } else {
+                    stack.push(bool_item(equal));
+                }
+                break;
+            }
+
+            // Arithmetic
+            case OP_1ADD: case OP_1SUB: case OP_NEGATE: case OP_ABS: case OP_NOT: case OP_0NOTEQUAL: {
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                int64_t n;
+                if (!read_number(stack.top(), n)) return fail(error, ScriptError::SCRIPTNUM);
+                switch (op) {
+                    case OP_1ADD: n += 1; break;
+                    case OP_1SUB: n -= 1; break;
+                    case OP_NEGATE: n = -n; break;
+                    case OP_ABS: if (n < 0) n = -n; break;
+                    case OP_NOT: n = n == 0; break;
+                    default: n = n != 0; break;
+                }
+                stack.pop();
+                stack.push(number_item(n));
+                break;
+            }
+
+            case OP_ADD: case OP_SUB: case OP_BOOLAND: case OP_BOOLOR: case OP_NUMEQUAL: case OP_NUMEQUALVERIFY:
+            case OP_NUMNOTEQUAL: case OP_LESSTHAN: case OP_GREATERTHAN: case OP_LESSTHANOREQUAL:
+            case OP_GREATERTHANOREQUAL: case OP_MIN: case OP_MAX: {
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                int64_t a, b, n;
+                if (!read_number(stack.top(2), a) || !read_number(stack.top(1), b)) {
+                    return fail(error, ScriptError::SCRIPTNUM);
+                }
+                switch (op) {
+                    case OP_ADD: n = a + b; break;
+                    case OP_SUB: n = a - b; break;
+                    case OP_BOOLAND: n = a != 0 && b != 0; break;
+                    case OP_BOOLOR: n = a != 0 || b != 0; break;
+                    case OP_NUMEQUAL: case OP_NUMEQUALVERIFY: n = a == b; break;
+                    case OP_NUMNOTEQUAL: n = a != b; break;
+                    case OP_LESSTHAN: n = a < b; break;
+                    case OP_GREATERTHAN: n = a > b; break;
+                    case OP_LESSTHANOREQUAL: n = a <= b; break;
+                    case OP_GREATERTHANOREQUAL: n = a >= b; break;
+                    case OP_MIN: n = std::min(a, b); break;
+                    default: n = std::max(a, b); break;
+                }
+                stack.pop(2);
+                if (op == OP_NUMEQUALVERIFY) {
+                    if (!n) return fail(error, ScriptError::NUMEQUALVERIFY);
+                } else {
+                    stack.push(number_item(n));
+                }
+                break;
+            }
+
+            case OP_WITHIN: {
+                if (stack.size() < 3) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                int64_t x, low, high;
+                if (!read_number(stack.top(3), x) || !read_number(stack.top(2), low) ||
+                    !read_number(stack.top(1), high)) {
+                    return fail(error, ScriptError::SCRIPTNUM);
+                }
+                stack.pop(3);
+                stack.push(bool_item(low <= x && x < high));
+                break;
+            }
+
+            // Crypto
+            case OP_RIPEMD160: case OP_SHA1: case OP_SHA256: case OP_HASH160: case OP_HASH256: {
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                std::span<const unsigned char> data = stack.top().span();
+                StackItem result;
+                if (op == OP_SHA256 || op == OP_HASH256) {
+                    crypto::Hash256 hash = op == OP_SHA256 ? crypto::Hash::sha256(data.data(), data.size())
+                                                           : crypto::Hash::double_sha256(data.data(), data.size());
+                    result = local_item(hash.data(), hash.size());
+                } else {
+                    crypto::Hash160 hash = op == OP_RIPEMD160 ? crypto::Hash::ripemd160(data.data(), data.size())
+                                         : op == OP_SHA1      ? crypto::Hash::sha1(data.data(), data.size())
+                                                              : crypto::Hash::hash160(data.data(), data.size());
+                    result = local_item(hash.data(), hash.size());
+                }
+                stack.pop();
+                stack.push(result);
+                break;
+            }
+
+            case OP_CODESEPARATOR:
+                code_start = pc.data();
+                break;
+
+            case OP_CHECKSIG:
+            case OP_CHECKSIGVERIFY: {
+                if (stack.size() < 2) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                std::span<const unsigned char> sig = stack.top(2).span(), pubkey = stack.top(1).span();
+                std::span<const unsigned char> script_code(code_start, script_end);
+                std::vector<unsigned char> storage;
+                if (sigversion == SigVersion::BASE) script_code = remove_signature(script_code, sig, storage);
+
+                if (!check_signature_encoding(sig, error)) return false;
+                bool success = checker.check_ecdsa(sig, pubkey, script_code, sigversion);
+                stack.pop(2);
+                if (op == OP_CHECKSIGVERIFY) {
+                    if (!success) return fail(error, ScriptError::CHECKSIGVERIFY);
+                } else {
+                    stack.push(bool_item(success));
+                }
+                break;
+            }
+
+            case OP_CHECKMULTISIG:
+            case OP_CHECKMULTISIGVERIFY: {
+                // dummy <sig1> .. <sigM> M <key1> .. <keyN> N
+                size_t i = 1;
+                if (stack.size() < i) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                int64_t key_count;
+                if (!read_number(stack.top(i), key_count)) return fail(error, ScriptError::SCRIPTNUM);
+                if (key_count < 0 || key_count > MAX_PUBKEYS_PER_MULTISIG) {
+                    return fail(error, ScriptError::PUBKEY_COUNT);
+                }
+                op_count += (int)key_count;
+                if (op_count > MAX_OPS_PER_SCRIPT) return fail(error, ScriptError::OP_COUNT);
+                size_t key_pos = ++i;
+                i += key_count;
+                if (stack.size() < i) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+
+                int64_t sig_count;
+                if (!read_number(stack.top(i), sig_count)) return fail(error, ScriptError::SCRIPTNUM);
+                if (sig_count < 0 || sig_count > key_count) return fail(error, ScriptError::SIG_COUNT);
+                size_t sig_pos = ++i;
+                i += sig_count;
+                if (stack.size() < i) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+
+                std::span<const unsigned char> script_code(code_start, script_end);
+                std::vector<unsigned char> storage;
+                if (sigversion == SigVersion::BASE) {
+                    for (int64_t k = 0; k < sig_count; k++) {
+                        script_code = remove_signature(script_code, stack.top(sig_pos + k).span(), storage);
+                    }
+                }
+
+                // Signatures must match keys in order; give up once too few keys are left
+                bool success = true;
+                while (success && sig_count > 0) {
+                    std::span<const unsigned char> sig = stack.top(sig_pos).span();
+                    std::span<const unsigned char> pubkey = stack.top(key_pos).span();
+                    if (!check_signature_encoding(sig, error)) return false;
+                    if (checker.check_ecdsa(sig, pubkey, script_code, sigversion)) {
+                        sig_pos++;
+                        sig_count--;
+                    }
+                    key_pos++;
+                    key_count--;
+                    if (sig_count > key_count) success = false;
+                }
+                stack.pop(i - 1);
+
+                // The original client pops one item too many: BIP147 makes it an empty dummy
+                if (stack.empty()) return fail(error, ScriptError::INVALID_STACK_OPERATION);
+                if ((flags & SCRIPT_VERIFY_NULLDUMMY) && stack.top().size) {
+                    return fail(error, ScriptError::SIG_NULLDUMMY);
+                }
+                stack.pop();
+
+                if (op == OP_CHECKMULTISIGVERIFY) {
+                    if (!success) return fail(error, ScriptError::CHECKMULTISIGVERIFY);
+                } else {
+                    stack.push(bool_item(success));
+                }
+                break;
+            }
+
+            // OP_VERIF / OP_VERNOTIF (even unexecuted), OP_RESERVED, OP_VER, OP_RESERVED1/2,
+            // OP_CHECKSIGADD and everything past it
+            default:
+                return fail(error, ScriptError::BAD_OPCODE);
+        }
+
+        if (stack.size() + altstack.size() > MAX_STACK_SIZE) return fail(error, ScriptError::STACK_SIZE);
+    }
+
+    if (!conditions.empty()) return fail(error, ScriptError::UNBALANCED_CONDITIONAL);
+    return true;
+}
+
+std::span<const unsigned char> as_bytes(const std::string& s) {
+    return {reinterpret_cast<const unsigned char*>(s.data()), s.size()};
+}
+
+// OP_n <2-40 bytes>: witness version `n` with that program
+bool is_witness_program(std::span<const unsigned char> script, int& version, std::span<const unsigned char>& program) {
+    if (script.size() < 4 || script.size() > 42) return false;
+    if (script[0] != OP_0 && (script[0] < OP_1 || script[0] > OP_16)) return false;
+    if ((size_t)script[1] + 2 != script.size()) return false;
+    version = script[0] == OP_0 ? 0 : script[0] - (OP_1 - 1);
+    program = script.subspan(2);
+    return true;
+}
+
+// <sig> <pubkey> against OP_DUP OP_HASH160 <key_hash> OP_EQUALVERIFY OP_CHECKSIG,
+// which is what P2PKH and P2WPKH spends come down to: one hash, one signature check
+bool verify_key_hash(std::span<const unsigned char> sig, std::span<const unsigned char> pubkey,
+                     std::span<const unsigned char> key_hash, std::span<const unsigned char> script_code,
+                     SigVersion sigversion, const SignatureChecker& checker, ScriptError& error) {
+    if (sig.size() > MAX_SCRIPT_ELEMENT_SIZE || pubkey.size() > MAX_SCRIPT_ELEMENT_SIZE) {
+        return fail(error, ScriptError::PUSH_SIZE);
+    }
+    if (crypto::Hash::hash160(pubkey.data(), pubkey.size()) != crypto::Hash160(key_hash.data())) {
+        return fail(error, ScriptError::EQUALVERIFY);
+    }
+    std::vector<unsigned char> storage;
+    if (sigversion == SigVersion::BASE) script_code = remove_signature(script_code, sig, storage);
+    if (!check_signature_encoding(sig, error)) return false;
+    if (!checker.check_ecdsa(sig, pubkey, script_code, sigversion)) return fail(error, ScriptError::EVAL_FALSE);
+    return true;
+}
+
+bool verify_witness_program(const std::vector<std::string>& witness, int version,
+                            std::span<const unsigned char> program, uint32_t flags,
+                            const SignatureChecker& checker, ScriptError& error) {
+    // Later versions (taproot, ...) aren't enforced yet
+    if (version != 0) return true;
+
+    if (program.size() == 20) {
+        // P2WPKH: <sig> <pubkey> against the P2PKH script for the program
+        if (witness.size() != 2) return fail(error, ScriptError::WITNESS_PROGRAM_MISMATCH);
+        Script script_code = make_p2pkh(crypto::Hash160(program.data()));
+        return verify_key_hash(as_bytes(witness[0]), as_bytes(witness[1]), program, script_code.span(),
+                               SigVersion::WITNESS_V0, checker, error);
+    }
+    if (program.size() != 32) return fail(error, ScriptError::WITNESS_PROGRAM_WRONG_LENGTH);
+
+    // P2WSH: the last item is the script, which must hash to the program
+    if (witness.empty()) return fail(error, ScriptError::WITNESS_PROGRAM_WITNESS_EMPTY);
+    std::span<const unsigned char> script = as_bytes(witness.back());
+    if (crypto::Hash::sha256(script.data(), script.size()) != crypto::Hash256(program.data())) {
+        return fail(error, ScriptError::WITNESS_PROGRAM_MISMATCH);
+    }
+    size_t stack_items = witness.size() - 1;
+
+    // More items than the stack may hold would fail on the first opcode anyway
+    if (stack_items > MAX_STACK_SIZE) return fail(error, ScriptError::STACK_SIZE);
+    ItemStack stack;
+    for (size_t i = 0; i < stack_items; i++) {
+        if (witness[i].size() > MAX_SCRIPT_ELEMENT_SIZE) return fail(error, ScriptError::PUSH_SIZE);
+        stack.push(view_item(as_bytes(witness[i])));
+    }
+    if (!eval_script(stack, script, flags, checker, SigVersion::WITNESS_V0, error)) return false;
+
+    // Witness scripts must leave exactly one true item
+    if (stack.size() != 1) return fail(error, ScriptError::WITNESS_CLEANSTACK);
+    if (!cast_to_bool(stack.top())) return fail(error, ScriptError::EVAL_FALSE);
+    return true;
+}
+
+// The usual P2PKH and P2WPKH spends, matched as templates. False if the spend
+// doesn't have that shape and needs the interpreter; otherwise the result is
+// in `valid`.
+bool verify_template(std::span<const unsigned char> script_sig, const Script& script_pubkey,
+                     const std::vector<std::string>& witness, uint32_t flags, const SignatureChecker& checker,
+                     bool& valid, ScriptError& error) {
+    std::span<const unsigned char> key_hash;
+    switch (classify_script(script_pubkey, &key_hash)) {
+        case ScriptType::P2PKH: {
+            // scriptSig: exactly <sig> <pubkey>
+            if (!witness.empty()) return false;
+            std::span<const unsigned char> pc = script_sig, sig, pubkey;
+            Opcode op;
+            if (!get_script_op(pc, op, &sig) || op > OP_PUSHDATA4) return false;
+            if (!get_script_op(pc, op, &pubkey) || op > OP_PUSHDATA4 || !pc.empty()) return false;
+            valid = verify_key_hash(sig, pubkey, key_hash, script_pubkey.span(), SigVersion::BASE, checker, error);
+            return true;
+        }
+        case ScriptType::P2WPKH: {
+            if (!(flags & SCRIPT_VERIFY_WITNESS) || !script_sig.empty() || witness.size() != 2) return false;
+            Script script_code = make_p2pkh(crypto::Hash160(key_hash.data()));
+            valid = verify_key_hash(as_bytes(witness[0]), as_bytes(witness[1]), key_hash, script_code.span(),
+                                    SigVersion::WITNESS_V0, checker, error);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+const char* script_error_name(ScriptError error) {
+    switch (error) {
+        case ScriptError::OK: return "ok";
+        case ScriptError::EVAL_FALSE: return "script evaluated to false";
+        case ScriptError::OP_RETURN: return "OP_RETURN";
+        case ScriptError::SCRIPT_SIZE: return "script too large";
+        case ScriptError::PUSH_SIZE: return "push too large";
+        case ScriptError::OP_COUNT: return "too many operations";
+        case ScriptError::STACK_SIZE: return "stack too large";
+        case ScriptError::SIG_COUNT: return "bad signature count";
+        case ScriptError::PUBKEY_COUNT: return "bad public key count";
+        case ScriptError::VERIFY: return "OP_VERIFY failed";
+        case ScriptError::EQUALVERIFY: return "OP_EQUALVERIFY failed";
+        case ScriptError::CHECKSIGVERIFY: return "OP_CHECKSIGVERIFY failed";
+        case ScriptError::CHECKMULTISIGVERIFY: return "OP_CHECKMULTISIGVERIFY failed";
+        case ScriptError::NUMEQUALVERIFY: return "OP_NUMEQUALVERIFY failed";
+        case ScriptError::BAD_OPCODE: return "bad opcode";
+        case ScriptError::DISABLED_OPCODE: return "disabled opcode";
+        case ScriptError::INVALID_STACK_OPERATION: return "invalid stack operation";
+        case ScriptError::INVALID_ALTSTACK_OPERATION: return "invalid altstack operation";
+        case ScriptError::UNBALANCED_CONDITIONAL: return "unbalanced conditional";
+        case ScriptError::SCRIPTNUM: return "bad script number";
+        case ScriptError::NEGATIVE_LOCKTIME: return "negative lock time";
+        case ScriptError::UNSATISFIED_LOCKTIME: return "lock time not satisfied";
+        case ScriptError::SIG_NULLDUMMY: return "multisig dummy not empty";
+        case ScriptError::SIG_DER: return "signature not strict DER";
+        case ScriptError::SIG_PUSHONLY: return "scriptSig not push only";
+        case ScriptError::WITNESS_PROGRAM_WRONG_LENGTH: return "witness program wrong length";
+        case ScriptError::WITNESS_PROGRAM_WITNESS_EMPTY: return "witness program with empty witness";
+        case ScriptError::WITNESS_PROGRAM_MISMATCH: return "witness program mismatch";
+        case ScriptError::WITNESS_MALLEATED: return "witness spend with a scriptSig";
+        case ScriptError::WITNESS_MALLEATED_P2SH: return "P2SH witness spend with extra scriptSig";
+        case ScriptError::WITNESS_UNEXPECTED: return "unexpected witness";
+        case ScriptError::WITNESS_CLEANSTACK: return "witness script left extra stack items";
+    }
+    return "unknown error";
+}
+
+bool TransactionSignatureChecker::check_ecdsa(std::span<const unsigned char> signature,
+                                              std::span<const unsigned char> pubkey,
+                                              std::span<const unsigned char> script_code,
+                                              SigVersion sigversion) const {
+    if (signature.empty()) return false;
+    uint8_t hash_type = signature.back();
+    std::span<const unsigned char> der = signature.first(signature.size() - 1);
+
+    crypto::Hash256 sighash;
+    if (sigversion == SigVersion::WITNESS_V0) {
+        if (precomputed) {
+            sighash = segwit_signature_hash(tx, input_index, script_code, amount, hash_type, *precomputed);
+        } else {
+            sighash = segwit_signature_hash(tx, input_index, script_code, amount, hash_type, PrecomputedSighash(tx));
+        }
+    } else {
+        sighash = legacy_signature_hash(tx, input_index, script_code, hash_type);
+    }
+
+    crypto::Hash256 entry;
+    if (sig_cache) {
+        entry = sig_cache->compute_entry_ecdsa(pubkey, sighash, der);
+        if (sig_cache->contains(entry)) return true;
+    }
+    crypto::secp256k1::AffinePoint point;
+    crypto::secp256k1::Scalar r, s;
+    if (!crypto::secp256k1::parse_public_key(pubkey, point) || !crypto::secp256k1::parse_der_signature(der, r, s) ||
+        !crypto::secp256k1::ecdsa_verify(point, sighash, r, s)) {
+        return false;
+    }
+    if (sig_cache) sig_cache->insert(entry);
+    return true;
+}
+
+bool TransactionSignatureChecker::check_locktime(int64_t locktime) const {
+    // Heights only compare with heights, times with times
+    bool script_is_time = locktime >= LOCKTIME_THRESHOLD;
+    bool tx_is_time = tx.locktime >= LOCKTIME_THRESHOLD;
+    if (script_is_time != tx_is_time || locktime > (int64_t)tx.locktime) return false;
+
+    // A final input would switch the transaction's lock time off
+    return tx.inputs[input_index].sequence != SEQUENCE_FINAL;
+}
+
+bool TransactionSignatureChecker::check_sequence(int64_t sequence) const {
+    // BIP68 relative lock times only exist from version 2 on, and not on inputs that opt out
+    uint32_t tx_sequence = tx.inputs[input_index].sequence;
+    if (tx.version < 2 || (tx_sequence & SEQUENCE_LOCKTIME_DISABLE_FLAG)) return false;
+
+    // Blocks only compare with blocks, time with time
+    uint32_t mask = SEQUENCE_LOCKTIME_TYPE_FLAG | SEQUENCE_LOCKTIME_MASK;
+    int64_t tx_masked = tx_sequence & mask;
+    int64_t script_masked = sequence & mask;
+    bool script_is_time = script_masked >= SEQUENCE_LOCKTIME_TYPE_FLAG;
+    bool tx_is_time = tx_masked >= SEQUENCE_LOCKTIME_TYPE_FLAG;
+    return script_is_time == tx_is_time && script_masked <= tx_masked;
+}
+
+bool verify_script(std::span<const unsigned char> script_sig, const Script& script_pubkey,
+                   const std::vector<std::string>& witness, uint32_t flags, const SignatureChecker& checker,
+                   ScriptError* error_out) {
+    ScriptError error = ScriptError::OK;
+    auto finish = [&](bool valid) {
+        if (error_out) *error_out = valid ? ScriptError::OK : error;
+        return valid;
+    };
+
+    bool valid;
+    if (verify_template(script_sig, script_pubkey, witness, flags, checker, valid, error)) return finish(valid);
+
+    ItemStack stack;
+    if (!eval_script(stack, script_sig, flags, checker, SigVersion::BASE, error)) return finish(false);
+
+    // P2SH evaluates the redeem script against the stack as the scriptSig left it
+    bool p2sh = (flags & SCRIPT_VERIFY_P2SH) && classify_script(script_pubkey) == ScriptType::P2SH;
+    ItemStack p2sh_stack;
+    if (p2sh) p2sh_stack.assign(stack);
+
+    if (!eval_script(stack, script_pubkey.span(), flags, checker, SigVersion::BASE, error)) return finish(false);
+    if (stack.empty() || !cast_to_bool(stack.top())) return finish(fail(error, ScriptError::EVAL_FALSE));
+
+    bool had_witness = false;
+    int version;
+    std::span<const unsigned char> program;
+    if ((flags & SCRIPT_VERIFY_WITNESS) && is_witness_program(script_pubkey.span(), version, program)) {
+        had_witness = true;
+        // Native witness spends have an empty scriptSig, so it can't be malleated
+        if (!script_sig.empty()) return finish(fail(error, ScriptError::WITNESS_MALLEATED));
+        if (!verify_witness_program(witness, version, program, flags, checker, error)) return finish(false);
+    }
+
+    if (p2sh) {
+        if (!is_push_only(script_sig)) return finish(fail(error, ScriptError::SIG_PUSHONLY));
+        if (p2sh_stack.empty()) return finish(fail(error, ScriptError::EVAL_FALSE));
+        std::span<const unsigned char> redeem_script = p2sh_stack.top().span();
+        p2sh_stack.pop();
+        if (!eval_script(p2sh_stack, redeem_script, flags, checker, SigVersion::BASE, error)) return finish(false);
+        if (p2sh_stack.empty() || !cast_to_bool(p2sh_stack.top())) {
+            return finish(fail(error, ScriptError::EVAL_FALSE));
+        }
+
+        if ((flags & SCRIPT_VERIFY_WITNESS) && is_witness_program(redeem_script, version, program)) {
+            had_witness = true;
+            // The scriptSig must be nothing but the push of the redeem script
+            unsigned char expected[3 + MAX_SCRIPT_ELEMENT_SIZE];
+            size_t expected_size = write_push(redeem_script, expected);
+            if (!std::equal(script_sig.begin(), script_sig.end(), expected, expected + expected_size)) {
+                return finish(fail(error, ScriptError::WITNESS_MALLEATED_P2SH));
+            }
+            if (!verify_witness_program(witness, version, program, flags, checker, error)) return finish(false);
+        }
+    }
+
+    // Witness data on an input that doesn't use it could be malleated freely
+    if ((flags & SCRIPT_VERIFY_WITNESS) && !had_witness && !witness.empty()) {
+        return finish(fail(error, ScriptError::WITNESS_UNEXPECTED));
+    }
+    return finish(true);
+}
+
+} // namespace bitcoin
@@ -0,0 +1,146 @@
+// src/script/interpreter.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "script.h"
+#include "sig_cache.h"
+#include "sighash.h"
+#include "../transaction/transaction.h"
+
+namespace bitcoin {
+
+// Consensus limits
+static constexpr size_t MAX_SCRIPT_ELEMENT_SIZE = 520;  // bytes per stack item
+static constexpr int MAX_OPS_PER_SCRIPT = 201;          // non-push opcodes
+static constexpr size_t MAX_STACK_SIZE = 1000;          // main + alt stack
+static constexpr int MAX_PUBKEYS_PER_MULTISIG = 20;
+static constexpr uint32_t LOCKTIME_THRESHOLD = 500000000;  // below: block height, above: unix time
+
+// Input sequence number bits (BIP68 relative lock times)
+static constexpr uint32_t SEQUENCE_FINAL = 0xffffffff;
+static constexpr uint32_t SEQUENCE_LOCKTIME_DISABLE_FLAG = 1u << 31;   // no relative lock time
+static constexpr uint32_t SEQUENCE_LOCKTIME_TYPE_FLAG = 1u << 22;      // set: units of 512 seconds, clear: blocks
+static constexpr uint32_t SEQUENCE_LOCKTIME_MASK = 0x0000ffff;
+
+// Soft fork rules to enforce. Strict DER signatures (BIP66) aren't a flag:
+// they're always required.
+enum ScriptFlags : uint32_t {
+    SCRIPT_VERIFY_NONE = 0,
+    SCRIPT_VERIFY_P2SH = 1 << 0,                    // BIP16
+    SCRIPT_VERIFY_NULLDUMMY = 1 << 1,               // BIP147
+    SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY = 1 << 2,     // BIP65
+    SCRIPT_VERIFY_CHECKSEQUENCEVERIFY = 1 << 3,     // BIP112
+    SCRIPT_VERIFY_WITNESS = 1 << 4,                 // BIP141/143
+};
+
+// Every soft fork is active from genesis on this chain
+static constexpr uint32_t CONSENSUS_SCRIPT_FLAGS = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_NULLDUMMY |
+    SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY | SCRIPT_VERIFY_CHECKSEQUENCEVERIFY | SCRIPT_VERIFY_WITNESS;
+
+enum class ScriptError : uint8_t {
+    OK,
+    EVAL_FALSE,
+    OP_RETURN,
+    SCRIPT_SIZE,
+    PUSH_SIZE,
+    OP_COUNT,
+    STACK_SIZE,
+    SIG_COUNT,
+    PUBKEY_COUNT,
+    VERIFY,
+    EQUALVERIFY,
+    CHECKSIGVERIFY,
+    CHECKMULTISIGVERIFY,
+    NUMEQUALVERIFY,
+    BAD_OPCODE,
+    DISABLED_OPCODE,
+    INVALID_STACK_OPERATION,
+    INVALID_ALTSTACK_OPERATION,
+    UNBALANCED_CONDITIONAL,
+    SCRIPTNUM,
+    NEGATIVE_LOCKTIME,
+    UNSATISFIED_LOCKTIME,
+    SIG_NULLDUMMY,
+    SIG_DER,
+    SIG_PUSHONLY,
+    WITNESS_PROGRAM_WRONG_LENGTH,
+    WITNESS_PROGRAM_WITNESS_EMPTY,
+    WITNESS_PROGRAM_MISMATCH,
+    WITNESS_MALLEATED,
+    WITNESS_MALLEATED_P2SH,
+    WITNESS_UNEXPECTED,
+    WITNESS_CLEANSTACK,
+};
+
+const char* script_error_name(ScriptError error);
+
+// Which signature hash an OP_CHECKSIG uses
+enum class SigVersion : uint8_t {
+    BASE,           // legacy and P2SH scripts
+    WITNESS_V0,     // P2WPKH / P2WSH (BIP143)
+};
+
+/**
+ * What the interpreter needs from the spending transaction
+ *
+ * The base class rejects every signature and lock time - handy for running
+ * scripts that shouldn't need either.
+ */
+class SignatureChecker {
+public:
+    virtual ~SignatureChecker() = default;
+
+    // `signature` is DER plus the hash type byte; `script_code` is what gets signed
+    virtual bool check_ecdsa(std::span<const unsigned char> /*signature*/, std::span<const unsigned char> /*pubkey*/,
+                             std::span<const unsigned char> /*script_code*/, SigVersion /*sigversion*/) const {
+        return false;
+    }
+    virtual bool check_locktime(int64_t /*locktime*/) const { return false; }
+    virtual bool check_sequence(int64_t /*sequence*/) const { return false; }
+};
+
+/**
+ * Checks signatures against input `input_index` of `tx`
+ *
+ * `precomputed` (BIP143 hashes, optional) and `sig_cache` (optional) must
+ * outlive the checker.
+ */
+class TransactionSignatureChecker : public SignatureChecker {
+private:
+    const Transaction& tx;
+    size_t input_index;
+    uint64_t amount;                            // value of the output being spent
+    const PrecomputedSighash* precomputed;
+    SignatureCache* sig_cache;
+
+public:
+    TransactionSignatureChecker(const Transaction& transaction, size_t index, uint64_t spent_amount,
+                                const PrecomputedSighash* precomputed_sighash = nullptr,
+                                SignatureCache* cache = nullptr)
+        : tx(transaction), input_index(index), amount(spent_amount), precomputed(precomputed_sighash),
+          sig_cache(cache) {}
+
+    bool check_ecdsa(std::span<const unsigned char> signature, std::span<const unsigned char> pubkey,
+                     std::span<const unsigned char> script_code, SigVersion sigversion) const override;
+    bool check_locktime(int64_t locktime) const override;
+    bool check_sequence(int64_t sequence) const override;
+};
+
+/**
+ * Does `script_sig` + `witness` satisfy `script_pubkey`?
+ *
+ * P2PKH and P2WPKH spends in their usual shape are matched as templates and
+ * checked directly (one hash and one signature check) without running the
+ * interpreter; everything else is evaluated on fixed-capacity stacks whose
+ * items point into the scripts and witness instead of copying them, so
+ * evaluation never allocates. Witness versions above 0 (taproot included)
+ * aren't enforced yet and pass, as they do for any node that predates them.
+ */
+bool verify_script(std::span<const unsigned char> script_sig, const Script& script_pubkey,
+                   const std::vector<std::string>& witness, uint32_t flags, const SignatureChecker& checker,
+                   ScriptError* error = nullptr);
+
+} // namespace bitcoin
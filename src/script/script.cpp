@@ -0,0 +1,250 @@
+// src/script/script.cpp
+#include "script.h"
+#include "../crypto/hex.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace bitcoin {
+
+void Script::grow(size_t min_capacity) {
+    size_t new_capacity = std::max(min_capacity, 2 * capacity());
+    unsigned char* buffer = static_cast<unsigned char*>(std::malloc(new_capacity));
+    if (!buffer) throw std::bad_alloc();
+    std::memcpy(buffer, data(), length);
+    if (on_heap) std::free(indirect.data);
+    indirect.data = buffer;
+    indirect.capacity = (uint32_t)new_capacity;
+    on_heap = true;
+}
+
+Script::Script(Script&& other) noexcept : length(other.length), on_heap(other.on_heap) {
+    if (on_heap) {
+        indirect = other.indirect;
+    } else {
+        std::memcpy(direct, other.direct, length);
+    }
+    other.length = 0;
+    other.on_heap = false;
+}
+
+Script& Script::operator=(const Script& other) {
+    if (this != &other) assign(other.span());
+    return *this;
+}
+
+Script& Script::operator=(Script&& other) noexcept {
+    if (this == &other) return *this;
+    if (on_heap) std::free(indirect.data);
+    length = other.length;
+    on_heap = other.on_heap;
+    if (on_heap) {
+        indirect = other.indirect;
+    } else {
+        std::memcpy(direct, other.direct, length);
+    }
+    other.length = 0;
+    other.on_heap = false;
+    return *this;
+}
+
+Script::~Script() {
+    if (on_heap) std::free(indirect.data);
+}
+
+void Script::assign(std::span<const unsigned char> bytes) {
+    length = 0;
+    append(bytes);
+}
+
+void Script::append(std::span<const unsigned char> bytes) {
+    reserve(length + bytes.size());
+    if (!bytes.empty()) std::memcpy(data() + length, bytes.data(), bytes.size());
+    length += (uint32_t)bytes.size();
+}
+
+Script& Script::push_opcode(Opcode op) {
+    unsigned char byte = op;
+    append({&byte, 1});
+    return *this;
+}
+
+Script& Script::push_data(std::span<const unsigned char> bytes) {
+    size_t n = bytes.size();
+    if (n < OP_PUSHDATA1) {
+        push_opcode((Opcode)n);
+    } else if (n <= 0xff) {
+        unsigned char prefix[2] = {OP_PUSHDATA1, (unsigned char)n};
+        append(prefix);
+    } else if (n <= 0xffff) {
+        unsigned char prefix[3] = {OP_PUSHDATA2, (unsigned char)n, (unsigned char)(n >> 8)};
+        append(prefix);
+    } else {
+        unsigned char prefix[5] = {OP_PUSHDATA4, (unsigned char)n, (unsigned char)(n >> 8),
+                                   (unsigned char)(n >> 16), (unsigned char)(n >> 24)};
+        append(prefix);
+    }
+    append(bytes);
+    return *this;
+}
+
+Script& Script::push_int(int64_t n) {
+    if (n == 0) return push_opcode(OP_0);
+    if (n == -1 || (n >= 1 && n <= 16)) return push_opcode((Opcode)(n + (OP_1 - 1)));
+
+    // Minimal little-endian sign-magnitude encoding (script numbers)
+    unsigned char bytes[9];
+    size_t len = 0;
+    bool negative = n < 0;
+    uint64_t magnitude = negative ? 0 - (uint64_t)n : (uint64_t)n;
+    while (magnitude) {
+        bytes[len++] = (unsigned char)magnitude;
+        magnitude >>= 8;
+    }
+    if (bytes[len - 1] & 0x80) {
+        bytes[len++] = negative ? 0x80 : 0x00;
+    } else if (negative) {
+        bytes[len - 1] |= 0x80;
+    }
+    return push_data({bytes, len});
+}
+
+std::string Script::to_hex() const {
+    return crypto::bytes_to_hex(data(), length);
+}
+
+bool operator==(const Script& a, const Script& b) {
+    return a.length == b.length && std::memcmp(a.data(), b.data(), a.length) == 0;
+}
+
+bool operator<(const Script& a, const Script& b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+Script make_p2pkh(const crypto::Hash160& key_hash) {
+    Script script;
+    script.push_opcode(OP_DUP).push_opcode(OP_HASH160).push_data({key_hash.data(), key_hash.size()});
+    script.push_opcode(OP_EQUALVERIFY).push_opcode(OP_CHECKSIG);
+    return script;
+}
+
+Script make_p2sh(const crypto::Hash160& script_hash) {
+    Script script;
+    script.push_opcode(OP_HASH160).push_data({script_hash.data(), script_hash.size()}).push_opcode(OP_EQUAL);
+    return script;
+}
+
+Script make_p2wpkh(const crypto::Hash160& key_hash) {
+    Script script;
+    script.push_opcode(OP_0).push_data({key_hash.data(), key_hash.size()});
+    return script;
+}
+
+Script make_p2wsh(const crypto::Hash256& script_hash) {
+    Script script;
+    script.push_opcode(OP_0).push_data({script_hash.data(), script_hash.size()});
+    return script;
+}
+
+Script make_p2tr(std::span<const unsigned char, 32> output_key) {
+    Script script;
+    script.push_opcode(OP_1).push_data(output_key);
+    return script;
+}
+
+ScriptType classify_script(const Script& script, std::span<const unsigned char>* hash) {
+    const unsigned char* s = script.data();
+    size_t n = script.size();
+    ScriptType type = ScriptType::NONSTANDARD;
+    size_t offset = 0, hash_size = 0;
+
+    if (n == 25 && s[0] == OP_DUP && s[1] == OP_HASH160 && s[2] == 20 && s[23] == OP_EQUALVERIFY &&
+        s[24] == OP_CHECKSIG) {
+        type = ScriptType::P2PKH;
+        offset = 3;
+        hash_size = 20;
+    } else if (n == 23 && s[0] == OP_HASH160 && s[1] == 20 && s[22] == OP_EQUAL) {
+        type = ScriptType::P2SH;
+        offset = 2;
+        hash_size = 20;
+    } else if (n == 22 && s[0] == OP_0 && s[1] == 20) {
+        type = ScriptType::P2WPKH;
+        offset = 2;
+        hash_size = 20;
+    } else if (n == 34 && s[0] == OP_0 && s[1] == 32) {
+        type = ScriptType::P2WSH;
+        offset = 2;
+        hash_size = 32;
+    } else if (n == 34 && s[0] == OP_1 && s[1] == 32) {
+        type = ScriptType::P2TR;
+        offset = 2;
+        hash_size = 32;
+    } else if (n >= 1 && s[0] == OP_RETURN) {
+        type = ScriptType::NULL_DATA;
+    }
+
+    if (hash) *hash = std::span<const unsigned char>(s + offset, hash_size);
+    return type;
+}
+
+const char* script_type_name(ScriptType type) {
+    switch (type) {
+        case ScriptType::P2PKH: return "P2PKH";
+        case ScriptType::P2SH: return "P2SH";
+        case ScriptType::P2WPKH: return "P2WPKH";
+        case ScriptType::P2WSH: return "P2WSH";
+        case ScriptType::P2TR: return "P2TR";
+        case ScriptType::NULL_DATA: return "NULL_DATA";
+        default: return "NONSTANDARD";
+    }
+}
+
+bool get_script_op(std::span<const unsigned char>& pc, Opcode& op, std::span<const unsigned char>* data) {
+    if (pc.empty()) return false;
+    op = (Opcode)pc[0];
+    pc = pc.subspan(1);
+    if (op > OP_PUSHDATA4) return true;
+
+    size_t len = op;
+    size_t prefix = op == OP_PUSHDATA1 ? 1 : op == OP_PUSHDATA2 ? 2 : op == OP_PUSHDATA4 ? 4 : 0;
+    if (pc.size() < prefix) return false;
+    if (prefix) {
+        len = 0;
+        for (size_t i = 0; i < prefix; i++) len |= (size_t)pc[i] << (8 * i);
+        pc = pc.subspan(prefix);
+    }
+    if (pc.size() < len) return false;
+    if (data) *data = pc.first(len);
+    pc = pc.subspan(len);
+    return true;
+}
+
+unsigned count_sigops(std::span<const unsigned char> script, bool accurate) {
+    static constexpr unsigned MAX_PUBKEYS_PER_MULTISIG = 20;
+    unsigned count = 0;
+    Opcode op, last = OP_INVALIDOPCODE;
+    while (get_script_op(script, op)) {
+        if (op == OP_CHECKSIG || op == OP_CHECKSIGVERIFY) {
+            count++;
+        } else if (op == OP_CHECKMULTISIG || op == OP_CHECKMULTISIGVERIFY) {
+            count += accurate && last >= OP_1 && last <= OP_16 ? last - OP_1 + 1 : MAX_PUBKEYS_PER_MULTISIG;
+        }
+        last = op;
+    }
+    return count;
+}
+
+Script decompress_script(SpanReader& reader) {
+    uint64_t tag = read_compact_size(reader);
+    switch (tag) {
+        case 0: return make_p2pkh(crypto::Hash160(reader.read(20).data()));
+        case 1: return make_p2sh(crypto::Hash160(reader.read(20).data()));
+        case 2: return make_p2wpkh(crypto::Hash160(reader.read(20).data()));
+        case 3: return make_p2wsh(crypto::Hash256(reader.read(32).data()));
+        case 4: return make_p2tr(reader.read(32).first<32>());
+        default: return Script(reader.read(tag - NUM_SCRIPT_TAGS));
+    }
+}
+
+} // namespace bitcoin
@@ -0,0 +1,262 @@
+// src/script/script.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include "../crypto/uint256.h"
+#include "../util/serialize.h"
+
+namespace bitcoin {
+
+// Script opcodes (the ones consensus still knows about)
+enum Opcode : unsigned char {
+    // Pushes
+    OP_0 = 0x00,
+    OP_FALSE = OP_0,
+    OP_PUSHDATA1 = 0x4c,
+    OP_PUSHDATA2 = 0x4d,
+    OP_PUSHDATA4 = 0x4e,
+    OP_1NEGATE = 0x4f,
+    OP_RESERVED = 0x50,
+    OP_1 = 0x51,
+    OP_TRUE = OP_1,
+    OP_2 = 0x52, OP_3 = 0x53, OP_4 = 0x54, OP_5 = 0x55, OP_6 = 0x56, OP_7 = 0x57, OP_8 = 0x58,
+    OP_9 = 0x59, OP_10 = 0x5a, OP_11 = 0x5b, OP_12 = 0x5c, OP_13 = 0x5d, OP_14 = 0x5e, OP_15 = 0x5f,
+    OP_16 = 0x60,
+
+    // Flow control
+    OP_NOP = 0x61,
+    OP_VER = 0x62,
+    OP_IF = 0x63,
+    OP_NOTIF = 0x64,
+    OP_VERIF = 0x65,
+    OP_VERNOTIF = 0x66,
+    OP_ELSE = 0x67,
+    OP_ENDIF = 0x68,
+    OP_VERIFY = 0x69,
+    OP_RETURN = 0x6a,
+
+    // Stack
+    OP_TOALTSTACK = 0x6b,
+    OP_FROMALTSTACK = 0x6c,
+    OP_2DROP = 0x6d,
+    OP_2DUP = 0x6e,
+    OP_3DUP = 0x6f,
+    OP_2OVER = 0x70,
+    OP_2ROT = 0x71,
+    OP_2SWAP = 0x72,
+    OP_IFDUP = 0x73,
+    OP_DEPTH = 0x74,
+    OP_DROP = 0x75,
+    OP_DUP = 0x76,
+    OP_NIP = 0x77,
+    OP_OVER = 0x78,
+    OP_PICK = 0x79,
+    OP_ROLL = 0x7a,
+    OP_ROT = 0x7b,
+    OP_SWAP = 0x7c,
+    OP_TUCK = 0x7d,
+
+    // Splice
+    OP_CAT = 0x7e,
+    OP_SUBSTR = 0x7f,
+    OP_LEFT = 0x80,
+    OP_RIGHT = 0x81,
+    OP_SIZE = 0x82,
+
+    // Bit logic
+    OP_INVERT = 0x83,
+    OP_AND = 0x84,
+    OP_OR = 0x85,
+    OP_XOR = 0x86,
+    OP_EQUAL = 0x87,
+    OP_EQUALVERIFY = 0x88,
+    OP_RESERVED1 = 0x89,
+    OP_RESERVED2 = 0x8a,
+
+    // Arithmetic
+    OP_1ADD = 0x8b,
+    OP_1SUB = 0x8c,
+    OP_2MUL = 0x8d,
+    OP_2DIV = 0x8e,
+    OP_NEGATE = 0x8f,
+    OP_ABS = 0x90,
+    OP_NOT = 0x91,
+    OP_0NOTEQUAL = 0x92,
+    OP_ADD = 0x93,
+    OP_SUB = 0x94,
+    OP_MUL = 0x95,
+    OP_DIV = 0x96,
+    OP_MOD = 0x97,
+    OP_LSHIFT = 0x98,
+    OP_RSHIFT = 0x99,
+    OP_BOOLAND = 0x9a,
+    OP_BOOLOR = 0x9b,
+    OP_NUMEQUAL = 0x9c,
+    OP_NUMEQUALVERIFY = 0x9d,
+    OP_NUMNOTEQUAL = 0x9e,
+    OP_LESSTHAN = 0x9f,
+    OP_GREATERTHAN = 0xa0,
+    OP_LESSTHANOREQUAL = 0xa1,
+    OP_GREATERTHANOREQUAL = 0xa2,
+    OP_MIN = 0xa3,
+    OP_MAX = 0xa4,
+    OP_WITHIN = 0xa5,
+
+    // Crypto
+    OP_RIPEMD160 = 0xa6,
+    OP_SHA1 = 0xa7,
+    OP_SHA256 = 0xa8,
+    OP_HASH160 = 0xa9,
+    OP_HASH256 = 0xaa,
+    OP_CODESEPARATOR = 0xab,
+    OP_CHECKSIG = 0xac,
+    OP_CHECKSIGVERIFY = 0xad,
+    OP_CHECKMULTISIG = 0xae,
+    OP_CHECKMULTISIGVERIFY = 0xaf,
+
+    // Expansion
+    OP_NOP1 = 0xb0,
+    OP_CHECKLOCKTIMEVERIFY = 0xb1,
+    OP_CHECKSEQUENCEVERIFY = 0xb2,
+    OP_NOP4 = 0xb3, OP_NOP5 = 0xb4, OP_NOP6 = 0xb5, OP_NOP7 = 0xb6, OP_NOP8 = 0xb7, OP_NOP9 = 0xb8,
+    OP_NOP10 = 0xb9,
+    OP_CHECKSIGADD = 0xba,          // tapscript only
+
+    OP_INVALIDOPCODE = 0xff,
+};
+
+/**
+ * Script bytes with a small-buffer optimization
+ *
+ * Up to INLINE_CAPACITY bytes are stored inside the object - enough for every
+ * standard output template (P2PKH 25, P2SH 23, P2WPKH 22, P2WSH/P2TR 34) -
+ * so a TransactionOutput (value + Script) fits in one cache line and never
+ * touches the heap. Longer scripts (mostly input scripts) spill to the heap.
+ */
+class Script {
+public:
+    static constexpr size_t INLINE_CAPACITY = 34;
+    static constexpr size_t MAX_SCRIPT_SIZE = 10000;
+
+private:
+    union {
+        unsigned char direct[INLINE_CAPACITY];
+        struct {
+            unsigned char* data;
+            uint32_t capacity;
+        } indirect;
+    };
+    uint32_t length = 0;
+    bool on_heap = false;
+
+    void grow(size_t min_capacity);
+
+public:
+    Script() {}
+    explicit Script(std::span<const unsigned char> bytes) { assign(bytes); }
+    Script(const unsigned char* begin, const unsigned char* end) { assign({begin, end}); }
+
+    Script(const Script& other) { assign(other.span()); }
+    Script(Script&& other) noexcept;
+    Script& operator=(const Script& other);
+    Script& operator=(Script&& other) noexcept;
+    ~Script();
+
+    unsigned char* data() { return on_heap ? indirect.data : direct; }
+    const unsigned char* data() const { return on_heap ? indirect.data : direct; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    size_t capacity() const { return on_heap ? indirect.capacity : INLINE_CAPACITY; }
+
+    const unsigned char* begin() const { return data(); }
+    const unsigned char* end() const { return data() + length; }
+    unsigned char operator[](size_t i) const { return data()[i]; }
+    std::span<const unsigned char> span() const { return {data(), length}; }
+
+    void clear() { length = 0; }
+    void reserve(size_t n) { if (n > capacity()) grow(n); }
+    void assign(std::span<const unsigned char> bytes);
+    void append(std::span<const unsigned char> bytes);
+
+    // Script building
+    Script& push_opcode(Opcode op);
+    Script& push_data(std::span<const unsigned char> bytes);    // smallest push that fits
+    Script& push_int(int64_t n);                                // OP_0 / OP_1..16 / minimal number
+
+    // OP_RETURN outputs and oversized scripts can never be spent (kept out of the UTXO set)
+    bool is_unspendable() const { return (length > 0 && data()[0] == OP_RETURN) || length > MAX_SCRIPT_SIZE; }
+
+    std::string to_hex() const;
+
+    friend bool operator==(const Script& a, const Script& b);
+    friend bool operator!=(const Script& a, const Script& b) { return !(a == b); }
+    friend bool operator<(const Script& a, const Script& b);
+};
+
+// Standard output templates
+enum class ScriptType : uint8_t {
+    NONSTANDARD,
+    P2PKH,          // OP_DUP OP_HASH160 <20> OP_EQUALVERIFY OP_CHECKSIG
+    P2SH,           // OP_HASH160 <20> OP_EQUAL
+    P2WPKH,         // OP_0 <20>
+    P2WSH,          // OP_0 <32>
+    P2TR,           // OP_1 <32>
+    NULL_DATA,      // OP_RETURN ... (provably unspendable)
+};
+
+Script make_p2pkh(const crypto::Hash160& key_hash);
+Script make_p2sh(const crypto::Hash160& script_hash);
+Script make_p2wpkh(const crypto::Hash160& key_hash);
+Script make_p2wsh(const crypto::Hash256& script_hash);
+Script make_p2tr(std::span<const unsigned char, 32> output_key);
+
+// Which template is this? `hash` (if given) is set to the embedded 20/32 bytes.
+ScriptType classify_script(const Script& script, std::span<const unsigned char>* hash = nullptr);
+
+const char* script_type_name(ScriptType type);
+
+// Read the next opcode from `pc`, advancing it. For pushes `data` (if given)
+// is set to the pushed bytes. False at the end of the script or if a push
+// runs past it.
+bool get_script_op(std::span<const unsigned char>& pc, Opcode& op, std::span<const unsigned char>* data = nullptr);
+
+// Signature operations in a script, counted as Bitcoin Core does: a
+// CHECKMULTISIG is 20, or with `accurate` the key count pushed just before
+// it (P2SH redeem scripts and witness scripts). Stops at a malformed push.
+unsigned count_sigops(std::span<const unsigned char> script, bool accurate);
+
+/**
+ * Compact script encoding for UTXO storage
+ *
+ * Standard templates become a 1-byte tag plus their 20 or 32 byte hash
+ * (21-33 bytes instead of 22-34 + length); anything else is stored as
+ * CompactSize(size + NUM_SCRIPT_TAGS) followed by the raw bytes.
+ */
+static constexpr uint64_t NUM_SCRIPT_TAGS = 5;
+
+template <typename Stream>
+void compress_script(Stream& s, const Script& script) {
+    std::span<const unsigned char> hash;
+    ScriptType type = classify_script(script, &hash);
+    unsigned char tag;
+    switch (type) {
+        case ScriptType::P2PKH:  tag = 0; break;
+        case ScriptType::P2SH:   tag = 1; break;
+        case ScriptType::P2WPKH: tag = 2; break;
+        case ScriptType::P2WSH:  tag = 3; break;
+        case ScriptType::P2TR:   tag = 4; break;
+        default:
+            write_compact_size(s, script.size() + NUM_SCRIPT_TAGS);
+            write_bytes(s, script.data(), script.size());
+            return;
+    }
+    s.write(std::span<const unsigned char>(&tag, 1));
+    s.write(hash);
+}
+
+// Inverse of compress_script (throws DeserializeError)
+Script decompress_script(SpanReader& reader);
+
+} // namespace bitcoin
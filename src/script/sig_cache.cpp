@@ -0,0 +1,90 @@
+// src/script/sig_cache.cpp
+#include "sig_cache.h"
+#include <cstring>
+#include <random>
+
+namespace bitcoin {
+
+SignatureCache::SignatureCache(size_t max_bytes) {
+    // Largest power of two number of buckets that fits (at least two)
+    size_t count = 2;
+    while (count * 2 * sizeof(Bucket) <= max_bytes) count *= 2;
+    buckets = std::make_unique<Bucket[]>(count);
+    bucket_mask = count - 1;    // slots start out zero (empty)
+
+    // Salt, then padding that tags the entry as ECDSA and fills the first
+    // 64-byte block, so computing an entry starts from a finished state
+    unsigned char salt[32];
+    std::random_device rd;
+    for (size_t i = 0; i < sizeof(salt); i += 4) {
+        uint32_t word = rd();
+        std::memcpy(salt + i, &word, 4);
+    }
+    unsigned char padding[32];
+    std::memset(padding, 'E', sizeof(padding));
+    ecdsa_hasher.update(salt, sizeof(salt)).update(padding, sizeof(padding));
+}
+
+crypto::Hash256 SignatureCache::compute_entry_ecdsa(std::span<const unsigned char> pubkey,
+                                                    const crypto::Hash256& sighash,
+                                                    std::span<const unsigned char> signature) const {
+    crypto::Sha256Writer hasher = ecdsa_hasher;
+    return hasher.update(sighash.data(), sighash.size()).update(pubkey).update(signature).finalize();
+}
+
+uint64_t SignatureCache::fingerprint(const crypto::Hash256& entry) {
+    uint64_t fp = entry.get_uint64(0);
+    return fp ? fp : 1;
+}
+
+bool SignatureCache::find(uint64_t fp) const {
+    size_t first = fp & bucket_mask;
+    for (size_t bucket : {first, other_bucket(first, fp)}) {
+        for (const auto& slot : buckets[bucket].slots) {
+            if (slot.load(std::memory_order_relaxed) == fp) return true;
+        }
+    }
+    return false;
+}
+
+bool SignatureCache::contains(const crypto::Hash256& entry) const {
+    bool found = find(fingerprint(entry));
+    (found ? hits : misses).fetch_add(1, std::memory_order_relaxed);
+    return found;
+}
+
+void SignatureCache::insert(const crypto::Hash256& entry) {
+    uint64_t fp = fingerprint(entry);
+    if (find(fp)) return;
+    inserts.fetch_add(1, std::memory_order_relaxed);
+
+    size_t bucket = fp & bucket_mask;
+    for (int kick = 0; kick < MAX_KICKS; kick++) {
+        for (size_t candidate : {bucket, other_bucket(bucket, fp)}) {
+            for (auto& slot : buckets[candidate].slots) {
+                uint64_t expected = 0;
+                if (slot.load(std::memory_order_relaxed) == 0 &&
+                    slot.compare_exchange_strong(expected, fp, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+        // Both buckets full: take a slot and move its entry on to its other bucket
+        int victim = (int)((fp >> 56) + kick) % SLOTS;
+        fp = buckets[bucket].slots[victim].exchange(fp, std::memory_order_relaxed);
+        bucket = other_bucket(bucket, fp);
+    }
+    evictions.fetch_add(1, std::memory_order_relaxed);
+}
+
+SignatureCacheStats SignatureCache::stats() const {
+    SignatureCacheStats out;
+    out.hits = hits.load(std::memory_order_relaxed);
+    out.misses = misses.load(std::memory_order_relaxed);
+    out.inserts = inserts.load(std::memory_order_relaxed);
+    out.evictions = evictions.load(std::memory_order_relaxed);
+    out.capacity = (bucket_mask + 1) * SLOTS;
+    return out;
+}
+
+} // namespace bitcoin
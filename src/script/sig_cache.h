@@ -0,0 +1,87 @@
+// src/script/sig_cache.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include "../crypto/sha256.h"
+#include "../crypto/uint256.h"
+
+namespace bitcoin {
+
+struct SignatureCacheStats {
+    uint64_t hits = 0;              // signatures that skipped verification
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;         // entries pushed out by newer ones
+    size_t capacity = 0;            // entries
+
+    double hit_rate() const { return hits + misses ? (double)hits / (hits + misses) : 0; }
+};
+
+/**
+ * Cache of signatures that already verified
+ *
+ * A transaction's signatures are checked when it enters the mempool and
+ * again when it shows up in a block; with the cache the second check is a
+ * hash and a couple of memory reads instead of the elliptic curve math.
+ *
+ * Entries are 64-bit fingerprints of a salted SHA256 over (public key,
+ * sighash, signature), kept in a bucketized cuckoo table: every fingerprint
+ * has two 64-byte buckets of 8 slots. Lookups are a few atomic loads and
+ * never block; inserts claim an empty slot with a CAS or kick an entry over
+ * to its other bucket, and drop the last one kicked if that goes on for too
+ * long. Racing an insert can only make a lookup miss, never hit falsely.
+ * The salt is random per instance, so nobody can aim an invalid signature
+ * at a cached fingerprint.
+ */
+class SignatureCache {
+public:
+    static constexpr size_t DEFAULT_MAX_BYTES = 32 << 20;
+
+    explicit SignatureCache(size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    // Cache key for an ECDSA signature (DER, no hash type byte) over
+    // `sighash` by `pubkey`
+    crypto::Hash256 compute_entry_ecdsa(std::span<const unsigned char> pubkey, const crypto::Hash256& sighash,
+                                        std::span<const unsigned char> signature) const;
+
+    // Was this entry inserted (and not evicted since)? Lock-free.
+    bool contains(const crypto::Hash256& entry) const;
+
+    // Record a signature that verified
+    void insert(const crypto::Hash256& entry);
+
+    SignatureCacheStats stats() const;
+
+private:
+    static constexpr int SLOTS = 8;
+    static constexpr int MAX_KICKS = 16;
+
+    struct alignas(64) Bucket {
+        std::atomic<uint64_t> slots[SLOTS];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucket_mask;
+
+    // SHA256 state with the salt already absorbed
+    crypto::Sha256Writer ecdsa_hasher;
+
+    mutable std::atomic<uint64_t> hits{0};
+    mutable std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> inserts{0};
+    std::atomic<uint64_t> evictions{0};
+
+    // Never 0 - that marks an empty slot
+    static uint64_t fingerprint(const crypto::Hash256& entry);
+
+    // A fingerprint's two buckets are `fp & mask` and that xor `fp >> 32`, so
+    // either one gives the other without the full entry
+    size_t other_bucket(size_t bucket, uint64_t fp) const { return (bucket ^ (fp >> 32)) & bucket_mask; }
+
+    bool find(uint64_t fp) const;
+};
+
+} // namespace bitcoin
@@ -0,0 +1,150 @@
+// src/script/sighash.cpp
+#include "sighash.h"
+#include "../crypto/sha256.h"
+#include <stdexcept>
+
+namespace bitcoin {
+
+// Script code as it is signed: length-prefixed, OP_CODESEPARATORs removed
+template <typename Stream>
+static void write_script_code(Stream& s, std::span<const unsigned char> script_code) {
+    size_t separators = 0;
+    std::span<const unsigned char> pc = script_code;
+    Opcode op;
+    while (get_script_op(pc, op)) {
+        if (op == OP_CODESEPARATOR) separators++;
+    }
+    write_compact_size(s, script_code.size() - separators);
+    if (!separators) {
+        write_bytes(s, script_code.data(), script_code.size());
+        return;
+    }
+
+    // Copy the runs between separators
+    pc = script_code;
+    const unsigned char* run = pc.data();
+    while (true) {
+        const unsigned char* at = pc.data();
+        if (!get_script_op(pc, op)) break;
+        if (op == OP_CODESEPARATOR) {
+            write_bytes(s, run, at - run);
+            run = pc.data();
+        }
+    }
+    write_bytes(s, run, script_code.data() + script_code.size() - run);
+}
+
+crypto::Hash256 legacy_signature_hash(const Transaction& tx, size_t input_index,
+                                      std::span<const unsigned char> script_code, uint8_t hash_type) {
+    if (input_index >= tx.inputs.size()) throw std::out_of_range("Signature hash input index out of range");
+
+    bool anyone_can_pay = hash_type & SIGHASH_ANYONECANPAY;
+    bool hash_none = (hash_type & 0x1f) == SIGHASH_NONE;
+    bool hash_single = (hash_type & 0x1f) == SIGHASH_SINGLE;
+    if (hash_single && input_index >= tx.outputs.size()) {
+        // Original client bug: signs the number 1 instead of failing
+        crypto::Hash256 one;
+        one.data()[0] = 1;
+        return one;
+    }
+
+    crypto::Sha256Writer hasher;
+    write_le32(hasher, tx.version);
+
+    // ANYONECANPAY: only this input. NONE / SINGLE: other inputs' sequences are
+    // zeroed so they can be updated.
+    write_compact_size(hasher, anyone_can_pay ? 1 : tx.inputs.size());
+    for (size_t i = 0; i < tx.inputs.size(); i++) {
+        if (anyone_can_pay && i != input_index) continue;
+        const TransactionInput& input = tx.inputs[i];
+        write_bytes(hasher, input.previous_txid.data(), input.previous_txid.size());
+        write_le32(hasher, input.vout);
+        if (i == input_index) {
+            write_script_code(hasher, script_code);
+        } else {
+            write_compact_size(hasher, 0);
+        }
+        write_le32(hasher, i != input_index && (hash_none || hash_single) ? 0 : input.sequence);
+    }
+
+    // NONE: no outputs. SINGLE: outputs up to this input's, the earlier ones blanked.
+    size_t output_count = hash_none ? 0 : hash_single ? input_index + 1 : tx.outputs.size();
+    write_compact_size(hasher, output_count);
+    for (size_t i = 0; i < output_count; i++) {
+        if (hash_single && i != input_index) {
+            write_le64(hasher, UINT64_MAX);     // value -1
+            write_compact_size(hasher, 0);
+            continue;
+        }
+        const TransactionOutput& output = tx.outputs[i];
+        write_le64(hasher, output.value);
+        write_compact_size(hasher, output.script_pubkey.size());
+        write_bytes(hasher, output.script_pubkey.data(), output.script_pubkey.size());
+    }
+
+    write_le32(hasher, tx.locktime);
+    write_le32(hasher, hash_type);
+    return hasher.finalize_double();
+}
+
+PrecomputedSighash::PrecomputedSighash(const Transaction& tx) {
+    crypto::Sha256Writer prevouts, sequences, outputs;
+    for (const TransactionInput& input : tx.inputs) {
+        write_bytes(prevouts, input.previous_txid.data(), input.previous_txid.size());
+        write_le32(prevouts, input.vout);
+        write_le32(sequences, input.sequence);
+    }
+    for (const TransactionOutput& output : tx.outputs) {
+        write_le64(outputs, output.value);
+        write_compact_size(outputs, output.script_pubkey.size());
+        write_bytes(outputs, output.script_pubkey.data(), output.script_pubkey.size());
+    }
+    hash_prevouts = prevouts.finalize_double();
+    hash_sequence = sequences.finalize_double();
+    hash_outputs = outputs.finalize_double();
+}
+
+crypto::Hash256 segwit_signature_hash(const Transaction& tx, size_t input_index,
+                                      std::span<const unsigned char> script_code, uint64_t amount,
+                                      uint8_t hash_type, const PrecomputedSighash& precomputed) {
+    if (input_index >= tx.inputs.size()) throw std::out_of_range("Signature hash input index out of range");
+
+    bool anyone_can_pay = hash_type & SIGHASH_ANYONECANPAY;
+    uint8_t base_type = hash_type & 0x1f;
+    crypto::Hash256 zero;
+
+    // SINGLE commits to just the output at this input's index (if there is one)
+    crypto::Hash256 single_output;
+    if (base_type == SIGHASH_SINGLE && input_index < tx.outputs.size()) {
+        const TransactionOutput& output = tx.outputs[input_index];
+        crypto::Sha256Writer hasher;
+        write_le64(hasher, output.value);
+        write_compact_size(hasher, output.script_pubkey.size());
+        write_bytes(hasher, output.script_pubkey.data(), output.script_pubkey.size());
+        single_output = hasher.finalize_double();
+    }
+
+    const crypto::Hash256& hash_prevouts = anyone_can_pay ? zero : precomputed.hash_prevouts;
+    const crypto::Hash256& hash_sequence =
+        anyone_can_pay || base_type == SIGHASH_SINGLE || base_type == SIGHASH_NONE ? zero : precomputed.hash_sequence;
+    const crypto::Hash256& hash_outputs =
+        base_type == SIGHASH_SINGLE ? single_output : base_type == SIGHASH_NONE ? zero : precomputed.hash_outputs;
+
+    const TransactionInput& input = tx.inputs[input_index];
+    crypto::Sha256Writer hasher;
+    write_le32(hasher, tx.version);
+    write_bytes(hasher, hash_prevouts.data(), hash_prevouts.size());
+    write_bytes(hasher, hash_sequence.data(), hash_sequence.size());
+    write_bytes(hasher, input.previous_txid.data(), input.previous_txid.size());
+    write_le32(hasher, input.vout);
+    write_compact_size(hasher, script_code.size());     // as is: v0 keeps OP_CODESEPARATORs
+    write_bytes(hasher, script_code.data(), script_code.size());
+    write_le64(hasher, amount);
+    write_le32(hasher, input.sequence);
+    write_bytes(hasher, hash_outputs.data(), hash_outputs.size());
+    write_le32(hasher, tx.locktime);
+    write_le32(hasher, hash_type);
+    return hasher.finalize_double();
+}
+
+} // namespace bitcoin
@@ -0,0 +1,53 @@
+// src/script/sighash.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "script.h"
+#include "../crypto/uint256.h"
+#include "../transaction/transaction.h"
+
+namespace bitcoin {
+
+// Signature hash types (last byte of every signature)
+enum SigHashType : uint8_t {
+    SIGHASH_ALL = 0x01,
+    SIGHASH_NONE = 0x02,
+    SIGHASH_SINGLE = 0x03,
+    SIGHASH_ANYONECANPAY = 0x80,
+};
+
+/**
+ * Pre-segwit signature hash
+ *
+ * The transaction serialized with every input script emptied except input
+ * `input_index`, which carries `script_code` (minus any OP_CODESEPARATORs),
+ * trimmed the way `hash_type` asks, followed by the 4-byte hash type,
+ * double-SHA256'd. Streamed straight into the hasher - no modified copy of
+ * the transaction is made. SIGHASH_SINGLE without a matching output hashes
+ * to 1, as it always has.
+ */
+crypto::Hash256 legacy_signature_hash(const Transaction& tx, size_t input_index,
+                                      std::span<const unsigned char> script_code, uint8_t hash_type = SIGHASH_ALL);
+
+/**
+ * The parts of a BIP143 signature hash that don't depend on the input
+ *
+ * Computed once per transaction, so every input hashes a fixed ~200 bytes
+ * instead of the whole transaction again.
+ */
+struct PrecomputedSighash {
+    crypto::Hash256 hash_prevouts;      // SHA256d of every outpoint
+    crypto::Hash256 hash_sequence;      // SHA256d of every nSequence
+    crypto::Hash256 hash_outputs;       // SHA256d of every output
+
+    PrecomputedSighash() {}
+    explicit PrecomputedSighash(const Transaction& tx);
+};
+
+// BIP143 (segwit v0) signature hash of input `input_index`, which spends `amount`
+crypto::Hash256 segwit_signature_hash(const Transaction& tx, size_t input_index,
+                                      std::span<const unsigned char> script_code, uint64_t amount,
+                                      uint8_t hash_type, const PrecomputedSighash& precomputed);
+
+} // namespace bitcoin
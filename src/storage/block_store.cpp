@@ -0,0 +1,284 @@
+// src/storage/block_store.cpp
+#include "block_store.h"
+#include "../util/serialize.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace bitcoin {
+
+static constexpr unsigned char DB_BLOCK = 'b';      // 'b' + hash -> VARINT(file) VARINT(offset) VARINT(size)
+static constexpr unsigned char DB_FILE = 'f';       // 'f' + file (big endian) -> VARINT(bytes in use)
+
+static std::runtime_error io_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+static void write_exact(int fd, const unsigned char* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error(std::string("Write to block file failed: ") + std::strerror(errno));
+        data += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+static std::array<unsigned char, 5> file_key(uint32_t id) {
+    return {DB_FILE, (unsigned char)(id >> 24), (unsigned char)(id >> 16), (unsigned char)(id >> 8), (unsigned char)id};
+}
+
+// A read-only mapping of a whole blk file, unmapped when the last view using it goes
+struct BlockStore::Mapping {
+    const unsigned char* base = nullptr;
+    size_t length = 0;
+
+    Mapping(const unsigned char* b, size_t len) : base(b), length(len) {}
+    ~Mapping() { ::munmap(const_cast<unsigned char*>(base), length); }
+};
+
+// What read_block() hands out: the view plus the mapping its spans point into
+struct MappedBlock {
+    std::shared_ptr<const void> mapping;
+    BlockView view;
+
+    MappedBlock(std::shared_ptr<const void> m, ByteSpan bytes) : mapping(std::move(m)), view(bytes, false) {}
+};
+
+static KvStoreOptions index_options(const BlockStoreOptions& options) {
+    KvStoreOptions result;
+    result.sync_writes = options.sync_writes;
+    return result;
+}
+
+// The index's KvStore creates `dir` along with its own directory
+BlockStore::BlockStore(const std::string& dir, BlockStoreOptions opts)
+    : directory(dir), options(opts), index((std::filesystem::path(dir) / "index").string(), index_options(opts)) {
+    index.for_each([&](KvBytes key, KvBytes value) {
+        SpanReader reader(value);
+        if (key.size() == 33 && key[0] == DB_BLOCK) {
+            BlockLocation location;
+            location.file = (uint32_t)read_varint(reader);
+            location.offset = read_varint(reader);
+            location.size = (uint32_t)read_varint(reader);
+            blocks[crypto::Hash256(key.data() + 1)] = location;
+        } else if (key.size() == 5 && key[0] == DB_FILE) {
+            uint32_t id = (uint32_t)key[1] << 24 | (uint32_t)key[2] << 16 | (uint32_t)key[3] << 8 | key[4];
+            files[id].size = read_varint(reader);
+        }
+    });
+
+    // Appends continue in the newest file the index knows about
+    active_file = files.empty() ? 0 : files.rbegin()->first;
+    for (auto& [id, file] : files) {
+        open_file(id);
+        if (file.allocated < file.size) throw std::runtime_error("Block file shorter than its index: " + file_path(id));
+    }
+    open_file(active_file);
+}
+
+BlockStore::~BlockStore() {
+    // Views still alive keep their mappings; those don't need the descriptors
+    for (auto& [id, file] : files) {
+        if (file.fd >= 0) ::close(file.fd);
+    }
+}
+
+std::string BlockStore::file_path(uint32_t id) const {
+    char name[20];
+    std::snprintf(name, sizeof(name), "blk%05u.dat", id);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+BlockStore::BlockFile& BlockStore::open_file(uint32_t id) const {
+    BlockFile& file = files[id];
+    if (file.fd >= 0) return file;
+
+    std::string path = file_path(id);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) throw io_error("Cannot open", path);
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size < 0) {
+        ::close(fd);
+        throw io_error("Cannot seek", path);
+    }
+    file.fd = fd;
+    file.allocated = (uint64_t)size;
+    return file;
+}
+
+void BlockStore::allocate(uint32_t id, BlockFile& file, uint64_t needed) {
+    if (needed <= file.allocated) return;
+
+    // Whole chunks, but not past the file size limit unless one block needs it
+    uint64_t chunk = std::max<uint64_t>(options.preallocation_chunk, 1);
+    uint64_t target = (needed + chunk - 1) / chunk * chunk;
+    target = std::max(needed, std::min(target, options.max_file_size));
+
+    // posix_fallocate returns the error instead of setting errno. Filesystems
+    // without it just get a longer (sparse) file.
+    int error = ::posix_fallocate(file.fd, (off_t)file.allocated, (off_t)(target - file.allocated));
+    if (error != 0 && ::ftruncate(file.fd, (off_t)target) != 0) throw io_error("Cannot extend", file_path(id));
+    file.allocated = target;
+}
+
+void BlockStore::finalize_file(uint32_t id, BlockFile& file) {
+    // Give back the unused preallocation
+    if (file.allocated > file.size) {
+        if (::ftruncate(file.fd, (off_t)file.size) != 0) throw io_error("Cannot truncate", file_path(id));
+        file.allocated = file.size;
+    }
+    if (options.sync_writes && ::fdatasync(file.fd) != 0) throw io_error("Cannot sync", file_path(id));
+}
+
+BlockLocation BlockStore::write_block(const Block& block) {
+    SizeCounter counter;
+    block.serialize(counter);
+    std::vector<unsigned char> bytes(counter.size);
+
+    // Sized up front, so serialize straight into it
+    struct Writer {
+        unsigned char* out;
+        void write(std::span<const unsigned char> data) {
+            std::memcpy(out, data.data(), data.size());
+            out += data.size();
+        }
+    } writer{bytes.data()};
+    block.serialize(writer);
+    return write_block(block.calculate_hash(), bytes);
+}
+
+BlockLocation BlockStore::write_block(const crypto::Hash256& hash, ByteSpan bytes) {
+    if (bytes.size() > UINT32_MAX) throw std::runtime_error("Block too large to store");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto known = blocks.find(hash);
+    if (known != blocks.end()) return known->second;
+
+    uint64_t record_size = RECORD_HEADER_SIZE + bytes.size();
+    BlockFile* file = &open_file(active_file);
+    if (file->size > 0 && file->size + record_size > options.max_file_size) {
+        finalize_file(active_file, *file);
+        active_file++;
+        file = &open_file(active_file);
+        file->size = 0;     // anything already there was never indexed
+    }
+    allocate(active_file, *file, file->size + record_size);
+
+    std::vector<unsigned char> header;
+    VectorWriter header_writer(header);
+    write_le32(header_writer, MAGIC);
+    write_le32(header_writer, (uint32_t)bytes.size());
+    write_exact(file->fd, header.data(), header.size(), file->size);
+    write_exact(file->fd, bytes.data(), bytes.size(), file->size + RECORD_HEADER_SIZE);
+    if (options.sync_writes && ::fdatasync(file->fd) != 0) throw io_error("Cannot sync", file_path(active_file));
+
+    BlockLocation location;
+    location.file = active_file;
+    location.offset = file->size + RECORD_HEADER_SIZE;
+    location.size = (uint32_t)bytes.size();
+
+    // The block and the file's new size go in one batch
+    WriteBatch batch;
+    std::vector<unsigned char> value;
+    VectorWriter writer(value);
+    write_varint(writer, location.file);
+    write_varint(writer, location.offset);
+    write_varint(writer, location.size);
+    unsigned char block_key[33];
+    block_key[0] = DB_BLOCK;
+    std::copy(hash.begin(), hash.end(), block_key + 1);
+    batch.put(block_key, value);
+
+    value.clear();
+    write_varint(writer, file->size + record_size);
+    auto size_key = file_key(active_file);
+    batch.put(size_key, value);
+    index.write(batch);
+
+    file->size += record_size;
+    blocks[hash] = location;
+    return location;
+}
+
+bool BlockStore::contains(const crypto::Hash256& hash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blocks.count(hash) > 0;
+}
+
+bool BlockStore::get_location(const crypto::Hash256& hash, BlockLocation& location) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = blocks.find(hash);
+    if (it == blocks.end()) return false;
+    location = it->second;
+    return true;
+}
+
+std::shared_ptr<const BlockStore::Mapping> BlockStore::map_file(uint32_t id, BlockFile& file, uint64_t needed) const {
+    if (file.mapping && file.mapping->length >= needed) return file.mapping;
+
+    // The active file outgrew its mapping: map it again at its current length.
+    // The old mapping stays valid for the views already using it.
+    size_t length = (size_t)file.allocated;
+    void* base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, file.fd, 0);
+    if (base == MAP_FAILED) throw io_error("Cannot map", file_path(id));
+    file.mapping = std::make_shared<const Mapping>(static_cast<const unsigned char*>(base), length);
+    return file.mapping;
+}
+
+std::shared_ptr<const BlockView> BlockStore::read_block(const crypto::Hash256& hash) const {
+    BlockLocation location;
+    std::shared_ptr<const Mapping> mapping;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = blocks.find(hash);
+        if (it == blocks.end()) return nullptr;
+        location = it->second;
+        mapping = map_file(location.file, open_file(location.file), location.offset + location.size);
+    }
+
+    const unsigned char* record = mapping->base + location.offset - RECORD_HEADER_SIZE;
+    if (read_le32(record) != MAGIC || read_le32(record + 4) != location.size) {
+        throw DeserializeError("Bad block record header in " + file_path(location.file));
+    }
+
+    // Fault the whole block in with one call rather than page by page as it's
+    // parsed (older kernels: at least start reading it in)
+    static const uintptr_t page_size = (uintptr_t)::sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)record & ~(page_size - 1);
+    size_t length = (uintptr_t)(record + RECORD_HEADER_SIZE + location.size) - start;
+#ifdef MADV_POPULATE_READ
+    if (::madvise((void*)start, length, MADV_POPULATE_READ) != 0)
+#endif
+        ::madvise((void*)start, length, MADV_WILLNEED);
+
+    auto block = std::make_shared<const MappedBlock>(mapping, ByteSpan(record + RECORD_HEADER_SIZE, location.size));
+    return std::shared_ptr<const BlockView>(block, &block->view);
+}
+
+size_t BlockStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blocks.size();
+}
+
+uint64_t BlockStore::disk_usage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t total = 0;
+    for (const auto& [id, file] : files) total += file.size;
+    return total;
+}
+
+uint32_t BlockStore::file_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (uint32_t)files.size();
+}
+
+} // namespace bitcoin
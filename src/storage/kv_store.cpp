@@ -0,0 +1,341 @@
+// src/storage/kv_store.cpp
+#include "kv_store.h"
+#include "../util/serialize.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace bitcoin {
+
+static constexpr size_t RECORD_HEADER_SIZE = 8;     // payload length + CRC32
+static constexpr size_t COMPACTION_BATCH_SIZE = 4 << 20;
+
+enum : uint8_t { OP_ERASE = 0, OP_PUT = 1 };
+
+// CRC-32 (IEEE 802.3, as in zlib)
+static uint32_t crc32(KvBytes data) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    uint32_t crc = 0xffffffff;
+    for (unsigned char byte : data) crc = table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffff;
+}
+
+static std::runtime_error io_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+static void read_exact(int fd, unsigned char* out, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, out, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error("Short read from key-value log");
+        out += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+static void write_exact(int fd, const unsigned char* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pwrite(fd, data, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error(std::string("Write to key-value log failed: ") + std::strerror(errno));
+        data += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+void WriteBatch::put(KvBytes key, KvBytes value) {
+    VectorWriter writer(payload);
+    unsigned char op = OP_PUT;
+    writer.write({&op, 1});
+    write_compact_size(writer, key.size());
+    writer.write(key);
+    write_compact_size(writer, value.size());
+    writer.write(value);
+    operations++;
+}
+
+void WriteBatch::erase(KvBytes key) {
+    VectorWriter writer(payload);
+    unsigned char op = OP_ERASE;
+    writer.write({&op, 1});
+    write_compact_size(writer, key.size());
+    writer.write(key);
+    operations++;
+}
+
+KvStore::KvStore(const std::string& dir, KvStoreOptions opts) : directory(dir), options(opts) {
+    std::filesystem::create_directories(directory);
+
+    // Log files are named 00001.log, 00002.log, ... and replayed in that order
+    std::vector<uint32_t> ids;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() == 9 && name.ends_with(".log") &&
+            name.find_first_not_of("0123456789") == 5) {
+            ids.push_back((uint32_t)std::stoul(name.substr(0, 5)));
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    for (size_t i = 0; i < ids.size(); i++) {
+        open_file(ids[i]);
+        replay_file(ids[i], i + 1 == ids.size());
+    }
+    if (ids.empty()) {
+        open_file(1);
+        sync_directory();
+    }
+    active_file = files.rbegin()->first;
+}
+
+KvStore::~KvStore() {
+    for (auto& [id, file] : files) ::close(file.fd);
+}
+
+std::string KvStore::file_path(uint32_t id) const {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%05u.log", id);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+void KvStore::open_file(uint32_t id) {
+    std::string path = file_path(id);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) throw io_error("Cannot open", path);
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size < 0) {
+        ::close(fd);
+        throw io_error("Cannot seek", path);
+    }
+    files[id] = LogFile{fd, (uint64_t)size};
+}
+
+// Is there a whole record with a matching CRC anywhere from `from` on?
+// Batches are never empty, so a zero length (as in zero-filled space a crash
+// can leave behind) doesn't count.
+static bool find_valid_record(const std::vector<unsigned char>& data, uint64_t from) {
+    for (uint64_t pos = from; pos + RECORD_HEADER_SIZE < data.size(); pos++) {
+        uint32_t length = read_le32(&data[pos]);
+        if (length == 0 || data.size() - pos - RECORD_HEADER_SIZE < length) continue;
+        if (crc32(KvBytes(&data[pos + RECORD_HEADER_SIZE], length)) == read_le32(&data[pos + 4])) return true;
+    }
+    return false;
+}
+
+void KvStore::replay_file(uint32_t id, bool newest) {
+    LogFile& file = files[id];
+    std::vector<unsigned char> data(file.size);
+    if (!data.empty()) read_exact(file.fd, data.data(), data.size(), 0);
+
+    uint64_t pos = 0;
+    while (pos < data.size()) {
+        bool complete = data.size() - pos >= RECORD_HEADER_SIZE;
+        uint32_t length = complete ? read_le32(&data[pos]) : 0;
+        complete = complete && data.size() - pos - RECORD_HEADER_SIZE >= length;
+        KvBytes payload = complete ? KvBytes(&data[pos + RECORD_HEADER_SIZE], length) : KvBytes();
+        bool valid = complete && crc32(payload) == read_le32(&data[pos + 4]);
+
+        if (!valid) {
+            // Only the end of the newest file may be torn by a crash. A bad
+            // length can't tell a torn tail from a damaged record in the
+            // middle, but a good record somewhere after it can.
+            if (!newest || find_valid_record(data, pos + 1)) {
+                throw std::runtime_error("Corrupt record in " + file_path(id));
+            }
+            if (::ftruncate(file.fd, (off_t)pos) != 0) throw io_error("Cannot truncate", file_path(id));
+            file.size = pos;
+            return;
+        }
+
+        apply_payload(id, pos + RECORD_HEADER_SIZE, payload);
+        pos += RECORD_HEADER_SIZE + length;
+    }
+}
+
+void KvStore::apply_payload(uint32_t file, uint64_t payload_offset, KvBytes payload) {
+    SpanReader reader(payload);
+    while (!reader.empty()) {
+        uint8_t op = read_u8(reader);
+        KvBytes key_bytes = read_var_bytes(reader);
+        std::string key(reinterpret_cast<const char*>(key_bytes.data()), key_bytes.size());
+
+        auto it = keydir.find(key);
+        if (it != keydir.end()) {
+            live -= key.size() + it->second.size;
+        }
+
+        if (op == OP_PUT) {
+            uint64_t size = read_compact_size(reader);
+            Location location{file, (uint32_t)size, payload_offset + reader.position()};
+            reader.read(size);
+            live += key.size() + size;
+            if (it != keydir.end()) {
+                it->second = location;
+            } else {
+                keydir.emplace(std::move(key), location);
+            }
+        } else if (op == OP_ERASE) {
+            if (it != keydir.end()) keydir.erase(it);
+        } else {
+            throw DeserializeError("Unknown key-value operation");
+        }
+    }
+}
+
+void KvStore::append_record(const std::vector<unsigned char>& payload) {
+    std::vector<unsigned char> record(RECORD_HEADER_SIZE);
+    uint32_t length = (uint32_t)payload.size();
+    uint32_t checksum = crc32(payload);
+    for (int i = 0; i < 4; i++) {
+        record[i] = (unsigned char)(length >> (8 * i));
+        record[4 + i] = (unsigned char)(checksum >> (8 * i));
+    }
+    record.insert(record.end(), payload.begin(), payload.end());
+
+    if (files[active_file].size > 0 && files[active_file].size + record.size() > options.max_file_size) {
+        active_file++;
+        open_file(active_file);
+        sync_directory();
+    }
+
+    LogFile& file = files[active_file];
+    try {
+        write_exact(file.fd, record.data(), record.size(), file.size);
+    } catch (...) {
+        // Don't leave a torn record for later records to land behind. If even
+        // this fails, the next replay still cuts the torn tail off.
+        int ignored = ::ftruncate(file.fd, (off_t)file.size);
+        (void)ignored;
+        throw;
+    }
+    uint64_t payload_offset = file.size + RECORD_HEADER_SIZE;
+    file.size += record.size();
+    apply_payload(active_file, payload_offset, payload);
+}
+
+void KvStore::write(const WriteBatch& batch) {
+    if (batch.empty()) return;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+
+    append_record(batch.payload);
+    if (options.sync_writes && ::fdatasync(files[active_file].fd) != 0) {
+        throw io_error("Cannot sync", file_path(active_file));
+    }
+    if (needs_compaction()) compact_locked();
+}
+
+bool KvStore::get(KvBytes key, std::vector<unsigned char>& value) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = keydir.find(std::string(reinterpret_cast<const char*>(key.data()), key.size()));
+    if (it == keydir.end()) return false;
+    value.resize(it->second.size);
+    if (!value.empty()) read_exact(files.at(it->second.file).fd, value.data(), value.size(), it->second.offset);
+    return true;
+}
+
+bool KvStore::contains(KvBytes key) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return keydir.count(std::string(reinterpret_cast<const char*>(key.data()), key.size())) > 0;
+}
+
+void KvStore::for_each(const std::function<void(KvBytes key, KvBytes value)>& visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<unsigned char> value;
+    for (const auto& [key, location] : keydir) {
+        value.resize(location.size);
+        if (!value.empty()) read_exact(files.at(location.file).fd, value.data(), value.size(), location.offset);
+        visit(KvBytes(reinterpret_cast<const unsigned char*>(key.data()), key.size()), value);
+    }
+}
+
+void KvStore::compact() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    compact_locked();
+}
+
+bool KvStore::needs_compaction() const {
+    uint64_t disk = 0;
+    for (const auto& [id, file] : files) disk += file.size;
+    return disk >= options.min_compact_size && (double)(disk - live) > disk * options.compact_garbage_ratio;
+}
+
+void KvStore::compact_locked() {
+    // Copy every live value into fresh files, then drop the old ones. Until the
+    // old files are gone a crash just replays the copies on top of them.
+    uint32_t first_new = active_file + 1;
+    active_file = first_new;
+    open_file(active_file);
+
+    WriteBatch batch;
+    std::vector<unsigned char> value;
+    for (auto& [key, location] : keydir) {
+        value.resize(location.size);
+        if (!value.empty()) read_exact(files.at(location.file).fd, value.data(), value.size(), location.offset);
+        batch.put(KvBytes(reinterpret_cast<const unsigned char*>(key.data()), key.size()), value);
+        // Only existing entries are updated below, so this iteration stays valid
+        if (batch.size_in_bytes() >= COMPACTION_BATCH_SIZE) {
+            append_record(batch.payload);
+            batch.clear();
+        }
+    }
+    if (!batch.empty()) append_record(batch.payload);
+
+    for (auto it = files.lower_bound(first_new); it != files.end(); ++it) {
+        if (::fdatasync(it->second.fd) != 0) throw io_error("Cannot sync", file_path(it->first));
+    }
+    sync_directory();
+
+    // Oldest first: a file may hold deletes for keys written in an older one
+    while (files.begin()->first < first_new) {
+        auto it = files.begin();
+        ::close(it->second.fd);
+        std::filesystem::remove(file_path(it->first));
+        files.erase(it);
+    }
+    sync_directory();
+}
+
+void KvStore::sync_directory() const {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw io_error("Cannot open", directory);
+    ::fsync(fd);
+    ::close(fd);
+}
+
+size_t KvStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return keydir.size();
+}
+
+uint64_t KvStore::disk_usage() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    uint64_t total = 0;
+    for (const auto& [id, file] : files) total += file.size;
+    return total;
+}
+
+uint64_t KvStore::live_bytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return live;
+}
+
+} // namespace bitcoin
@@ -0,0 +1,115 @@
+// src/storage/kv_store.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bitcoin {
+
+using KvBytes = std::span<const unsigned char>;
+
+// Puts and deletes applied together by KvStore::write()
+class WriteBatch {
+private:
+    std::vector<unsigned char> payload;     // operations, already in on-disk form
+    size_t operations = 0;
+
+    friend class KvStore;
+
+public:
+    void put(KvBytes key, KvBytes value);
+    void erase(KvBytes key);
+
+    size_t count() const { return operations; }
+    size_t size_in_bytes() const { return payload.size(); }
+    bool empty() const { return operations == 0; }
+    void clear() { payload.clear(); operations = 0; }
+};
+
+struct KvStoreOptions {
+    size_t max_file_size = 64 << 20;        // start a new log file past this
+    bool sync_writes = true;                // fdatasync every batch
+    // Rewrite the live data once garbage passes this share of the disk usage
+    // (and the store is at least min_compact_size)
+    double compact_garbage_ratio = 0.5;
+    size_t min_compact_size = 64 << 20;
+};
+
+/**
+ * Embedded log-structured key-value store (Bitcask style)
+ *
+ * Every write() appends one record - length, CRC32, then all of the batch's
+ * operations - to the active log file, so a batch is on disk completely or
+ * not at all. An in-memory "keydir" maps each live key to where its value
+ * sits, so a read is one hash lookup plus one pread.
+ *
+ * Opening a directory replays its log files in order. A torn record at the
+ * end of the newest file (a crash mid-write) is cut off; corruption anywhere
+ * else throws, including a bad record with a good one after it.
+ * Overwritten and deleted values are garbage until compact() copies the
+ * live values into a fresh file and drops the old ones.
+ *
+ * Reads may run concurrently with each other; writes are serialized.
+ */
+class KvStore {
+public:
+    explicit KvStore(const std::string& directory, KvStoreOptions options = KvStoreOptions());
+    ~KvStore();
+
+    KvStore(const KvStore&) = delete;
+    KvStore& operator=(const KvStore&) = delete;
+
+    // Copy the value of `key` into `value`; false if absent
+    bool get(KvBytes key, std::vector<unsigned char>& value) const;
+    bool contains(KvBytes key) const;
+
+    // Apply the batch atomically (throws std::runtime_error on I/O failure)
+    void write(const WriteBatch& batch);
+
+    // Visit every live key/value (order unspecified)
+    void for_each(const std::function<void(KvBytes key, KvBytes value)>& visit) const;
+
+    void compact();
+
+    size_t size() const;                // live keys
+    uint64_t disk_usage() const;        // bytes in all log files
+    uint64_t live_bytes() const;        // bytes of live records
+
+private:
+    struct Location {
+        uint32_t file;
+        uint32_t size;
+        uint64_t offset;
+    };
+
+    struct LogFile {
+        int fd = -1;
+        uint64_t size = 0;
+    };
+
+    std::string directory;
+    KvStoreOptions options;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Location> keydir;
+    std::map<uint32_t, LogFile> files;
+    uint32_t active_file = 0;
+    uint64_t live = 0;
+
+    std::string file_path(uint32_t id) const;
+    void open_file(uint32_t id);
+    void replay_file(uint32_t id, bool newest);
+    void apply_payload(uint32_t file, uint64_t payload_offset, KvBytes payload);
+    void append_record(const std::vector<unsigned char>& payload);
+    void sync_directory() const;
+    void compact_locked();
+    bool needs_compaction() const;
+};
+
+} // namespace bitcoin
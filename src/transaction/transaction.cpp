@@ -1,57 +1,110 @@
 // src/transaction/transaction.cpp
 #include "transaction.h"
-#include "../crypto/hash.h"
+#include "../coins/coins.h"
+#include "../crypto/sha256.h"
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 
 namespace bitcoin {
 
 void TransactionInput::print() const {
     std::cout << "  Input:" << std::endl;
-    std::cout << "      Previous TXID:  " << previous_txid << std::endl;
+    std::cout << "      Previous TXID:  " << previous_txid.to_hex() << std::endl;
     std::cout << "      Output Index:   " << vout << std::endl;
     std::cout << "      Script Sig      " << script_sig << std::endl;
     std::cout << "      Sequence:       " << sequence  << std::endl;
+    if (!witness.empty()) {
+        std::cout << "      Witness Items:  " << witness.size() << std::endl;
+    }
 }
 
 void TransactionOutput::print() const {
     std::cout << "  Output:" << std::endl;
     std::cout << "      Value:         " << value << " satoshis ("
               << std::fixed << std::setprecision(8) << get_btc_amount() << " BTC" << std::endl;
-    std::cout << "      Script Pubkey: " << script_pubkey << std::endl;
+    std::cout << "      Script Pubkey: " << script_pubkey.to_hex() << " ("
+              << script_type_name(classify_script(script_pubkey)) << ")" << std::endl;
 }
 
-std::string Transaction::calculate_txid() const {
-    // In real Bitcoin, this would serialize the entire transaction
-    // and double SHA256 it. For simplicity, we'll create a representative hash
+// Serialize straight into the hasher and double SHA256 it
+template <typename Tx>
+static crypto::Hash256 hash_transaction(const Tx& tx, bool include_witness) {
+    crypto::Sha256Writer hasher;
+    tx.serialize(hasher, include_witness);
+    return hasher.finalize_double();
+}
 
-    std::stringstream tx_data;
-    tx_data << version;
+TransactionBuilder::TransactionBuilder(const Transaction& tx)
+    : version(tx.version), inputs(tx.inputs), outputs(tx.outputs), locktime(tx.locktime),
+      txid(tx.get_txid()) {}
 
-    // Add all inputs
-    for (const auto& input : inputs) {
-        tx_data << input.previous_txid << input.vout << input.script_sig << input.sequence;
-    }
+const crypto::Hash256& TransactionBuilder::get_txid() const {
+    if (!txid) txid = hash_transaction(*this, false);
+    return *txid;
+}
 
-    // Add all outputs
-    for (const auto& output : outputs) {
-        tx_data << output.value << output.script_pubkey;
-    }
+TransactionRef TransactionBuilder::build() const& {
+    return std::make_shared<const Transaction>(*this);
+}
 
-    tx_data << locktime;
+TransactionRef TransactionBuilder::build() && {
+    return std::make_shared<const Transaction>(std::move(*this));
+}
+
+Transaction::Transaction(const TransactionBuilder& builder)
+    : version(builder.version), inputs(builder.inputs), outputs(builder.outputs), locktime(builder.locktime) {
+    // Reuse a txid the builder already paid for
+    if (builder.txid) std::call_once(txid_once, [&] { txid = *builder.txid; });
+}
+
+Transaction::Transaction(TransactionBuilder&& builder)
+    : version(builder.version), inputs(std::move(builder.inputs)), outputs(std::move(builder.outputs)),
+      locktime(builder.locktime) {
+    if (builder.txid) std::call_once(txid_once, [&] { txid = *builder.txid; });
+    builder.txid.reset();
+}
 
-    // Calculate double SAH256
-    std::string data = tx_data.str();
-    txid = crypto::Hash::double_sha256(data);
+const crypto::Hash256& Transaction::get_txid() const {
+    std::call_once(txid_once, [this] { txid = hash_transaction(*this, false); });
     return txid;
 }
 
-uint64_t Transaction::get_total_input_value() const {
-    // Note: In real Bitcoin, you'd need to look up the previous transactions
-    // to know the input values. For demo purposes, we'll estimate.
+const crypto::Hash256& Transaction::get_wtxid() const {
+    if (!has_witness()) return get_txid();
+    std::call_once(wtxid_once, [this] { wtxid = hash_transaction(*this, true); });
+    return wtxid;
+}
+
+size_t Transaction::get_serialized_size(bool include_witness) const {
+    SizeCounter counter;
+    serialize(counter, include_witness);
+    return counter.size;
+}
+
+size_t Transaction::get_weight() const {
+    return get_serialized_size(false) * (WITNESS_SCALE_FACTOR - 1) + get_serialized_size(true);
+}
+
+bool Transaction::have_inputs(const CoinsView& view) const {
+    if (is_coinbase()) return true;
+    for (const auto& input : inputs) {
+        if (!view.have_coin(OutPoint(input))) return false;
+    }
+    return true;
+}
+
+uint64_t Transaction::get_total_input_value(const CoinsView& view) const {
+    // Inputs only name the output they spend - the amount lives in the UTXO set
+    if (is_coinbase()) return 0;
     uint64_t total = 0;
-    // This is simplified - real implementation would look up previous outputs
+    Coin coin;
+    for (const auto& input : inputs) {
+        if (!view.get_coin(OutPoint(input), coin)) {
+            throw std::runtime_error("Missing input " + input.previous_txid.to_hex() + ":" +
+                                     std::to_string(input.vout));
+        }
+        total += coin.out.value;
+    }
     return total;
 }
 
@@ -63,10 +116,22 @@ uint64_t Transaction::get_total_output_value() const {
     return total;
 }
 
-uint64_t Transaction::get_fee() const {
-    // Fee = Total INputs - Total Outputs
-    // For now, return 0 since we can't easaily calculate input values
-    return 0;
+bool Transaction::get_output_value_checked(uint64_t& total) const {
+    total = 0;
+    for (const auto& output : outputs) {
+        if (!money_range(output.value)) return false;
+        total += output.value;
+        if (!money_range(total)) return false;
+    }
+    return true;
+}
+
+uint64_t Transaction::get_fee(const CoinsView& view) const {
+    // Fee = Total Inputs - Total Outputs (coinbase pays no fee)
+    if (is_coinbase()) return 0;
+    uint64_t input_value = get_total_input_value(view);
+    uint64_t output_value = get_total_output_value();
+    return input_value > output_value ? input_value - output_value : 0;
 }
 
 bool Transaction::is_coinbase() const {
@@ -74,13 +139,16 @@ bool Transaction::is_coinbase() const {
     // - previous_txid of all zeros
     // - vout of 0xFFFFFFFF
     return inputs.size() == 1 &&
-        inputs[0].previous_txid == std::string(64, '0') &&
+        inputs[0].previous_txid.is_null() &&
         inputs[0].vout == 0xFFFFFFFF;
 }
 
 void Transaction::print() const {
     std::cout << "Transaction:" << std::endl;
-    std::cout << "  TXID:       " << (txid.empty() ? calculate_txid() : txid) << std::endl;
+    std::cout << "  TXID:       " << get_txid().to_hex() << std::endl;
+    if (has_witness()) {
+        std::cout << "  WTXID:      " << get_wtxid().to_hex() << std::endl;
+    }
     std::cout << "  Version:    " << version << std::endl;
     std::cout << "  Locktime:   " << locktime << std::endl;
     std::cout << "  Inputs (" << inputs.size() << "):" << std::endl;
@@ -1,8 +1,14 @@
 // src/transaction/transaction.h
 #pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
-#include <cstdint>
+#include "../crypto/uint256.h"
+#include "../script/script.h"
+#include "../util/serialize.h"
 
 namespace bitcoin
 {
@@ -16,14 +22,15 @@ namespace bitcoin
 
 class TransactionInput {
 public:
-    std::string previous_txid;      // Hash of the previous transaction (64 hex chars)
+    crypto::Hash256 previous_txid;  // Hash of the previous transaction
     uint32_t vout;                  // Index of output in previous transaciton
     std::string script_sig;         // Unlocking script (signature + public key)
     uint32_t sequence;              // Sequence number (for locktime/RBF)
+    std::vector<std::string> witness; // Segwit witness stack (empty for legacy inputs)
 
     TransactionInput() : vout(0), sequence(0xFFFFFFFF) {}
 
-    TransactionInput(const std::string& prev_txid, uint32_t output_index,
+    TransactionInput(const crypto::Hash256& prev_txid, uint32_t output_index,
                     const std::string& signature_script)
         : previous_txid(prev_txid), vout(output_index),
         script_sig(signature_script), sequence(0xFFFFFFFF) {}
@@ -35,12 +42,12 @@ public:
 class TransactionOutput {
 public: 
     uint64_t value;                 // Amount in satoshis (1 BTC = 100,000,000 satoshis)
-    std::string script_pubkey;      // Locking script (how to spend this output)
+    Script script_pubkey;           // Locking script (how to spend this output), inline up to 34 bytes
 
     TransactionOutput() : value(0) {}
 
-    TransactionOutput(uint64_t amount, const std::string& locking_script)
-        : value(amount), script_pubkey(locking_script) {}
+    TransactionOutput(uint64_t amount, Script locking_script)
+        : value(amount), script_pubkey(std::move(locking_script)) {}
 
     // Convert satoshis to BTC for display
     double get_btc_amount() const { return (double)value / 1000000000.0; }
@@ -49,36 +56,195 @@ public:
     void print() const;
 };
 
+// Witness weight factor (BIP141): weight = base size * 3 + total size
+static constexpr size_t WITNESS_SCALE_FACTOR = 4;
+static constexpr size_t MAX_BLOCK_WEIGHT = 4000000;
+static constexpr uint64_t MAX_BLOCK_SIGOPS_COST = 80000;   // legacy sigops count 4, witness ones 1
+
+// Amounts, in satoshis. No single value or sum of values may exceed
+// MAX_MONEY, which also keeps sums far away from wrapping around.
+static constexpr uint64_t COIN = 100000000;
+static constexpr uint64_t MAX_MONEY = 21000000 * COIN;
+inline bool money_range(uint64_t value) { return value <= MAX_MONEY; }
+
+inline bool inputs_have_witness(const std::vector<TransactionInput>& inputs) {
+    for (const auto& input : inputs) {
+        if (!input.witness.empty()) return true;
+    }
+    return false;
+}
+
+// Wire format, shared by Transaction and TransactionBuilder. With witness data
+// (BIP144) a 0x00 marker and 0x01 flag follow the version, and each input's
+// witness stack goes before the locktime. The txid always hashes the form
+// without witness.
+template <typename Stream>
+void serialize_transaction(Stream& s, uint32_t version, const std::vector<TransactionInput>& inputs,
+                           const std::vector<TransactionOutput>& outputs, uint32_t locktime,
+                           bool include_witness) {
+    bool witness = include_witness && inputs_have_witness(inputs);
+
+    write_le32(s, version);
+    if (witness) {
+        unsigned char marker_flag[2] = {0x00, 0x01};
+        s.write(marker_flag);
+    }
+
+    write_compact_size(s, inputs.size());
+    for (const auto& input : inputs) {
+        write_bytes(s, input.previous_txid.data(), input.previous_txid.size());
+        write_le32(s, input.vout);
+        write_compact_size(s, input.script_sig.size());
+        write_bytes(s, input.script_sig.data(), input.script_sig.size());
+        write_le32(s, input.sequence);
+    }
+
+    write_compact_size(s, outputs.size());
+    for (const auto& output : outputs) {
+        write_le64(s, output.value);
+        write_compact_size(s, output.script_pubkey.size());
+        write_bytes(s, output.script_pubkey.data(), output.script_pubkey.size());
+    }
+
+    if (witness) {
+        for (const auto& input : inputs) {
+            write_compact_size(s, input.witness.size());
+            for (const auto& item : input.witness) {
+                write_compact_size(s, item.size());
+                write_bytes(s, item.data(), item.size());
+            }
+        }
+    }
+
+    write_le32(s, locktime);
+}
+
+class Transaction;
+class CoinsView;
+
+// Shared, read-only handle - blocks, the mempool and relay all point at one copy
+using TransactionRef = std::shared_ptr<const Transaction>;
+
+/**
+ * Mutable transaction under construction
+ *
+ * Every change goes through a setter, which drops the cached txid, so
+ * get_txid() hashes at most once per round of edits. build() freezes the
+ * result into a shared Transaction, moving the vectors when called on an
+ * rvalue: `TransactionRef tx = std::move(builder).build();`
+ */
+class TransactionBuilder {
+private:
+    uint32_t version = 1;
+    std::vector<TransactionInput> inputs;
+    std::vector<TransactionOutput> outputs;
+    uint32_t locktime = 0;
+
+    mutable std::optional<crypto::Hash256> txid;   // reset by every mutation
+
+    friend class Transaction;
+
+public:
+    TransactionBuilder() {}
+
+    // Start from an existing transaction (e.g. to re-sign or bump a coinbase)
+    explicit TransactionBuilder(const Transaction& tx);
+
+    TransactionBuilder& set_version(uint32_t value) { txid.reset(); version = value; return *this; }
+    TransactionBuilder& set_locktime(uint32_t value) { txid.reset(); locktime = value; return *this; }
+    TransactionBuilder& add_input(const TransactionInput& input) { txid.reset(); inputs.push_back(input); return *this; }
+    TransactionBuilder& add_output(const TransactionOutput& output) { txid.reset(); outputs.push_back(output); return *this; }
+
+    // In-place edits. The cache is dropped when the reference is handed out,
+    // so don't hold on to it across a get_txid() call.
+    TransactionInput& mutable_input(size_t index) { txid.reset(); return inputs.at(index); }
+    TransactionOutput& mutable_output(size_t index) { txid.reset(); return outputs.at(index); }
+
+    uint32_t get_version() const { return version; }
+    uint32_t get_locktime() const { return locktime; }
+    const std::vector<TransactionInput>& get_inputs() const { return inputs; }
+    const std::vector<TransactionOutput>& get_outputs() const { return outputs; }
+
+    // Hashed on first use, cached until the next mutation
+    const crypto::Hash256& get_txid() const;
+
+    template <typename Stream>
+    void serialize(Stream& s, bool include_witness = true) const {
+        serialize_transaction(s, version, inputs, outputs, locktime, include_witness);
+    }
+
+    TransactionRef build() const&;
+    TransactionRef build() &&;
+};
+
+/**
+ * Finished transaction - immutable once built
+ *
+ * Nothing can change after construction, so the txid is hashed on first use
+ * and then cached for the lifetime of the object (thread-safe, since one
+ * instance is shared through TransactionRef).
+ */
 class Transaction {
 public:
-    uint32_t version;                           // Transaction version (usually 1 or 2)
-    std::vector<TransactionInput> inputs;       // Transaction inputs (what were spending)
-    std::vector<TransactionOutput> outputs;     // Transaction outputs (where money goes)
-    uint32_t locktime;                          // Transaction locktime (0 = can be mined immediately)
+    const uint32_t version;                           // Transaction version (usually 1 or 2)
+    const std::vector<TransactionInput> inputs;       // Transaction inputs (what were spending)
+    const std::vector<TransactionOutput> outputs;     // Transaction outputs (where money goes)
+    const uint32_t locktime;                          // Transaction locktime (0 = can be mined immediately)
+
+    explicit Transaction(const TransactionBuilder& builder);
+    explicit Transaction(TransactionBuilder&& builder);
+
+    // Share it through TransactionRef instead of copying
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
 
-    // Calculated fields
-    mutable std::string txid;                   // Transaction ID (double SHA256 of transaction)
+    // Transaction ID (double SHA256 of the serialization without witness)
+    const crypto::Hash256& get_txid() const;
 
-    Transaction() : version(1), locktime(0) {}
+    // Witness transaction ID (includes witness data; equals the txid without it)
+    const crypto::Hash256& get_wtxid() const;
 
-    // Calculate transaction ID (hash of the transaction)
-    std::string calculate_txid() const;
+    bool has_witness() const { return inputs_have_witness(inputs); }
 
-    // Get total input value
-    uint64_t get_total_input_value() const;
+    // Write the transaction in Bitcoin's raw format
+    template <typename Stream>
+    void serialize(Stream& s, bool include_witness = true) const {
+        serialize_transaction(s, version, inputs, outputs, locktime, include_witness);
+    }
+
+    size_t get_serialized_size(bool include_witness = true) const;
+
+    // BIP141 weight (block limit is 4,000,000)
+    size_t get_weight() const;
+
+    // Are all spent outputs in `view`? (always true for a coinbase)
+    bool have_inputs(const CoinsView& view) const;
+
+    // Sum of the outputs being spent, looked up in `view`
+    // (throws std::runtime_error if one is missing; 0 for a coinbase)
+    uint64_t get_total_input_value(const CoinsView& view) const;
 
     // Get total output value
     uint64_t get_total_output_value() const;
 
-    // Get transaction fee (input - output)
-    uint64_t get_fee() const;
+    // Sum of the outputs into `total`; false if an output or the running sum
+    // is above MAX_MONEY (CVE-2010-5139)
+    bool get_output_value_checked(uint64_t& total) const;
+
+    // Get transaction fee (input - output, looked up in `view`)
+    uint64_t get_fee(const CoinsView& view) const;
 
     // Check if this is a coinbase transaction (mining reward)
     bool is_coinbase() const;
 
     // For debugging 
     void print() const;
+
+private:
+    mutable std::once_flag txid_once;
+    mutable crypto::Hash256 txid;
+    mutable std::once_flag wtxid_once;
+    mutable crypto::Hash256 wtxid;
 };
 
 } // namespace bitcoin
-
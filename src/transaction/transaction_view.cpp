@@ -0,0 +1,143 @@
+// src/transaction/transaction_view.cpp
+#include "transaction_view.h"
+#include "../crypto/sha256.h"
+
+namespace bitcoin {
+
+// Smallest possible serialized input / output, used to sanity check counts
+// before reserving memory for them
+static constexpr size_t MIN_INPUT_SIZE = 32 + 4 + 1 + 4;
+static constexpr size_t MIN_OUTPUT_SIZE = 8 + 1;
+
+TransactionView::TransactionView(std::pmr::memory_resource* resource)
+    : inputs(resource), outputs(resource), witness_items(resource) {}
+
+static void reserve_checked(auto& vector, uint64_t count, const SpanReader& reader, size_t min_size) {
+    if (count > reader.remaining() / min_size) throw DeserializeError("Count exceeds remaining data");
+    vector.reserve(count);
+}
+
+static void parse_inputs(SpanReader& reader, uint64_t count, std::pmr::vector<InputView>& inputs) {
+    reserve_checked(inputs, count, reader, MIN_INPUT_SIZE);
+    for (uint64_t i = 0; i < count; i++) {
+        InputView input;
+        input.previous_txid = reader.read(32);
+        input.vout = read_le32(reader);
+        input.script_sig = read_var_bytes(reader);
+        input.sequence = read_le32(reader);
+        input.witness_begin = 0;
+        input.witness_count = 0;
+        inputs.push_back(input);
+    }
+}
+
+static void parse_outputs(SpanReader& reader, std::pmr::vector<OutputView>& outputs) {
+    uint64_t count = read_compact_size(reader);
+    reserve_checked(outputs, count, reader, MIN_OUTPUT_SIZE);
+    for (uint64_t i = 0; i < count; i++) {
+        OutputView output;
+        output.value = read_le64(reader);
+        output.script_pubkey = read_var_bytes(reader);
+        outputs.push_back(output);
+    }
+}
+
+void TransactionView::parse(SpanReader& reader) {
+    inputs.clear();
+    outputs.clear();
+    witness_items.clear();
+
+    size_t start = reader.position();
+    version = read_le32(reader);
+
+    // An empty input list followed by flag 0x01 marks the segwit format (BIP144)
+    size_t body_start = reader.position();
+    uint64_t input_count = read_compact_size(reader);
+    uint8_t flags = 0;
+    if (input_count == 0) {
+        flags = read_u8(reader);
+        if (flags != 0) {
+            body_start = reader.position();
+            input_count = read_compact_size(reader);
+            parse_inputs(reader, input_count, inputs);
+            parse_outputs(reader, outputs);
+        }
+        // flags == 0: that byte was the (empty) output count
+    } else {
+        parse_inputs(reader, input_count, inputs);
+        parse_outputs(reader, outputs);
+    }
+    body = reader.since(body_start);
+
+    if (flags & 1) {
+        flags ^= 1;
+        for (InputView& input : inputs) {
+            uint64_t items = read_compact_size(reader);
+            input.witness_begin = (uint32_t)witness_items.size();
+            input.witness_count = (uint32_t)items;
+            for (uint64_t j = 0; j < items; j++) {
+                witness_items.push_back(read_var_bytes(reader));
+            }
+        }
+        if (witness_items.empty()) throw DeserializeError("Superfluous witness record");
+    }
+    if (flags) throw DeserializeError("Unknown transaction optional data");
+
+    locktime = read_le32(reader);
+    raw = reader.since(start);
+}
+
+crypto::Hash256 TransactionView::compute_txid() const {
+    if (!has_witness()) return compute_wtxid();
+
+    // version || inputs and outputs || locktime - skipping marker, flag and witness
+    crypto::Sha256Writer hasher;
+    hasher.update(raw.first(4));
+    hasher.update(body);
+    hasher.update(raw.last(4));
+    return hasher.finalize_double();
+}
+
+crypto::Hash256 TransactionView::compute_wtxid() const {
+    crypto::Sha256Writer hasher;
+    hasher.update(raw);
+    return hasher.finalize_double();
+}
+
+static std::string to_string(ByteSpan bytes) {
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+TransactionRef TransactionView::to_transaction() const {
+    TransactionBuilder builder;
+    builder.set_version(version);
+    builder.set_locktime(locktime);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        TransactionInput input(inputs[i].get_previous_txid(), inputs[i].vout, to_string(inputs[i].script_sig));
+        input.sequence = inputs[i].sequence;
+        for (ByteSpan item : witness(i)) {
+            input.witness.push_back(to_string(item));
+        }
+        builder.add_input(input);
+    }
+    for (const OutputView& output : outputs) {
+        builder.add_output(TransactionOutput(output.value, Script(output.script_pubkey)));
+    }
+    return std::move(builder).build();
+}
+
+TransactionRef deserialize_transaction(ByteSpan bytes) {
+    SpanReader reader(bytes);
+    TransactionView view;
+    view.parse(reader);
+    if (!reader.empty()) throw DeserializeError("Trailing data after transaction");
+    return view.to_transaction();
+}
+
+void serialize_transaction(const Transaction& tx, std::vector<unsigned char>& out, bool include_witness) {
+    out.clear();
+    VectorWriter writer(out);
+    tx.serialize(writer, include_witness);
+}
+
+} // namespace bitcoin
@@ -0,0 +1,78 @@
+// src/transaction/transaction_view.h
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include "transaction.h"
+
+namespace bitcoin {
+
+using ByteSpan = std::span<const unsigned char>;
+
+struct InputView {
+    ByteSpan previous_txid;         // 32 bytes
+    uint32_t vout;
+    ByteSpan script_sig;
+    uint32_t sequence;
+    uint32_t witness_begin;         // first item in TransactionView::witness_items
+    uint32_t witness_count;
+
+    crypto::Hash256 get_previous_txid() const { return crypto::Hash256(previous_txid.data()); }
+};
+
+struct OutputView {
+    uint64_t value;
+    ByteSpan script_pubkey;
+};
+
+/**
+ * Zero-copy transaction parser
+ *
+ * Scripts, witness items and prevout hashes are spans into the buffer that
+ * was parsed, so the buffer must outlive the view. Apart from the inputs,
+ * outputs and witness item arrays (which come from `resource`) nothing is
+ * allocated, and a view can be reused for the next transaction without
+ * giving that memory back.
+ */
+class TransactionView {
+public:
+    uint32_t version = 0;
+    std::pmr::vector<InputView> inputs;
+    std::pmr::vector<OutputView> outputs;
+    std::pmr::vector<ByteSpan> witness_items;   // every input's stack, back to back
+    uint32_t locktime = 0;
+
+    ByteSpan raw;                   // the whole serialized transaction
+
+    explicit TransactionView(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Parse one transaction at the reader's position (throws DeserializeError)
+    void parse(SpanReader& reader);
+
+    bool has_witness() const { return !witness_items.empty(); }
+
+    // Witness stack of input `index`
+    std::span<const ByteSpan> witness(size_t index) const {
+        return std::span<const ByteSpan>(witness_items).subspan(inputs[index].witness_begin,
+                                                                  inputs[index].witness_count);
+    }
+
+    // Hashed straight from the source bytes
+    crypto::Hash256 compute_txid() const;
+    crypto::Hash256 compute_wtxid() const;
+
+    // Copy into an owning, shareable Transaction
+    TransactionRef to_transaction() const;
+
+private:
+    ByteSpan body;                  // input count .. end of outputs (what the txid covers)
+};
+
+// Decode exactly one transaction from `bytes` (throws DeserializeError)
+TransactionRef deserialize_transaction(ByteSpan bytes);
+
+// Encode into `out`, replacing its contents but keeping its capacity
+void serialize_transaction(const Transaction& tx, std::vector<unsigned char>& out, bool include_witness = true);
+
+} // namespace bitcoin
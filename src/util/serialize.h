@@ -0,0 +1,189 @@
+// src/util/serialize.h
+#pragma once
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace bitcoin {
+
+/**
+ * Bitcoin wire-format primitives
+ *
+ * A "stream" is anything with `void write(std::span<const unsigned char>)` -
+ * a hasher (crypto::Sha256Writer) or a byte buffer. All integers are little
+ * endian, like the real network protocol.
+ *
+ * Reading goes through SpanReader, which hands out spans into the source
+ * buffer instead of copying. Malformed input throws DeserializeError.
+ */
+
+// Largest length or count we accept from the wire (same limit as Bitcoin Core)
+static constexpr uint64_t MAX_SERIALIZED_SIZE = 0x02000000;
+
+class DeserializeError : public std::runtime_error {
+public:
+    explicit DeserializeError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Appends to a caller-owned buffer, so one allocation is reused across writes
+class VectorWriter {
+private:
+    std::vector<unsigned char>& buffer;
+
+public:
+    explicit VectorWriter(std::vector<unsigned char>& out) : buffer(out) {}
+
+    void write(std::span<const unsigned char> data) { buffer.insert(buffer.end(), data.begin(), data.end()); }
+};
+
+// Counts bytes instead of writing them (serialized sizes, weight)
+class SizeCounter {
+public:
+    size_t size = 0;
+
+    void write(std::span<const unsigned char> data) { size += data.size(); }
+};
+
+// Cursor over a byte span. Reads return views into the span - nothing is copied.
+class SpanReader {
+private:
+    std::span<const unsigned char> data;
+    size_t pos = 0;
+
+public:
+    explicit SpanReader(std::span<const unsigned char> bytes) : data(bytes) {}
+
+    size_t position() const { return pos; }
+    size_t remaining() const { return data.size() - pos; }
+    bool empty() const { return pos == data.size(); }
+
+    // Bytes from `from` up to the current position
+    std::span<const unsigned char> since(size_t from) const { return data.subspan(from, pos - from); }
+
+    std::span<const unsigned char> read(size_t len) {
+        if (len > remaining()) throw DeserializeError("Unexpected end of data");
+        std::span<const unsigned char> result = data.subspan(pos, len);
+        pos += len;
+        return result;
+    }
+};
+
+template <typename Stream>
+inline void write_bytes(Stream& s, const void* data, size_t len) {
+    s.write(std::span<const unsigned char>(static_cast<const unsigned char*>(data), len));
+}
+
+template <typename Stream>
+inline void write_le16(Stream& s, uint16_t value) {
+    unsigned char buf[2] = {(unsigned char)value, (unsigned char)(value >> 8)};
+    s.write(buf);
+}
+
+template <typename Stream>
+inline void write_le32(Stream& s, uint32_t value) {
+    unsigned char buf[4];
+    for (int i = 0; i < 4; i++) buf[i] = (unsigned char)(value >> (8 * i));
+    s.write(buf);
+}
+
+template <typename Stream>
+inline void write_le64(Stream& s, uint64_t value) {
+    unsigned char buf[8];
+    for (int i = 0; i < 8; i++) buf[i] = (unsigned char)(value >> (8 * i));
+    s.write(buf);
+}
+
+// CompactSize: 1, 3, 5 or 9 bytes depending on the value
+template <typename Stream>
+inline void write_compact_size(Stream& s, uint64_t size) {
+    if (size < 0xfd) {
+        unsigned char byte = (unsigned char)size;
+        s.write(std::span<const unsigned char>(&byte, 1));
+    } else if (size <= 0xffff) {
+        unsigned char prefix = 0xfd;
+        s.write(std::span<const unsigned char>(&prefix, 1));
+        write_le16(s, (uint16_t)size);
+    } else if (size <= 0xffffffff) {
+        unsigned char prefix = 0xfe;
+        s.write(std::span<const unsigned char>(&prefix, 1));
+        write_le32(s, (uint32_t)size);
+    } else {
+        unsigned char prefix = 0xff;
+        s.write(std::span<const unsigned char>(&prefix, 1));
+        write_le64(s, size);
+    }
+}
+
+inline uint16_t read_le16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t read_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t read_le64(const unsigned char* p) {
+    return read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+}
+
+inline uint8_t read_u8(SpanReader& r) { return r.read(1)[0]; }
+inline uint16_t read_le16(SpanReader& r) { return read_le16(r.read(2).data()); }
+inline uint32_t read_le32(SpanReader& r) { return read_le32(r.read(4).data()); }
+inline uint64_t read_le64(SpanReader& r) { return read_le64(r.read(8).data()); }
+
+// CompactSize, rejecting non-canonical encodings and sizes above MAX_SERIALIZED_SIZE
+inline uint64_t read_compact_size(SpanReader& r, bool range_check = true) {
+    uint8_t prefix = read_u8(r);
+    uint64_t size;
+    if (prefix < 0xfd) {
+        size = prefix;
+    } else if (prefix == 0xfd) {
+        size = read_le16(r);
+        if (size < 0xfd) throw DeserializeError("Non-canonical CompactSize");
+    } else if (prefix == 0xfe) {
+        size = read_le32(r);
+        if (size < 0x10000) throw DeserializeError("Non-canonical CompactSize");
+    } else {
+        size = read_le64(r);
+        if (size < 0x100000000ull) throw DeserializeError("Non-canonical CompactSize");
+    }
+    if (range_check && size > MAX_SERIALIZED_SIZE) throw DeserializeError("CompactSize too large");
+    return size;
+}
+
+// Length-prefixed byte string, as a view into the reader's buffer
+inline std::span<const unsigned char> read_var_bytes(SpanReader& r) {
+    return r.read(read_compact_size(r));
+}
+
+// Bitcoin Core's VARINT: base-128, most significant group first, with an
+// offset per byte so every value has exactly one encoding. Used in storage
+// formats (coins, undo data), never on the network.
+template <typename Stream>
+inline void write_varint(Stream& s, uint64_t n) {
+    unsigned char tmp[10];
+    int len = 0;
+    while (true) {
+        tmp[len] = (unsigned char)((n & 0x7f) | (len ? 0x80 : 0x00));
+        if (n <= 0x7f) break;
+        n = (n >> 7) - 1;
+        len++;
+    }
+    for (int i = len; i >= 0; i--) s.write(std::span<const unsigned char>(&tmp[i], 1));
+}
+
+inline uint64_t read_varint(SpanReader& r) {
+    uint64_t n = 0;
+    while (true) {
+        uint8_t byte = read_u8(r);
+        if (n > (UINT64_MAX >> 7)) throw DeserializeError("VARINT too large");
+        n = (n << 7) | (byte & 0x7f);
+        if (!(byte & 0x80)) return n;
+        if (n == UINT64_MAX) throw DeserializeError("VARINT too large");
+        n++;
+    }
+}
+
+} // namespace bitcoin
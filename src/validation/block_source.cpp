@@ -0,0 +1,151 @@
+// src/validation/block_source.cpp
+#include "block_source.h"
+#include "../blockchain/block_index.h"
+#include "../storage/block_store.h"
+#include "../util/serialize.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace bitcoin {
+
+void HeaderChainSource::append_header(const BlockHeader& header, const crypto::Hash256& hash) {
+    heights[hash] = (uint32_t)headers.size();
+    headers.push_back(header);
+}
+
+std::vector<BlockHeader> HeaderChainSource::get_headers(const std::vector<crypto::Hash256>& locator,
+                                                        size_t max_count) {
+    size_t start = 0;
+    for (const crypto::Hash256& hash : locator) {
+        auto it = heights.find(hash);
+        if (it != heights.end()) {
+            start = it->second + 1;
+            break;
+        }
+    }
+
+    size_t end = std::min(headers.size(), start + std::min(max_count, headers.size()));
+    if (start >= end) return {};
+    return std::vector<BlockHeader>(headers.begin() + start, headers.begin() + end);
+}
+
+MemoryBlockSource::MemoryBlockSource(const std::vector<Block>& chain, std::chrono::microseconds request_latency)
+    : latency(request_latency) {
+    blocks.reserve(chain.size());
+    for (const Block& block : chain) {
+        append_header(block.header, block.calculate_hash());
+        std::vector<unsigned char>& bytes = blocks.emplace_back();
+        VectorWriter writer(bytes);
+        block.serialize(writer);
+    }
+}
+
+bool MemoryBlockSource::get_block(const crypto::Hash256& hash, std::vector<unsigned char>& bytes) {
+    if (latency.count() > 0) std::this_thread::sleep_for(latency);
+    auto it = heights.find(hash);
+    if (it == heights.end()) return false;
+    bytes = blocks[it->second];
+    return true;
+}
+
+static bool read_exact(int fd, unsigned char* out, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, out, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        out += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+}
+
+BlockFileSource::BlockFileSource(const std::string& dir) : directory(dir) {
+    std::vector<std::string> names;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() == 12 && name.starts_with("blk") && name.ends_with(".dat") &&
+            name.find_first_not_of("0123456789", 3) == 8) {
+            names.push_back(entry.path().string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    // Record headers and block headers only
+    std::vector<BlockHeader> found;
+    unsigned char buffer[BlockStore::RECORD_HEADER_SIZE + BlockHeader::SERIALIZED_SIZE];
+    for (const std::string& path : names) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        fds.push_back(fd);
+        off_t file_size = ::lseek(fd, 0, SEEK_END);
+
+        uint64_t pos = 0;
+        while (pos + sizeof(buffer) <= (uint64_t)file_size && read_exact(fd, buffer, sizeof(buffer), pos)) {
+            uint32_t size = read_le32(buffer + 4);
+            uint64_t offset = pos + BlockStore::RECORD_HEADER_SIZE;
+            if (read_le32(buffer) != BlockStore::MAGIC || size < BlockHeader::SERIALIZED_SIZE ||
+                offset + size > (uint64_t)file_size) {
+                break;
+            }
+            BlockHeader header = BlockHeader::from_bytes(buffer + BlockStore::RECORD_HEADER_SIZE);
+            if (records.try_emplace(header.calculate_hash(), Record{fd, size, offset}).second) {
+                found.push_back(header);
+            }
+            pos = offset + size;
+        }
+    }
+
+    // Files needn't be in chain order: link the headers from the genesis
+    // block (the one without a parent here) up, then serve the best chain
+    std::unordered_map<crypto::Hash256, std::vector<size_t>> children;
+    const BlockHeader* genesis = nullptr;
+    for (size_t i = 0; i < found.size(); i++) {
+        const crypto::Hash256& parent = found[i].previous_block_hash;
+        if (records.count(parent)) {
+            children[parent].push_back(i);
+        } else if (!genesis || parent.is_null()) {
+            genesis = &found[i];
+        }
+    }
+    if (!genesis) return;
+
+    BlockIndex index;
+    std::deque<const BlockHeader*> pending{genesis};
+    while (!pending.empty()) {
+        const BlockIndexEntry* entry = index.add_header(*pending.front());
+        pending.pop_front();
+        auto it = children.find(entry->get_hash());
+        if (it == children.end()) continue;
+        for (size_t child : it->second) pending.push_back(&found[child]);
+    }
+
+    std::vector<const BlockIndexEntry*> chain;
+    for (const BlockIndexEntry* entry = index.get_best_header(); entry; entry = entry->parent) {
+        chain.push_back(entry);
+    }
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        append_header((*it)->get_header(), (*it)->get_hash());
+    }
+}
+
+BlockFileSource::~BlockFileSource() {
+    for (int fd : fds) ::close(fd);
+}
+
+bool BlockFileSource::get_block(const crypto::Hash256& hash, std::vector<unsigned char>& bytes) {
+    auto it = records.find(hash);
+    if (it == records.end()) return false;
+    const Record& record = it->second;
+    bytes.resize(record.size);
+    return read_exact(record.fd, bytes.data(), record.size, record.offset);
+}
+
+} // namespace bitcoin
@@ -0,0 +1,97 @@
+// src/validation/block_source.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../blockchain/block.h"
+
+namespace bitcoin {
+
+/**
+ * Where initial block download gets headers and blocks from
+ *
+ * A peer, a directory of block files, or a fake for tests. get_block()
+ * may be called from several threads at once.
+ */
+class BlockSource {
+public:
+    virtual ~BlockSource() {}
+
+    // Up to `max_count` headers that follow the first `locator` hash this
+    // source has on its chain (from its genesis block if it has none of
+    // them) - getheaders, in protocol terms. Empty: nothing more to give.
+    virtual std::vector<BlockHeader> get_headers(const std::vector<crypto::Hash256>& locator, size_t max_count) = 0;
+
+    // The serialized block; false if this source doesn't have it
+    virtual bool get_block(const crypto::Hash256& hash, std::vector<unsigned char>& bytes) = 0;
+};
+
+// A source that serves one chain of headers, kept in order
+class HeaderChainSource : public BlockSource {
+protected:
+    std::vector<BlockHeader> headers;                   // by height
+    std::unordered_map<crypto::Hash256, uint32_t> heights;
+
+    void append_header(const BlockHeader& header, const crypto::Hash256& hash);
+
+public:
+    std::vector<BlockHeader> get_headers(const std::vector<crypto::Hash256>& locator, size_t max_count) override;
+
+    size_t header_count() const { return headers.size(); }
+};
+
+/**
+ * An in-process fake peer serving a chain from memory
+ *
+ * `latency` is slept on every get_block() call, to stand in for the round
+ * trip to a real peer.
+ */
+class MemoryBlockSource : public HeaderChainSource {
+private:
+    std::vector<std::vector<unsigned char>> blocks;     // serialized, by height
+    std::chrono::microseconds latency;
+
+public:
+    explicit MemoryBlockSource(const std::vector<Block>& chain,
+                               std::chrono::microseconds request_latency = std::chrono::microseconds(0));
+
+    bool get_block(const crypto::Hash256& hash, std::vector<unsigned char>& bytes) override;
+};
+
+/**
+ * Blocks from a directory of blkNNNNN.dat files (as BlockStore and Bitcoin
+ * Core write them)
+ *
+ * Opening reads only the record headers and block headers; the most-work
+ * chain through them is what get_headers() serves. Blocks are read on
+ * demand. Records after a bad magic in a file are ignored, like the zeroed
+ * tail of a preallocated file.
+ */
+class BlockFileSource : public HeaderChainSource {
+private:
+    struct Record {
+        int fd;
+        uint32_t size;
+        uint64_t offset;
+    };
+
+    std::string directory;
+    std::vector<int> fds;
+    std::unordered_map<crypto::Hash256, Record> records;
+
+public:
+    explicit BlockFileSource(const std::string& directory);
+    ~BlockFileSource();
+
+    BlockFileSource(const BlockFileSource&) = delete;
+    BlockFileSource& operator=(const BlockFileSource&) = delete;
+
+    bool get_block(const crypto::Hash256& hash, std::vector<unsigned char>& bytes) override;
+
+    size_t block_count() const { return records.size(); }   // all records, side branches included
+};
+
+} // namespace bitcoin
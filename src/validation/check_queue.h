@@ -0,0 +1,168 @@
+// src/validation/check_queue.h
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bitcoin {
+
+template <typename Check>
+class CheckQueueControl;
+
+/**
+ * Parallel verification queue (after Bitcoin Core's CCheckQueue)
+ *
+ * Checks - anything callable as `bool check()` - are queued in bulk and
+ * picked up in batches by a fixed pool of worker threads. The thread that
+ * calls wait() works through the queue as well instead of sleeping. The
+ * first failing check clears a shared flag, and every thread skips whatever
+ * it picks up after that, so an invalid block costs little more than the
+ * checks already running.
+ *
+ * One round (block) at a time: use it through CheckQueueControl.
+ */
+template <typename Check>
+class CheckQueue {
+public:
+    // `worker_threads` extra threads; with 0 the caller of wait() runs every check
+    explicit CheckQueue(unsigned worker_threads, size_t max_batch_size = 128) : batch_size(max_batch_size) {
+        workers.reserve(worker_threads);
+        for (unsigned i = 0; i < worker_threads; i++) {
+            workers.emplace_back([this] { loop(false); });
+        }
+    }
+
+    ~CheckQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        worker_cv.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    CheckQueue(const CheckQueue&) = delete;
+    CheckQueue& operator=(const CheckQueue&) = delete;
+
+    size_t worker_count() const { return workers.size(); }
+
+private:
+    friend class CheckQueueControl<Check>;
+
+    std::mutex mutex;
+    std::condition_variable worker_cv;      // work added, or shutting down
+    std::condition_variable master_cv;      // last check of the round finished
+    std::vector<Check> queue;
+    size_t idle = 0;                        // threads waiting for work
+    size_t running = 0;                     // threads in loop(), including the master
+    size_t todo = 0;                        // checks of this round not finished yet
+    std::atomic<bool> all_ok{true};
+    bool stopping = false;
+
+    std::mutex control_mutex;               // held by CheckQueueControl for a round
+    std::vector<std::thread> workers;
+    const size_t batch_size;
+
+    void add(std::vector<Check>&& checks) {
+        if (checks.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.insert(queue.end(), std::make_move_iterator(checks.begin()), std::make_move_iterator(checks.end()));
+            todo += checks.size();
+        }
+        if (checks.size() == 1) {
+            worker_cv.notify_one();
+        } else {
+            worker_cv.notify_all();
+        }
+    }
+
+    // Workers run this until shutdown. The master runs it until the round is
+    // done and returns the round's result, resetting it for the next one.
+    bool loop(bool master) {
+        std::condition_variable& cv = master ? master_cv : worker_cv;
+        std::vector<Check> batch;
+        batch.reserve(batch_size);
+        size_t finished = 0;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        running++;
+        while (true) {
+            if (finished) {
+                todo -= finished;
+                if (todo == 0 && !master) master_cv.notify_one();
+            }
+            while (queue.empty() && !stopping) {
+                if (master && todo == 0) {
+                    running--;
+                    return all_ok.exchange(true);
+                }
+                idle++;
+                cv.wait(lock);
+                idle--;
+            }
+            if (stopping) {
+                running--;
+                return false;
+            }
+
+            // Small batches while there's little left, so the tail is shared out
+            size_t take = std::max<size_t>(1, std::min(batch_size, queue.size() / (running + idle + 1)));
+            std::move(queue.end() - take, queue.end(), std::back_inserter(batch));
+            queue.resize(queue.size() - take);
+            lock.unlock();
+
+            for (Check& check : batch) {
+                if (!all_ok.load(std::memory_order_relaxed)) break;
+                if (!check()) all_ok.store(false, std::memory_order_relaxed);
+            }
+            finished = batch.size();
+            batch.clear();
+            lock.lock();
+        }
+    }
+};
+
+/**
+ * One round of checks on a CheckQueue
+ *
+ * Holds the queue for its lifetime. The destructor waits for anything still
+ * queued, so checks never outlive the data they point into.
+ */
+template <typename Check>
+class CheckQueueControl {
+private:
+    CheckQueue<Check>& queue;
+    bool done = false;
+
+public:
+    explicit CheckQueueControl(CheckQueue<Check>& check_queue) : queue(check_queue) {
+        queue.control_mutex.lock();
+    }
+
+    ~CheckQueueControl() {
+        if (!done) wait();
+        queue.control_mutex.unlock();
+    }
+
+    CheckQueueControl(const CheckQueueControl&) = delete;
+    CheckQueueControl& operator=(const CheckQueueControl&) = delete;
+
+    void add(std::vector<Check>&& checks) {
+        done = false;
+        queue.add(std::move(checks));
+    }
+
+    // Help run the queued checks; true if every one passed
+    bool wait() {
+        done = true;
+        return queue.loop(true);
+    }
+};
+
+} // namespace bitcoin
@@ -0,0 +1,307 @@
+// src/validation/ibd.cpp
+#include "ibd.h"
+#include "validation.h"
+#include "../blockchain/block_view.h"
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace bitcoin {
+
+using Clock = std::chrono::steady_clock;
+
+// How far ahead of our clock a header's timestamp may be
+static constexpr int64_t MAX_FUTURE_BLOCK_TIME = 2 * 60 * 60;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void IbdStats::print() const {
+    double wall = block_seconds;
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "IBD: " << headers << " headers in " << header_seconds << "s, " << blocks << " blocks ("
+              << transactions << " txs, " << std::setprecision(1) << bytes / 1e6 << " MB) in "
+              << std::setprecision(2) << wall << "s = " << std::setprecision(1) << blocks_per_second()
+              << " blocks/s" << std::endl;
+    std::cout << "  download " << std::setw(5) << 100 * download.utilization(wall) << "% of " << download.threads
+              << " threads" << std::endl;
+    std::cout << "  decode   " << std::setw(5) << 100 * decode.utilization(wall) << "% of " << decode.threads
+              << " threads" << std::endl;
+    std::cout << "  utxo     " << std::setw(5) << 100 * utxo.utilization(wall) << "%" << std::endl;
+    std::cout << "  scripts  " << std::setw(5) << 100 * scripts.utilization(wall) << "% (over " << scripts.threads
+              << " threads)" << std::endl;
+    std::cout << "  store    " << std::setw(5) << 100 * store.utilization(wall) << "%" << std::endl;
+    std::cout << "  waiting for blocks " << (wall > 0 ? 100 * stall_seconds / wall : 0.0) << "%" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+InitialBlockDownload::InitialBlockDownload(std::vector<BlockSource*> block_sources, BlockIndex& block_index,
+                                           Chain& active_chain, MutableCoinsView& coins,
+                                           const ConsensusParams& consensus, IbdOptions ibd_options)
+    : sources(std::move(block_sources)), index(block_index), chain(active_chain), view(coins), params(consensus),
+      options(std::move(ibd_options)) {
+    options.window = std::max<size_t>(options.window, 1);
+    options.download_threads = std::max(options.download_threads, 1u);
+    options.headers_per_request = std::max<size_t>(options.headers_per_request, 1);
+}
+
+bool InitialBlockDownload::accept_header(const BlockHeader& header, bool& added) {
+    crypto::Hash256 hash = header.calculate_hash();
+    added = false;
+    if (index.lookup(hash)) return true;
+
+    const BlockIndexEntry* parent = index.lookup(header.previous_block_hash);
+    if (!parent && (index.size() > 0 || hash != params.genesis_hash)) {
+        error = index.size() > 0 ? "Header " + hash.to_hex() + " doesn't connect to a known header"
+                                 : "Header " + hash.to_hex() + " isn't the genesis block";
+        return false;
+    }
+    if (!check_proof_of_work(hash, header.bits, params)) {
+        error = "Header " + hash.to_hex() + " has invalid proof of work";
+        return false;
+    }
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                      std::chrono::system_clock::now().time_since_epoch()).count();
+    if (header.timestamp > now + MAX_FUTURE_BLOCK_TIME) {
+        error = "Header " + hash.to_hex() + " is too far in the future";
+        return false;
+    }
+    if (parent) {
+        if (header.timestamp <= parent->get_median_time_past()) {
+            error = "Header " + hash.to_hex() + " isn't later than the median time past";
+            return false;
+        }
+        // The first block of the period that just ended, on retarget boundaries
+        uint32_t height = parent->height + 1;
+        int64_t interval = params.retarget_interval();
+        int64_t first_time = height % interval == 0 ? parent->get_ancestor(height - interval)->timestamp : 0;
+        if (header.bits != get_next_work_required(height, parent->bits, first_time, parent->timestamp, params)) {
+            error = "Header " + hash.to_hex() + " has the wrong difficulty";
+            return false;
+        }
+    }
+
+    index.add_header(header);
+    added = true;
+    counters.headers++;
+    return true;
+}
+
+bool InitialBlockDownload::sync_headers() {
+    auto start = Clock::now();
+    for (BlockSource* source : sources) {
+        while (true) {
+            std::vector<BlockHeader> headers =
+                source->get_headers(get_locator(index.get_best_header()), options.headers_per_request);
+
+            bool any_new = false;
+            for (const BlockHeader& header : headers) {
+                bool added;
+                if (!accept_header(header, added)) {
+                    counters.header_seconds += seconds_since(start);
+                    return false;
+                }
+                any_new |= added;
+            }
+            // A short batch is the end of its chain; one with nothing new
+            // means it's behind ours
+            if (headers.size() < options.headers_per_request || !any_new) break;
+        }
+    }
+    counters.header_seconds += seconds_since(start);
+    return true;
+}
+
+namespace {
+
+// A block on its way from the download threads to the connecting thread
+struct Slot {
+    bool ready = false;
+    std::string error;                      // set instead of `block` if fetching or decoding failed
+    std::vector<unsigned char> bytes;
+    Block block;
+};
+
+} // namespace
+
+bool InitialBlockDownload::download_blocks() {
+    if (sources.empty()) return true;
+    const BlockIndexEntry* best = index.get_best_header();
+    if (!best || chain.tip() == best) return true;
+    BlockIndexEntry* target = index.lookup(best->get_hash());
+    if (chain.find_fork(target) != chain.tip()) {
+        error = "Best header doesn't extend the active chain";
+        return false;
+    }
+
+    // Everything above the tip, by height
+    uint32_t first_height = chain.tip() ? chain.tip()->height + 1 : 0;
+    std::vector<BlockIndexEntry*> todo(target->height + 1 - first_height);
+    for (BlockIndexEntry* entry = target; entry && entry->height >= first_height; entry = entry->parent) {
+        todo[entry->height - first_height] = entry;
+    }
+
+    const size_t window = options.window;
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable fetched_cv;     // a slot became ready
+    std::condition_variable window_cv;      // the window moved on
+    size_t next_fetch = 0;
+    size_t next_connect = 0;
+    bool stopping = false;
+
+    counters.download.threads = counters.decode.threads = options.download_threads;
+    counters.scripts.threads = options.script_threads + 1;
+
+    // Download threads: take the next height inside the window, fetch it
+    // (preferring "their" source), decode it and check it's the block the
+    // header promised
+    auto download = [&](unsigned thread) {
+        double download_time = 0, decode_time = 0;
+        while (true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                window_cv.wait(lock, [&] {
+                    return stopping || next_fetch >= todo.size() || next_fetch < next_connect + window;
+                });
+                if (stopping || next_fetch >= todo.size()) break;
+                i = next_fetch++;
+            }
+
+            // Anything thrown here (a failing source, running out of memory)
+            // must still fill the slot, or the connecting thread waits forever
+            const crypto::Hash256& hash = todo[i]->get_hash();
+            Slot slot;
+            auto start = Clock::now();
+            bool downloaded = false;
+            try {
+                bool found = false;
+                for (size_t k = 0; k < sources.size() && !found; k++) {
+                    found = sources[(thread + k) % sources.size()]->get_block(hash, slot.bytes);
+                }
+                download_time += seconds_since(start);
+                downloaded = true;
+
+                start = Clock::now();
+                if (!found) {
+                    slot.error = "No source has block " + hash.to_hex();
+                } else {
+                    BlockView decoded(slot.bytes, false);
+                    if (decoded.header.calculate_hash() != hash) {
+                        slot.error = "Source sent the wrong block for " + hash.to_hex();
+                    } else if (!decoded.check_merkle_root()) {
+                        slot.error = "Block " + hash.to_hex() + " doesn't match its merkle root";
+                    } else if (!decoded.check_witness_commitment()) {
+                        // The header doesn't cover witness data, so a peer can
+                        // mangle it without touching the hash: their fault,
+                        // not the block's
+                        slot.error = "Block " + hash.to_hex() + " doesn't match its witness commitment";
+                    } else {
+                        slot.block = decoded.to_block();
+                    }
+                }
+            } catch (const DeserializeError& e) {
+                slot.error = "Block " + hash.to_hex() + " is malformed: " + e.what();
+            } catch (const std::exception& e) {
+                slot.error = "Fetching block " + hash.to_hex() + " failed: " + e.what();
+            }
+            (downloaded ? decode_time : download_time) += seconds_since(start);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot.ready = true;
+                slots[i % window] = std::move(slot);
+            }
+            fetched_cv.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.download.busy_seconds += download_time;
+        counters.decode.busy_seconds += decode_time;
+    };
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < options.download_threads; t++) threads.emplace_back(download, t);
+    ScriptCheckQueue script_queue(options.script_threads);
+
+    // The connecting thread: blocks strictly in order
+    bool ok = true;
+    try {
+        for (size_t i = 0; i < todo.size() && ok; i++) {
+            Slot slot;
+            {
+                auto wait_start = Clock::now();
+                std::unique_lock<std::mutex> lock(mutex);
+                fetched_cv.wait(lock, [&] { return slots[i % window].ready; });
+                slot = std::move(slots[i % window]);
+                slots[i % window] = Slot();
+                next_connect = i + 1;
+                counters.stall_seconds += seconds_since(wait_start);
+            }
+            window_cv.notify_all();
+
+            BlockIndexEntry* entry = todo[i];
+            if (!slot.error.empty()) {
+                // A source problem, not an invalid block: leave the header alone
+                error = slot.error;
+                ok = false;
+                break;
+            }
+
+            const Block& block = slot.block;
+            BlockUndo undo;
+            ConnectBlockTimings timings;
+            bool connected = connect_block_verified(view, block, entry->parent, params, undo, &script_queue,
+                                                    nullptr, options.sig_cache, &timings);
+            counters.utxo.busy_seconds += timings.utxo_seconds;
+            counters.scripts.busy_seconds += timings.script_seconds;
+            if (!connected) {
+                // Everything connect_block_verified() saw is committed to by
+                // the header (transactions and, checked on decode, their
+                // witnesses), so the block itself is invalid
+                error = "Block " + entry->get_hash().to_hex() + " at height " + std::to_string(entry->height) +
+                        " is invalid";
+                index.mark_failed(entry);
+                ok = false;
+                break;
+            }
+
+            if (options.store) {
+                auto step = Clock::now();
+                options.store->write_block(entry->get_hash(), slot.bytes);
+                counters.store.busy_seconds += seconds_since(step);
+            }
+            index.set_status(entry, BLOCK_HAVE_DATA | BLOCK_VALID_SCRIPTS);
+            chain.set_tip(entry);
+
+            counters.blocks++;
+            counters.transactions += block.transactions.size();
+            counters.bytes += slot.bytes.size();
+            if (options.on_block_connected) options.on_block_connected(entry);
+        }
+    } catch (const std::exception& e) {
+        // I/O errors, or a view that doesn't match the chain
+        error = e.what();
+        ok = false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    window_cv.notify_all();
+    for (std::thread& thread : threads) thread.join();
+    counters.block_seconds += seconds_since(start);
+    return ok;
+}
+
+} // namespace bitcoin
@@ -0,0 +1,121 @@
+// src/validation/ibd.h
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "block_source.h"
+#include "../blockchain/block_index.h"
+#include "../blockchain/pow.h"
+#include "../coins/coins.h"
+#include "../script/sig_cache.h"
+#include "../storage/block_store.h"
+
+namespace bitcoin {
+
+struct IbdOptions {
+    size_t window = 1024;                   // blocks fetched ahead of the one being connected
+    unsigned download_threads = 8;          // fetch and decode, spread over the sources
+    unsigned script_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;  // besides the connecting thread
+    size_t headers_per_request = 2000;
+    BlockStore* store = nullptr;            // keep the downloaded blocks (optional)
+    SignatureCache* sig_cache = nullptr;
+    // After each block is connected (e.g. to flush a coins cache)
+    std::function<void(const BlockIndexEntry*)> on_block_connected;
+};
+
+struct IbdStageStats {
+    double busy_seconds = 0;                // summed over the stage's threads
+    unsigned threads = 1;
+
+    // Share of the stage's thread time spent working; the stage near 1.0 is the bottleneck
+    double utilization(double wall_seconds) const {
+        return wall_seconds > 0 ? busy_seconds / (wall_seconds * threads) : 0;
+    }
+};
+
+struct IbdStats {
+    uint64_t headers = 0;                   // new headers accepted
+    uint64_t blocks = 0;                    // blocks connected
+    uint64_t transactions = 0;
+    uint64_t bytes = 0;
+    double header_seconds = 0;
+    double block_seconds = 0;               // wall clock of the block phase
+
+    // Block pipeline, in order. Download and decode share the download threads;
+    // the script stage is one step of the connecting thread, run in parallel.
+    IbdStageStats download;                 // BlockSource::get_block
+    IbdStageStats decode;                   // parse, merkle and witness commitment checks
+    IbdStageStats utxo;                     // spend inputs, add outputs
+    IbdStageStats scripts;
+    IbdStageStats store;                    // BlockStore writes
+    double stall_seconds = 0;               // connecting thread waiting for the next block
+
+    double blocks_per_second() const { return block_seconds > 0 ? blocks / block_seconds : 0; }
+
+    // For debugging
+    void print() const;
+};
+
+/**
+ * Headers-first initial block download
+ *
+ * sync_headers() pulls headers from each source in turn, checking that
+ * each one links to a known header (or is the genesis block of `consensus`),
+ * carries the right difficulty and meets it, and has a timestamp after its
+ * parent's median time past and no more than two hours ahead of our clock -
+ * 80 bytes and a hash per block, so the best chain is known before any
+ * block is fetched.
+ *
+ * download_blocks() then walks from the active chain's tip to the best
+ * header through a pipeline:
+ *
+ *   download threads:   fetch -> decode -> merkle and witness commitment checks
+ *                       (any order, in parallel)
+ *   connecting thread:  connect_block_verified() -> store
+ *                       (strictly in height order)
+ *
+ * connect_block_verified() runs every consensus check: lock times, weight,
+ * sigops and the coinbase amount around the UTXO apply, then the scripts on
+ * a ScriptCheckQueue, since they need the coins being spent. A block that
+ * fails is rolled back. Downloads stay within a window
+ * of `window` blocks ahead of the block being connected, so memory is
+ * bounded and the next blocks are usually ready by the time they're needed.
+ *
+ * Blocks that fail validation are marked failed in the index. A block that
+ * doesn't match its header - merkle root or witness commitment - is the
+ * source's fault and only stops the download. Reorgs
+ * (a best header off the active chain) aren't handled here.
+ */
+class InitialBlockDownload {
+private:
+    std::vector<BlockSource*> sources;
+    BlockIndex& index;
+    Chain& chain;
+    MutableCoinsView& view;
+    ConsensusParams params;
+    IbdOptions options;
+
+    IbdStats counters;
+    std::string error;
+
+    bool accept_header(const BlockHeader& header, bool& added);
+
+public:
+    InitialBlockDownload(std::vector<BlockSource*> block_sources, BlockIndex& block_index, Chain& active_chain,
+                         MutableCoinsView& coins, const ConsensusParams& consensus, IbdOptions ibd_options = IbdOptions());
+
+    // Both phases; false (see get_error()) on the first invalid header or block
+    bool run() { return sync_headers() && download_blocks(); }
+
+    bool sync_headers();
+    bool download_blocks();
+
+    const IbdStats& stats() const { return counters; }
+    const std::string& get_error() const { return error; }
+};
+
+} // namespace bitcoin
@@ -0,0 +1,225 @@
+// src/validation/validation.cpp
+#include "validation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace bitcoin {
+
+static std::span<const unsigned char> as_bytes(const std::string& s) {
+    return std::span<const unsigned char>(reinterpret_cast<const unsigned char*>(s.data()), s.size());
+}
+
+uint64_t get_block_subsidy(uint32_t height, const ConsensusParams& params) {
+    uint32_t halvings = height / params.subsidy_halving_interval;
+    return halvings >= 64 ? 0 : (50 * COIN) >> halvings;
+}
+
+bool check_transaction(const Transaction& tx) {
+    if (tx.inputs.empty() || tx.outputs.empty()) return false;
+    if (tx.is_coinbase()) {
+        size_t script_size = tx.inputs[0].script_sig.size();
+        if (script_size < 2 || script_size > 100) return false;
+    }
+    return true;
+}
+
+uint64_t get_transaction_sigop_cost(const Transaction& tx, const std::vector<Coin>& spent) {
+    uint64_t legacy = 0;
+    for (const TransactionInput& input : tx.inputs) legacy += count_sigops(as_bytes(input.script_sig), false);
+    for (const TransactionOutput& output : tx.outputs) legacy += count_sigops(output.script_pubkey.span(), false);
+    uint64_t cost = legacy * WITNESS_SCALE_FACTOR;
+    if (tx.is_coinbase()) return cost;
+
+    for (size_t i = 0; i < tx.inputs.size() && i < spent.size(); i++) {
+        const TransactionInput& input = tx.inputs[i];
+        ScriptType type = classify_script(spent[i].out.script_pubkey);
+        if (type == ScriptType::P2SH) {
+            // The redeem script is the last push of a push-only scriptSig
+            std::span<const unsigned char> pc = as_bytes(input.script_sig), redeem;
+            Opcode op;
+            std::span<const unsigned char> data;
+            bool push_only = true;
+            while (push_only && get_script_op(pc, op, &data)) {
+                push_only = op <= OP_16;
+                redeem = op <= OP_PUSHDATA4 ? data : std::span<const unsigned char>();
+            }
+            if (!push_only || !pc.empty()) continue;
+            cost += count_sigops(redeem, true) * WITNESS_SCALE_FACTOR;
+            type = classify_script(Script(redeem));     // P2SH-wrapped segwit
+        }
+        if (type == ScriptType::P2WPKH) {
+            cost += 1;
+        } else if (type == ScriptType::P2WSH && !input.witness.empty()) {
+            cost += count_sigops(as_bytes(input.witness.back()), true);
+        }
+    }
+    return cost;
+}
+
+bool verify_input_script(const Transaction& tx, size_t input_index, const TransactionOutput& spent,
+                         SignatureCache* sig_cache, const PrecomputedSighash* precomputed) {
+    const TransactionInput& input = tx.inputs[input_index];
+    std::span<const unsigned char> script_sig = as_bytes(input.script_sig);
+    TransactionSignatureChecker checker(tx, input_index, spent.value, precomputed, sig_cache);
+    return verify_script(script_sig, spent.script_pubkey, input.witness, CONSENSUS_SCRIPT_FLAGS, checker);
+}
+
+bool is_final_transaction(const Transaction& tx, uint32_t height, int64_t lock_time_cutoff) {
+    if (tx.locktime == 0) return true;
+    int64_t now = tx.locktime < LOCKTIME_THRESHOLD ? (int64_t)height : lock_time_cutoff;
+    if ((int64_t)tx.locktime < now) return true;
+    // A lock time in the future only binds if some input opts in to it
+    for (const TransactionInput& input : tx.inputs) {
+        if (input.sequence != SEQUENCE_FINAL) return false;
+    }
+    return true;
+}
+
+bool check_sequence_locks(const Transaction& tx, const std::vector<uint32_t>& coin_heights,
+                          const BlockIndexEntry* parent) {
+    if (tx.version < 2 || tx.is_coinbase()) return true;
+
+    // The last height and median time past at which the transaction is still
+    // locked (-1: not locked at all)
+    int64_t min_height = -1;
+    int64_t min_time = -1;
+    for (size_t i = 0; i < tx.inputs.size() && i < coin_heights.size(); i++) {
+        uint32_t sequence = tx.inputs[i].sequence;
+        if (sequence & SEQUENCE_LOCKTIME_DISABLE_FLAG) continue;
+        int64_t lock = sequence & SEQUENCE_LOCKTIME_MASK;
+        if (sequence & SEQUENCE_LOCKTIME_TYPE_FLAG) {
+            // Time locks count from the median time past of the block before the coin's
+            const BlockIndexEntry* coin_parent =
+                parent ? parent->get_ancestor(coin_heights[i] > 0 ? coin_heights[i] - 1 : 0) : nullptr;
+            int64_t coin_time = coin_parent ? coin_parent->get_median_time_past() : 0;
+            min_time = std::max(min_time, coin_time + (lock << 9) - 1);
+        } else {
+            min_height = std::max(min_height, (int64_t)coin_heights[i] + lock - 1);
+        }
+    }
+
+    int64_t height = parent ? (int64_t)parent->height + 1 : 0;
+    int64_t median_time_past = parent ? parent->get_median_time_past() : 0;
+    return min_height < height && min_time < median_time_past;
+}
+
+bool check_block_scripts(const Block& block, const BlockUndo& undo, ScriptCheckQueue* queue,
+                         SignatureCache* sig_cache) {
+    // BIP143 hashes for every segwit transaction, shared by its inputs. Sized
+    // up front: queued checks point into it.
+    std::vector<PrecomputedSighash> precomputed;
+    size_t witness_txs = 0;
+    for (const TransactionRef& tx : block.transactions) {
+        if (tx->has_witness()) witness_txs++;
+    }
+    precomputed.reserve(witness_txs);
+
+    std::vector<ScriptCheck> checks;
+    size_t u = 0;
+    for (const TransactionRef& tx : block.transactions) {
+        if (tx->is_coinbase()) continue;
+        if (u >= undo.txs.size() || undo.txs[u].spent.size() != tx->inputs.size()) return false;
+        const TxUndo& tx_undo = undo.txs[u++];
+        const PrecomputedSighash* tx_precomputed = nullptr;
+        if (tx->has_witness()) tx_precomputed = &precomputed.emplace_back(*tx);
+        for (size_t i = 0; i < tx->inputs.size(); i++) {
+            ScriptCheck check{tx.get(), (uint32_t)i, &tx_undo.spent[i].out, sig_cache, tx_precomputed};
+            if (queue) {
+                checks.push_back(check);
+            } else if (!check()) {
+                return false;
+            }
+        }
+    }
+    if (!queue) return true;
+
+    CheckQueueControl<ScriptCheck> control(*queue);
+    control.add(std::move(checks));
+    return control.wait();
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Checks that need the block's place in the chain but not the coins
+static bool check_block_context(const Block& block, uint32_t height, int64_t lock_time_cutoff) {
+    // BIP34: the coinbase starts by pushing the height, so no two coinbases
+    // (and their txids) are the same. Not the genesis block, which is fixed
+    // by its hash and predates the rule.
+    if (height > 0) {
+        Script expected;
+        expected.push_int(height);
+        const std::string& script_sig = block.transactions[0]->inputs[0].script_sig;
+        if (script_sig.size() < expected.size() || std::memcmp(script_sig.data(), expected.data(), expected.size()) != 0) {
+            return false;
+        }
+    }
+
+    SizeCounter prefix;
+    write_compact_size(prefix, block.transactions.size());
+    size_t weight = (BlockHeader::SERIALIZED_SIZE + prefix.size) * WITNESS_SCALE_FACTOR;
+    for (const TransactionRef& tx : block.transactions) {
+        if (!check_transaction(*tx)) return false;
+        weight += tx->get_weight();
+        if (!is_final_transaction(*tx, height, lock_time_cutoff)) return false;
+    }
+    return weight <= MAX_BLOCK_WEIGHT;
+}
+
+// Checks against the coins a connected block spent
+static bool check_block_inputs(const Block& block, const BlockUndo& undo, const BlockIndexEntry* parent,
+                               uint64_t max_coinbase_value) {
+    static const std::vector<Coin> no_coins;
+    std::vector<uint32_t> coin_heights;
+    uint64_t sigop_cost = 0;
+    size_t u = 0;
+    for (const TransactionRef& tx : block.transactions) {
+        const std::vector<Coin>& spent = tx->is_coinbase() ? no_coins : undo.txs[u++].spent;
+        sigop_cost += get_transaction_sigop_cost(*tx, spent);
+        if (sigop_cost > MAX_BLOCK_SIGOPS_COST) return false;
+
+        if (tx->is_coinbase()) continue;
+        coin_heights.clear();
+        for (const Coin& coin : spent) coin_heights.push_back(coin.height);
+        if (!check_sequence_locks(*tx, coin_heights, parent)) return false;
+    }
+    // connect_block() already range-checked the coinbase outputs
+    return block.transactions[0]->get_total_output_value() <= max_coinbase_value;
+}
+
+bool connect_block_verified(MutableCoinsView& view, const Block& block, const BlockIndexEntry* parent,
+                            const ConsensusParams& params, BlockUndo& undo, ScriptCheckQueue* queue,
+                            uint64_t* fees, SignatureCache* sig_cache, ConnectBlockTimings* timings) {
+    auto start = Clock::now();
+    auto add_time = [&](double ConnectBlockTimings::*field) {
+        auto now = Clock::now();
+        if (timings) timings->*field += std::chrono::duration<double>(now - start).count();
+        start = now;
+    };
+
+    uint32_t height = parent ? parent->height + 1 : 0;
+    uint64_t block_fees = 0;
+    bool ok = block.validate_transactions() &&
+              check_block_context(block, height, parent ? parent->get_median_time_past() : 0) &&
+              connect_block(view, block, height, undo, &block_fees);
+    if (!ok) {
+        add_time(&ConnectBlockTimings::utxo_seconds);
+        return false;
+    }
+    ok = check_block_inputs(block, undo, parent, get_block_subsidy(height, params) + block_fees);
+    add_time(&ConnectBlockTimings::utxo_seconds);
+    if (ok) {
+        ok = check_block_scripts(block, undo, queue, sig_cache);
+        add_time(&ConnectBlockTimings::script_seconds);
+    }
+    if (!ok) {
+        disconnect_block(view, block, undo);
+        undo.txs.clear();
+        add_time(&ConnectBlockTimings::utxo_seconds);
+        return false;
+    }
+    if (fees) *fees = block_fees;
+    return true;
+}
+
+} // namespace bitcoin
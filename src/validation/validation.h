@@ -0,0 +1,97 @@
+// src/validation/validation.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "check_queue.h"
+#include "../blockchain/block.h"
+#include "../blockchain/block_index.h"
+#include "../blockchain/pow.h"
+#include "../coins/coins.h"
+#include "../script/interpreter.h"
+#include "../script/sig_cache.h"
+
+namespace bitcoin {
+
+// New coins the coinbase of the block at `height` may claim on top of its fees
+uint64_t get_block_subsidy(uint32_t height, const ConsensusParams& params);
+
+// Context-free rules every transaction must meet: at least one input and
+// one output, and a coinbase scriptSig of 2 to 100 bytes
+bool check_transaction(const Transaction& tx);
+
+// BIP141 sigop cost of `tx`: legacy and P2SH sigops count four times,
+// witness ones once. `spent` are the coins its inputs spend (unused for a
+// coinbase, which has none).
+uint64_t get_transaction_sigop_cost(const Transaction& tx, const std::vector<Coin>& spent);
+
+// Does input `input_index` of `tx` satisfy the output it spends, under every
+// consensus script rule? With a `sig_cache`, signatures found there skip
+// verification and ones that verify are added. `precomputed` (the
+// transaction's BIP143 hashes) saves computing them per input.
+bool verify_input_script(const Transaction& tx, size_t input_index, const TransactionOutput& spent,
+                         SignatureCache* sig_cache = nullptr, const PrecomputedSighash* precomputed = nullptr);
+
+// Is `tx`'s nLockTime satisfied in a block at `height` whose parent has
+// median time past `lock_time_cutoff` (BIP113)? Always true when every
+// input has a final sequence number.
+bool is_final_transaction(const Transaction& tx, uint32_t height, int64_t lock_time_cutoff);
+
+// Are `tx`'s BIP68 relative lock times met in the block after `parent`?
+// `coin_heights` are the heights of the coins its inputs spend, in input
+// order (the next block's height for coins that aren't in a block yet).
+bool check_sequence_locks(const Transaction& tx, const std::vector<uint32_t>& coin_heights,
+                          const BlockIndexEntry* parent);
+
+/**
+ * Script check for one input, as queued on a CheckQueue
+ *
+ * Points at the transaction and at the spent output in the block's undo
+ * data instead of copying them; both must outlive the check.
+ */
+struct ScriptCheck {
+    const Transaction* tx = nullptr;
+    uint32_t input_index = 0;
+    const TransactionOutput* spent = nullptr;
+    SignatureCache* sig_cache = nullptr;
+    const PrecomputedSighash* precomputed = nullptr;   // shared by the transaction's inputs
+
+    bool operator()() const { return verify_input_script(*tx, input_index, *spent, sig_cache, precomputed); }
+};
+
+using ScriptCheckQueue = CheckQueue<ScriptCheck>;
+
+// Verify every input script of a connected block against the coins it spent
+// (from connect_block's undo data). Spread over `queue` if given, otherwise
+// checked one by one on this thread; stops at the first failure either way.
+// Signatures already verified on mempool admission come out of `sig_cache`.
+bool check_block_scripts(const Block& block, const BlockUndo& undo, ScriptCheckQueue* queue = nullptr,
+                         SignatureCache* sig_cache = nullptr);
+
+// Where connect_block_verified() spent its time, added to on every call
+struct ConnectBlockTimings {
+    double utxo_seconds = 0;                // everything but the scripts
+    double script_seconds = 0;
+};
+
+/**
+ * Fully validate a block on top of `parent` (nullptr for the genesis block)
+ * and connect it
+ *
+ * Structure checks; check_transaction() on every transaction; the height
+ * in the coinbase (BIP34, after the genesis block); weight; every
+ * transaction final at the block's height and its parent's median time
+ * past; connect_block(), which enforces BIP30; BIP68 sequence locks and
+ * sigop cost against the spent coins; a coinbase claiming no more than the
+ * subsidy plus fees; then check_block_scripts(). A block that fails is
+ * disconnected again, leaving `view` as it was.
+ *
+ * The merkle root and witness commitment are the caller's to check, as they
+ * are where the block is decoded.
+ */
+bool connect_block_verified(MutableCoinsView& view, const Block& block, const BlockIndexEntry* parent,
+                            const ConsensusParams& params, BlockUndo& undo, ScriptCheckQueue* queue = nullptr,
+                            uint64_t* fees = nullptr, SignatureCache* sig_cache = nullptr,
+                            ConnectBlockTimings* timings = nullptr);
+
+} // namespace bitcoin
@@ -0,0 +1,26 @@
+// tests/check.h
+#pragma once
+#include <cstdio>
+
+/**
+ * Minimal test harness
+ *
+ * CHECK() reports a failed condition and keeps going, so one run shows every
+ * failure; a test's main() ends with `return test_result();`, which ctest
+ * reads as pass or fail.
+ */
+
+inline int test_failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures++;                                                          \
+        }                                                                             \
+    } while (0)
+
+inline int test_result() {
+    if (test_failures) std::printf("%d check(s) failed\n", test_failures);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+// tests/test_base58.cpp
+//
+// Base58 against Bitcoin Core's base58_encode_decode.json vectors, inputs
+// of zero bytes only, Base58Check corruption, and the size limits decode()
+// computes before and after the conversion, on both sides of STACK_SIZE.
+
+#include <random>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "crypto/base58.h"
+#include "crypto/hex.h"
+
+using namespace crypto;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+// Bitcoin Core's src/test/data/base58_encode_decode.json: hex, encoding
+const char* const vectors[][2] = {
+    {"", ""},
+    {"61", "2g"},
+    {"626262", "a3gV"},
+    {"636363", "aPEr"},
+    {"73696d706c792061206c6f6e6720737472696e67", "2cFupjhnEsSn59qHXstmK2ffpLv2"},
+    {"00eb15231dfceb60925886b67d065299925915aeb172c06647", "1NS17iag9jJgTHD1VXjvLCEnZuQ3rJDE9L"},
+    {"516b6fcd0f", "ABnLTmg"},
+    {"bf4f89001e670274dd", "3SEo3LWLoPntC"},
+    {"572e4794", "3EFU7m"},
+    {"ecac89cad93923c02321", "EJDM8drfXA6uyA"},
+    {"10c8511e", "Rt5zm"},
+    {"00000000000000000000", "1111111111"},
+    {"000111d38e5fc9071ffcd20b4a763cc9ae4f252bb4e48fd66a835e252ada93ff480d6dd43dc62a641155a5",
+     "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"},
+    {"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f202122232425262728292a2b2c2d2e2f"
+     "303132333435363738393a3b3c3d3e3f404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+     "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f808182838485868788898a8b8c8d8e8f"
+     "909192939495969798999a9b9c9d9e9fa0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+     "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedfe0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+     "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+     "1cWB5HCBdLjAuqGGReWE3R3CguuwSjw6RHn39s2yuDRTS5NsBgNiFpWgAnEx6VQi8csexkgYw3mdYrMHr8x9i7aEwP8kZ7vccX"
+     "WqKDvGv3u1GxFKPuAkn8JCPPGDMf3vMMnbzm6Nh9zh1gcNsMvH3ZNLmP5fSG6DGbbi2tuwMWPthr4boWwCxf7ewSgNQeacyozh"
+     "KDDQQ1qL5fQFUW52QKUZDZ5fw3KXNQJMcNTcaB723LchjeKun7MuGW5qyCBZYzA1KjofN1gYBV3NqyhQJ3Ns746GNuf9N2pQPm"
+     "Hz4xpnSrrfCvy6TVVz5d4PdrjeshsWQwpZsZGzvbdAdN8MKV5QsBDY"},
+};
+
+void test_vectors() {
+    for (const auto& [hex, encoded] : vectors) {
+        Bytes data = hex_to_bytes(hex);
+        CHECK(Base58::encode(data) == encoded);
+        Bytes decoded;
+        CHECK(Base58::decode(encoded, decoded));
+        CHECK(decoded == data);
+
+        // The caller-buffer overloads, with exactly the room they need
+        std::string out(Base58::max_encoded_size(data.size()), '\0');
+        out.resize(Base58::encode(data, out.data()));
+        CHECK(out == encoded);
+        Bytes exact(data.size() + 1);
+        size_t len = 0;
+        CHECK(Base58::decode(encoded, exact.data(), data.size(), len));
+        CHECK(len == data.size() && Bytes(exact.begin(), exact.begin() + len) == data);
+        if (!data.empty()) CHECK(!Base58::decode(encoded, exact.data(), data.size() - 1, len));
+    }
+
+    // Characters outside the alphabet (0, O, I, l), whitespace and NULs;
+    // unlike Core, not even whitespace at either end is skipped
+    Bytes decoded;
+    std::vector<std::string> invalid{"invalid", "0", "O", "I", "l", "3SEo3LWLoPntC ", " 3SEo3LWLoPntC",
+                                     "3SEo3LW LoPntC", std::string("3SEo3LWLoPntC\0", 14), "3SEo3LWLoPntC\n"};
+    for (const std::string& bad : invalid) {
+        CHECK(!Base58::decode(bad, decoded));
+        CHECK(decoded.empty());
+    }
+}
+
+void test_zeros() {
+    // Every zero byte is one '1' and nothing else - no extra digit for the
+    // (zero) value after them
+    for (size_t n = 0; n <= 300; n++) {
+        Bytes zeros(n, 0);
+        std::string ones(n, '1');
+        CHECK(Base58::encode(zeros) == ones);
+        Bytes decoded;
+        CHECK(Base58::decode(ones, decoded, n));
+        CHECK(decoded == zeros);
+        if (n) CHECK(!Base58::decode(ones, decoded, n - 1));
+
+        Bytes one_after = zeros;
+        one_after.push_back(1);
+        CHECK(Base58::encode(one_after) == ones + "2");
+        CHECK(Base58::decode(ones + "2", decoded, n + 1) && decoded == one_after);
+    }
+}
+
+void test_check() {
+    const std::string hello = "3vQB7B6MrGQZaxCuFg4oh";    // "hello world" with its checksum
+    Bytes decoded;
+    CHECK(Base58::decode_check(hello, decoded));
+    CHECK(std::string(decoded.begin(), decoded.end()) == "hello world");
+    CHECK(Base58::encode_check(decoded) == hello);
+    CHECK(Base58::decode_check(hello, decoded, 11));
+    CHECK(!Base58::decode_check(hello, decoded, 10));   // the limit is on the payload
+    CHECK(decoded.empty());
+
+    // Any one character changed breaks the checksum, or the alphabet
+    for (size_t i = 0; i < hello.size(); i++) {
+        for (char c : {'1', 'z', '0'}) {
+            if (hello[i] == c) continue;
+            std::string corrupted = hello;
+            corrupted[i] = c;
+            CHECK(!Base58::decode_check(corrupted, decoded));
+            CHECK(decoded.empty());
+        }
+    }
+    // Dropped, added or swapped characters
+    CHECK(!Base58::decode_check(hello.substr(1), decoded));
+    CHECK(!Base58::decode_check(hello.substr(0, hello.size() - 1), decoded));
+    CHECK(!Base58::decode_check(hello + "1", decoded));
+    CHECK(!Base58::decode_check("1" + hello, decoded));
+    std::string swapped = hello;
+    std::swap(swapped[3], swapped[4]);
+    CHECK(!Base58::decode_check(swapped, decoded));
+
+    // Too short to hold a checksum at all, including nothing
+    for (const char* short_input : {"", "1", "111", "2g", "a3gV"}) CHECK(!Base58::decode_check(short_input, decoded));
+
+    // An empty payload is just its checksum
+    std::string empty = Base58::encode_check({});
+    CHECK(Base58::decode_check(empty, decoded) && decoded.empty());
+    CHECK(Base58::decode_check(Base58::encode_check(Bytes(5, 0)), decoded) && decoded == Bytes(5, 0));
+}
+
+// Random lengths through the stack and heap paths, checking decode()'s
+// early length estimate never turns down a result that fits
+void test_round_trips(std::mt19937_64& rng) {
+    for (size_t size = 0; size <= 2 * Base58::STACK_SIZE + 20; size++) {
+        for (int round = 0; round < 4; round++) {
+            Bytes data(size);
+            for (unsigned char& b : data) b = (unsigned char)rng();
+            // Biggest and smallest numbers of this length, and leading zeros
+            if (round == 1) std::fill(data.begin(), data.end(), 0xff);
+            if (round == 2 && size) data[0] = 1;
+            if (round == 3) std::fill(data.begin(), data.begin() + std::min<size_t>(size, rng() % 8), 0);
+
+            std::string encoded = Base58::encode(data);
+            CHECK(encoded.size() <= Base58::max_encoded_size(size));
+            Bytes decoded;
+            CHECK(Base58::decode(encoded, decoded, size));
+            CHECK(decoded == data);
+            if (size) CHECK(!Base58::decode(encoded, decoded, size - 1));
+            CHECK(Base58::decode_check(Base58::encode_check(data), decoded, size) && decoded == data);
+        }
+    }
+}
+
+void test_limits() {
+    // n 'z's are the largest n-digit number: the limb buffer has to hold
+    // its full width, and max_len has to cut it off exactly
+    Bytes decoded;
+    for (size_t n = 1; n <= 400; n++) {
+        std::string digits(n, 'z');
+        CHECK(Base58::decode(digits, decoded, SIZE_MAX));
+        size_t size = decoded.size();
+        CHECK(size > 0 && decoded[0] != 0);
+        CHECK(Base58::encode(decoded) == digits);
+        CHECK(Base58::decode(digits, decoded, size) && decoded.size() == size);
+        CHECK(!Base58::decode(digits, decoded, size - 1));
+        // "2" followed by '1's: the smallest n-digit number
+        std::string smallest = "2" + std::string(n - 1, '1');
+        CHECK(Base58::decode(smallest, decoded, SIZE_MAX));
+        CHECK(Base58::encode(decoded) == smallest);
+    }
+
+    // The default limit
+    CHECK(Base58::decode(std::string(Base58::MAX_DECODED_SIZE, '1'), decoded));
+    CHECK(!Base58::decode(std::string(Base58::MAX_DECODED_SIZE + 1, '1'), decoded));
+    // Far too long is turned down before the conversion
+    CHECK(!Base58::decode(std::string(100000, 'z'), decoded));
+    CHECK(decoded.empty());
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(58);
+    test_vectors();
+    test_zeros();
+    test_check();
+    test_round_trips(rng);
+    test_limits();
+    return test_result();
+}
@@ -0,0 +1,221 @@
+// tests/test_block_index.cpp
+//
+// BlockIndex on a forked tree of a few thousand headers: get_ancestor()'s
+// skip-list walk against plain parent steps, find_fork() between branches,
+// the shape of get_locator(), and Chain moving between branches.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "blockchain/block_index.h"
+#include "check.h"
+#include "test_util.h"
+
+using namespace bitcoin;
+
+namespace {
+
+/**
+ * A main chain of 3000 headers with branches off it: 1000 headers from
+ * height 1500, 200 from height 2200 of that branch, 50 from the genesis
+ * block and 1 from the main tip's parent. No proof of work - add_header()
+ * leaves that to its caller.
+ */
+struct Tree {
+    BlockIndex index;
+    BlockIndexEntry* genesis = nullptr;
+    BlockIndexEntry* main_tip = nullptr;
+    BlockIndexEntry* branch_tip = nullptr;      // from 1500
+    BlockIndexEntry* twig_tip = nullptr;        // from 2200 on the branch
+    BlockIndexEntry* early_tip = nullptr;       // from the genesis block
+    BlockIndexEntry* stale_tip = nullptr;       // from 2998
+    std::vector<BlockIndexEntry*> all;
+
+    Tree() {
+        BlockHeader header;
+        header.bits = test::REGTEST_BITS;
+        genesis = index.add_header(header);
+        all.push_back(genesis);
+        main_tip = extend(genesis, 2999, 0);
+        branch_tip = extend(main_tip->get_ancestor(1500), 1000, 1);
+        twig_tip = extend(branch_tip->get_ancestor(2200), 200, 2);
+        early_tip = extend(genesis, 50, 3);
+        stale_tip = extend(main_tip->get_ancestor(2998), 1, 4);
+    }
+
+    // `count` headers on top of `from`, told apart from other branches by `branch`
+    BlockIndexEntry* extend(BlockIndexEntry* from, uint32_t count, uint32_t branch) {
+        for (uint32_t i = 0; i < count; i++) {
+            BlockHeader header;
+            header.previous_block_hash = from->get_hash();
+            header.timestamp = test::FIRST_BLOCK_TIME + 600 * (from->height + 1);
+            header.bits = test::REGTEST_BITS;
+            header.nonce = branch;
+            from = index.add_header(header);
+            CHECK(from);
+            all.push_back(from);
+        }
+        return from;
+    }
+};
+
+const BlockIndexEntry* walk_to(const BlockIndexEntry* entry, uint32_t height) {
+    while (entry && entry->height > height) entry = entry->parent;
+    return entry && entry->height == height ? entry : nullptr;
+}
+
+const BlockIndexEntry* walk_fork(const BlockIndexEntry* a, const BlockIndexEntry* b) {
+    a = walk_to(a, std::min(a->height, b->height));
+    b = walk_to(b, a->height);
+    while (a != b) {
+        a = a->parent;
+        b = b->parent;
+    }
+    return a;
+}
+
+void test_ancestors(const Tree& tree, std::mt19937_64& rng) {
+    CHECK(tree.index.size() == 3000 + 1000 + 200 + 50 + 1);
+    CHECK(tree.main_tip->height == 2999 && tree.branch_tip->height == 2500 && tree.twig_tip->height == 2400);
+
+    // Every height below each tip
+    for (const BlockIndexEntry* tip : {tree.main_tip, tree.branch_tip, tree.twig_tip, tree.early_tip}) {
+        const BlockIndexEntry* walk = tip;
+        for (uint32_t height = tip->height + 1; height-- > 0;) {
+            CHECK(tip->get_ancestor(height) == walk);
+            walk = walk->parent;
+        }
+        CHECK(!walk);
+        CHECK(!tip->get_ancestor(tip->height + 1));
+    }
+
+    // Random pairs anywhere in the tree, and where the skips point
+    for (int i = 0; i < 20000; i++) {
+        const BlockIndexEntry* entry = tree.all[rng() % tree.all.size()];
+        uint32_t height = rng() % (entry->height + 1);
+        CHECK(entry->get_ancestor(height) == walk_to(entry, height));
+    }
+    for (const BlockIndexEntry* entry : tree.all) {
+        if (entry->height == 0) CHECK(!entry->skip);
+        else CHECK(entry->skip && entry->skip->height < entry->height && entry->skip == walk_to(entry, entry->skip->height));
+    }
+}
+
+void test_find_fork(const Tree& tree, std::mt19937_64& rng) {
+    const BlockIndexEntry* at_1500 = tree.main_tip->get_ancestor(1500);
+    CHECK(find_fork(tree.main_tip, tree.branch_tip) == at_1500);
+    CHECK(find_fork(tree.branch_tip, tree.main_tip) == at_1500);
+    CHECK(find_fork(tree.main_tip, tree.twig_tip) == at_1500);
+    CHECK(find_fork(tree.branch_tip, tree.twig_tip) == tree.branch_tip->get_ancestor(2200));
+    CHECK(find_fork(tree.main_tip, tree.early_tip) == tree.genesis);
+    CHECK(find_fork(tree.main_tip, tree.stale_tip) == tree.main_tip->parent);
+    CHECK(find_fork(tree.main_tip, tree.main_tip) == tree.main_tip);
+    CHECK(find_fork(tree.main_tip, tree.main_tip->get_ancestor(777)) == tree.main_tip->get_ancestor(777));
+    CHECK(!find_fork(tree.main_tip, nullptr) && !find_fork(nullptr, tree.main_tip));
+
+    for (int i = 0; i < 5000; i++) {
+        const BlockIndexEntry* a = tree.all[rng() % tree.all.size()];
+        const BlockIndexEntry* b = tree.all[rng() % tree.all.size()];
+        CHECK(find_fork(a, b) == walk_fork(a, b));
+    }
+}
+
+// Heights get_locator() should list from `height`, as Bitcoin Core does:
+// twelve in a row, then steps doubling from 2, and always the genesis block
+std::vector<uint32_t> locator_heights(uint32_t height) {
+    std::vector<uint32_t> heights;
+    uint32_t step = 1;
+    for (size_t i = 0; heights.empty() || heights.back() > 0; i++) {
+        heights.push_back(height);
+        if (i >= 11) step *= 2;
+        height = height > step ? height - step : 0;
+    }
+    return heights;
+}
+
+void test_locator(const Tree& tree) {
+    CHECK(get_locator(nullptr).empty());
+    CHECK(get_locator(tree.genesis) == std::vector<crypto::Hash256>{tree.genesis->get_hash()});
+
+    for (const BlockIndexEntry* tip : {tree.main_tip, tree.branch_tip, tree.twig_tip, tree.early_tip,
+                                       tree.main_tip->get_ancestor(10), tree.main_tip->get_ancestor(11),
+                                       tree.main_tip->get_ancestor(12)}) {
+        std::vector<crypto::Hash256> locator = get_locator(tip);
+        std::vector<uint32_t> heights = locator_heights(tip->height);
+        CHECK(locator.size() == heights.size());
+        for (size_t i = 0; i < locator.size() && i < heights.size(); i++) {
+            CHECK(locator[i] == tip->get_ancestor(heights[i])->get_hash());
+        }
+        CHECK(locator.back() == tree.genesis->get_hash());
+    }
+
+    // Spelled out for the main tip
+    std::vector<uint32_t> expected{2999, 2998, 2997, 2996, 2995, 2994, 2993, 2992, 2991, 2990, 2989, 2988,
+                                   2986, 2982, 2974, 2958, 2926, 2862, 2734, 2478, 1966, 942, 0};
+    CHECK(locator_heights(2999) == expected);
+    std::vector<uint32_t> heights;
+    for (const crypto::Hash256& hash : get_locator(tree.main_tip)) heights.push_back(tree.index.lookup(hash)->height);
+    CHECK(heights == expected);
+
+    Chain chain;
+    chain.set_tip(tree.branch_tip);
+    CHECK(chain.get_locator() == get_locator(tree.branch_tip));
+}
+
+void test_chain(const Tree& tree) {
+    Chain chain;
+    CHECK(chain.height() == -1 && !chain.tip() && !chain.find_fork(tree.main_tip));
+    chain.set_tip(tree.main_tip);
+    CHECK(chain.height() == 2999 && chain.genesis() == tree.genesis);
+    CHECK(chain.find_fork(tree.twig_tip) == tree.main_tip->get_ancestor(1500));
+    CHECK(chain.find_fork(tree.main_tip->get_ancestor(2000)) == tree.main_tip->get_ancestor(2000));
+
+    // Over to the twig: only the heights above the fork change
+    chain.set_tip(tree.twig_tip);
+    CHECK(chain.height() == 2400 && chain.tip() == tree.twig_tip);
+    for (uint32_t height = 0; height <= 2400; height++) CHECK(chain[height] == tree.twig_tip->get_ancestor(height));
+    CHECK(!chain[2401]);
+    CHECK(chain.contains(tree.main_tip->get_ancestor(1500)) && !chain.contains(tree.main_tip->get_ancestor(1501)));
+    CHECK(!chain.contains(tree.branch_tip));
+    CHECK(chain.next(tree.main_tip->get_ancestor(1500)) == tree.twig_tip->get_ancestor(1501));
+    CHECK(!chain.next(tree.twig_tip) && !chain.next(tree.main_tip));
+    CHECK(chain.find_fork(tree.branch_tip) == tree.twig_tip->get_ancestor(2200));
+
+    // And to the short branch off the genesis block
+    chain.set_tip(tree.early_tip);
+    CHECK(chain.height() == 50 && chain[50] == tree.early_tip && chain[1] == tree.early_tip->get_ancestor(1));
+    chain.set_tip(nullptr);
+    CHECK(!chain.tip());
+}
+
+void test_failed(Tree& tree) {
+    // Every header has the same work, so the best is the first one to reach
+    // the greatest height - until its chain is failed
+    CHECK(tree.index.get_best_header() == tree.main_tip);
+    tree.index.mark_failed(tree.main_tip->get_ancestor(1600));
+    CHECK(!tree.main_tip->is_valid() && !tree.stale_tip->is_valid());
+    CHECK(tree.main_tip->get_ancestor(1599)->is_valid() && tree.branch_tip->is_valid());
+    CHECK(tree.index.get_best_header() == tree.branch_tip);
+
+    // Children of a failed block come in failed
+    BlockHeader child;
+    child.previous_block_hash = tree.main_tip->get_hash();
+    child.bits = test::REGTEST_BITS;
+    const BlockIndexEntry* entry = tree.index.add_header(child);
+    CHECK(entry && !entry->is_valid());
+    CHECK(tree.index.get_best_header() == tree.branch_tip);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(2024);
+    Tree tree;
+    test_ancestors(tree, rng);
+    test_find_fork(tree, rng);
+    test_locator(tree);
+    test_chain(tree);
+    test_failed(tree);
+    return test_result();
+}
@@ -0,0 +1,187 @@
+// tests/test_block_template.cpp
+//
+// MerkleTree's incremental updates against a full rebuild after every
+// append, replace and remove (roots, branches and the sizes where levels
+// come and go), and BlockTemplate keeping its header's merkle root and
+// coinbase branch right through coinbase swaps and transaction changes.
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "blockchain/merkle.h"
+#include "check.h"
+#include "mining/block_template.h"
+#include "test_util.h"
+
+using namespace bitcoin;
+using crypto::Hash256;
+
+namespace {
+
+const test::TestKey key(1);
+
+Hash256 random_hash(std::mt19937_64& rng) {
+    Hash256 hash;
+    for (size_t i = 0; i < hash.size(); i++) hash.data()[i] = (unsigned char)rng();
+    return hash;
+}
+
+// Everything `tree` answers matches a tree built from scratch over `leaves`
+bool matches_rebuild(const MerkleTree& tree, const std::vector<Hash256>& leaves) {
+    if (tree.size() != leaves.size() || tree.root() != compute_merkle_root(leaves)) return false;
+    if (MerkleTree(leaves).root() != tree.root()) return false;
+    for (size_t i = 0; i < leaves.size(); i++) {
+        if (tree.leaf(i) != leaves[i] || tree.branch(i) != compute_merkle_branch(leaves, i)) return false;
+    }
+    return tree.branch(leaves.size()).empty();
+}
+
+void test_append() {
+    // One at a time from empty past a few powers of two: each append can add
+    // a level or end an odd level's self-pairing
+    std::mt19937_64 rng(1);
+    MerkleTree tree;
+    std::vector<Hash256> leaves;
+    CHECK(matches_rebuild(tree, leaves));
+    for (int i = 0; i < 70; i++) {
+        leaves.push_back(random_hash(rng));
+        tree.append(leaves.back());
+        CHECK(matches_rebuild(tree, leaves));
+    }
+}
+
+void test_replace_remove() {
+    std::mt19937_64 rng(2);
+    for (size_t count : {1, 2, 3, 4, 5, 8, 9, 16, 17, 33}) {
+        std::vector<Hash256> leaves;
+        for (size_t i = 0; i < count; i++) leaves.push_back(random_hash(rng));
+        MerkleTree tree(leaves);
+        CHECK(matches_rebuild(tree, leaves));
+
+        for (size_t i = 0; i < count; i++) {
+            leaves[i] = random_hash(rng);
+            tree.replace(i, leaves[i]);
+            CHECK(matches_rebuild(tree, leaves));
+        }
+
+        // Down to nothing from the end, the front and the middle, so the
+        // tree loses levels on the way
+        for (int where = 0; where < 3; where++) {
+            MerkleTree shrinking(leaves);
+            std::vector<Hash256> left = leaves;
+            while (!left.empty()) {
+                size_t index = where == 0 ? left.size() - 1 : where == 1 ? 0 : left.size() / 2;
+                left.erase(left.begin() + index);
+                shrinking.remove(index);
+                CHECK(matches_rebuild(shrinking, left));
+            }
+            CHECK(shrinking.root() == Hash256());
+            // And usable again afterwards
+            shrinking.append(leaves[0]);
+            CHECK(matches_rebuild(shrinking, {leaves[0]}));
+        }
+    }
+}
+
+void test_random_edits() {
+    std::mt19937_64 rng(3);
+    MerkleTree tree;
+    std::vector<Hash256> leaves;
+    for (int step = 0; step < 3000; step++) {
+        size_t op = rng() % 10;
+        if (leaves.empty() || op < 4) {
+            leaves.push_back(random_hash(rng));
+            tree.append(leaves.back());
+        } else if (op < 7) {
+            size_t index = rng() % leaves.size();
+            leaves[index] = random_hash(rng);
+            tree.replace(index, leaves[index]);
+        } else {
+            size_t index = rng() % leaves.size();
+            leaves.erase(leaves.begin() + index);
+            tree.remove(index);
+        }
+        CHECK(tree.root() == compute_merkle_root(leaves));
+        if (step % 250 == 0) CHECK(matches_rebuild(tree, leaves));
+    }
+    CHECK(matches_rebuild(tree, leaves));
+}
+
+TransactionRef make_tx(const std::string& name) {
+    TransactionBuilder builder;
+    builder.add_input(TransactionInput(crypto::Hash::sha256(name), 0, ""));
+    builder.add_output(TransactionOutput(1000, key.script));
+    return std::move(builder).build();
+}
+
+// The header commits to what's in the block, and the coinbase branch proves the coinbase
+bool consistent(const BlockTemplate& tmpl) {
+    const Block& block = tmpl.get_block();
+    std::vector<Hash256> txids;
+    for (const TransactionRef& tx : block.transactions) txids.push_back(tx->get_txid());
+    if (tmpl.size() != txids.size() || tmpl.get_header().merkle_root != compute_merkle_root(txids)) return false;
+    if (txids.empty()) return true;
+    return verify_merkle_branch(txids[0], tmpl.get_coinbase_branch(), 0, tmpl.get_header().merkle_root);
+}
+
+void test_block_template() {
+    BlockTemplate tmpl;
+    CHECK(tmpl.size() == 0 && tmpl.get_header().merkle_root == Hash256());
+
+    // Transactions first, the coinbase later goes in front of them
+    for (int i = 0; i < 5; i++) {
+        tmpl.add_transaction(make_tx("tx " + std::to_string(i)));
+        CHECK(consistent(tmpl));
+    }
+    tmpl.set_coinbase(test::make_coinbase(1, {TransactionOutput(50, key.script)}));
+    CHECK(tmpl.size() == 6 && tmpl.get_block().transactions[0]->is_coinbase());
+    CHECK(consistent(tmpl));
+
+    // New extranonce, then more transactions, then another extranonce
+    for (int extranonce = 0; extranonce < 10; extranonce++) {
+        tmpl.set_coinbase(test::make_coinbase(1, {TransactionOutput(50, key.script)}, std::to_string(extranonce)));
+        CHECK(tmpl.size() == 6 + 3 * extranonce);
+        CHECK(consistent(tmpl));
+        for (int i = 0; i < 3; i++) {
+            tmpl.add_transaction(make_tx("more " + std::to_string(extranonce) + " " + std::to_string(i)));
+            CHECK(consistent(tmpl));
+        }
+    }
+
+    tmpl.replace_transaction(7, make_tx("replacement"));
+    CHECK(consistent(tmpl));
+    CHECK(tmpl.get_block().transactions[7]->get_txid() == make_tx("replacement")->get_txid());
+    while (tmpl.size() > 1) {
+        tmpl.remove_transaction(tmpl.size() / 2);
+        CHECK(consistent(tmpl));
+    }
+    CHECK(tmpl.get_coinbase_branch().empty());
+    CHECK(tmpl.get_header().merkle_root == tmpl.get_block().transactions[0]->get_txid());
+
+    bool threw = false;
+    try {
+        tmpl.replace_transaction(1, make_tx("past the end"));
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    threw = false;
+    try {
+        tmpl.remove_transaction(1);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(consistent(tmpl));
+}
+
+} // namespace
+
+int main() {
+    test_append();
+    test_replace_remove();
+    test_random_edits();
+    test_block_template();
+    return test_result();
+}
@@ -0,0 +1,265 @@
+// tests/test_coins.cpp
+//
+// connect_block() and disconnect_block() on a UtxoSet, below the script and
+// header checks: blocks connected and disconnected again through their
+// (serialized) BlockUndo, blocks failing part way through and rolled back,
+// and coinbase maturity.
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "coins/utxo_set.h"
+#include "test_util.h"
+#include "util/serialize.h"
+
+using namespace bitcoin;
+
+namespace {
+
+const test::TestKey key(1);
+
+// Unsigned: connect_block() doesn't run scripts
+TransactionRef transfer(const std::vector<OutPoint>& from, const std::vector<uint64_t>& values) {
+    TransactionBuilder builder;
+    for (const OutPoint& outpoint : from) builder.add_input(TransactionInput(outpoint.txid, outpoint.vout, ""));
+    for (uint64_t value : values) builder.add_output(TransactionOutput(value, key.script));
+    return std::move(builder).build();
+}
+
+Block block_of(uint32_t height, std::vector<TransactionRef> transactions) {
+    Block block;
+    block.transactions.push_back(test::make_coinbase(height, {TransactionOutput(50 * COIN, key.script)}));
+    for (TransactionRef& tx : transactions) block.transactions.push_back(std::move(tx));
+    return block;
+}
+
+OutPoint out(const TransactionRef& tx, uint32_t vout) { return OutPoint(tx->get_txid(), vout); }
+
+/**
+ * Coin-level chain: coinbase-only blocks at heights 0 to 100, so block 101
+ * can spend the first coinbase. snapshot() reads back every outpoint any
+ * block here has created or spent, in the order they were first seen.
+ */
+struct TestCoins {
+    UtxoSet utxo;
+    std::vector<Block> blocks;
+    std::vector<OutPoint> seen;
+
+    TestCoins() {
+        for (uint32_t height = 0; height <= 100; height++) CHECK(connect(block_of(height, {})));
+    }
+
+    uint32_t height() const { return blocks.size(); }
+
+    OutPoint coinbase(uint32_t height) const { return out(blocks[height].transactions[0], 0); }
+
+    bool connect(const Block& block, BlockUndo* undo_out = nullptr) {
+        note(block);
+        BlockUndo undo;
+        if (!connect_block(utxo, block, height(), undo)) return false;
+        blocks.push_back(block);
+        if (undo_out) *undo_out = std::move(undo);
+        return true;
+    }
+
+    void note(const Block& block) {
+        auto add = [this](const OutPoint& outpoint) {
+            if (std::find(seen.begin(), seen.end(), outpoint) == seen.end()) seen.push_back(outpoint);
+        };
+        for (const TransactionRef& tx : block.transactions) {
+            for (const TransactionInput& input : tx->inputs) add(OutPoint(input));
+            for (uint32_t i = 0; i < tx->outputs.size(); i++) add(out(tx, i));
+        }
+    }
+
+    struct Entry {
+        uint64_t value;
+        uint32_t height;
+        bool coinbase;
+        friend bool operator==(const Entry&, const Entry&) = default;
+    };
+
+    std::vector<std::optional<Entry>> snapshot() const {
+        std::vector<std::optional<Entry>> result;
+        for (const OutPoint& outpoint : seen) {
+            Coin coin;
+            if (utxo.get_coin(outpoint, coin)) result.push_back(Entry{coin.out.value, coin.height, (bool)coin.coinbase});
+            else result.push_back(std::nullopt);
+        }
+        return result;
+    }
+};
+
+BlockUndo reserialized(const BlockUndo& undo) {
+    std::vector<unsigned char> bytes;
+    VectorWriter writer(bytes);
+    undo.serialize(writer);
+    SpanReader reader(bytes);
+    BlockUndo copy = BlockUndo::deserialize(reader);
+    CHECK(reader.empty());
+    return copy;
+}
+
+void test_round_trip() {
+    TestCoins coins;
+    uint32_t height = coins.height();
+
+    // Spends the first coinbase, then its own outputs within the block; an
+    // OP_RETURN output that never becomes a coin; two inputs at once
+    TransactionRef a = transfer({coins.coinbase(0)}, {20 * COIN, 20 * COIN, 10 * COIN - 1000});
+    TransactionRef b = transfer({out(a, 0)}, {20 * COIN - 1000});
+    TransactionBuilder burn;
+    burn.add_input(TransactionInput(a->get_txid(), 1, ""));
+    burn.add_output(TransactionOutput(0, Script(crypto::hex_to_bytes("6a0474657374"))));
+    burn.add_output(TransactionOutput(20 * COIN - 500, key.script));
+    TransactionRef c = std::move(burn).build();
+    TransactionRef d = transfer({out(b, 0), coins.coinbase(1)}, {70 * COIN - 1000});
+    Block block = block_of(height, {a, b, c, d});
+
+    coins.note(block);
+    auto before = coins.snapshot();
+    size_t size_before = coins.utxo.size();
+    BlockUndo undo;
+    uint64_t fees = 0;
+    CHECK(connect_block(coins.utxo, block, height, undo, &fees));
+    CHECK(fees == 1000 + 1000 + 500);
+
+    // What's left: the new coinbase, a:2, c:1 and d:0
+    CHECK(coins.utxo.size() == size_before - 2 + 4);
+    for (OutPoint spent : {coins.coinbase(0), coins.coinbase(1), out(a, 0), out(a, 1), out(b, 0)}) {
+        CHECK(!coins.utxo.have_coin(spent));
+    }
+    CHECK(!coins.utxo.have_coin(out(c, 0)));
+    Coin coin;
+    CHECK(coins.utxo.get_coin(out(d, 0), coin) && coin.height == height && !coin.coinbase);
+    CHECK(coins.utxo.get_coin(out(block.transactions[0], 0), coin) && coin.coinbase);
+
+    // One entry per non-coinbase transaction, in input order
+    CHECK(undo.txs.size() == 4);
+    CHECK(undo.txs[0].spent.size() == 1 && undo.txs[0].spent[0].coinbase && undo.txs[0].spent[0].height == 0);
+    CHECK(undo.txs[3].spent.size() == 2);
+    CHECK(undo.txs[3].spent[0].out.value == 20 * COIN - 1000 && undo.txs[3].spent[1].height == 1);
+
+    // Back again from the undo data as it would come off disk
+    CHECK(disconnect_block(coins.utxo, block, reserialized(undo)));
+    CHECK(coins.snapshot() == before);
+    CHECK(coins.utxo.size() == size_before);
+
+    // Undo data that doesn't match the block is refused before anything changes
+    BlockUndo short_undo = undo;
+    short_undo.txs.pop_back();
+    CHECK(connect_block(coins.utxo, block, height, undo));
+    auto connected = coins.snapshot();
+    CHECK(!disconnect_block(coins.utxo, block, short_undo));
+    CHECK(!disconnect_block(coins.utxo, block, BlockUndo()));
+    BlockUndo extra_input = undo;
+    extra_input.txs[1].spent.push_back(Coin());
+    CHECK(!disconnect_block(coins.utxo, block, extra_input));
+    CHECK(coins.snapshot() == connected);
+    CHECK(disconnect_block(coins.utxo, block, undo));
+    CHECK(coins.snapshot() == before);
+
+    // Disconnecting twice doesn't match the view any more
+    CHECK(!disconnect_block(coins.utxo, block, undo));
+}
+
+void test_chain_round_trip() {
+    // Ten blocks, each spending the previous one's output, taken off in reverse
+    TestCoins coins;
+    auto before = coins.snapshot();
+    size_t size_before = coins.utxo.size();
+    std::vector<BlockUndo> undos;
+    OutPoint from = coins.coinbase(0);
+    uint64_t value = 50 * COIN;
+    for (int i = 0; i < 10; i++) {
+        value -= 1000;
+        TransactionRef tx = transfer({from, coins.coinbase(i + 1)}, {value, 50 * COIN});
+        CHECK(coins.connect(block_of(coins.height(), {tx}), &undos.emplace_back()));
+        from = out(tx, 0);
+    }
+    before.resize(coins.seen.size(), std::nullopt);   // new outpoints, all of them created here
+    CHECK(coins.utxo.size() == size_before - 11 + 10 + 10 + 1);
+
+    for (size_t i = undos.size(); i-- > 0;) {
+        CHECK(disconnect_block(coins.utxo, coins.blocks.back(), reserialized(undos[i])));
+        coins.blocks.pop_back();
+    }
+    // The coins these blocks spent are back, with their heights and flags
+    CHECK(coins.snapshot() == before);
+    CHECK(coins.utxo.size() == size_before);
+}
+
+void test_rollback() {
+    // Two good transactions and then one that fails: nothing may stay behind,
+    // not the good transactions' outputs and not their spends
+    TestCoins coins;
+    uint32_t height = coins.height();
+    TransactionRef a = transfer({coins.coinbase(0)}, {25 * COIN, 25 * COIN});
+    TransactionRef b = transfer({out(a, 0), coins.coinbase(1)}, {75 * COIN});
+
+    std::vector<TransactionRef> failing = {
+        transfer({OutPoint(crypto::Hash::sha256("missing"), 0)}, {1000}),      // no such coin
+        transfer({out(a, 1), out(a, 0)}, {1000}),                               // a:0 already spent by b
+        transfer({out(a, 1)}, {25 * COIN + 1}),                                 // creates money
+        transfer({out(a, 1)}, {MAX_MONEY + 1}),                                 // out of range
+        transfer({out(a, 1), coins.coinbase(2), coins.coinbase(2)}, {1000}),   // the same coin twice
+        transfer({out(a, 1), coins.coinbase(height - 1)}, {1000}),              // immature coinbase
+    };
+    for (const TransactionRef& bad : failing) {
+        Block block = block_of(height, {a, b, bad});
+        coins.note(block);
+        auto before = coins.snapshot();
+        size_t size_before = coins.utxo.size();
+        BlockUndo undo;
+        uint64_t fees = 12345;
+        CHECK(!connect_block(coins.utxo, block, height, undo, &fees));
+        CHECK(coins.snapshot() == before);
+        CHECK(coins.utxo.size() == size_before);
+        CHECK(undo.txs.empty());
+        CHECK(fees == 12345);
+    }
+
+    // Failing at the first transaction after the coinbase, and then the
+    // same block without the bad transaction still connects
+    Block block = block_of(height, {failing[0], a, b});
+    auto before = coins.snapshot();
+    BlockUndo undo;
+    CHECK(!connect_block(coins.utxo, block, height, undo));
+    CHECK(coins.snapshot() == before);
+    CHECK(coins.connect(block_of(height, {a, b})));
+}
+
+void test_maturity() {
+    // Block h's coinbase can first be spent in block h + COINBASE_MATURITY
+    TestCoins coins;
+    while (coins.height() < 150) CHECK(coins.connect(block_of(coins.height(), {})));
+    uint32_t height = coins.height();
+    for (uint32_t age : {1u, Coin::COINBASE_MATURITY - 1, Coin::COINBASE_MATURITY, Coin::COINBASE_MATURITY + 1}) {
+        Block block = block_of(height, {transfer({coins.coinbase(height - age)}, {50 * COIN})});
+        BlockUndo undo;
+        bool connected = connect_block(coins.utxo, block, height, undo);
+        CHECK(connected == (age >= Coin::COINBASE_MATURITY));
+        if (connected) CHECK(disconnect_block(coins.utxo, block, undo));
+    }
+
+    // A non-coinbase output can be spent in the same block it was created
+    TransactionRef a = transfer({coins.coinbase(0)}, {50 * COIN});
+    TransactionRef b = transfer({out(a, 0)}, {50 * COIN});
+    CHECK(coins.connect(block_of(height, {a, b})));
+    // But the new coinbase can't be
+    Block next = block_of(coins.height(), {transfer({out(coins.blocks.back().transactions[0], 0)}, {1000})});
+    BlockUndo undo;
+    CHECK(!connect_block(coins.utxo, next, coins.height(), undo));
+}
+
+} // namespace
+
+int main() {
+    test_round_trip();
+    test_chain_round_trip();
+    test_rollback();
+    test_maturity();
+    return test_result();
+}
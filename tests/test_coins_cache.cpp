@@ -0,0 +1,161 @@
+// tests/test_coins_cache.cpp
+//
+// CoinsViewCache flushes into a CoinsViewDB: which entries reach the
+// database (DIRTY), which are dropped without a write because it never had
+// them (FRESH), and what a reopened database holds afterwards.
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include "check.h"
+#include "coins/coins_cache.h"
+#include "coins/coins_db.h"
+#include "test_util.h"
+
+using namespace bitcoin;
+
+namespace {
+
+const test::TestKey key(1);
+
+struct TempDir {
+    std::string path;
+
+    explicit TempDir(const std::string& name)
+        : path((std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))).string()) {
+        std::filesystem::remove_all(path);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+};
+
+KvStoreOptions test_options() {
+    KvStoreOptions options;
+    options.sync_writes = false;
+    return options;
+}
+
+OutPoint outpoint(const std::string& name) { return OutPoint(crypto::Hash::sha256(name), 0); }
+
+Coin coin(uint64_t value, uint32_t height = 1) { return Coin(TransactionOutput(value, key.script), height, false); }
+
+uint64_t value_in(const CoinsView& view, const OutPoint& at) {
+    Coin found;
+    return view.get_coin(at, found) ? found.out.value : 0;
+}
+
+void test_fresh() {
+    // Added and spent between flushes: nothing for the database
+    TempDir dir("test_coins_cache_fresh");
+    CoinsViewDB db(dir.path, test_options());
+    CoinsViewCache cache(db);
+    cache.add_coin(outpoint("a"), coin(1000));
+    cache.add_coin(outpoint("b"), coin(2000));
+    CHECK(cache.stats().dirty_coins == 2);
+    CHECK(cache.spend_coin(outpoint("a")));
+    CHECK(!cache.have_coin(outpoint("a")));
+    CHECK(cache.stats().cached_coins == 1);
+    CHECK(cache.stats().dirty_coins == 1);
+
+    cache.set_best_block(crypto::Hash::sha256("block 1"));
+    cache.flush();
+    CHECK(cache.stats().coins_written == 1);
+    CHECK(db.coin_count() == 1);
+    CHECK(!db.have_coin(outpoint("a")));
+    CHECK(value_in(db, outpoint("b")) == 2000);
+    CHECK(db.get_best_block() == crypto::Hash::sha256("block 1"));
+    CHECK(cache.stats().cached_coins == 0);
+
+    // Spending a coin the database has is a delete on the next flush
+    CHECK(cache.spend_coin(outpoint("b")));
+    CHECK(!cache.spend_coin(outpoint("b")));
+    CHECK(db.have_coin(outpoint("b")));             // not before the flush
+    CHECK(cache.stats().dirty_coins == 1);
+    cache.flush();
+    CHECK(cache.stats().coins_written == 2);
+    CHECK(db.coin_count() == 0);
+}
+
+void test_readd_spent() {
+    // A coin on disk, spent and then added again before a flush: the new coin
+    // can't be FRESH, as the database's copy still has to be replaced
+    TempDir dir("test_coins_cache_readd");
+    CoinsViewDB db(dir.path, test_options());
+    CoinsViewCache cache(db);
+    cache.add_coin(outpoint("a"), coin(1000));
+    cache.add_coin(outpoint("b"), coin(1000));
+    cache.flush();
+
+    // Spent, added, spent: the database copy must still be deleted
+    CHECK(cache.spend_coin(outpoint("a")));
+    cache.add_coin(outpoint("a"), coin(3000, 2));
+    CHECK(value_in(cache, outpoint("a")) == 3000);
+    CHECK(cache.spend_coin(outpoint("a")));
+    CHECK(!cache.have_coin(outpoint("a")));
+    // Spent, added: the new coin replaces the one on disk
+    CHECK(cache.spend_coin(outpoint("b")));
+    cache.add_coin(outpoint("b"), coin(4000, 2));
+    CHECK(cache.stats().dirty_coins == 2);
+    cache.flush();
+    CHECK(!db.have_coin(outpoint("a")));
+    CHECK(value_in(db, outpoint("b")) == 4000);
+    CHECK(db.coin_count() == 1);
+
+    // Read back from disk: a clean entry, nothing to write
+    CHECK(value_in(cache, outpoint("b")) == 4000);
+    CHECK(cache.stats().dirty_coins == 0);
+    cache.flush();
+    CHECK(db.coin_count() == 1);
+
+    // An unspent coin can't be added over once the cache holds it (only on
+    // disk it isn't looked up - see add_coin())
+    CHECK(cache.have_coin(outpoint("b")));
+    bool threw = false;
+    try {
+        cache.add_coin(outpoint("b"), coin(5000));
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    // unless it's one of the duplicate coinbases
+    cache.add_coin(outpoint("b"), coin(5000), true);
+    cache.flush();
+    CHECK(value_in(db, outpoint("b")) == 5000);
+}
+
+void test_reopen() {
+    // A flushed cache's coins and best block are what the next run starts from
+    TempDir dir("test_coins_cache_reopen");
+    {
+        CoinsViewDB db(dir.path, test_options());
+        CoinsViewCache cache(db);
+        CHECK(cache.get_best_block().is_null());
+        for (int i = 0; i < 100; i++) cache.add_coin(outpoint(std::to_string(i)), coin(1000 + i, i));
+        cache.set_best_block(crypto::Hash::sha256("block 100"));
+        cache.flush();
+        for (int i = 0; i < 100; i += 3) CHECK(cache.spend_coin(outpoint(std::to_string(i))));
+        cache.add_coin(outpoint("unflushed"), coin(1));
+        // Never flushed: none of this reaches the database
+    }
+    CoinsViewDB db(dir.path, test_options());
+    CHECK(db.coin_count() == 100);
+    CHECK(db.get_best_block() == crypto::Hash::sha256("block 100"));
+    CoinsViewCache cache(db);
+    CHECK(cache.get_best_block() == crypto::Hash::sha256("block 100"));
+    Coin found;
+    CHECK(cache.get_coin(outpoint("42"), found) && found.out.value == 1042 && found.height == 42);
+    CHECK(cache.have_coin(outpoint("0")));
+    CHECK(!cache.have_coin(outpoint("unflushed")));
+    CHECK(cache.stats().misses == 3 && cache.stats().hits == 0);
+    CHECK(cache.have_coin(outpoint("42")));
+    CHECK(cache.stats().hits == 1);
+}
+
+} // namespace
+
+int main() {
+    test_fresh();
+    test_readd_spent();
+    test_reopen();
+    return test_result();
+}
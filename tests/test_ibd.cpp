@@ -0,0 +1,205 @@
+// tests/test_ibd.cpp
+//
+// InitialBlockDownload end to end over a mined regtest chain served by
+// MemoryBlockSource: a clean run, a source sending a block that doesn't
+// match its header (stops the download, the header stays valid), an
+// invalid block (marked failed) and a source that throws mid-download.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "coins/utxo_set.h"
+#include "test_util.h"
+#include "validation/ibd.h"
+#include "validation/validation.h"
+
+using namespace bitcoin;
+
+namespace {
+
+const test::TestKey key(1);
+
+ConsensusParams test_params(const std::vector<Block>& blocks) {
+    ConsensusParams params = ConsensusParams::regtest();
+    params.genesis_hash = blocks[0].calculate_hash();
+    return params;
+}
+
+// Blocks 0 to `tip`, each paying the subsidy to `key`; block 101 spends the
+// genesis coinbase so the scripts get run too
+std::vector<Block> mine_chain(uint32_t tip) {
+    const ConsensusParams params = ConsensusParams::regtest();
+    std::vector<Block> blocks;
+    for (uint32_t height = 0; height <= tip; height++) {
+        std::vector<TransactionRef> txs;
+        if (height == 101) {
+            const TransactionRef& coinbase = blocks[0].transactions[0];
+            txs.push_back(test::spend(key, {{OutPoint(coinbase->get_txid(), 0), coinbase->outputs[0]}},
+                                      {TransactionOutput(coinbase->outputs[0].value - 1000, key.script)}));
+        }
+        TransactionOutput reward(get_block_subsidy(height, params) + (txs.empty() ? 0 : 1000), key.script);
+        blocks.push_back(test::make_block(height ? &blocks.back() : nullptr, height,
+                                          test::make_coinbase(height, {reward}), std::move(txs), params));
+    }
+    return blocks;
+}
+
+// Serves `chain`, except for one block: other bytes in its place, or an exception
+class FaultySource : public MemoryBlockSource {
+private:
+    crypto::Hash256 target;
+    std::vector<unsigned char> replacement;     // empty: throw instead
+
+public:
+    FaultySource(const std::vector<Block>& chain, const crypto::Hash256& hash, std::vector<unsigned char> bytes)
+        : MemoryBlockSource(chain), target(hash), replacement(std::move(bytes)) {}
+
+    bool get_block(const crypto::Hash256& hash, std::vector<unsigned char>& bytes) override {
+        if (hash != target) return MemoryBlockSource::get_block(hash, bytes);
+        if (replacement.empty()) throw std::runtime_error("connection reset");
+        bytes = replacement;
+        return true;
+    }
+};
+
+// Small windows and header batches, so every part of the pipeline wraps
+// around many times on a short chain
+IbdOptions test_options() {
+    IbdOptions options;
+    options.window = 8;
+    options.download_threads = 4;
+    options.script_threads = 2;
+    options.headers_per_request = 50;
+    return options;
+}
+
+struct Node {
+    BlockIndex index;
+    Chain chain;
+    UtxoSet utxo;
+};
+
+// run(), failing the test instead of hanging if it never returns
+bool run_ibd(InitialBlockDownload& ibd) {
+    auto result = std::async(std::launch::async, [&] { return ibd.run(); });
+    if (result.wait_for(std::chrono::seconds(60)) != std::future_status::ready) {
+        // The stuck threads can't be joined: report and leave without them
+        CHECK(!"IBD didn't finish");
+        int result = test_result();
+        std::fflush(stdout);
+        std::_Exit(result);
+    }
+    return result.get();
+}
+
+void test_full_run(const std::vector<Block>& blocks) {
+    MemoryBlockSource source(blocks);
+    Node node;
+    std::vector<uint32_t> connected;
+    IbdOptions options = test_options();
+    options.on_block_connected = [&](const BlockIndexEntry* entry) { connected.push_back(entry->height); };
+    InitialBlockDownload ibd({&source}, node.index, node.chain, node.utxo, test_params(blocks), options);
+    CHECK(run_ibd(ibd));
+    CHECK(ibd.get_error().empty());
+
+    CHECK(node.chain.height() == (int)blocks.size() - 1);
+    CHECK(node.chain.tip()->get_hash() == blocks.back().calculate_hash());
+    CHECK(ibd.stats().headers == blocks.size() && ibd.stats().blocks == blocks.size());
+    CHECK(ibd.stats().transactions == blocks.size() + 1);
+    CHECK(connected.size() == blocks.size());
+    for (size_t i = 0; i < connected.size(); i++) CHECK(connected[i] == i);
+    CHECK(node.chain.tip()->status & BLOCK_VALID_SCRIPTS);
+
+    // The genesis coinbase was spent in block 101, every other one is there
+    CHECK(node.utxo.size() == blocks.size());
+    CHECK(!node.utxo.have_coin(OutPoint(blocks[0].transactions[0]->get_txid(), 0)));
+    CHECK(node.utxo.have_coin(OutPoint(blocks[101].transactions[1]->get_txid(), 0)));
+    CHECK(node.utxo.have_coin(OutPoint(blocks.back().transactions[0]->get_txid(), 0)));
+
+    // Nothing more to do the second time
+    CHECK(run_ibd(ibd));
+    CHECK(ibd.stats().blocks == blocks.size());
+}
+
+void test_bad_merkle(const std::vector<Block>& blocks) {
+    // Block 60 with its coinbase changed under the same header
+    Block tampered = blocks[60];
+    TransactionBuilder coinbase(*tampered.transactions[0]);
+    coinbase.mutable_output(0).value--;
+    tampered.transactions[0] = std::move(coinbase).build();
+    crypto::Hash256 hash = blocks[60].calculate_hash();
+    CHECK(tampered.calculate_hash() == hash);
+    std::vector<unsigned char> bytes;
+    CHECK(MemoryBlockSource({tampered}).get_block(hash, bytes));
+    FaultySource source(blocks, hash, bytes);
+
+    Node node;
+    InitialBlockDownload ibd({&source}, node.index, node.chain, node.utxo, test_params(blocks), test_options());
+    CHECK(!run_ibd(ibd));
+    CHECK(ibd.get_error().find("merkle root") != std::string::npos);
+    CHECK(node.chain.height() == 59);
+    // The source's fault, not the block's: a good copy can still come later
+    const BlockIndexEntry* entry = node.index.lookup(hash);
+    CHECK(entry && entry->is_valid());
+    CHECK(node.index.get_best_header()->get_hash() == blocks.back().calculate_hash());
+
+    MemoryBlockSource honest(blocks);
+    InitialBlockDownload retry({&honest}, node.index, node.chain, node.utxo, test_params(blocks), test_options());
+    CHECK(run_ibd(retry));
+    CHECK(node.chain.height() == (int)blocks.size() - 1);
+}
+
+void test_invalid_block(std::vector<Block> blocks) {
+    // Block 70 pays its coinbase one satoshi too much; everything after it
+    // is mined on top
+    const ConsensusParams params = ConsensusParams::regtest();
+    blocks.resize(70);
+    TransactionOutput reward(get_block_subsidy(70, params) + 1, key.script);
+    blocks.push_back(test::make_block(&blocks.back(), 70, test::make_coinbase(70, {reward}), {}, params));
+    for (uint32_t height = 71; height <= 80; height++) {
+        TransactionOutput next(get_block_subsidy(height, params), key.script);
+        blocks.push_back(test::make_block(&blocks.back(), height, test::make_coinbase(height, {next}), {}, params));
+    }
+
+    MemoryBlockSource source(blocks);
+    Node node;
+    InitialBlockDownload ibd({&source}, node.index, node.chain, node.utxo, test_params(blocks), test_options());
+    CHECK(!run_ibd(ibd));
+    CHECK(ibd.get_error().find("is invalid") != std::string::npos);
+    CHECK(node.chain.height() == 69);
+    CHECK(!node.index.lookup(blocks[70].calculate_hash())->is_valid());
+    CHECK(!node.index.lookup(blocks[80].calculate_hash())->is_valid());
+    CHECK(node.index.get_best_header() == node.chain.tip());
+    CHECK(node.utxo.size() == 70);
+}
+
+void test_throwing_source(const std::vector<Block>& blocks) {
+    // The exception ends the run at that block; it must not leave the
+    // connecting thread waiting for a slot nobody fills
+    for (uint32_t height : {0u, 1u, 50u, 119u}) {
+        crypto::Hash256 hash = blocks[height].calculate_hash();
+        FaultySource source(blocks, hash, {});
+        Node node;
+        InitialBlockDownload ibd({&source}, node.index, node.chain, node.utxo, test_params(blocks), test_options());
+        CHECK(!run_ibd(ibd));
+        CHECK(ibd.get_error().find("connection reset") != std::string::npos);
+        CHECK(node.chain.height() == (int)height - 1);
+        CHECK(node.index.lookup(hash)->is_valid());
+    }
+}
+
+} // namespace
+
+int main() {
+    std::vector<Block> blocks = mine_chain(120);
+    test_full_run(blocks);
+    test_bad_merkle(blocks);
+    test_invalid_block(blocks);
+    test_throwing_source(blocks);
+    return test_result();
+}
@@ -0,0 +1,243 @@
+// tests/test_kv_store.cpp
+//
+// KvStore log replay after damage: a torn tail on the newest file is cut
+// off and the store carries on, while a damaged record with good ones
+// after it makes opening the store throw. Then compaction, by hand and on
+// its own, and what a reopened store finds afterwards.
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "check.h"
+#include "storage/kv_store.h"
+
+using namespace bitcoin;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+KvBytes bytes(const std::string& s) { return KvBytes((const unsigned char*)s.data(), s.size()); }
+
+KvStoreOptions test_options() {
+    KvStoreOptions options;
+    options.sync_writes = false;
+    return options;
+}
+
+// A fresh directory per test, removed again afterwards
+struct TempDir {
+    std::filesystem::path path;
+
+    explicit TempDir(const std::string& name)
+        : path(std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))) {
+        std::filesystem::remove_all(path);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+
+    std::filesystem::path log() const { return path / "00001.log"; }
+};
+
+void put(KvStore& store, const std::string& key, const std::string& value) {
+    WriteBatch batch;
+    batch.put(bytes(key), bytes(value));
+    store.write(batch);
+}
+
+bool has(const KvStore& store, const std::string& key, const std::string& value) {
+    Bytes found;
+    return store.get(bytes(key), found) && std::string(found.begin(), found.end()) == value;
+}
+
+Bytes read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return Bytes(std::istreambuf_iterator<char>(in), {});
+}
+
+void write_file(const std::filesystem::path& path, const Bytes& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char*)data.data(), data.size());
+}
+
+bool opens(const TempDir& dir) {
+    try {
+        KvStore store(dir.path.string(), test_options());
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+// Three records, returning where each one starts (and the end of the file)
+std::vector<size_t> write_three(const TempDir& dir) {
+    KvStore store(dir.path.string(), test_options());
+    std::vector<size_t> offsets{0};
+    for (const char* key : {"a", "b", "c"}) {
+        put(store, key, std::string(40, key[0]));
+        offsets.push_back(store.disk_usage());
+    }
+    return offsets;
+}
+
+void test_torn_tail() {
+    // Part of a fourth record: a header promising more than was written
+    TempDir dir("test_kv_store_torn");
+    std::vector<size_t> offsets = write_three(dir);
+    Bytes data = read_file(dir.log());
+    data.insert(data.end(), {0xe8, 0x03, 0, 0, 0x12, 0x34, 0x56, 0x78, 1, 1, 'd'});
+    write_file(dir.log(), data);
+    {
+        KvStore store(dir.path.string(), test_options());
+        CHECK(store.size() == 3);
+        CHECK(has(store, "c", std::string(40, 'c')));
+        CHECK(store.disk_usage() == offsets[3]);
+        put(store, "d", "after");
+    }
+    KvStore reopened(dir.path.string(), test_options());
+    CHECK(reopened.size() == 4);
+    CHECK(has(reopened, "d", "after"));
+}
+
+void test_torn_last_record() {
+    // The last record written in full but with a bad byte, then zeros a
+    // crash can leave behind
+    TempDir dir("test_kv_store_last");
+    std::vector<size_t> offsets = write_three(dir);
+    Bytes data = read_file(dir.log());
+    data[offsets[2] + 20] ^= 1;
+    data.resize(data.size() + 4096, 0);
+    write_file(dir.log(), data);
+    KvStore store(dir.path.string(), test_options());
+    CHECK(store.size() == 2);
+    CHECK(!store.contains(bytes("c")));
+    CHECK(store.disk_usage() == offsets[2]);
+}
+
+void test_corrupt_middle() {
+    // A length pointing past the end of the file, with good records after it
+    TempDir dir("test_kv_store_length");
+    std::vector<size_t> offsets = write_three(dir);
+    Bytes data = read_file(dir.log());
+    data[offsets[1] + 3] = 0x7f;
+    write_file(dir.log(), data);
+    CHECK(!opens(dir));
+    CHECK(read_file(dir.log()) == data);        // nothing truncated
+
+    // A bad CRC in the middle
+    TempDir crc_dir("test_kv_store_crc");
+    offsets = write_three(crc_dir);
+    data = read_file(crc_dir.log());
+    data[offsets[1] + 20] ^= 1;
+    write_file(crc_dir.log(), data);
+    CHECK(!opens(crc_dir));
+
+    // An older file is never truncated, even at its end
+    TempDir old_dir("test_kv_store_old");
+    offsets = write_three(old_dir);
+    data = read_file(old_dir.log());
+    data.insert(data.end(), {0xe8, 0x03, 0, 0});
+    write_file(old_dir.log(), data);
+    write_file(old_dir.path / "00002.log", {});
+    CHECK(!opens(old_dir));
+}
+
+std::string value_of(const KvStore& store, const std::string& key) {
+    Bytes found;
+    return store.get(bytes(key), found) ? std::string(found.begin(), found.end()) : "<missing>";
+}
+
+size_t log_files(const TempDir& dir) {
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir.path)) count += entry.path().extension() == ".log";
+    return count;
+}
+
+void test_compact() {
+    // Small files, so the values and the deletes are spread over many of them
+    TempDir dir("test_kv_store_compact");
+    KvStoreOptions options = test_options();
+    options.max_file_size = 2048;
+    options.min_compact_size = SIZE_MAX;
+    {
+        KvStore store(dir.path.string(), options);
+        for (int round = 0; round < 5; round++) {
+            for (int i = 0; i < 100; i++) put(store, "key" + std::to_string(i), std::string(30, 'a' + round));
+        }
+        for (int i = 0; i < 100; i += 2) {
+            WriteBatch batch;
+            batch.erase(bytes("key" + std::to_string(i)));
+            store.write(batch);
+        }
+        put(store, "key0", "back");     // deleted, then written again
+        CHECK(log_files(dir) > 10);
+        uint64_t before = store.disk_usage();
+
+        store.compact();
+        CHECK(store.size() == 51);
+        CHECK(store.disk_usage() < before / 5);
+        CHECK(store.disk_usage() >= store.live_bytes());
+        CHECK(log_files(dir) <= 2);
+        CHECK(value_of(store, "key0") == "back");
+        CHECK(value_of(store, "key1") == std::string(30, 'e'));
+        CHECK(!store.contains(bytes("key2")));
+
+        // Still writable, into the files compaction left
+        put(store, "after", "compact");
+        CHECK(value_of(store, "after") == "compact");
+    }
+
+    // Reopened: the deletes went with the old files, and nothing comes back
+    KvStore reopened(dir.path.string(), options);
+    CHECK(reopened.size() == 52);
+    CHECK(value_of(reopened, "key0") == "back");
+    CHECK(value_of(reopened, "key99") == std::string(30, 'e'));
+    CHECK(!reopened.contains(bytes("key98")));
+    CHECK(value_of(reopened, "after") == "compact");
+    size_t visited = 0;
+    reopened.for_each([&](KvBytes, KvBytes value) {
+        CHECK(!value.empty());
+        visited++;
+    });
+    CHECK(visited == 52);
+}
+
+void test_auto_compact() {
+    // Overwriting one key over and over: compaction keeps the disk usage
+    // near the live data instead of growing with every write
+    TempDir dir("test_kv_store_auto");
+    KvStoreOptions options = test_options();
+    options.max_file_size = 4096;
+    options.min_compact_size = 16384;
+    options.compact_garbage_ratio = 0.5;
+    {
+        KvStore store(dir.path.string(), options);
+        put(store, "fixed", "stays");
+        uint64_t peak = 0;
+        for (int i = 0; i < 2000; i++) {
+            put(store, "counter", std::to_string(i) + std::string(100, 'x'));
+            peak = std::max(peak, store.disk_usage());
+        }
+        CHECK(peak < 2 * options.min_compact_size);
+        CHECK(store.size() == 2);
+        CHECK(value_of(store, "counter") == "1999" + std::string(100, 'x'));
+    }
+    KvStore reopened(dir.path.string(), options);
+    CHECK(reopened.size() == 2);
+    CHECK(value_of(reopened, "fixed") == "stays");
+    CHECK(value_of(reopened, "counter") == "1999" + std::string(100, 'x'));
+}
+
+} // namespace
+
+int main() {
+    test_torn_tail();
+    test_torn_last_record();
+    test_corrupt_middle();
+    test_compact();
+    test_auto_compact();
+    return test_result();
+}
@@ -0,0 +1,358 @@
+// tests/test_mempool.cpp
+//
+// Mempool package bookkeeping and block templates: transactions added
+// with add_unchecked() (and signed ones through accept()), checked against
+// ancestor and descendant totals worked out from scratch, the conflicts a
+// block evicts, trim_to_size()'s eviction order and the block limits and
+// ordering the template must respect.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "coins/utxo_set.h"
+#include "mempool/mempool.h"
+#include "test_util.h"
+#include "validation/validation.h"
+
+using namespace bitcoin;
+
+namespace {
+
+const test::TestKey key(1);
+
+// Confirmed coins for key's spends, and a tip to accept them on
+struct Funds {
+    UtxoSet chain;
+    std::vector<std::pair<OutPoint, TransactionOutput>> coins;
+    BlockIndexEntry tip;
+
+    explicit Funds(size_t count) {
+        tip.height = 10;
+        for (uint32_t i = 0; i < count; i++) {
+            OutPoint outpoint(crypto::Hash::sha256(std::to_string(i)), 0);
+            TransactionOutput output(1000000, key.script);
+            chain.add_coin(outpoint, Coin(output, 1, false));
+            coins.push_back({outpoint, output});
+        }
+    }
+};
+
+// Unsigned: spends `from`, one output with `checksigs` bare OP_CHECKSIGs
+// (four sigop cost each) and a second one to spend later
+TransactionRef unchecked_tx(const OutPoint& from, size_t checksigs) {
+    TransactionBuilder builder;
+    builder.add_input(TransactionInput(from.txid, from.vout, ""));
+    builder.add_output(TransactionOutput(1000, Script(std::vector<unsigned char>(checksigs, OP_CHECKSIG))));
+    builder.add_output(TransactionOutput(1000, key.script));
+    return std::move(builder).build();
+}
+
+size_t count_of(const std::vector<TransactionRef>& txs, const TransactionRef& tx) {
+    size_t n = 0;
+    for (const TransactionRef& t : txs) n += t->get_txid() == tx->get_txid();
+    return n;
+}
+
+// Unsigned, spending `from` into `outputs` outputs of 1000 each
+TransactionRef tx_spending(const std::vector<OutPoint>& from, size_t outputs = 1) {
+    TransactionBuilder builder;
+    for (const OutPoint& outpoint : from) builder.add_input(TransactionInput(outpoint.txid, outpoint.vout, ""));
+    for (size_t i = 0; i < outputs; i++) builder.add_output(TransactionOutput(1000, key.script));
+    return std::move(builder).build();
+}
+
+OutPoint confirmed(const std::string& name) { return OutPoint(crypto::Hash::sha256(name), 0); }
+
+OutPoint out(const TransactionRef& tx, uint32_t vout) { return OutPoint(tx->get_txid(), vout); }
+
+// Every pool entry in `txs` against totals walked out of the transactions themselves
+void check_totals(const Mempool& pool, const std::vector<TransactionRef>& txs) {
+    std::vector<TransactionRef> in_pool;
+    for (const TransactionRef& tx : txs) {
+        if (pool.contains(tx->get_txid())) in_pool.push_back(tx);
+    }
+    CHECK(pool.size() == in_pool.size());
+    auto spends = [](const TransactionRef& child, const TransactionRef& parent) {
+        for (const TransactionInput& input : child->inputs) {
+            if (input.previous_txid == parent->get_txid()) return true;
+        }
+        return false;
+    };
+    // reaches[i][j]: in_pool[j] is in_pool[i] or one of its ancestors
+    size_t n = in_pool.size();
+    std::vector<std::vector<bool>> reaches(n, std::vector<bool>(n));
+    for (size_t i = 0; i < n; i++) {
+        reaches[i][i] = true;
+        for (size_t j = 0; j < n; j++) reaches[i][j] = reaches[i][j] || spends(in_pool[i], in_pool[j]);
+    }
+    for (size_t k = 0; k < n; k++) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) reaches[i][j] = reaches[i][j] || (reaches[i][k] && reaches[k][j]);
+        }
+    }
+
+    std::vector<Mempool::Entry> entries(n);
+    for (size_t i = 0; i < n; i++) CHECK(pool.get_entry(in_pool[i]->get_txid(), entries[i]));
+    for (size_t i = 0; i < n; i++) {
+        Mempool::Entry expected;
+        expected.ancestor_count = expected.descendant_count = 0;
+        for (size_t j = 0; j < n; j++) {
+            if (reaches[i][j]) {
+                expected.ancestor_count++;
+                expected.ancestor_size += entries[j].vsize;
+                expected.ancestor_fee += entries[j].fee;
+                expected.ancestor_sigop_cost += entries[j].sigop_cost;
+            }
+            if (reaches[j][i]) {
+                expected.descendant_count++;
+                expected.descendant_size += entries[j].vsize;
+                expected.descendant_fee += entries[j].fee;
+            }
+        }
+        const Mempool::Entry& entry = entries[i];
+        CHECK(entry.ancestor_count == expected.ancestor_count && entry.ancestor_size == expected.ancestor_size &&
+              entry.ancestor_fee == expected.ancestor_fee &&
+              entry.ancestor_sigop_cost == expected.ancestor_sigop_cost);
+        CHECK(entry.descendant_count == expected.descendant_count &&
+              entry.descendant_size == expected.descendant_size && entry.descendant_fee == expected.descendant_fee);
+    }
+}
+
+void test_template_sigops() {
+    // 25 transactions of 4000 sigop cost: 19 fit under the default budget
+    Mempool pool(SIZE_MAX);
+    std::vector<TransactionRef> heavy;
+    for (uint32_t i = 0; i < 25; i++) {
+        heavy.push_back(unchecked_tx(OutPoint(crypto::Hash::sha256("heavy " + std::to_string(i)), 0), 1000));
+        pool.add_unchecked(heavy.back(), 100000 + i);
+    }
+    // Cheaper per vbyte, and no sigops: still go in once the heavy ones stop fitting
+    TransactionRef light = unchecked_tx(OutPoint(crypto::Hash::sha256("light"), 0), 0);
+    pool.add_unchecked(light, 200);
+
+    std::vector<TransactionRef> block = pool.build_block_template(MAX_BLOCK_WEIGHT - 4000);
+    uint64_t sigop_cost = 0;
+    for (const TransactionRef& tx : block) sigop_cost += get_transaction_sigop_cost(*tx, {});
+    CHECK(sigop_cost <= MAX_BLOCK_SIGOPS_COST - Mempool::COINBASE_SIGOP_RESERVE);
+    CHECK(block.size() == 20);
+    CHECK(count_of(block, light) == 1);
+    CHECK(count_of(block, heavy[24]) == 1);     // highest fees first
+    CHECK(count_of(block, heavy[0]) == 0);
+
+    // A package counts its ancestors' sigops: a cheap child can't bring in
+    // a parent that doesn't fit
+    Mempool chained(SIZE_MAX);
+    TransactionRef parent = unchecked_tx(OutPoint(crypto::Hash::sha256("parent"), 0), 1000);
+    TransactionRef child = unchecked_tx(OutPoint(parent->get_txid(), 1), 0);
+    chained.add_unchecked(parent, 1000);
+    chained.add_unchecked(child, 1000000);
+    CHECK(chained.build_block_template(MAX_BLOCK_WEIGHT, nullptr, 3999).empty());
+    CHECK(chained.build_block_template(MAX_BLOCK_WEIGHT, nullptr, 4000).size() == 2);
+
+    // Once the parent is confirmed only the child's own sigops count
+    Block confirmed;
+    confirmed.transactions = {parent};
+    chained.remove_for_block(confirmed);
+    CHECK(chained.build_block_template(MAX_BLOCK_WEIGHT, nullptr, 0).size() == 1);
+}
+
+void test_accept_sigops() {
+    // accept() counts witness sigops too: a P2WPKH spend costs 1
+    Funds funds(3);
+    Mempool pool;
+    for (const auto& coin : funds.coins) {
+        TransactionRef tx = test::spend(key, {coin}, {TransactionOutput(coin.second.value - 1000, key.script)});
+        CHECK(pool.accept(tx, funds.chain, &funds.tip) == MempoolReject::OK);
+    }
+    CHECK(pool.build_block_template(MAX_BLOCK_WEIGHT, nullptr, 2).size() == 2);
+    CHECK(pool.build_block_template(MAX_BLOCK_WEIGHT).size() == 3);
+}
+
+void test_package_totals() {
+    // A diamond with a tail, and a second parent for the tail:
+    //   a -> b, c -> d (spends both) -> e <- f
+    Mempool pool(SIZE_MAX);
+    TransactionRef a = tx_spending({confirmed("a")}, 2);
+    TransactionRef b = tx_spending({out(a, 0)});
+    TransactionRef c = tx_spending({out(a, 1)});
+    TransactionRef d = tx_spending({out(b, 0), out(c, 0)}, 2);
+    TransactionRef f = unchecked_tx(confirmed("f"), 3);
+    TransactionRef e = tx_spending({out(d, 0), out(f, 1)});
+    std::vector<TransactionRef> all{a, b, c, d, f, e};
+    uint64_t fee = 1000;
+    for (const TransactionRef& tx : all) {
+        CHECK(pool.add_unchecked(tx, fee += 1000));
+        check_totals(pool, all);
+    }
+    CHECK(!pool.add_unchecked(a, 1));
+
+    Mempool::Entry entry;
+    CHECK(pool.get_entry(e->get_txid(), entry));
+    CHECK(entry.ancestor_count == 6 && entry.ancestor_sigop_cost == 12);
+    CHECK(pool.get_entry(a->get_txid(), entry));
+    CHECK(entry.descendant_count == 5 && entry.descendant_fee == 2000 + 3000 + 4000 + 5000 + 7000);
+    CHECK(!pool.get_entry(confirmed("a").txid, entry));
+
+    // Removing a middle transaction takes its descendants with it
+    pool.remove_recursive(c->get_txid());
+    CHECK(pool.size() == 3);
+    check_totals(pool, all);
+    CHECK(pool.get_entry(a->get_txid(), entry) && entry.descendant_count == 2);
+    CHECK(pool.get_entry(f->get_txid(), entry) && entry.descendant_count == 1);
+
+    // Back again, then a confirmed root: its children lose an ancestor
+    for (const TransactionRef& tx : {c, d, e}) CHECK(pool.add_unchecked(tx, 500));
+    check_totals(pool, all);
+    Block block;
+    block.transactions = {test::make_coinbase(11, {TransactionOutput(1, key.script)}), a, f};
+    pool.remove_for_block(block);
+    CHECK(pool.size() == 4);
+    check_totals(pool, all);
+    CHECK(pool.get_entry(e->get_txid(), entry) && entry.ancestor_count == 4 && entry.ancestor_sigop_cost == 0);
+    CHECK(pool.get_entry(b->get_txid(), entry) && entry.ancestor_count == 1 && entry.descendant_count == 3);
+}
+
+void test_block_conflicts() {
+    Mempool pool(SIZE_MAX);
+    TransactionRef x = tx_spending({confirmed("shared"), confirmed("x")}, 2);
+    TransactionRef x_child = tx_spending({out(x, 0)});
+    TransactionRef x_grandchild = tx_spending({out(x_child, 0), confirmed("other")});
+    TransactionRef unrelated = tx_spending({confirmed("unrelated")});
+    TransactionRef unrelated_child = tx_spending({out(unrelated, 0)});
+    std::vector<TransactionRef> all{x, x_child, x_grandchild, unrelated, unrelated_child};
+    for (const TransactionRef& tx : all) pool.add_unchecked(tx, 1000);
+
+    // A block with a different transaction spending "shared": x can never
+    // confirm now, and neither can anything built on it
+    Block block;
+    block.transactions = {test::make_coinbase(11, {TransactionOutput(1, key.script)}),
+                          tx_spending({confirmed("shared")}), unrelated};
+    pool.remove_for_block(block);
+    CHECK(pool.size() == 1);
+    CHECK(pool.contains(unrelated_child->get_txid()));
+    CHECK(!pool.contains(x->get_txid()) && !pool.contains(x_child->get_txid()) &&
+          !pool.contains(x_grandchild->get_txid()));
+    check_totals(pool, all);
+    CHECK(pool.stats().transactions == 1 && pool.stats().total_fees == 1000);
+
+    // The conflict's outputs are free again: another spender can come in
+    CHECK(pool.add_unchecked(tx_spending({out(unrelated, 1), confirmed("x")}), 1000));
+    CHECK(pool.size() == 2);
+}
+
+void test_trim_order() {
+    // Package feerates, lowest first, are what trim_to_size() evicts by: a
+    // cheap parent with a generous child (CPFP) outlasts loners paying more
+    // than the parent alone, and goes together with that child
+    Mempool pool(SIZE_MAX);
+    TransactionRef loner_low = tx_spending({confirmed("low")});
+    TransactionRef loner_mid = tx_spending({confirmed("mid")});
+    TransactionRef parent = tx_spending({confirmed("parent")});
+    TransactionRef child = tx_spending({out(parent, 0)});
+    TransactionRef loner_high = tx_spending({confirmed("high")});
+    pool.add_unchecked(loner_low, 100);
+    pool.add_unchecked(loner_mid, 5000);
+    pool.add_unchecked(parent, 200);
+    pool.add_unchecked(child, 30000);
+    pool.add_unchecked(loner_high, 12000);
+
+    // Trimming one byte below the current use evicts one package at a time
+    std::vector<std::vector<TransactionRef>> expected{{loner_low}, {loner_mid}, {loner_high}, {parent, child}};
+    uint64_t evicted = 0;
+    for (const auto& package : expected) {
+        size_t before = pool.size();
+        pool.trim_to_size(pool.stats().memory_usage - 1);
+        CHECK(pool.size() == before - package.size());
+        for (const TransactionRef& tx : package) CHECK(!pool.contains(tx->get_txid()));
+        evicted += package.size();
+        CHECK(pool.stats().evicted == evicted);
+    }
+    CHECK(pool.size() == 0 && pool.stats().memory_usage == 0);
+
+    // Equal feerates: the newer transaction goes first
+    TransactionRef older = tx_spending({confirmed("older")});
+    TransactionRef newer = tx_spending({confirmed("newer")});
+    pool.add_unchecked(older, 1000);
+    pool.add_unchecked(newer, 1000);
+    pool.trim_to_size(pool.stats().memory_usage - 1);
+    CHECK(pool.contains(older->get_txid()) && !pool.contains(newer->get_txid()));
+
+    // Under the limit already: nothing goes
+    pool.trim_to_size(pool.stats().memory_usage);
+    CHECK(pool.size() == 1 && pool.stats().evicted == evicted + 1);
+}
+
+void test_template_order() {
+    // Chains and a diamond with fees all over the place: the template must
+    // still list every parent before its children
+    Mempool pool(SIZE_MAX);
+    std::mt19937_64 rng(7);
+    std::vector<TransactionRef> txs;
+    for (int root = 0; root < 10; root++) {
+        TransactionRef tx = tx_spending({confirmed("root " + std::to_string(root))}, 2);
+        pool.add_unchecked(tx, 100 + rng() % 10000);
+        txs.push_back(tx);
+        for (int depth = 0; depth < 5; depth++) {
+            TransactionRef left = tx_spending({out(tx, 0)}, 2);
+            TransactionRef right = tx_spending({out(tx, 1)}, 2);
+            tx = tx_spending({out(left, 0), out(right, 0)}, 2);
+            for (const TransactionRef& t : {left, right, tx}) {
+                pool.add_unchecked(t, 100 + rng() % 10000);
+                txs.push_back(t);
+            }
+        }
+    }
+    check_totals(pool, txs);
+
+    for (size_t max_weight : {size_t(MAX_BLOCK_WEIGHT), size_t(20000), size_t(5000)}) {
+        uint64_t fees = 0;
+        std::vector<TransactionRef> block = pool.build_block_template(max_weight, &fees);
+        CHECK(!block.empty());
+        size_t weight = 0;
+        uint64_t fee_sum = 0;
+        for (size_t i = 0; i < block.size(); i++) {
+            weight += block[i]->get_weight();
+            Mempool::Entry entry;
+            CHECK(pool.get_entry(block[i]->get_txid(), entry));
+            fee_sum += entry.fee;
+            // Every in-pool parent is earlier in the block
+            for (const TransactionInput& input : block[i]->inputs) {
+                if (!pool.contains(input.previous_txid)) continue;
+                auto parent = std::find_if(block.begin(), block.begin() + i, [&](const TransactionRef& tx) {
+                    return tx->get_txid() == input.previous_txid;
+                });
+                CHECK(parent != block.begin() + i);
+            }
+        }
+        CHECK(weight <= max_weight);
+        CHECK(fees == fee_sum);
+        if (max_weight == MAX_BLOCK_WEIGHT) CHECK(block.size() == txs.size());
+    }
+
+    // A child paying for its parent beats a loner paying more than the
+    // parent but less than the two together
+    Mempool cpfp(SIZE_MAX);
+    TransactionRef parent = tx_spending({confirmed("cpfp parent")});
+    TransactionRef child = tx_spending({out(parent, 0)});
+    TransactionRef loner = tx_spending({confirmed("cpfp loner")});
+    cpfp.add_unchecked(parent, 100);
+    cpfp.add_unchecked(loner, 5000);
+    cpfp.add_unchecked(child, 20000);
+    std::vector<TransactionRef> block = cpfp.build_block_template(MAX_BLOCK_WEIGHT);
+    CHECK(block.size() == 3);
+    CHECK(block.size() == 3 && block[0] == parent && block[1] == child && block[2] == loner);
+}
+
+} // namespace
+
+int main() {
+    test_template_sigops();
+    test_accept_sigops();
+    test_package_totals();
+    test_block_conflicts();
+    test_trim_order();
+    test_template_order();
+    return test_result();
+}
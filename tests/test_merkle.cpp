@@ -0,0 +1,176 @@
+// tests/test_merkle.cpp
+//
+// Merkle roots against a one-pair-at-a-time reference and a mainnet block,
+// the CVE-2012-2459 `mutated` flag (a duplicated tail gives the same root),
+// and branch proofs: every leaf of trees of many sizes verifies, and any
+// wrong leaf, index, sibling or root doesn't.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include "blockchain/merkle.h"
+#include "check.h"
+#include "crypto/hash.h"
+
+using namespace bitcoin;
+using crypto::Hash256;
+
+namespace {
+
+Hash256 random_hash(std::mt19937_64& rng) {
+    Hash256 hash;
+    for (size_t i = 0; i < hash.size(); i++) hash.data()[i] = (unsigned char)rng();
+    return hash;
+}
+
+std::vector<Hash256> random_leaves(std::mt19937_64& rng, size_t count) {
+    std::vector<Hash256> leaves;
+    for (size_t i = 0; i < count; i++) leaves.push_back(random_hash(rng));
+    return leaves;
+}
+
+Hash256 hash_pair(const Hash256& a, const Hash256& b) {
+    unsigned char pair[64];
+    std::memcpy(pair, a.data(), 32);
+    std::memcpy(pair + 32, b.data(), 32);
+    return crypto::Hash::double_sha256(pair, sizeof(pair));
+}
+
+// Mainnet block 100000
+const char* const BLOCK_100000_ROOT = "f3e94742aca4b5ef85488dc37c06c3282295ffec960994b2c0d5ac2a25a95766";
+
+std::vector<Hash256> block_100000_txids() {
+    return {
+        Hash256::from_hex("8c14f0db3df150123e6f3dbbf30f8b955a8249b62ac1d1ff16284aefa3d06d87"),
+        Hash256::from_hex("fff2525b8931402dd09222c50775608f75787bd2b87e56995a7bdd30f79702c4"),
+        Hash256::from_hex("6359f0868171b1d194cbee1af2f16ea598ae8fad666d9b012c8ed2b79a236ec4"),
+        Hash256::from_hex("e9a66845e05d5abc0ad04ec80f774a7e585c6e8db975962d069a522137b80c1d"),
+    };
+}
+
+// The tree as the whitepaper draws it, one pair at a time
+Hash256 reference_root(std::vector<Hash256> level) {
+    if (level.empty()) return Hash256();
+    while (level.size() > 1) {
+        std::vector<Hash256> next;
+        for (size_t i = 0; i < level.size(); i += 2) {
+            next.push_back(hash_pair(level[i], level[i + 1 < level.size() ? i + 1 : i]));
+        }
+        level = std::move(next);
+    }
+    return level[0];
+}
+
+void test_roots(std::mt19937_64& rng) {
+    bool mutated = true;
+    CHECK(compute_merkle_root({}, &mutated) == Hash256() && !mutated);
+
+    std::vector<Hash256> txids = block_100000_txids();
+    Hash256 root = Hash256::from_hex(BLOCK_100000_ROOT);
+    CHECK(compute_merkle_root(txids) == root);
+    CHECK(reference_root(txids) == root);
+    CHECK(compute_merkle_root({txids[0]}) == txids[0]);
+
+    // Sizes around the hashing batch widths, and one big enough to be split up
+    for (size_t count : {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 1000, 4097, 20000}) {
+        std::vector<Hash256> leaves = random_leaves(rng, count);
+        CHECK(compute_merkle_root(leaves, &mutated) == reference_root(leaves));
+        CHECK(!mutated);
+    }
+
+    // hash_merkle_level() on its own
+    for (size_t pairs : {1, 3, 4, 8, 9, 17, 100}) {
+        std::vector<Hash256> in = random_leaves(rng, 2 * pairs), out(pairs);
+        hash_merkle_level(out.data(), in.data(), pairs);
+        for (size_t i = 0; i < pairs; i++) CHECK(out[i] == hash_pair(in[2 * i], in[2 * i + 1]));
+    }
+}
+
+void test_mutated(std::mt19937_64& rng) {
+    // An odd level pairs its last hash with itself, so appending a copy of
+    // the last leaf gives the same root - and that list must be flagged
+    for (size_t count : {3, 5, 7, 9, 11, 33}) {
+        std::vector<Hash256> leaves = random_leaves(rng, count);
+        bool mutated = true;
+        Hash256 root = compute_merkle_root(leaves, &mutated);
+        CHECK(!mutated);
+        leaves.push_back(leaves.back());
+        CHECK(compute_merkle_root(leaves, &mutated) == root);
+        CHECK(mutated);
+    }
+
+    // The same one level up: [a b c d e f] and [a b c d e f e f]
+    std::vector<Hash256> leaves = random_leaves(rng, 6);
+    bool mutated = true;
+    Hash256 root = compute_merkle_root(leaves, &mutated);
+    CHECK(!mutated);
+    leaves.push_back(leaves[4]);
+    leaves.push_back(leaves[5]);
+    CHECK(compute_merkle_root(leaves, &mutated) == root);
+    CHECK(mutated);
+
+    // Equal neighbours anywhere count, not just at the end
+    leaves = random_leaves(rng, 8);
+    leaves[3] = leaves[2];
+    compute_merkle_root(leaves, &mutated);
+    CHECK(mutated);
+    // Equal hashes that aren't paired with each other don't
+    leaves = random_leaves(rng, 8);
+    leaves[2] = leaves[1];
+    compute_merkle_root(leaves, &mutated);
+    CHECK(!mutated);
+    // Two leaves, both the same
+    Hash256 leaf = random_hash(rng);
+    compute_merkle_root({leaf, leaf}, &mutated);
+    CHECK(mutated);
+}
+
+void test_branches(std::mt19937_64& rng) {
+    for (size_t count : {1, 2, 3, 4, 5, 6, 7, 8, 9, 13, 16, 17, 31, 32, 33, 100}) {
+        std::vector<Hash256> leaves = random_leaves(rng, count);
+        Hash256 root = compute_merkle_root(leaves);
+        size_t depth = 0;
+        while ((size_t(1) << depth) < count) depth++;
+
+        for (size_t index = 0; index < count; index++) {
+            std::vector<Hash256> branch = compute_merkle_branch(leaves, index);
+            CHECK(branch.size() == depth);
+            CHECK(compute_root_from_branch(leaves[index], branch, index) == root);
+            CHECK(verify_merkle_branch(leaves[index], branch, index, root));
+
+            // Anything else wrong and it fails
+            CHECK(!verify_merkle_branch(random_hash(rng), branch, index, root));
+            CHECK(!verify_merkle_branch(leaves[index], branch, index, random_hash(rng)));
+            if (count > 1) {
+                size_t other = (index + 1 + rng() % (count - 1)) % count;
+                CHECK(!verify_merkle_branch(leaves[other], branch, index, root));
+                // The other side of its pair (a lone last leaf is paired with
+                // itself, so either side gives the same hash there)
+                if ((index ^ 1) < count) CHECK(!verify_merkle_branch(leaves[index], branch, index ^ 1, root));
+                for (size_t level = 0; level < branch.size(); level++) {
+                    std::vector<Hash256> tampered = branch;
+                    tampered[level].data()[rng() % 32] ^= 1 << (rng() % 8);
+                    CHECK(!verify_merkle_branch(leaves[index], tampered, index, root));
+                }
+                CHECK(!verify_merkle_branch(leaves[index], std::vector<Hash256>(branch.begin(), branch.end() - 1),
+                                            index, root));
+            }
+        }
+    }
+
+    // Block 100000's third transaction, checked the SPV way
+    std::vector<Hash256> txids = block_100000_txids();
+    std::vector<Hash256> branch = compute_merkle_branch(txids, 2);
+    CHECK(branch.size() == 2 && branch[0] == txids[3] && branch[1] == hash_pair(txids[0], txids[1]));
+    CHECK(verify_merkle_branch(txids[2], branch, 2, Hash256::from_hex(BLOCK_100000_ROOT)));
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(2459);
+    test_roots(rng);
+    test_mutated(rng);
+    test_branches(rng);
+    return test_result();
+}
@@ -0,0 +1,171 @@
+// tests/test_pow.cpp
+//
+// Proof of work: the compact nBits encoding (Bitcoin Core's vectors, the
+// sign bit and where a target stops fitting in 256 bits), decode_target()'s
+// rejections, and retargeting - mainnet periods from Core's tests plus the
+// factor-of-four clamp on either side and the pow_limit ceiling.
+
+#include <cstdint>
+#include <random>
+#include "blockchain/pow.h"
+#include "check.h"
+
+using namespace bitcoin;
+using crypto::ArithUint256;
+
+namespace {
+
+ArithUint256 from_hex(const char* hex) { return ArithUint256::from_hash(crypto::Hash256::from_hex(hex)); }
+
+// set_compact() of `bits` is `value`, with these flags
+bool decodes_to(uint32_t bits, const ArithUint256& value, bool negative = false, bool overflow = false) {
+    bool is_negative, is_overflow;
+    ArithUint256 target;
+    target.set_compact(bits, &is_negative, &is_overflow);
+    return target == value && is_negative == negative && is_overflow == overflow;
+}
+
+void test_compact_vectors() {
+    // Zero mantissas, whatever the exponent and sign bit
+    for (uint32_t bits : {0x00000000u, 0x00123456u, 0x01003456u, 0x02000056u, 0x03000000u, 0x04000000u,
+                          0x00923456u, 0x01803456u, 0x02800056u, 0x03800000u, 0x04800000u}) {
+        CHECK(decodes_to(bits, ArithUint256(0)));
+    }
+    CHECK(ArithUint256(0).get_compact() == 0);
+
+    // Small exponents shift the mantissa right
+    CHECK(decodes_to(0x01123456, ArithUint256(0x12)));
+    CHECK(ArithUint256(0x12).get_compact() == 0x01120000);
+    CHECK(decodes_to(0x02123456, ArithUint256(0x1234)));
+    CHECK(ArithUint256(0x1234).get_compact() == 0x02123400);
+    CHECK(decodes_to(0x03123456, ArithUint256(0x123456)));
+    CHECK(ArithUint256(0x123456).get_compact() == 0x03123456);
+    CHECK(decodes_to(0x04123456, ArithUint256(0x12345600)));
+    CHECK(ArithUint256(0x12345600).get_compact() == 0x04123456);
+    CHECK(decodes_to(0x20123456, from_hex("1234560000000000000000000000000000000000000000000000000000000000")));
+    CHECK(from_hex("1234560000000000000000000000000000000000000000000000000000000000").get_compact() == 0x20123456);
+
+    // A mantissa with its top bit set would read as negative: one more byte
+    CHECK(ArithUint256(0x80).get_compact() == 0x02008000);
+    CHECK(decodes_to(0x05009234, ArithUint256(0x92340000)));
+    CHECK(ArithUint256(0x92340000).get_compact() == 0x05009234);
+
+    // The sign bit
+    CHECK(decodes_to(0x01fedcba, ArithUint256(0x7e), true));
+    CHECK(ArithUint256(0x7e).get_compact(true) == 0x01fe0000);
+    CHECK(decodes_to(0x04923456, ArithUint256(0x12345600), true));
+    CHECK(ArithUint256(0x12345600).get_compact(true) == 0x04923456);
+    CHECK(ArithUint256(0).get_compact(true) == 0);
+}
+
+void test_compact_overflow() {
+    // The highest byte of the mantissa may reach bit 255, no further
+    CHECK(decodes_to(0x207fffff, from_hex("7fffff0000000000000000000000000000000000000000000000000000000000")));
+    CHECK(decodes_to(0x2100ffff, from_hex("ffff000000000000000000000000000000000000000000000000000000000000")));
+    CHECK(decodes_to(0x220000ff, from_hex("ff00000000000000000000000000000000000000000000000000000000000000")));
+    bool negative, overflow;
+    for (uint32_t bits : {0x21010000u, 0x22000100u, 0x23000001u, 0xff123456u, 0x2201ffffu}) {
+        ArithUint256().set_compact(bits, &negative, &overflow);
+        CHECK(overflow && !negative);
+    }
+    // Zero never overflows
+    ArithUint256().set_compact(0xff000000, &negative, &overflow);
+    CHECK(!overflow && !negative);
+
+    // decode_target() turns away all of those, zero and anything easier than pow_limit
+    ConsensusParams mainnet = ConsensusParams::mainnet();
+    ArithUint256 target;
+    CHECK(decode_target(0x1d00ffff, mainnet, target) &&
+          target == from_hex("00000000ffff0000000000000000000000000000000000000000000000000000"));
+    for (uint32_t bits : {0x00000000u, 0x01003456u, 0x04923456u, 0x01fedcbau, 0x23000001u, 0x1d010000u, 0x207fffffu}) {
+        CHECK(!decode_target(bits, mainnet, target));
+    }
+    CHECK(decode_target(0x207fffff, ConsensusParams::regtest(), target));
+    CHECK(!check_proof_of_work(crypto::Hash256(), 0x04923456, ConsensusParams::regtest()));
+    CHECK(check_proof_of_work(crypto::Hash256(), 0x207fffff, ConsensusParams::regtest()));
+}
+
+void test_compact_round_trip(std::mt19937_64& rng) {
+    // get_compact() keeps the top three bytes (two if the third would be the
+    // sign bit's byte) and rounds down; decoding that gives the same nBits
+    for (int i = 0; i < 10000; i++) {
+        ArithUint256 value(rng());
+        value <<= rng() % 200;
+        uint32_t bits = value.get_compact();
+        bool negative, overflow;
+        ArithUint256 decoded;
+        decoded.set_compact(bits, &negative, &overflow);
+        CHECK(!negative && !overflow);
+        CHECK(decoded <= value);
+        CHECK(decoded.bits() == value.bits());
+        CHECK(decoded.get_compact() == bits);
+        CHECK(!(bits & 0x00800000));
+    }
+}
+
+void test_retarget() {
+    ConsensusParams params = ConsensusParams::mainnet();
+    const int64_t two_weeks = params.target_timespan;
+
+    // From Bitcoin Core's pow_tests: a period a little faster than two weeks
+    CHECK(calculate_next_work_required(0x1d00ffff, 1261130161, 1262152739, params) == 0x1d00d86a);
+    // Slower than two weeks at the easiest target: stays at pow_limit
+    CHECK(calculate_next_work_required(0x1d00ffff, 1231006505, 1233061996, params) == 0x1d00ffff);
+    // Much faster than two weeks: only four times harder
+    CHECK(calculate_next_work_required(0x1c05a3f4, 1279008237, 1279297671, params) == 0x1c0168fd);
+    // Much slower: only four times easier
+    CHECK(calculate_next_work_required(0x1c387f6f, 1263163443, 1269211443, params) == 0x1d00e1fd);
+
+    // The clamp in isolation: anything at or past a quarter (or four times)
+    // two weeks gives the same result, negative timespans included
+    const uint32_t bits = 0x1b0404cb;
+    uint32_t harder = calculate_next_work_required(bits, 0, two_weeks / 4, params);
+    uint32_t easier = calculate_next_work_required(bits, 0, two_weeks * 4, params);
+    for (int64_t timespan : {int64_t(0), int64_t(1), two_weeks / 4 - 1, -two_weeks}) {
+        CHECK(calculate_next_work_required(bits, 1000000, 1000000 + timespan, params) == harder);
+    }
+    for (int64_t timespan : {two_weeks * 4 + 1, two_weeks * 100}) {
+        CHECK(calculate_next_work_required(bits, 1000000, 1000000 + timespan, params) == easier);
+    }
+    ArithUint256 old_target;
+    old_target.set_compact(bits);
+    CHECK(harder == (old_target / ArithUint256(4)).get_compact());
+    CHECK(easier == (old_target * 4).get_compact());
+    CHECK(calculate_next_work_required(bits, 0, two_weeks / 2, params) == (old_target / ArithUint256(2)).get_compact());
+    CHECK(calculate_next_work_required(bits, 0, two_weeks, params) == bits);
+
+    // Never easier than pow_limit; regtest's limit fills 255 bits, so the
+    // product only fits by taking the shifted path
+    CHECK(calculate_next_work_required(0x1d00ffff, 0, two_weeks * 4, params) == 0x1d00ffff);
+    CHECK(calculate_next_work_required(0x1d00ffff, 0, two_weeks / 4, params) == 0x1c3fffc0);
+    ConsensusParams regtest = ConsensusParams::regtest();
+    CHECK(calculate_next_work_required(0x207fffff, 0, two_weeks * 4, regtest) == 0x207fffff);
+
+    // Only on retarget boundaries, and never on regtest
+    CHECK(get_next_work_required(2015, bits, 0, 0, params) == bits);
+    CHECK(get_next_work_required(2016, bits, 0, 0, params) == harder);
+    CHECK(get_next_work_required(4032, bits, 0, two_weeks * 4, params) == easier);
+    CHECK(get_next_work_required(2016, 0x207fffff, 0, 0, regtest) == 0x207fffff);
+}
+
+void test_work() {
+    CHECK(get_block_work(0x1d00ffff) == ArithUint256(0x100010001));
+    CHECK(get_block_work(0x207fffff) == ArithUint256(2));
+    CHECK(get_block_work(0) == ArithUint256(0));
+    CHECK(get_block_work(0x04923456) == ArithUint256(0));
+    CHECK(get_block_work(0x23000001) == ArithUint256(0));
+    CHECK(get_difficulty(0x1d00ffff) == 1.0);
+    CHECK(get_difficulty(0x1c0168fd) > 181.0 && get_difficulty(0x1c0168fd) < 182.0);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(6);
+    test_compact_vectors();
+    test_compact_overflow();
+    test_compact_round_trip(rng);
+    test_retarget();
+    test_work();
+    return test_result();
+}
@@ -0,0 +1,389 @@
+// tests/test_script.cpp
+//
+// Signature hashes and script verification: the BIP143 examples, the
+// quirks of the legacy hash (the SIGHASH_SINGLE bug, ANYONECANPAY,
+// OP_CODESEPARATOR, FindAndDelete), the P2PKH/P2WPKH templates against the
+// interpreter, multisig, lock times and the witness malleation rules.
+
+#include <string>
+#include <vector>
+#include "check.h"
+#include "crypto/hex.h"
+#include "script/interpreter.h"
+#include "test_util.h"
+#include "transaction/transaction_view.h"
+
+using namespace bitcoin;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+const test::TestKey key(1), key2(2), key3(3);
+const uint64_t AMOUNT = 50000;
+
+std::span<const unsigned char> as_span(const std::string& s) {
+    return std::span<const unsigned char>((const unsigned char*)s.data(), s.size());
+}
+
+std::string hex_of(const crypto::Hash256& hash) { return crypto::bytes_to_hex(hash.data(), hash.size()); }
+
+Script script_from_hex(const std::string& hex) {
+    Bytes bytes = crypto::hex_to_bytes(hex);
+    return Script(std::span<const unsigned char>(bytes));
+}
+
+std::string pubkey_of(const test::TestKey& k) { return test::to_string(k.pub.get_bytes()); }
+
+Script p2pkh_of(const test::TestKey& k) { return make_p2pkh(crypto::Hash::hash160(k.pub.get_bytes())); }
+
+// `inputs` inputs from made-up outpoints and `outputs` outputs
+TransactionRef make_tx(size_t inputs, size_t outputs, uint32_t version = 1) {
+    TransactionBuilder builder;
+    builder.set_version(version);
+    for (size_t i = 0; i < inputs; i++) {
+        builder.add_input(TransactionInput(crypto::Hash::sha256("prevout " + std::to_string(i)), (uint32_t)i, ""));
+    }
+    for (size_t i = 0; i < outputs; i++) builder.add_output(TransactionOutput(1000 * (i + 1), p2pkh_of(key)));
+    return std::move(builder).build();
+}
+
+TransactionRef with_input(const TransactionRef& tx, size_t index, const std::string& script_sig,
+                          const std::vector<std::string>& witness = {}) {
+    TransactionBuilder builder(*tx);
+    builder.mutable_input(index).script_sig = script_sig;
+    builder.mutable_input(index).witness = witness;
+    return std::move(builder).build();
+}
+
+std::string sign_legacy(const test::TestKey& k, const Transaction& tx, size_t index,
+                        std::span<const unsigned char> script_code, uint8_t hash_type = SIGHASH_ALL) {
+    Bytes signature = k.key.sign(legacy_signature_hash(tx, index, script_code, hash_type));
+    signature.push_back(hash_type);
+    return test::to_string(signature);
+}
+
+std::string sign_segwit(const test::TestKey& k, const Transaction& tx, size_t index,
+                        std::span<const unsigned char> script_code, uint8_t hash_type = SIGHASH_ALL) {
+    Bytes signature = k.key.sign(segwit_signature_hash(tx, index, script_code, AMOUNT, hash_type, PrecomputedSighash(tx)));
+    signature.push_back(hash_type);
+    return test::to_string(signature);
+}
+
+// Script of pushes (as a scriptSig string)
+std::string pushes(const std::vector<std::string>& items) {
+    Script script;
+    for (const std::string& item : items) script.push_data(as_span(item));
+    return test::to_string(script.span());
+}
+
+// Verify input `index` of `tx` against `script_pubkey`; OK if it's valid
+ScriptError verify(const Transaction& tx, size_t index, const Script& script_pubkey,
+                   uint32_t flags = CONSENSUS_SCRIPT_FLAGS) {
+    TransactionSignatureChecker checker(tx, index, AMOUNT);
+    ScriptError error = ScriptError::OK;
+    verify_script(as_span(tx.inputs[index].script_sig), script_pubkey, tx.inputs[index].witness, flags, checker, &error);
+    return error;
+}
+
+void test_bip143_vectors() {
+    struct Vector {
+        const char* tx;
+        size_t input;
+        const char* script_code;
+        uint64_t amount;
+        const char* hash_prevouts;
+        const char* hash_sequence;
+        const char* hash_outputs;
+        const char* sighash;
+    };
+    const Vector vectors[] = {
+        // Native P2WPKH
+        {"0100000002fff7f7881a8099afa6940d42d1e7f6362bec38171ea3edf433541db4e4ad969f0000000000eeffffffef51e1b804cc89d1"
+         "82d279655c3aa89e815b1b309fe287d9b2b55d57b90ec68a0100000000ffffffff02202cb206000000001976a9148280b37df378db99f6"
+         "6f85c95a783a76ac7a6d5988ac9093510d000000001976a9143bde42dbee7e4dbe6a21b2d50ce2f0167faa815988ac11000000",
+         1, "76a9141d0f172a0ecb48aee1be1f2687d2963ae33f71a188ac", 600000000,
+         "96b827c8483d4e9b96712b6713a7b68d6e8003a781feba36c31143470b4efd37",
+         "52b0a642eea2fb7ae638c36f6252b6750293dbe574a806984b8e4d8548339a3b",
+         "863ef3e1a92afbfdb97f31ad0fc7683ee943e9abcf2501590ff8f6551f47e5e5",
+         "c37af31116d1b27caf68aae9e3ac82f1477929014d5b917657d0eb49478cb670"},
+        // P2SH-P2WPKH
+        {"0100000001db6b1b20aa0fd7b23880be2ecbd4a98130974cf4748fb66092ac4d3ceb1a54770100000000feffffff02b8b4eb0b000000"
+         "001976a914a457b684d7f0d539a46a45bbc043f35b59d0d96388ac0008af2f000000001976a914fd270b1ee6abcaea97fea7ad0402e8bd"
+         "8ad6d77c88ac92040000",
+         0, "76a91479091972186c449eb1ded22b78e40d009bdf008988ac", 1000000000,
+         "b0287b4a252ac05af83d2dcef00ba313af78a3e9c329afa216eb3aa2a7b4613a",
+         "18606b350cd8bf565266bc352f0caddcf01e8fa789dd8a15386327cf8cabe198",
+         "de984f44532e2173ca0d64314fcefe6d30da6f8cf27bafa706da61df8a226c83",
+         "64f3b0f4dd2bb3aa1ce8566d220cc74dda9df97d8490cc81d89d735c92e59fb6"},
+    };
+    for (const Vector& v : vectors) {
+        Bytes raw = crypto::hex_to_bytes(v.tx);
+        TransactionRef tx = deserialize_transaction(raw);
+        PrecomputedSighash precomputed(*tx);
+        CHECK(hex_of(precomputed.hash_prevouts) == v.hash_prevouts);
+        CHECK(hex_of(precomputed.hash_sequence) == v.hash_sequence);
+        CHECK(hex_of(precomputed.hash_outputs) == v.hash_outputs);
+        Script script_code = script_from_hex(v.script_code);
+        CHECK(hex_of(segwit_signature_hash(*tx, v.input, script_code.span(), v.amount, SIGHASH_ALL, precomputed)) ==
+              v.sighash);
+    }
+}
+
+void test_legacy_sighash() {
+    Script code = p2pkh_of(key);
+    TransactionRef tx = make_tx(2, 2);
+    auto hash = [&](const TransactionRef& t, size_t index, uint8_t type) {
+        return legacy_signature_hash(*t, index, code.span(), type);
+    };
+
+    // Changing the other input: only ANYONECANPAY doesn't notice
+    TransactionBuilder other_input(*tx);
+    other_input.mutable_input(1).vout = 7;
+    TransactionRef moved = std::move(other_input).build();
+    CHECK(hash(tx, 0, SIGHASH_ALL) != hash(moved, 0, SIGHASH_ALL));
+    CHECK(hash(tx, 0, SIGHASH_ALL | SIGHASH_ANYONECANPAY) == hash(moved, 0, SIGHASH_ALL | SIGHASH_ANYONECANPAY));
+    CHECK(hash(tx, 0, SIGHASH_ALL | SIGHASH_ANYONECANPAY) != hash(tx, 1, SIGHASH_ALL | SIGHASH_ANYONECANPAY));
+
+    // The other input's sequence: NONE and SINGLE let it change
+    TransactionBuilder other_sequence(*tx);
+    other_sequence.mutable_input(1).sequence = 5;
+    TransactionRef resequenced = std::move(other_sequence).build();
+    CHECK(hash(tx, 0, SIGHASH_ALL) != hash(resequenced, 0, SIGHASH_ALL));
+    CHECK(hash(tx, 0, SIGHASH_NONE) == hash(resequenced, 0, SIGHASH_NONE));
+    CHECK(hash(tx, 0, SIGHASH_SINGLE) == hash(resequenced, 0, SIGHASH_SINGLE));
+
+    // Outputs: NONE signs none, SINGLE only its own
+    TransactionBuilder second_output(*tx);
+    second_output.mutable_output(1).value++;
+    TransactionRef revalued = std::move(second_output).build();
+    CHECK(hash(tx, 0, SIGHASH_ALL) != hash(revalued, 0, SIGHASH_ALL));
+    CHECK(hash(tx, 0, SIGHASH_NONE) == hash(revalued, 0, SIGHASH_NONE));
+    CHECK(hash(tx, 0, SIGHASH_SINGLE) == hash(revalued, 0, SIGHASH_SINGLE));
+    CHECK(hash(tx, 1, SIGHASH_SINGLE) != hash(revalued, 1, SIGHASH_SINGLE));
+
+    // SINGLE with no output at the input's index signs the number 1 ...
+    TransactionRef one_output = make_tx(2, 1);
+    crypto::Hash256 one;
+    one.data()[0] = 1;
+    CHECK(hash(one_output, 1, SIGHASH_SINGLE) == one);
+    CHECK(hash(one_output, 1, SIGHASH_SINGLE | SIGHASH_ANYONECANPAY) == one);
+    CHECK(hash(one_output, 0, SIGHASH_SINGLE) != one);
+
+    // ... and a signature of it is valid for any such transaction
+    std::string signature = sign_legacy(key, *one_output, 1, code.span(), SIGHASH_SINGLE);
+    TransactionRef spend = with_input(one_output, 1, pushes({signature, pubkey_of(key)}));
+    CHECK(verify(*spend, 1, code) == ScriptError::OK);
+    TransactionRef other = with_input(make_tx(3, 1), 2, pushes({signature, pubkey_of(key)}));
+    CHECK(verify(*other, 2, code) == ScriptError::OK);
+}
+
+void test_codeseparator() {
+    // Separators are never signed ...
+    TransactionRef tx = make_tx(1, 1);
+    Script plain, separated;
+    plain.push_opcode(OP_1).push_opcode(OP_DROP).push_opcode(OP_CHECKSIG);
+    separated.push_opcode(OP_1).push_opcode(OP_CODESEPARATOR).push_opcode(OP_DROP).push_opcode(OP_CODESEPARATOR)
+        .push_opcode(OP_CHECKSIG);
+    CHECK(legacy_signature_hash(*tx, 0, plain.span()) == legacy_signature_hash(*tx, 0, separated.span()));
+
+    // ... and only what follows the last one executed is: <pubkey> OP_CODESEPARATOR OP_CHECKSIG
+    Script script_pubkey;
+    script_pubkey.push_data(key.pub.get_bytes()).push_opcode(OP_CODESEPARATOR).push_opcode(OP_CHECKSIG);
+    Script tail;
+    tail.push_opcode(OP_CHECKSIG);
+    TransactionRef good = with_input(tx, 0, pushes({sign_legacy(key, *tx, 0, tail.span())}));
+    CHECK(verify(*good, 0, script_pubkey) == ScriptError::OK);
+    TransactionRef whole = with_input(tx, 0, pushes({sign_legacy(key, *tx, 0, script_pubkey.span())}));
+    CHECK(verify(*whole, 0, script_pubkey) == ScriptError::EVAL_FALSE);
+}
+
+void test_find_and_delete() {
+    // <sig> OP_DROP <pubkey> OP_CHECKSIG: the signature sits in the very
+    // script it signs, so it must be cut out of the script code first
+    TransactionRef tx = make_tx(1, 1);
+    Script signed_code;
+    signed_code.push_opcode(OP_DROP).push_data(key.pub.get_bytes()).push_opcode(OP_CHECKSIG);
+    std::string signature = sign_legacy(key, *tx, 0, signed_code.span());
+
+    Script script_pubkey;
+    script_pubkey.push_data(as_span(signature)).append(signed_code.span());
+    TransactionRef spend = with_input(tx, 0, pushes({signature}));
+    CHECK(verify(*spend, 0, script_pubkey) == ScriptError::OK);
+
+    // Every copy goes: <sig> <sig> OP_2DROP <pubkey> OP_CHECKSIG
+    Script twice_code;
+    twice_code.push_opcode(OP_2DROP).push_data(key.pub.get_bytes()).push_opcode(OP_CHECKSIG);
+    std::string twice_signature = sign_legacy(key, *tx, 0, twice_code.span());
+    Script twice;
+    twice.push_data(as_span(twice_signature)).push_data(as_span(twice_signature)).append(twice_code.span());
+    CHECK(verify(*with_input(tx, 0, pushes({twice_signature})), 0, twice) == ScriptError::OK);
+
+    // Not in segwit scripts: there the signature would have to sign itself
+    Script witness_script;
+    witness_script.push_data(as_span(signature)).append(signed_code.span());
+    Script p2wsh = make_p2wsh(crypto::Hash::sha256(witness_script.data(), witness_script.size()));
+    TransactionRef segwit = with_input(tx, 0, "", {signature, test::to_string(witness_script.span())});
+    CHECK(verify(*segwit, 0, p2wsh) == ScriptError::EVAL_FALSE);
+}
+
+// The P2PKH and P2WPKH shortcuts must give the interpreter's answers
+void test_templates() {
+    TransactionRef tx = make_tx(1, 1);
+    Script p2pkh = p2pkh_of(key);
+    std::string good = sign_legacy(key, *tx, 0, p2pkh.span());
+    std::string bad = good;
+    bad[10] ^= 1;                               // inside r: still DER
+    std::string not_der = good;
+    not_der[0] = 0x31;
+    Script nop;
+    nop.push_opcode(OP_NOP);
+
+    // A trailing OP_NOP keeps the scriptSig off the template path
+    for (const std::string& signature : {good, bad, not_der}) {
+        for (const test::TestKey* k : {&key, &key2}) {
+            std::string script_sig = pushes({signature, pubkey_of(*k)});
+            ScriptError via_template = verify(*with_input(tx, 0, script_sig), 0, p2pkh);
+            ScriptError via_interpreter = verify(*with_input(tx, 0, script_sig + test::to_string(nop.span())), 0, p2pkh);
+            CHECK(via_template == via_interpreter);
+        }
+    }
+    CHECK(verify(*with_input(tx, 0, pushes({good, pubkey_of(key)})), 0, p2pkh) == ScriptError::OK);
+
+    // P2WPKH signs the P2PKH script as its script code: a P2WSH of that
+    // script takes the same signature, through the interpreter
+    Script p2wpkh = key.script;
+    Script p2wsh = make_p2wsh(crypto::Hash::sha256(p2pkh.data(), p2pkh.size()));
+    std::string segwit_good = sign_segwit(key, *tx, 0, p2pkh.span());
+    std::string segwit_bad = segwit_good;
+    segwit_bad[10] ^= 1;
+    for (const std::string& signature : {segwit_good, segwit_bad, not_der, good}) {
+        for (const test::TestKey* k : {&key, &key2}) {
+            ScriptError via_template = verify(*with_input(tx, 0, "", {signature, pubkey_of(*k)}), 0, p2wpkh);
+            ScriptError via_interpreter =
+                verify(*with_input(tx, 0, "", {signature, pubkey_of(*k), test::to_string(p2pkh.span())}), 0, p2wsh);
+            CHECK(via_template == via_interpreter);
+        }
+    }
+    CHECK(verify(*with_input(tx, 0, "", {segwit_good, pubkey_of(key)}), 0, p2wpkh) == ScriptError::OK);
+}
+
+void test_multisig() {
+    // 2 of 3, as P2SH and as P2WSH
+    Script redeem;
+    redeem.push_opcode(OP_2);
+    for (const test::TestKey* k : {&key, &key2, &key3}) redeem.push_data(k->pub.get_bytes());
+    redeem.push_opcode(OP_3).push_opcode(OP_CHECKMULTISIG);
+    std::string redeem_bytes = test::to_string(redeem.span());
+    TransactionRef tx = make_tx(1, 1);
+
+    Script p2sh = make_p2sh(crypto::Hash::hash160(redeem.data(), redeem.size()));
+    std::string sig1 = sign_legacy(key, *tx, 0, redeem.span()), sig3 = sign_legacy(key3, *tx, 0, redeem.span());
+    CHECK(verify(*with_input(tx, 0, pushes({"", sig1, sig3, redeem_bytes})), 0, p2sh) == ScriptError::OK);
+    CHECK(verify(*with_input(tx, 0, pushes({"", sig3, sig1, redeem_bytes})), 0, p2sh) == ScriptError::EVAL_FALSE);
+    CHECK(verify(*with_input(tx, 0, pushes({"", sig1, sig1, redeem_bytes})), 0, p2sh) == ScriptError::EVAL_FALSE);
+    CHECK(verify(*with_input(tx, 0, pushes({"\x01", sig1, sig3, redeem_bytes})), 0, p2sh) ==
+          ScriptError::SIG_NULLDUMMY);
+    CHECK(verify(*with_input(tx, 0, pushes({"\x01", sig1, sig3, redeem_bytes})), 0, p2sh,
+                 CONSENSUS_SCRIPT_FLAGS & ~SCRIPT_VERIFY_NULLDUMMY) == ScriptError::OK);
+    // The redeem script only runs with P2SH on; without, hashing it is all
+    CHECK(verify(*with_input(tx, 0, pushes({"", sig3, sig1, redeem_bytes})), 0, p2sh,
+                 CONSENSUS_SCRIPT_FLAGS & ~SCRIPT_VERIFY_P2SH & ~SCRIPT_VERIFY_WITNESS) == ScriptError::OK);
+
+    Script p2wsh = make_p2wsh(crypto::Hash::sha256(redeem.data(), redeem.size()));
+    std::string wsig1 = sign_segwit(key, *tx, 0, redeem.span()), wsig2 = sign_segwit(key2, *tx, 0, redeem.span());
+    CHECK(verify(*with_input(tx, 0, "", {"", wsig1, wsig2, redeem_bytes}), 0, p2wsh) == ScriptError::OK);
+    CHECK(verify(*with_input(tx, 0, "", {"", wsig2, wsig1, redeem_bytes}), 0, p2wsh) == ScriptError::EVAL_FALSE);
+    CHECK(verify(*with_input(tx, 0, "", {"", sig1, sig3, redeem_bytes}), 0, p2wsh) == ScriptError::EVAL_FALSE);
+    CHECK(verify(*with_input(tx, 0, "", {"\x01", wsig1, wsig2, redeem_bytes}), 0, p2wsh) ==
+          ScriptError::SIG_NULLDUMMY);
+}
+
+void test_lock_times() {
+    auto lock_script = [](int64_t n, Opcode op) {
+        Script script;
+        script.push_int(n).push_opcode(op).push_opcode(OP_DROP).push_opcode(OP_1);
+        return script;
+    };
+    auto spend = [](uint32_t version, uint32_t locktime, uint32_t sequence) {
+        TransactionBuilder builder(*make_tx(1, 1, version));
+        builder.set_locktime(locktime);
+        builder.mutable_input(0).sequence = sequence;
+        return std::move(builder).build();
+    };
+
+    // CLTV: heights against heights, times against times, and not on a final input
+    Script cltv = lock_script(100, OP_CHECKLOCKTIMEVERIFY);
+    CHECK(verify(*spend(1, 100, 0), 0, cltv) == ScriptError::OK);
+    CHECK(verify(*spend(1, 99, 0), 0, cltv) == ScriptError::UNSATISFIED_LOCKTIME);
+    CHECK(verify(*spend(1, 100, SEQUENCE_FINAL), 0, cltv) == ScriptError::UNSATISFIED_LOCKTIME);
+    CHECK(verify(*spend(1, LOCKTIME_THRESHOLD + 1, 0), 0, cltv) == ScriptError::UNSATISFIED_LOCKTIME);
+    Script cltv_time = lock_script(LOCKTIME_THRESHOLD + 1, OP_CHECKLOCKTIMEVERIFY);
+    CHECK(verify(*spend(1, LOCKTIME_THRESHOLD + 1, 0), 0, cltv_time) == ScriptError::OK);
+    CHECK(verify(*spend(1, 100, 0), 0, lock_script(-1, OP_CHECKLOCKTIMEVERIFY)) == ScriptError::NEGATIVE_LOCKTIME);
+    CHECK(verify(*spend(1, 99, 0), 0, cltv, CONSENSUS_SCRIPT_FLAGS & ~SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY) ==
+          ScriptError::OK);
+
+    // CSV: version 2 only, blocks against blocks, the disable flag a NOP
+    Script csv = lock_script(10, OP_CHECKSEQUENCEVERIFY);
+    CHECK(verify(*spend(2, 0, 10), 0, csv) == ScriptError::OK);
+    CHECK(verify(*spend(2, 0, 9), 0, csv) == ScriptError::UNSATISFIED_LOCKTIME);
+    CHECK(verify(*spend(1, 0, 10), 0, csv) == ScriptError::UNSATISFIED_LOCKTIME);
+    CHECK(verify(*spend(2, 0, 10 | SEQUENCE_LOCKTIME_DISABLE_FLAG), 0, csv) == ScriptError::UNSATISFIED_LOCKTIME);
+    CHECK(verify(*spend(2, 0, SEQUENCE_LOCKTIME_TYPE_FLAG | 10), 0, csv) == ScriptError::UNSATISFIED_LOCKTIME);
+    CHECK(verify(*spend(2, 0, SEQUENCE_LOCKTIME_TYPE_FLAG | 10), 0,
+                 lock_script(SEQUENCE_LOCKTIME_TYPE_FLAG | 10, OP_CHECKSEQUENCEVERIFY)) == ScriptError::OK);
+    CHECK(verify(*spend(1, 0, 0), 0, lock_script(SEQUENCE_LOCKTIME_DISABLE_FLAG, OP_CHECKSEQUENCEVERIFY)) ==
+          ScriptError::OK);
+}
+
+void test_witness_malleation() {
+    TransactionRef tx = make_tx(1, 1);
+    Script p2pkh = p2pkh_of(key);
+    std::string signature = sign_segwit(key, *tx, 0, p2pkh.span());
+    std::vector<std::string> witness{signature, pubkey_of(key)};
+
+    // Native witness spends take no scriptSig at all
+    CHECK(verify(*with_input(tx, 0, "", witness), 0, key.script) == ScriptError::OK);
+    CHECK(verify(*with_input(tx, 0, pushes({"x"}), witness), 0, key.script) == ScriptError::WITNESS_MALLEATED);
+
+    // P2SH-wrapped: the scriptSig is the redeem script push and nothing else
+    std::string program = test::to_string(key.script.span());
+    Script p2sh = make_p2sh(crypto::Hash::hash160(key.script.data(), key.script.size()));
+    CHECK(verify(*with_input(tx, 0, pushes({program}), witness), 0, p2sh) == ScriptError::OK);
+    CHECK(verify(*with_input(tx, 0, pushes({"x", program}), witness), 0, p2sh) ==
+          ScriptError::WITNESS_MALLEATED_P2SH);
+
+    // A witness nothing asked for
+    std::string legacy_sig = sign_legacy(key, *tx, 0, p2pkh.span());
+    CHECK(verify(*with_input(tx, 0, pushes({legacy_sig, pubkey_of(key)})), 0, p2pkh) == ScriptError::OK);
+    CHECK(verify(*with_input(tx, 0, pushes({legacy_sig, pubkey_of(key)}), {"x"}), 0, p2pkh) ==
+          ScriptError::WITNESS_UNEXPECTED);
+
+    // Malformed witness programs and witnesses
+    CHECK(verify(*with_input(tx, 0, "", {signature}), 0, key.script) == ScriptError::WITNESS_PROGRAM_MISMATCH);
+    Script wsh_script;
+    wsh_script.push_opcode(OP_1);
+    Script p2wsh = make_p2wsh(crypto::Hash::sha256(wsh_script.data(), wsh_script.size()));
+    CHECK(verify(*with_input(tx, 0, "", {test::to_string(wsh_script.span())}), 0, p2wsh) == ScriptError::OK);
+    CHECK(verify(*with_input(tx, 0, "", {}), 0, p2wsh) == ScriptError::WITNESS_PROGRAM_WITNESS_EMPTY);
+    CHECK(verify(*with_input(tx, 0, "", {"\x52"}), 0, p2wsh) == ScriptError::WITNESS_PROGRAM_MISMATCH);
+    CHECK(verify(*with_input(tx, 0, "", {"", test::to_string(wsh_script.span())}), 0, p2wsh) ==
+          ScriptError::WITNESS_CLEANSTACK);
+    CHECK(verify(*with_input(tx, 0, "", {"x"}), 0, script_from_hex("0015" + std::string(42, '1'))) ==
+          ScriptError::WITNESS_PROGRAM_WRONG_LENGTH);
+}
+
+} // namespace
+
+int main() {
+    test_bip143_vectors();
+    test_legacy_sighash();
+    test_codeseparator();
+    test_find_and_delete();
+    test_templates();
+    test_multisig();
+    test_lock_times();
+    test_witness_malleation();
+    return test_result();
+}
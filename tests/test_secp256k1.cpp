@@ -0,0 +1,371 @@
+// tests/test_secp256k1.cpp
+//
+// The native secp256k1 code against OpenSSL's generic EC implementation:
+// key derivation, ECDSA both ways, and public key (de)compression. Then
+// BIP340: the reference vectors, and batch verification on both sides of
+// the Strauss/Pippenger switch.
+
+// The EC_KEY / ECDSA_SIG API is deprecated in OpenSSL 3 but still the
+// simplest independent reference for raw curve operations
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/obj_mac.h>
+
+#include <random>
+#include <vector>
+#include "check.h"
+#include "crypto/hash.h"
+#include "crypto/hex.h"
+#include "crypto/keys.h"
+#include "crypto/secp256k1.h"
+
+using namespace crypto;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+EC_GROUP* group() {
+    static EC_GROUP* curve = EC_GROUP_new_by_curve_name(NID_secp256k1);
+    return curve;
+}
+
+// OpenSSL key pair for the private key `secret`
+EC_KEY* openssl_key(const Bytes& secret) {
+    EC_KEY* key = EC_KEY_new();
+    EC_KEY_set_group(key, group());
+    BIGNUM* priv = BN_bin2bn(secret.data(), (int)secret.size(), nullptr);
+    EC_POINT* pub = EC_POINT_new(group());
+    EC_POINT_mul(group(), pub, priv, nullptr, nullptr, nullptr);
+    EC_KEY_set_private_key(key, priv);
+    EC_KEY_set_public_key(key, pub);
+    EC_POINT_free(pub);
+    BN_free(priv);
+    return key;
+}
+
+Bytes openssl_public_key(EC_KEY* key, point_conversion_form_t form) {
+    Bytes out(65);
+    size_t len = EC_POINT_point2oct(group(), EC_KEY_get0_public_key(key), form, out.data(), out.size(), nullptr);
+    out.resize(len);
+    return out;
+}
+
+bool openssl_verify(EC_KEY* key, const Hash256& digest, const Bytes& der) {
+    const unsigned char* p = der.data();
+    ECDSA_SIG* sig = d2i_ECDSA_SIG(nullptr, &p, (long)der.size());
+    if (!sig) return false;
+    bool ok = ECDSA_do_verify(digest.data(), (int)digest.size(), sig, key) == 1;
+    ECDSA_SIG_free(sig);
+    return ok;
+}
+
+// OpenSSL signature, with s made low as Bitcoin signers do
+Bytes openssl_sign(EC_KEY* key, const Hash256& digest) {
+    ECDSA_SIG* sig = ECDSA_do_sign(digest.data(), (int)digest.size(), key);
+    const BIGNUM *r, *s;
+    ECDSA_SIG_get0(sig, &r, &s);
+    BIGNUM* order = BN_dup(EC_GROUP_get0_order(group()));
+    BIGNUM* half = BN_new();
+    BN_rshift1(half, order);
+    if (BN_cmp(s, half) > 0) {
+        BIGNUM* low = BN_new();
+        BN_sub(low, order, s);
+        ECDSA_SIG_set0(sig, BN_dup(r), low);
+    }
+    Bytes der(i2d_ECDSA_SIG(sig, nullptr));
+    unsigned char* p = der.data();
+    i2d_ECDSA_SIG(sig, &p);
+    BN_free(half);
+    BN_free(order);
+    ECDSA_SIG_free(sig);
+    return der;
+}
+
+void test_rfc6979_vector() {
+    // Private key 1 signing SHA256("Satoshi Nakamoto"): deterministic nonce, low s
+    PrivateKey key("0000000000000000000000000000000000000000000000000000000000000001");
+    Hash256 digest = Hash::sha256("Satoshi Nakamoto");
+    Bytes der = key.sign(digest);
+    secp256k1::Scalar r, s;
+    CHECK(secp256k1::parse_der_signature(der, r, s));
+    unsigned char rs[64];
+    r.get_bytes(rs);
+    s.get_bytes(rs + 32);
+    CHECK(bytes_to_hex(rs, 64) ==
+          "934b1ea10a4b3c1757e2b0c017d0b6143ce3c9a7e6a4a49860d7a6ab210ee3d8"
+          "2442ce9d2b916064108014783e923ec36b49743e2ffa1c4496f01a512aafd9e5");
+}
+
+void test_against_openssl(std::mt19937_64& rng, int rounds) {
+    for (int round = 0; round < rounds; round++) {
+        Bytes secret(32);
+        for (unsigned char& b : secret) b = (unsigned char)rng();
+        // Small and top-heavy keys now and then, where carries go wrong
+        if (round % 50 == 1) std::fill(secret.begin(), secret.end() - 1, 0);
+        if (round % 50 == 2) std::fill(secret.begin(), secret.begin() + 8, 0xff);
+
+        PrivateKey key(bytes_to_hex(secret));
+        EC_KEY* reference = openssl_key(secret);
+
+        // Key derivation, compressed
+        PublicKey pub(key);
+        Bytes compressed = openssl_public_key(reference, POINT_CONVERSION_COMPRESSED);
+        CHECK(pub.get_bytes() == compressed);
+
+        // Decompression: the compressed key parsed and written out in full
+        Bytes uncompressed = openssl_public_key(reference, POINT_CONVERSION_UNCOMPRESSED);
+        secp256k1::AffinePoint point;
+        CHECK(secp256k1::parse_public_key(compressed, point));
+        CHECK(secp256k1::serialize_public_key(point, false) == uncompressed);
+        secp256k1::AffinePoint full;
+        CHECK(secp256k1::parse_public_key(uncompressed, full));
+        CHECK(secp256k1::serialize_public_key(full, true) == compressed);
+
+        Bytes message(1 + rng() % 100);
+        for (unsigned char& b : message) b = (unsigned char)rng();
+        Hash256 digest = Hash::double_sha256(message.data(), message.size());
+        Hash256 other = Hash::sha256(message.data(), message.size());
+
+        // Ours signs, OpenSSL verifies
+        Bytes ours = key.sign(digest);
+        CHECK(openssl_verify(reference, digest, ours));
+        CHECK(!openssl_verify(reference, other, ours));
+        CHECK(pub.verify_digest(digest, ours));
+
+        // OpenSSL signs, ours verifies through either key encoding
+        Bytes theirs = openssl_sign(reference, digest);
+        CHECK(pub.verify_digest(digest, theirs));
+        CHECK(PublicKey(std::span<const unsigned char>(uncompressed)).verify_digest(digest, theirs));
+        CHECK(!pub.verify_digest(other, theirs));
+
+        EC_KEY_free(reference);
+    }
+}
+
+void test_invalid_keys() {
+    // x must be below the field prime
+    Bytes overflow = hex_to_bytes("02fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f");
+    CHECK(!PublicKey(std::span<const unsigned char>(overflow)).is_valid());
+
+    Bytes bad_prefix(33, 0x11);
+    bad_prefix[0] = 0x05;
+    CHECK(!PublicKey(std::span<const unsigned char>(bad_prefix)).is_valid());
+
+    // An uncompressed point with y flipped off the curve
+    PrivateKey key("00000000000000000000000000000000000000000000000000000000000000ff");
+    EC_KEY* reference = openssl_key(Bytes(key.get_bytes()));
+    Bytes uncompressed = openssl_public_key(reference, POINT_CONVERSION_UNCOMPRESSED);
+    uncompressed[64] ^= 1;
+    CHECK(!PublicKey(std::span<const unsigned char>(uncompressed)).is_valid());
+    EC_KEY_free(reference);
+}
+
+// BIP340 test-vectors.csv, rows 0-14: the ones with 32-byte messages, which
+// is what schnorr_sign/schnorr_verify take (15-18 cover other lengths)
+struct SchnorrVector {
+    const char* secret;         // empty: verification only
+    const char* public_key;
+    const char* aux_rand;
+    const char* message;
+    const char* signature;
+    bool valid;
+};
+
+const SchnorrVector schnorr_vectors[] = {
+    {"0000000000000000000000000000000000000000000000000000000000000003",
+     "F9308A019258C31049344F85F89D5229B531C845836F99B08601F113BCE036F9",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "E907831F80848D1069A5371B402410364BDF1C5F8307B0084C55F1CE2DCA8215"
+     "25F66A4A85EA8B71E482A74F382D2CE5EBEEE8FDB2172F477DF4900D310536C0", true},
+    {"B7E151628AED2A6ABF7158809CF4F3C762E7160F38B4DA56A784D9045190CFEF",
+     "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659",
+     "0000000000000000000000000000000000000000000000000000000000000001",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "6896BD60EEAE296DB48A229FF71DFE071BDE413E6D43F917DC8DCF8C78DE3341"
+     "8906D11AC976ABCCB20B091292BFF4EA897EFCB639EA871CFA95F6DE339E4B0A", true},
+    {"C90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B14E5C9",
+     "DD308AFEC5777E13121FA72B9CC1B7CC0139715309B086C960E18FD969774EB8",
+     "C87AA53824B4D7AE2EB035A2B5BBBCCC080E76CDC6D1692C4B0B62D798E6D906",
+     "7E2D58D8B3BCDF1ABADEC7829054F90DDA9805AAB56C77333024B9D0A508B75C",
+     "5831AAEED7B44BB74E5EAB94BA9D4294C49BCF2A60728D8B4C200F50DD313C1B"
+     "AB745879A5AD954A72C45A91C3A51D3C7ADEA98D82F8481E0E1E03674A6F3FB7", true},
+    {"0B432B2677937381AEF05BB02A66ECD012773062CF3FA2549E44F58ED2401710",
+     "25D1DFF95105F5253C4022F628A996AD3A0D95FBF21D468A1B33F8C160D8F517",
+     "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+     "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF",
+     "7EB0509757E246F19449885651611CB965ECC1A187DD51B64FDA1EDC9637D5EC"
+     "97582B9CB13DB3933705B32BA982AF5AF25FD78881EBB32771FC5922EFC66EA3", true},
+    {"", "D69C3509BB99E412E68B0FE8544E72837DFA30746D8BE2AA65975F29D22DC7B9", "",
+     "4DF3C3F68FCC83B27E9D42C90431A72499F17875C81A599B566C9889B9696703",
+     "00000000000000000000003B78CE563F89A0ED9414F5AA28AD0D96D6795F9C63"
+     "76AFB1548AF603B3EB45C9F8207DEE1060CB71C04E80F593060B07D28308D7F4", true},
+    // public key not on the curve
+    {"", "EEFDEA4CDB677750A420FEE807EACF21EB9898AE79B9768766E4FAA04A2D4A34", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+     "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", false},
+    // R has odd y
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "FFF97BD5755EEEA420453A14355235D382F6472F8568A18B2F057A1460297556"
+     "3CC27944640AC607CD107AE10923D9EF7A73C643E166BE5EBEAFA34B1AC553E2", false},
+    // negated message
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "1FA62E331EDBC21C394792D2AB1100A7B432B013DF3F6FF4F99FCB33E0E1515F"
+     "28890B3EDB6E7189B630448B515CE4F8622A954CFE545735AAEA5134FCCDB2BD", false},
+    // negated s
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+     "961764B3AA9B2FFCB6EF947B6887A226E8D7C93E00C5ED0C1834FF0D0C2E6DA6", false},
+    // sG - eP is infinite (and its x taken as 0)
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "0000000000000000000000000000000000000000000000000000000000000000"
+     "123DDA8328AF9C23A94C1FEECFD123BA4FB73476F0D594DCB65C6425BD186051", false},
+    // sG - eP is infinite (and its x taken as 1)
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "0000000000000000000000000000000000000000000000000000000000000001"
+     "7615FBAF5AE28864013C099742DEADB4DBA87F11AC6754F93780D5A1837CF197", false},
+    // r is not the x of a point on the curve
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "4A298DACAE57395A15D0795DDBFD1DCB564DA82B0F269BC70A74F8220429BA1D"
+     "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", false},
+    // r equals the field size
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F"
+     "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", false},
+    // s equals the group order
+    {"", "DFF1D77F2A671C5F36183726DB2341BE58FEAE1DA2DECED843240F7B502BA659", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+     "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141", false},
+    // public key above the field size
+    {"", "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC30", "",
+     "243F6A8885A308D313198A2E03707344A4093822299F31D0082EFA98EC4E6C89",
+     "6CFF5C3BA86C69EA4B7376F31A9BCB4F74C1976089B2D9963DA2E5543E177769"
+     "69E89B4C5564D00349106B8497785DD7D1D713A8AE82B32FA79D5F7FC407D39B", false},
+};
+
+void test_schnorr_vectors() {
+    for (const SchnorrVector& v : schnorr_vectors) {
+        Bytes public_key = hex_to_bytes(v.public_key), signature = hex_to_bytes(v.signature);
+        Hash256 digest(hex_to_bytes(v.message).data());
+        if (*v.secret) {
+            secp256k1::Scalar secret;
+            CHECK(secret.set_bytes(hex_to_bytes(v.secret).data()));
+            Bytes aux = hex_to_bytes(v.aux_rand);
+            unsigned char ours[64];
+            CHECK(secp256k1::schnorr_sign(secret, digest, aux.data(), ours));
+            CHECK(Bytes(ours, ours + 64) == signature);
+            CHECK(XOnlyPublicKey(PrivateKey(v.secret)).get_bytes() == public_key);
+        }
+
+        secp256k1::AffinePoint point;
+        bool lifted = secp256k1::lift_x(public_key.data(), point);
+        CHECK(lifted || !v.valid);
+        CHECK((lifted && secp256k1::schnorr_verify(point, digest, signature.data())) == v.valid);
+        CHECK(XOnlyPublicKey(std::span<const unsigned char>(public_key)).verify_schnorr(digest, signature) == v.valid);
+        if (lifted) {
+            secp256k1::SchnorrBatchEntry entry{&point, &digest, signature.data()};
+            CHECK(secp256k1::schnorr_verify_batch({&entry, 1}) == v.valid);
+        }
+    }
+}
+
+// A batch of n entries is a multi_multiply over 2n points: 31 entries go
+// through Strauss, 32 and up through Pippenger
+void test_schnorr_batch(std::mt19937_64& rng) {
+    const size_t sizes[] = {1, 2, 31, 32, 33, 100};
+    std::vector<secp256k1::AffinePoint> keys;
+    std::vector<Hash256> digests;
+    std::vector<Bytes> signatures;
+    for (size_t i = 0; i < 100; i++) {
+        Bytes secret(32);
+        for (unsigned char& b : secret) b = (unsigned char)rng();
+        secret[0] &= 0x7f;
+        PrivateKey key(bytes_to_hex(secret));
+        Bytes x = XOnlyPublicKey(key).get_bytes();
+        secp256k1::AffinePoint point;
+        CHECK(secp256k1::lift_x(x.data(), point));
+        keys.push_back(point);
+        digests.push_back(Hash::sha256(secret.data(), secret.size()));
+        signatures.push_back(key.sign_schnorr(digests.back()));
+    }
+
+    for (size_t n : sizes) {
+        auto batch = [&](const std::vector<Bytes>& sigs, const std::vector<Hash256>& msgs) {
+            std::vector<secp256k1::SchnorrBatchEntry> entries;
+            for (size_t i = 0; i < n; i++) entries.push_back({&keys[i], &msgs[i], sigs[i].data()});
+            return secp256k1::schnorr_verify_batch(entries);
+        };
+        CHECK(batch(signatures, digests));
+
+        // One bad entry anywhere sinks the batch: first, last, and a random one
+        for (size_t bad : {size_t(0), n - 1, size_t(rng() % n)}) {
+            std::vector<Bytes> corrupted = signatures;
+            corrupted[bad][32 + rng() % 32] ^= (unsigned char)(1 + rng() % 255);
+            CHECK(!batch(corrupted, digests));
+            std::vector<Hash256> other_digests = digests;
+            other_digests[bad].data()[0] ^= 1;
+            CHECK(!batch(signatures, other_digests));
+        }
+        // Two wrong signatures swapped between entries
+        if (n >= 2) {
+            std::vector<Bytes> swapped = signatures;
+            std::swap(swapped[0], swapped[n - 1]);
+            CHECK(!batch(swapped, digests));
+        }
+    }
+}
+
+// multi_multiply on both sides of its Strauss/Pippenger switch against
+// adding up single multiplications
+void test_multi_multiply(std::mt19937_64& rng) {
+    for (size_t n : {63, 64, 65}) {
+        std::vector<secp256k1::AffinePoint> points;
+        std::vector<secp256k1::Scalar> scalars;
+        secp256k1::Scalar ng, zero;
+        unsigned char bytes[32];
+        for (unsigned char& b : bytes) b = (unsigned char)rng();
+        bytes[0] &= 0x7f;
+        ng.set_bytes(bytes);
+        secp256k1::JacobianPoint expected = secp256k1::multiply_generator(ng);
+        for (size_t i = 0; i < n; i++) {
+            secp256k1::Scalar k, s;
+            for (unsigned char& b : bytes) b = (unsigned char)rng();
+            bytes[0] &= 0x7f;
+            k.set_bytes(bytes);
+            for (unsigned char& b : bytes) b = (unsigned char)rng();
+            bytes[0] &= 0x7f;
+            s.set_bytes(bytes);
+            points.push_back(secp256k1::multiply_generator(k).to_affine());
+            scalars.push_back(s);
+            expected = expected.add(secp256k1::multiply(points.back(), s, zero));
+        }
+        secp256k1::AffinePoint got = secp256k1::multi_multiply(points, scalars, ng).to_affine();
+        secp256k1::AffinePoint want = expected.to_affine();
+        CHECK(got.x == want.x && got.y == want.y);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(2009);
+    test_rfc6979_vector();
+    test_against_openssl(rng, 500);
+    test_invalid_keys();
+    test_schnorr_vectors();
+    test_schnorr_batch(rng);
+    test_multi_multiply(rng);
+    return test_result();
+}
@@ -0,0 +1,204 @@
+// tests/test_sha256.cpp
+//
+// Every compiled SHA-256 backend against OpenSSL: the scalar code, each SIMD
+// lane kernel this CPU can run, and the dispatched batch functions at batch
+// sizes that exercise every mix of 16-, 8-, 4- and 1-way steps.
+
+#include <openssl/sha.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "check.h"
+#include "crypto/sha256.h"
+
+#ifdef ENABLE_SSE41
+namespace crypto::sha256_sse41 {
+void transform_d64_4way(unsigned char* out, const unsigned char* in);
+void hash_headers_4way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+}
+#endif
+#ifdef ENABLE_AVX2
+namespace crypto::sha256_avx2 {
+void transform_d64_8way(unsigned char* out, const unsigned char* in);
+void hash_headers_8way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+}
+#endif
+#ifdef ENABLE_AVX512
+namespace crypto::sha256_avx512 {
+void transform_d64_16way(unsigned char* out, const unsigned char* in);
+void hash_headers_16way(unsigned char* out, const uint32_t* midstate, const unsigned char* tail, uint32_t first_nonce);
+}
+#endif
+#ifdef ENABLE_X86_SHANI
+namespace crypto::sha256_x86_shani {
+void transform(uint32_t* state, const unsigned char* chunk, size_t blocks);
+void transform_d64(unsigned char* out, const unsigned char* in);
+}
+#endif
+
+using namespace crypto;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+typedef void (*TransformFn)(uint32_t*, const unsigned char*, size_t);
+typedef void (*TransformD64Fn)(unsigned char*, const unsigned char*);
+typedef void (*HashHeadersFn)(unsigned char*, const uint32_t*, const unsigned char*, uint32_t);
+
+const size_t BATCH_SIZES[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 24, 31, 33, 64, 100};
+
+Bytes random_bytes(std::mt19937_64& rng, size_t size) {
+    Bytes out(size);
+    for (unsigned char& b : out) b = (unsigned char)rng();
+    return out;
+}
+
+// SHA256d of each 64-byte input, the slow way
+Bytes reference_d64(const Bytes& in) {
+    Bytes out(in.size() / 2);
+    for (size_t i = 0; i < in.size() / 64; i++) {
+        unsigned char first[32];
+        SHA256(in.data() + 64 * i, 64, first);
+        SHA256(first, 32, out.data() + 32 * i);
+    }
+    return out;
+}
+
+void test_sha256d64(std::mt19937_64& rng) {
+    for (size_t count : BATCH_SIZES) {
+        Bytes in = random_bytes(rng, 64 * count);
+        Bytes out(32 * count + 1, 0xee);
+        sha256::sha256d64(out.data(), in.data(), count);
+        CHECK(Bytes(out.begin(), out.end() - 1) == reference_d64(in));
+        CHECK(out.back() == 0xee);              // nothing written past the end
+    }
+}
+
+// A lane kernel on whole batches of `lanes` inputs
+void test_d64_kernel(std::mt19937_64& rng, TransformD64Fn fn, size_t lanes) {
+    for (int round = 0; round < 50; round++) {
+        Bytes in = random_bytes(rng, 64 * lanes);
+        Bytes out(32 * lanes);
+        fn(out.data(), in.data());
+        CHECK(out == reference_d64(in));
+    }
+}
+
+// A multi-block compression function on padded messages of 0 to 300 bytes
+void test_transform(std::mt19937_64& rng, TransformFn fn) {
+    for (size_t len = 0; len <= 300; len++) {
+        Bytes message = random_bytes(rng, len);
+        size_t blocks = (len + 8) / 64 + 1;
+        Bytes padded(64 * blocks, 0);
+        std::memcpy(padded.data(), message.data(), len);
+        padded[len] = 0x80;
+        uint64_t bit_length = (uint64_t)len * 8;
+        for (int i = 0; i < 8; i++) padded[padded.size() - 1 - i] = (unsigned char)(bit_length >> (8 * i));
+
+        uint32_t state[8];
+        std::memcpy(state, sha256::INITIAL_STATE, sizeof(state));
+        fn(state, padded.data(), blocks);
+        unsigned char got[32], expected[32];
+        sha256::write_digest(state, got);
+        SHA256(message.data(), len, expected);
+        CHECK(std::memcmp(got, expected, 32) == 0);
+    }
+}
+
+// A header kernel: `lanes` consecutive nonces after a midstate, across the
+// 32-bit wrap now and then
+void test_header_kernel(std::mt19937_64& rng, HashHeadersFn fn, size_t lanes) {
+    for (int round = 0; round < 50; round++) {
+        Bytes header = random_bytes(rng, 80);
+        uint32_t first_nonce = round % 10 == 0 ? 0xffffffff - (uint32_t)(round % lanes) : (uint32_t)rng();
+
+        uint32_t midstate[8];
+        std::memcpy(midstate, sha256::INITIAL_STATE, sizeof(midstate));
+        sha256::transform(midstate, header.data(), 1);
+        unsigned char tail[64] = {0};
+        std::memcpy(tail, header.data() + 64, 16);
+        tail[16] = 0x80;
+        tail[62] = 0x02;
+        tail[63] = 0x80;
+
+        unsigned char got[32 * sha256::MAX_HEADER_LANES];
+        fn(got, midstate, tail, first_nonce);
+        for (size_t lane = 0; lane < lanes; lane++) {
+            uint32_t nonce = first_nonce + (uint32_t)lane;
+            for (int i = 0; i < 4; i++) header[76 + i] = (unsigned char)(nonce >> (8 * i));
+            unsigned char first[32], expected[32];
+            SHA256(header.data(), 80, first);
+            SHA256(first, 32, expected);
+            CHECK(std::memcmp(got + 32 * lane, expected, 32) == 0);
+        }
+    }
+}
+
+// Split writes of odd sizes through the streaming writer
+void test_writer(std::mt19937_64& rng) {
+    for (int round = 0; round < 200; round++) {
+        Bytes message = random_bytes(rng, rng() % 1000);
+        Sha256Writer writer;
+        for (size_t pos = 0; pos < message.size();) {
+            size_t step = std::min<size_t>(1 + rng() % 130, message.size() - pos);
+            writer.update(message.data() + pos, step);
+            pos += step;
+        }
+        unsigned char expected[32];
+        SHA256(message.data(), message.size(), expected);
+        CHECK(std::memcmp(writer.finalize().data(), expected, 32) == 0);
+    }
+}
+
+void test_kernels(std::mt19937_64& rng) {
+#ifdef ENABLE_SSE41
+    if (__builtin_cpu_supports("sse4.1")) {
+        test_d64_kernel(rng, sha256_sse41::transform_d64_4way, 4);
+        test_header_kernel(rng, sha256_sse41::hash_headers_4way, 4);
+    }
+#endif
+#ifdef ENABLE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        test_d64_kernel(rng, sha256_avx2::transform_d64_8way, 8);
+        test_header_kernel(rng, sha256_avx2::hash_headers_8way, 8);
+    }
+#endif
+#ifdef ENABLE_AVX512
+    if (__builtin_cpu_supports("avx512f")) {
+        test_d64_kernel(rng, sha256_avx512::transform_d64_16way, 16);
+        test_header_kernel(rng, sha256_avx512::hash_headers_16way, 16);
+    }
+#endif
+#ifdef ENABLE_X86_SHANI
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) {
+        test_transform(rng, sha256_x86_shani::transform);
+        test_d64_kernel(rng, sha256_x86_shani::transform_d64, 1);
+    }
+#endif
+    (void)rng;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(2008);
+
+    // Before auto_detect() everything runs the scalar code
+    test_transform(rng, sha256::transform);
+    test_sha256d64(rng);
+    test_header_kernel(rng, sha256::hash_headers, sha256::header_lanes());
+    test_writer(rng);
+
+    test_kernels(rng);
+
+    // Then whatever was picked for this CPU
+    std::printf("sha256: %s\n", sha256::auto_detect().c_str());
+    test_transform(rng, sha256::transform);
+    test_sha256d64(rng);
+    test_header_kernel(rng, sha256::hash_headers, sha256::header_lanes());
+    test_writer(rng);
+
+    return test_result();
+}
@@ -0,0 +1,126 @@
+// tests/test_sig_cache.cpp
+//
+// SignatureCache: entries hit once inserted and only then, what goes into
+// an entry, eviction in a small table, and the cache behind
+// TransactionSignatureChecker - a second check of a good signature is a
+// hit, a corrupted one misses and fails however warm the cache is.
+
+#include <random>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "crypto/hash.h"
+#include "script/interpreter.h"
+#include "script/sig_cache.h"
+#include "test_util.h"
+
+using namespace bitcoin;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+const test::TestKey key(1);
+
+crypto::Hash256 random_hash(std::mt19937_64& rng) {
+    crypto::Hash256 hash;
+    for (size_t i = 0; i < hash.size(); i++) hash.data()[i] = (unsigned char)rng();
+    return hash;
+}
+
+void test_entries(std::mt19937_64& rng) {
+    SignatureCache cache;
+    Bytes pubkey = key.pub.get_bytes();
+    crypto::Hash256 sighash = random_hash(rng);
+    Bytes signature(71, 0x30);
+    crypto::Hash256 entry = cache.compute_entry_ecdsa(pubkey, sighash, signature);
+    CHECK(cache.compute_entry_ecdsa(pubkey, sighash, signature) == entry);
+
+    CHECK(!cache.contains(entry));
+    cache.insert(entry);
+    CHECK(cache.contains(entry));
+    cache.insert(entry);
+    SignatureCacheStats stats = cache.stats();
+    CHECK(stats.inserts == 1 && stats.hits == 1 && stats.misses == 1 && stats.evictions == 0);
+
+    // Every part of the key counts
+    Bytes other_pubkey = test::TestKey(2).pub.get_bytes();
+    Bytes other_signature = signature;
+    other_signature.back() ^= 1;
+    CHECK(!cache.contains(cache.compute_entry_ecdsa(other_pubkey, sighash, signature)));
+    CHECK(!cache.contains(cache.compute_entry_ecdsa(pubkey, random_hash(rng), signature)));
+    CHECK(!cache.contains(cache.compute_entry_ecdsa(pubkey, sighash, other_signature)));
+
+    // Another instance has another salt
+    SignatureCache other;
+    CHECK(other.compute_entry_ecdsa(pubkey, sighash, signature) != entry);
+    CHECK(!other.contains(entry));
+}
+
+void test_small_table(std::mt19937_64& rng) {
+    // 64 buckets of 8: inserting far more than fits pushes the oldest out,
+    // but nothing that was never inserted ever hits
+    SignatureCache cache(4096);
+    CHECK(cache.stats().capacity == 512);
+    std::vector<crypto::Hash256> entries;
+    for (int i = 0; i < 200; i++) {
+        entries.push_back(random_hash(rng));
+        cache.insert(entries.back());
+    }
+    size_t found = 0;
+    for (const crypto::Hash256& entry : entries) found += cache.contains(entry);
+    CHECK(found >= 190);
+
+    for (int i = 0; i < 5000; i++) cache.insert(random_hash(rng));
+    CHECK(cache.stats().inserts == 5200);
+    CHECK(cache.stats().evictions > 0);
+    size_t false_hits = 0;
+    for (int i = 0; i < 100000; i++) false_hits += cache.contains(random_hash(rng));
+    CHECK(false_hits == 0);
+}
+
+void test_checker(std::mt19937_64& rng) {
+    const uint64_t amount = 50000;
+    OutPoint coin(crypto::Hash::sha256("coin"), 0);
+    TransactionRef tx = test::spend(key, {{coin, TransactionOutput(amount, key.script)}},
+                                    {TransactionOutput(amount - 1000, key.script)});
+    Bytes signature(tx->inputs[0].witness[0].begin(), tx->inputs[0].witness[0].end());
+    Bytes pubkey = key.pub.get_bytes();
+    Script script_code = make_p2pkh(crypto::Hash::hash160(pubkey));
+
+    // Warm: full of other signatures' entries
+    SignatureCache cache(1 << 16);
+    for (size_t i = 0; i < cache.stats().capacity / 2; i++) cache.insert(random_hash(rng));
+    uint64_t inserts = cache.stats().inserts;
+
+    TransactionSignatureChecker checker(*tx, 0, amount, nullptr, &cache);
+    CHECK(checker.check_ecdsa(signature, pubkey, script_code.span(), SigVersion::WITNESS_V0));
+    CHECK(cache.stats().hits == 0 && cache.stats().inserts == inserts + 1);
+    CHECK(checker.check_ecdsa(signature, pubkey, script_code.span(), SigVersion::WITNESS_V0));
+    CHECK(cache.stats().hits == 1);
+
+    // The last byte of S (just before the hash type): still a well-formed
+    // DER signature, no longer a valid one, and not in the cache
+    Bytes corrupted = signature;
+    corrupted[corrupted.size() - 2] ^= 1;
+    uint64_t misses = cache.stats().misses;
+    CHECK(!checker.check_ecdsa(corrupted, pubkey, script_code.span(), SigVersion::WITNESS_V0));
+    CHECK(!checker.check_ecdsa(corrupted, pubkey, script_code.span(), SigVersion::WITNESS_V0));
+    CHECK(cache.stats().hits == 1 && cache.stats().misses == misses + 2);
+    CHECK(cache.stats().inserts == inserts + 1);
+
+    // Same signature, other amount: another sighash, so another entry
+    TransactionSignatureChecker wrong_amount(*tx, 0, amount + 1, nullptr, &cache);
+    CHECK(!wrong_amount.check_ecdsa(signature, pubkey, script_code.span(), SigVersion::WITNESS_V0));
+    CHECK(cache.stats().hits == 1);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(19);
+    test_entries(rng);
+    test_small_table(rng);
+    test_checker(rng);
+    return test_result();
+}
@@ -0,0 +1,170 @@
+// tests/test_transaction_view.cpp
+//
+// Random transactions through serialize_transaction(), TransactionView and
+// deserialize_transaction(), and random corruptions of them: every input
+// must either decode to something that re-encodes to the same bytes or
+// throw DeserializeError.
+
+#include <random>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "crypto/hash.h"
+#include "crypto/hex.h"
+#include "transaction/transaction_view.h"
+
+using namespace bitcoin;
+
+namespace {
+
+using Bytes = std::vector<unsigned char>;
+
+std::string random_string(std::mt19937_64& rng, size_t max_size) {
+    std::string out(rng() % (max_size + 1), '\0');
+    for (char& c : out) c = (char)rng();
+    return out;
+}
+
+// Sizes straddle the CompactSize boundaries (0xfc / 0xfd) now and then
+size_t random_size(std::mt19937_64& rng, size_t max_size) {
+    return rng() % 20 == 0 ? 250 + rng() % 10 : rng() % (max_size + 1);
+}
+
+TransactionRef random_transaction(std::mt19937_64& rng) {
+    TransactionBuilder builder;
+    builder.set_version((uint32_t)rng());
+    builder.set_locktime((uint32_t)rng());
+    bool witness = rng() % 2;
+    size_t input_count = 1 + rng() % 4;
+    for (size_t i = 0; i < input_count; i++) {
+        TransactionInput input(crypto::Hash::sha256(random_string(rng, 16)), (uint32_t)rng(),
+                               random_string(rng, random_size(rng, 120)));
+        input.sequence = (uint32_t)rng();
+        if (witness && rng() % 3) {
+            for (size_t k = rng() % 4; k > 0; k--) input.witness.push_back(random_string(rng, random_size(rng, 80)));
+        }
+        builder.add_input(input);
+    }
+    for (size_t i = rng() % 5; i > 0; i--) {
+        std::string script = random_string(rng, random_size(rng, 60));
+        const unsigned char* begin = (const unsigned char*)script.data();
+        builder.add_output(TransactionOutput(rng(), Script(begin, begin + script.size())));
+    }
+    return std::move(builder).build();
+}
+
+void check_same(const Transaction& a, const Transaction& b) {
+    CHECK(a.version == b.version);
+    CHECK(a.locktime == b.locktime);
+    CHECK(a.inputs.size() == b.inputs.size());
+    for (size_t i = 0; i < a.inputs.size() && i < b.inputs.size(); i++) {
+        CHECK(a.inputs[i].previous_txid == b.inputs[i].previous_txid);
+        CHECK(a.inputs[i].vout == b.inputs[i].vout);
+        CHECK(a.inputs[i].script_sig == b.inputs[i].script_sig);
+        CHECK(a.inputs[i].sequence == b.inputs[i].sequence);
+        CHECK(a.inputs[i].witness == b.inputs[i].witness);
+    }
+    CHECK(a.outputs.size() == b.outputs.size());
+    for (size_t i = 0; i < a.outputs.size() && i < b.outputs.size(); i++) {
+        CHECK(a.outputs[i].value == b.outputs[i].value);
+        CHECK(a.outputs[i].script_pubkey == b.outputs[i].script_pubkey);
+    }
+    CHECK(a.get_txid() == b.get_txid());
+    CHECK(a.get_wtxid() == b.get_wtxid());
+}
+
+void test_genesis_coinbase() {
+    Bytes raw = crypto::hex_to_bytes(
+        "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff4d04ffff001d01044554"
+        "68652054696d65732030332f4a616e2f32303039204368616e63656c6c6f72206f6e206272696e6b206f66207365636f6e64"
+        "206261696c6f757420666f722062616e6b73ffffffff0100f2052a01000000434104678afdb0fe5548271967f1a67130b7105c"
+        "d6a828e03909a67962e0ea1f61deb649f6bc3f4cef38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac00000000");
+    TransactionRef tx = deserialize_transaction(raw);
+    CHECK(tx->get_txid().to_hex() == "4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b");
+    Bytes out;
+    serialize_transaction(*tx, out);
+    CHECK(out == raw);
+}
+
+void test_round_trip(std::mt19937_64& rng, int rounds) {
+    Bytes bytes, again;
+    TransactionView view;
+    for (int round = 0; round < rounds; round++) {
+        TransactionRef tx = random_transaction(rng);
+        serialize_transaction(*tx, bytes);
+        CHECK(bytes.size() == tx->get_serialized_size());
+        CHECK(tx->get_weight() == tx->get_serialized_size(false) * (WITNESS_SCALE_FACTOR - 1) + bytes.size());
+
+        // Through the view, reused from the last round
+        SpanReader reader(bytes);
+        view.parse(reader);
+        CHECK(reader.empty());
+        CHECK(view.raw.size() == bytes.size());
+        CHECK(view.has_witness() == tx->has_witness());
+        CHECK(view.compute_txid() == tx->get_txid());
+        CHECK(view.compute_wtxid() == tx->get_wtxid());
+        check_same(*view.to_transaction(), *tx);
+
+        // Through the owning decoder, and back out
+        TransactionRef decoded = deserialize_transaction(bytes);
+        check_same(*decoded, *tx);
+        serialize_transaction(*decoded, again);
+        CHECK(again == bytes);
+
+        // Without witness: same txid, and that's also the wtxid
+        serialize_transaction(*tx, again, false);
+        TransactionRef stripped = deserialize_transaction(again);
+        CHECK(stripped->get_txid() == tx->get_txid());
+        CHECK(stripped->get_wtxid() == tx->get_txid());
+    }
+}
+
+void test_mutations(std::mt19937_64& rng, int rounds) {
+    Bytes bytes, again;
+    int decoded = 0, rejected = 0;
+    for (int round = 0; round < rounds; round++) {
+        serialize_transaction(*random_transaction(rng), bytes);
+        for (int m = 0; m < 20; m++) {
+            Bytes mutated = bytes;
+            switch (rng() % 4) {
+            case 0:     // flip a bit
+                mutated[rng() % mutated.size()] ^= (unsigned char)(1 << (rng() % 8));
+                break;
+            case 1:     // truncate
+                mutated.resize(rng() % mutated.size());
+                break;
+            case 2:     // overwrite a byte with a CompactSize prefix
+                mutated[rng() % mutated.size()] = (unsigned char)(0xfd + rng() % 3);
+                break;
+            case 3:     // append garbage
+                mutated.push_back((unsigned char)rng());
+                break;
+            }
+            try {
+                TransactionRef tx = deserialize_transaction(mutated);
+                serialize_transaction(*tx, again);
+                CHECK(again == mutated);
+                SpanReader reader(mutated);
+                TransactionView view;
+                view.parse(reader);
+                CHECK(view.compute_wtxid() == tx->get_wtxid());
+                decoded++;
+            } catch (const DeserializeError&) {
+                rejected++;
+            }
+        }
+    }
+    // Both outcomes should actually happen
+    CHECK(decoded > 0);
+    CHECK(rejected > 0);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937_64 rng(2017);
+    test_genesis_coinbase();
+    test_round_trip(rng, 2000);
+    test_mutations(rng, 1000);
+    return test_result();
+}
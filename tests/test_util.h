@@ -0,0 +1,115 @@
+// tests/test_util.h
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "blockchain/block.h"
+#include "blockchain/merkle.h"
+#include "blockchain/pow.h"
+#include "coins/coins.h"
+#include "crypto/hash.h"
+#include "crypto/hex.h"
+#include "crypto/keys.h"
+#include "script/sighash.h"
+
+/**
+ * Building blocks for tests: deterministic keys, coinbases, signed P2WPKH
+ * spends and mined regtest blocks
+ */
+namespace test {
+
+using namespace bitcoin;
+
+static constexpr uint32_t REGTEST_BITS = 0x207fffff;
+static constexpr uint32_t FIRST_BLOCK_TIME = 1600000000;
+
+inline std::string to_string(std::span<const unsigned char> bytes) { return std::string(bytes.begin(), bytes.end()); }
+
+// Private key `n` (1, 2, ...) with its P2WPKH output script
+struct TestKey {
+    crypto::PrivateKey key;
+    crypto::PublicKey pub;
+    Script script;
+
+    explicit TestKey(unsigned n)
+        : key([n] {
+              char hex[65];
+              std::snprintf(hex, sizeof(hex), "%064x", n);
+              return std::string(hex);
+          }()),
+          pub(key), script(make_p2wpkh(crypto::Hash::hash160(pub.get_bytes()))) {}
+};
+
+// Coinbase for `height`: the BIP34 height push, then a tag to pad it to size
+inline TransactionRef make_coinbase(uint32_t height, const std::vector<TransactionOutput>& outputs,
+                                    const std::string& tag = "test") {
+    Script script_sig;
+    script_sig.push_int(height);
+    script_sig.push_data(std::span<const unsigned char>((const unsigned char*)tag.data(), tag.size()));
+    TransactionInput input;
+    input.previous_txid.set_null();
+    input.vout = 0xffffffff;
+    input.script_sig = to_string(script_sig.span());
+    TransactionBuilder builder;
+    builder.add_input(input);
+    for (const TransactionOutput& output : outputs) builder.add_output(output);
+    return std::move(builder).build();
+}
+
+// Spend P2WPKH coins of `key` (all of them its) into `outputs`
+inline TransactionRef spend(const TestKey& key, const std::vector<std::pair<OutPoint, TransactionOutput>>& coins,
+                            const std::vector<TransactionOutput>& outputs, uint32_t version = 2) {
+    TransactionBuilder builder;
+    builder.set_version(version);
+    for (const auto& [outpoint, coin] : coins) builder.add_input(TransactionInput(outpoint.txid, outpoint.vout, ""));
+    for (const TransactionOutput& output : outputs) builder.add_output(output);
+
+    TransactionRef unsigned_tx = builder.build();
+    PrecomputedSighash precomputed(*unsigned_tx);
+    Script script_code = make_p2pkh(crypto::Hash::hash160(key.pub.get_bytes()));
+    for (size_t i = 0; i < coins.size(); i++) {
+        std::vector<unsigned char> signature = key.key.sign(
+            segwit_signature_hash(*unsigned_tx, i, script_code.span(), coins[i].second.value, SIGHASH_ALL, precomputed));
+        signature.push_back(SIGHASH_ALL);
+        builder.mutable_input(i).witness = {to_string(signature), to_string(key.pub.get_bytes())};
+    }
+    return std::move(builder).build();
+}
+
+// Add the witness commitment if anything has a witness, set the merkle root
+// and grind the nonce
+inline void finish_block(Block& block, const ConsensusParams& params) {
+    bool witness = false;
+    for (const TransactionRef& tx : block.transactions) witness |= tx->has_witness();
+    if (witness) {
+        std::vector<crypto::Hash256> wtxids(1);
+        for (size_t i = 1; i < block.transactions.size(); i++) wtxids.push_back(block.transactions[i]->get_wtxid());
+        std::string reserved(32, '\0');
+        crypto::Hash256 commitment = compute_witness_commitment(
+            wtxids, std::span<const unsigned char>((const unsigned char*)reserved.data(), reserved.size()));
+        std::vector<unsigned char> script = crypto::hex_to_bytes("6a24aa21a9ed");
+        script.insert(script.end(), commitment.begin(), commitment.end());
+        TransactionBuilder coinbase(*block.transactions[0]);
+        coinbase.mutable_input(0).witness = {reserved};
+        coinbase.add_output(TransactionOutput(0, Script(std::span<const unsigned char>(script))));
+        block.transactions[0] = std::move(coinbase).build();
+    }
+    block.header.merkle_root = block.calculate_merkle_root();
+    while (!check_proof_of_work(block.calculate_hash(), block.header.bits, params)) block.header.nonce++;
+}
+
+// The next block after `previous` (nullptr: a genesis block) at `height`
+inline Block make_block(const Block* previous, uint32_t height, TransactionRef coinbase,
+                        std::vector<TransactionRef> transactions, const ConsensusParams& params) {
+    Block block;
+    block.header.version = 0x20000000;
+    if (previous) block.header.previous_block_hash = previous->calculate_hash();
+    block.header.timestamp = FIRST_BLOCK_TIME + 600 * height;
+    block.header.bits = REGTEST_BITS;
+    block.transactions.push_back(std::move(coinbase));
+    for (TransactionRef& tx : transactions) block.transactions.push_back(std::move(tx));
+    finish_block(block, params);
+    return block;
+}
+
+} // namespace test
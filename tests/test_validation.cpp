@@ -0,0 +1,148 @@
+// tests/test_validation.cpp
+//
+// Consensus checks on a mined regtest chain: check_transaction() on its
+// own, then blocks at height 101 through connect_block_verified(), each
+// breaking one rule (BIP34 and BIP30 among them), and the same
+// transactions offered to the mempool.
+
+#include <string>
+#include <vector>
+#include "check.h"
+#include "coins/utxo_set.h"
+#include "mempool/mempool.h"
+#include "test_util.h"
+#include "validation/validation.h"
+
+using namespace bitcoin;
+
+namespace {
+
+const ConsensusParams params = ConsensusParams::regtest();
+const test::TestKey key(1);
+
+TransactionRef with_script_sig_size(const TransactionRef& coinbase, size_t size) {
+    TransactionBuilder builder(*coinbase);
+    builder.mutable_input(0).script_sig.resize(size, 'x');
+    return std::move(builder).build();
+}
+
+void test_check_transaction() {
+    TransactionOutput output(1000, key.script);
+    TransactionRef coinbase = test::make_coinbase(1, {output});
+    CHECK(check_transaction(*coinbase));
+
+    TransactionBuilder no_inputs;
+    no_inputs.add_output(output);
+    CHECK(!check_transaction(*no_inputs.build()));
+    TransactionBuilder no_outputs;
+    no_outputs.add_input(TransactionInput(coinbase->get_txid(), 0, ""));
+    CHECK(!check_transaction(*no_outputs.build()));
+    CHECK(!check_transaction(*TransactionBuilder().build()));
+
+    CHECK(!check_transaction(*with_script_sig_size(coinbase, 1)));
+    CHECK(check_transaction(*with_script_sig_size(coinbase, 2)));
+    CHECK(check_transaction(*with_script_sig_size(coinbase, 100)));
+    CHECK(!check_transaction(*with_script_sig_size(coinbase, 101)));
+}
+
+/**
+ * Blocks 0 to 100, each coinbase paying the subsidy to `key`, connected to
+ * a UtxoSet; block 101 may spend the genesis coinbase
+ */
+struct TestChain {
+    std::vector<Block> blocks;
+    BlockIndex index;
+    UtxoSet utxo;
+
+    TestChain() {
+        for (uint32_t height = 0; height <= 100; height++) {
+            TransactionOutput reward(get_block_subsidy(height, params), key.script);
+            blocks.push_back(test::make_block(height ? &blocks.back() : nullptr, height,
+                                              test::make_coinbase(height, {reward}), {}, params));
+            index.add_header(blocks.back().header);
+            BlockUndo undo;
+            CHECK(connect_block_verified(utxo, blocks.back(), parent(height), params, undo));
+        }
+    }
+
+    const BlockIndexEntry* parent(uint32_t height) const {
+        return height ? index.lookup(blocks[height - 1].calculate_hash()) : nullptr;
+    }
+
+    const BlockIndexEntry* tip() const { return parent(blocks.size()); }
+
+    // Does a block at the next height connect? If so it's disconnected
+    // again; either way the coins must be as they were.
+    bool try_connect(std::vector<TransactionRef> transactions, TransactionRef coinbase = nullptr) {
+        uint32_t height = blocks.size();
+        if (!coinbase) coinbase = test::make_coinbase(height, {TransactionOutput(get_block_subsidy(height, params), key.script)});
+        Block block = test::make_block(&blocks.back(), height, coinbase, std::move(transactions), params);
+        size_t before = utxo.size();
+        BlockUndo undo;
+        bool connected = connect_block_verified(utxo, block, parent(height), params, undo);
+        if (connected) disconnect_block(utxo, block, undo);
+        CHECK(utxo.size() == before);
+        return connected;
+    }
+
+    std::pair<OutPoint, TransactionOutput> genesis_coin() const {
+        const TransactionRef& coinbase = blocks[0].transactions[0];
+        return {OutPoint(coinbase->get_txid(), 0), coinbase->outputs[0]};
+    }
+};
+
+void test_block_transactions(TestChain& chain) {
+    auto coin = chain.genesis_coin();
+    TransactionRef good = test::spend(key, {coin}, {TransactionOutput(coin.second.value - 1000, key.script)});
+    CHECK(chain.try_connect({good}));
+
+    // A spend with no outputs would destroy the coin, not pay it anywhere
+    CHECK(!chain.try_connect({test::spend(key, {coin}, {})}));
+    // Nothing at all - on the wire the empty input count reads as a segwit marker
+    CHECK(!chain.try_connect({TransactionBuilder().build()}));
+    CHECK(!chain.try_connect({good, TransactionBuilder().build()}));
+
+    uint32_t height = chain.blocks.size();
+    TransactionRef coinbase = test::make_coinbase(height, {TransactionOutput(get_block_subsidy(height, params), key.script)});
+    CHECK(chain.try_connect({good}, with_script_sig_size(coinbase, 100)));
+    CHECK(!chain.try_connect({good}, with_script_sig_size(coinbase, 101)));
+}
+
+void test_coinbase_uniqueness(TestChain& chain) {
+    uint32_t height = chain.blocks.size();
+    TransactionOutput reward(get_block_subsidy(height, params), key.script);
+    CHECK(chain.try_connect({}, test::make_coinbase(height, {reward}, "")));
+    CHECK(!chain.try_connect({}, test::make_coinbase(height - 1, {reward})));
+    CHECK(!chain.try_connect({}, test::make_coinbase(height + 1, {reward})));
+    TransactionBuilder no_height(*test::make_coinbase(height, {reward}));
+    no_height.mutable_input(0).script_sig = "no height";
+    CHECK(!chain.try_connect({}, std::move(no_height).build()));
+
+    // BIP34 keeps a repeat out of connect_block_verified(), so BIP30 is
+    // checked on connect_block(): the last block's coinbase, unspent, again
+    Block repeat = test::make_block(&chain.blocks.back(), height, chain.blocks.back().transactions[0], {}, params);
+    size_t before = chain.utxo.size();
+    BlockUndo undo;
+    CHECK(!connect_block(chain.utxo, repeat, height, undo));
+    CHECK(chain.utxo.size() == before);
+}
+
+void test_mempool_empty(TestChain& chain) {
+    Mempool pool;
+    auto coin = chain.genesis_coin();
+    CHECK(pool.accept(test::spend(key, {coin}, {}), chain.utxo, chain.tip()) == MempoolReject::EMPTY);
+    CHECK(pool.accept(TransactionBuilder().build(), chain.utxo, chain.tip()) == MempoolReject::EMPTY);
+    TransactionRef good = test::spend(key, {coin}, {TransactionOutput(coin.second.value - 1000, key.script)});
+    CHECK(pool.accept(good, chain.utxo, chain.tip()) == MempoolReject::OK);
+}
+
+} // namespace
+
+int main() {
+    test_check_transaction();
+    TestChain chain;
+    test_block_transactions(chain);
+    test_coinbase_uniqueness(chain);
+    test_mempool_empty(chain);
+    return test_result();
+}